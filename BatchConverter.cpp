@@ -0,0 +1,283 @@
+#include "BatchConverter.h"
+#include "GpuFrame.h"
+#include "Logger.h"
+#include "QoiCodec.h"
+#include "RawFrameFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 多生产者/多消费者的有界队列；Close 之后 Pop 在队列取空时返回 false
+template <typename T> class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity((std::max)(capacity, size_t{1})) {}
+
+    void Push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [&] { return m_items.size() < m_capacity || m_closed; });
+        if (m_closed) {
+            return;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+    }
+
+    bool Pop(T &item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [&] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+struct LoadedFrame {
+    std::filesystem::path source;
+    RawFrameFile raw;
+};
+
+struct EncodeJob {
+    std::filesystem::path destination;
+    ConvertedImage image;
+};
+
+// 按秒累加的原子计数（std::atomic<double> 的 fetch_add 需要 C++20 且并非所有标准库都支持）
+class AtomicSeconds {
+public:
+    void Add(double seconds) { m_micros.fetch_add(static_cast<uint64_t>(seconds * 1e6)); }
+    double Get() const { return static_cast<double>(m_micros.load()) / 1e6; }
+
+private:
+    std::atomic<uint64_t> m_micros{0};
+};
+
+std::vector<std::filesystem::path> ListRawFrames(const std::filesystem::path &directory) {
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == kRawFrameExtension) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+} // namespace
+
+BatchStats RunBatchConversion(const EglEnvironment &egl, const BatchOptions &options) {
+    const std::vector<std::filesystem::path> files = ListRawFrames(options.inputDirectory);
+    std::filesystem::create_directories(options.outputDirectory);
+
+    const unsigned encoderThreads =
+        options.encoderThreads != 0 ? options.encoderThreads : (std::max)(std::thread::hardware_concurrency(), 1u);
+    OutputPixelFormat format = OutputPixelFormat::Bgra8;
+    const char *extension = ".png";
+    if (options.outputFormat == BatchOutputFormat::Exr) {
+        format = OutputPixelFormat::Rgba16F;
+        extension = ".exr";
+    } else if (options.outputFormat == BatchOutputFormat::UltraHdr) {
+        format = OutputPixelFormat::Bgra8GainMap;
+        extension = ".jpg";
+    } else if (options.outputFormat == BatchOutputFormat::Qoi) {
+        extension = QoiCodec::kFileExtension;
+    } else if (options.outputFormat == BatchOutputFormat::Qoi16) {
+        format = OutputPixelFormat::Rgba16F;
+        extension = QoiCodec::kFileExtension;
+    }
+    // JPEG 按 restart 区间、QoiCodec 按条带并行编码，线程数按编码线程池平分，避免超额订阅
+    const unsigned codecThreads = (std::max)((std::max)(std::thread::hardware_concurrency(), 1u) / encoderThreads, 1u);
+
+    LOG("Batch conversion: " + std::to_string(files.size()) + " frames, " + std::to_string(encoderThreads) +
+        " encoder threads.");
+
+    BoundedQueue<LoadedFrame> loadQueue(options.queueDepth);
+    BoundedQueue<EncodeJob> encodeQueue(options.queueDepth);
+
+    std::atomic<size_t> framesConverted{0};
+    std::atomic<size_t> framesFailed{0};
+    std::atomic<size_t> imagesWritten{0};
+    std::atomic<size_t> imagesFailed{0};
+    std::atomic<uint64_t> inputBytes{0};
+    std::atomic<uint64_t> outputBytes{0};
+    AtomicSeconds readBusy;
+    AtomicSeconds encodeBusy;
+    double gpuBusy = 0.0;
+    std::vector<StageTimingStats> stageTimings;
+
+    const Clock::time_point start = Clock::now();
+
+    std::thread reader([&] {
+        for (const auto &path : files) {
+            const Clock::time_point readStart = Clock::now();
+            try {
+                LoadedFrame loaded{path, ReadRawFrameFile(path)};
+                inputBytes += loaded.raw.frame->pixelData.size();
+                readBusy.Add(SecondsSince(readStart));
+                loadQueue.Push(std::move(loaded));
+            } catch (const std::exception &ex) {
+                LOG(std::string("Batch: failed to read frame: ") + ex.what());
+                ++framesFailed;
+            }
+        }
+        loadQueue.Close();
+    });
+
+    std::vector<std::thread> encoders;
+    for (unsigned i = 0; i < encoderThreads; ++i) {
+        encoders.emplace_back([&] {
+            EncodeJob job;
+            while (encodeQueue.Pop(job)) {
+                const Clock::time_point encodeStart = Clock::now();
+                try {
+                    if (options.outputFormat == BatchOutputFormat::Exr) {
+                        ExrFileSink sink(job.destination);
+                        job.image.ReplayInto(sink);
+                        outputBytes += sink.BytesWritten();
+                    } else if (options.outputFormat == BatchOutputFormat::UltraHdr) {
+                        UltraHdrJpegSink sink(job.destination, options.jpegQuality, codecThreads);
+                        job.image.ReplayInto(sink);
+                        outputBytes += sink.BytesWritten();
+                    } else if (options.outputFormat == BatchOutputFormat::Qoi ||
+                               options.outputFormat == BatchOutputFormat::Qoi16) {
+                        QoiFileSink sink(job.destination, job.image.info.format, codecThreads);
+                        job.image.ReplayInto(sink);
+                        outputBytes += sink.BytesWritten();
+                    } else {
+                        PngFileSink sink(job.destination, options.conversion.colorLut
+                                                              ? options.conversion.colorLut->IccProfile()
+                                                              : std::vector<uint8_t>{});
+                        job.image.ReplayInto(sink);
+                        outputBytes += sink.BytesWritten();
+                    }
+                    ++imagesWritten;
+                } catch (const std::exception &ex) {
+                    LOG("Batch: failed to encode " + job.destination.string() + ": " + ex.what());
+                    ++imagesFailed;
+                }
+                encodeBusy.Add(SecondsSince(encodeStart));
+            }
+        });
+    }
+
+    // GPU 阶段：上传、检测、转换都在调用线程上完成，回读结果交给编码线程池
+    try {
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        outputModule->SetTimingEnabled(options.stageTiming);
+        LoadedFrame loaded;
+        while (loadQueue.Pop(loaded)) {
+            const Clock::time_point gpuStart = Clock::now();
+            try {
+                DisplayHdrInfo hdrInfo = loaded.raw.hdrInfo;
+                if (options.sdrWhiteOverride) {
+                    hdrInfo.sdrWhiteLevel = *options.sdrWhiteOverride;
+                }
+
+                auto gpuFrame = GpuFrame::Create(std::move(loaded.raw.frame), egl.Display(), egl.DummySurface(),
+                                                 egl.RootContext());
+
+                const SelectionRect fullFrame = {0, 0, static_cast<int>(gpuFrame->Width()),
+                                                 static_cast<int>(gpuFrame->Height())};
+                const size_t outputCount = options.regions.empty() ? options.scales.size() : options.regions.size();
+                std::vector<MemorySink> sinks(outputCount, MemorySink(format));
+                if (options.regions.empty()) {
+                    std::vector<ScaledOutput> outputs;
+                    for (size_t i = 0; i < options.scales.size(); ++i) {
+                        outputs.push_back({options.scales[i], &sinks[i]});
+                    }
+                    outputModule->ConvertSelectionToSinks(*gpuFrame, fullFrame, hdrInfo, options.conversion,
+                                                          outputs);
+                } else {
+                    std::vector<RegionOutput> outputs;
+                    for (size_t i = 0; i < options.regions.size(); ++i) {
+                        outputs.push_back({options.regions[i], &sinks[i]});
+                    }
+                    outputModule->ConvertRegionsToSinks(*gpuFrame, hdrInfo, options.conversion, outputs);
+                }
+                gpuFrame.reset();
+                gpuBusy += SecondsSince(gpuStart);
+                ++framesConverted;
+
+                for (size_t i = 0; i < sinks.size(); ++i) {
+                    EncodeJob job;
+                    job.destination = options.outputDirectory / loaded.source.stem();
+                    if (options.regions.empty()) {
+                        job.destination += OutputScaleSuffix(options.scales[i]);
+                    } else {
+                        job.destination += ".r" + std::to_string(i);
+                    }
+                    job.destination += extension;
+                    job.image = std::move(sinks[i].Image());
+                    encodeQueue.Push(std::move(job));
+                }
+            } catch (const std::exception &ex) {
+                LOG("Batch: failed to convert " + loaded.source.string() + ": " + ex.what());
+                ++framesFailed;
+                gpuBusy += SecondsSince(gpuStart);
+            }
+        }
+        stageTimings = outputModule->GetTimingStats();
+    } catch (...) {
+        loadQueue.Close();
+        encodeQueue.Close();
+        reader.join();
+        for (auto &encoder : encoders) {
+            encoder.join();
+        }
+        throw;
+    }
+
+    encodeQueue.Close();
+    reader.join();
+    for (auto &encoder : encoders) {
+        encoder.join();
+    }
+
+    BatchStats stats;
+    stats.framesConverted   = framesConverted.load();
+    stats.framesFailed      = framesFailed.load();
+    stats.imagesWritten     = imagesWritten.load();
+    stats.imagesFailed      = imagesFailed.load();
+    stats.inputBytes        = inputBytes.load();
+    stats.outputBytes       = outputBytes.load();
+    stats.seconds           = SecondsSince(start);
+    stats.readBusySeconds   = readBusy.Get();
+    stats.gpuBusySeconds    = gpuBusy;
+    stats.encodeBusySeconds = encodeBusy.Get();
+    stats.stageTimings      = std::move(stageTimings);
+    return stats;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "EglEnvironment.h"
+#include "OutputModule.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+enum class BatchOutputFormat {
+    Png,      // 与剪贴板路径相同的 8-bit 结果
+    Exr,      // 同一结果的半精度线性光版本
+    UltraHdr, // JPEG 基础图像 + 增益图，只支持 1x 输出
+    Qoi,      // 与 Png 相同的 8-bit 结果，QoiCodec 快速无损格式
+    Qoi16,    // 与 Exr 相同的半精度结果，QoiCodec 快速无损格式
+};
+
+struct BatchOptions {
+    std::filesystem::path inputDirectory;
+    std::filesystem::path outputDirectory;
+    BatchOutputFormat outputFormat = BatchOutputFormat::Png;
+    ConversionOptions conversion;
+    // 每帧产生的输出尺寸；非 1x 的输出文件名带 OutputScaleSuffix 后缀
+    std::vector<OutputScale> scales{OutputScale{}};
+    // 非空时每帧只转换这些区域（1x，一次批量 dispatch），文件名带 ".r<序号>" 后缀；与 scales 互斥
+    std::vector<SelectionRect> regions;
+    std::optional<float> sdrWhiteOverride; // 覆盖转储文件中记录的 SDR 白点（nits）
+    unsigned encoderThreads = 0;           // 0 表示使用 hardware_concurrency
+    int jpegQuality = 90;                  // UltraHdr 输出的 JPEG 质量（1..100）
+    size_t queueDepth = 4;                 // 每个阶段间队列的最大帧数，限制内存占用
+    bool stageTiming = false;              // 开启 OutputModule 的逐阶段 GPU 计时
+};
+
+struct BatchStats {
+    size_t framesConverted = 0; // 完成 GPU 转换的帧数
+    size_t framesFailed = 0;    // 读取或转换失败的帧数
+    size_t imagesWritten = 0;   // 写出的文件数（每帧每个输出尺寸一个）
+    size_t imagesFailed = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    double seconds = 0.0;
+
+    // 各阶段实际工作时间（编码阶段为所有线程之和），用于判断流水线瓶颈
+    double readBusySeconds = 0.0;
+    double gpuBusySeconds = 0.0;
+    double encodeBusySeconds = 0.0;
+
+    // stageTiming 开启时 OutputModule 各阶段的滚动统计
+    std::vector<StageTimingStats> stageTimings;
+};
+
+// 把 inputDirectory 中所有 .scrgb 转储按 读取 → 上传/检测/转换 → 多线程编码 的流水线转换到 outputDirectory。
+// GPU 阶段运行在调用线程上，使用 egl 的根 context。
+BatchStats RunBatchConversion(const EglEnvironment &egl, const BatchOptions &options);
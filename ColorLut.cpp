@@ -0,0 +1,381 @@
+#include "ColorLut.h"
+#include "TransferLut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t kIccHeaderSize = 128;
+constexpr int kTrcInverseIterations = 32;
+
+// 源信号为 sRGB：线性光经 Bradford 适应到 D50 后的 XYZ，与 ICC 的 PCS 一致
+constexpr double kSrgbToXyzD50[3][3] = {
+    {0.4360747, 0.3850649, 0.1430804},
+    {0.2225045, 0.7168786, 0.0606169},
+    {0.0139322, 0.0971045, 0.7141733},
+};
+
+double SrgbToLinear(double signal) {
+    return signal > 0.04045 ? std::pow((signal + 0.055) / 1.055, 2.4) : signal / 12.92;
+}
+
+std::vector<uint8_t> ReadFileBytes(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path.string());
+    }
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// ICC 配置文件中按需读取的大端字段；越界读取抛出异常
+class IccReader {
+public:
+    explicit IccReader(const std::vector<uint8_t> &data) : m_data(data) {}
+
+    uint32_t Read32(size_t offset) const {
+        Require(offset, 4);
+        return (uint32_t{m_data[offset]} << 24) | (uint32_t{m_data[offset + 1]} << 16) |
+               (uint32_t{m_data[offset + 2]} << 8) | uint32_t{m_data[offset + 3]};
+    }
+
+    uint16_t Read16(size_t offset) const {
+        Require(offset, 2);
+        return static_cast<uint16_t>((m_data[offset] << 8) | m_data[offset + 1]);
+    }
+
+    double ReadS15Fixed16(size_t offset) const { return static_cast<int32_t>(Read32(offset)) / 65536.0; }
+
+    bool HasSignature(size_t offset, const char signature[4]) const {
+        Require(offset, 4);
+        return std::memcmp(m_data.data() + offset, signature, 4) == 0;
+    }
+
+    // 标签数据的起始偏移；不存在时返回空
+    std::optional<size_t> FindTag(const char signature[4]) const {
+        const uint32_t count = Read32(kIccHeaderSize);
+        for (uint32_t i = 0; i < count; ++i) {
+            const size_t entry = kIccHeaderSize + 4 + static_cast<size_t>(i) * 12;
+            if (HasSignature(entry, signature)) {
+                return Read32(entry + 4);
+            }
+        }
+        return std::nullopt;
+    }
+
+    size_t RequireTag(const char signature[4]) const {
+        const auto offset = FindTag(signature);
+        if (!offset) {
+            throw std::runtime_error(std::string("ICC profile has no ") + std::string(signature, 4) + " tag");
+        }
+        return *offset;
+    }
+
+private:
+    void Require(size_t offset, size_t size) const {
+        if (offset + size > m_data.size()) {
+            throw std::runtime_error("ICC profile is truncated");
+        }
+    }
+
+    const std::vector<uint8_t> &m_data;
+};
+
+// rTRC/gTRC/bTRC：curv（恒等、单一 gamma 或采样表）或 para（参数曲线 0-4），信号值 → 线性光
+class ToneCurve {
+public:
+    ToneCurve(const IccReader &reader, size_t offset) {
+        if (reader.HasSignature(offset, "curv")) {
+            const uint32_t count = reader.Read32(offset + 8);
+            if (count == 1) {
+                m_parameters = {reader.Read16(offset + 12) / 256.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+            } else {
+                for (uint32_t i = 0; i < count; ++i) {
+                    m_table.push_back(reader.Read16(offset + 12 + i * 2) / 65535.0);
+                }
+                m_identity = count == 0;
+            }
+        } else if (reader.HasSignature(offset, "para")) {
+            static constexpr int kParameterCounts[] = {1, 3, 4, 5, 7};
+            const uint16_t type = reader.Read16(offset + 8);
+            if (type >= std::size(kParameterCounts)) {
+                throw std::runtime_error("Unsupported ICC parametric curve type " + std::to_string(type));
+            }
+            std::array<double, 7> values = {1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+            for (int i = 0; i < kParameterCounts[type]; ++i) {
+                values[i] = reader.ReadS15Fixed16(offset + 12 + i * 4);
+            }
+            // 统一为类型 4 的形式：x >= d 时 (a·x + b)^g + e，否则 c·x + f
+            const double g = values[0], a = values[1], b = values[2];
+            switch (type) {
+            case 0:
+                m_parameters = {g, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+                break;
+            case 1:
+                m_parameters = {g, a, b, 0.0, -b / a, 0.0, 0.0};
+                break;
+            case 2:
+                m_parameters = {g, a, b, 0.0, -b / a, values[3], values[3]};
+                break;
+            case 3:
+                m_parameters = {g, a, b, values[3], values[4], 0.0, 0.0};
+                break;
+            default:
+                m_parameters = values;
+                break;
+            }
+        } else {
+            throw std::runtime_error("Unsupported ICC tone curve type");
+        }
+    }
+
+    double Evaluate(double x) const {
+        if (m_identity) {
+            return x;
+        }
+        if (!m_table.empty()) {
+            const double position = x * static_cast<double>(m_table.size() - 1);
+            const size_t index = (std::min)(static_cast<size_t>(position), m_table.size() - 2);
+            const double fraction = position - static_cast<double>(index);
+            return m_table[index] + (m_table[index + 1] - m_table[index]) * fraction;
+        }
+        const auto &[g, a, b, c, d, e, f] = m_parameters;
+        return x >= d ? std::pow((std::max)(a * x + b, 0.0), g) + e : c * x + f;
+    }
+
+    // 曲线单调不减，二分求逆；结果在 [0, 1]
+    double Invert(double y) const {
+        double low = 0.0;
+        double high = 1.0;
+        for (int i = 0; i < kTrcInverseIterations; ++i) {
+            const double middle = 0.5 * (low + high);
+            (Evaluate(middle) < y ? low : high) = middle;
+        }
+        return 0.5 * (low + high);
+    }
+
+private:
+    bool m_identity = false;
+    std::vector<double> m_table;
+    std::array<double, 7> m_parameters{}; // g, a, b, c, d, e, f
+};
+
+bool Invert3x3(const double m[3][3], double inverse[3][3]) {
+    const double determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                               m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                               m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    if (std::abs(determinant) < 1e-9) {
+        return false;
+    }
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            const int r0 = (column + 1) % 3, r1 = (column + 2) % 3;
+            const int c0 = (row + 1) % 3, c1 = (row + 2) % 3;
+            inverse[row][column] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / determinant;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+ColorLut::ColorLut(uint32_t size, const std::vector<float> &rgb, std::string description)
+    : m_size(size), m_description(std::move(description)) {
+    const size_t count = static_cast<size_t>(size) * size * size;
+    m_texels.resize(count * 4);
+    m_values.resize(count * 3);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            m_texels[i * 4 + c] = TransferLut::FloatToHalf(rgb[i * 3 + c]);
+            m_values[i * 3 + c] = TransferLut::HalfToFloat(m_texels[i * 4 + c]);
+        }
+        m_texels[i * 4 + 3] = TransferLut::FloatToHalf(1.0f);
+    }
+}
+
+ColorLut ColorLut::LoadCubeFile(const std::filesystem::path &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path.string());
+    }
+
+    std::string title;
+    uint32_t size = 0;
+    std::vector<float> rgb;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::istringstream fields(line.substr(first));
+        std::string keyword;
+        fields >> keyword;
+        auto fail = [&](const std::string &reason) {
+            return std::runtime_error(path.string() + ":" + std::to_string(lineNumber) + ": " + reason);
+        };
+
+        if (keyword == "TITLE") {
+            const size_t open = line.find('"');
+            const size_t close = line.rfind('"');
+            title = open != close ? line.substr(open + 1, close - open - 1) : std::string();
+        } else if (keyword == "LUT_3D_SIZE") {
+            fields >> size;
+            if (!fields || size < kMinSize || size > kMaxSize || !rgb.empty()) {
+                throw fail("invalid LUT_3D_SIZE");
+            }
+            rgb.reserve(static_cast<size_t>(size) * size * size * 3);
+        } else if (keyword == "LUT_1D_SIZE") {
+            throw fail("1D LUTs are not supported");
+        } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+            // 着色器以 [0, 1] 的信号值为索引，不支持其他输入范围
+            const float expected = keyword == "DOMAIN_MAX" ? 1.0f : 0.0f;
+            float values[3] = {};
+            fields >> values[0] >> values[1] >> values[2];
+            if (!fields || values[0] != expected || values[1] != expected || values[2] != expected) {
+                throw fail(keyword + " must be " + (expected == 0.0f ? "0 0 0" : "1 1 1"));
+            }
+        } else if (keyword == "LUT_3D_INPUT_RANGE") {
+            float values[2] = {};
+            fields >> values[0] >> values[1];
+            if (!fields || values[0] != 0.0f || values[1] != 1.0f) {
+                throw fail("LUT_3D_INPUT_RANGE must be 0 1");
+            }
+        } else {
+            float value[3] = {};
+            std::istringstream data(line.substr(first));
+            data >> value[0] >> value[1] >> value[2];
+            if (!data || size == 0) {
+                throw fail(size == 0 ? "data before LUT_3D_SIZE" : "expected three values");
+            }
+            rgb.insert(rgb.end(), value, value + 3);
+        }
+    }
+
+    if (size == 0 || rgb.size() != static_cast<size_t>(size) * size * size * 3) {
+        throw std::runtime_error(path.string() + ": expected " + std::to_string(size) + "^3 entries, got " +
+                                 std::to_string(rgb.size() / 3));
+    }
+    const std::string name = title.empty() ? path.filename().string() : title;
+    return ColorLut(size, rgb, name + " (.cube, " + std::to_string(size) + "^3)");
+}
+
+ColorLut ColorLut::BakeFromIccProfile(const std::filesystem::path &path, uint32_t gridSize) {
+    if (gridSize < kMinSize || gridSize > kMaxSize) {
+        throw std::runtime_error("Invalid color LUT grid size");
+    }
+    std::vector<uint8_t> profile = ReadFileBytes(path);
+    const IccReader reader(profile);
+    if (profile.size() < kIccHeaderSize + 4 || !reader.HasSignature(36, "acsp")) {
+        throw std::runtime_error(path.string() + " is not an ICC profile");
+    }
+    if (!reader.HasSignature(16, "RGB ") || !reader.HasSignature(20, "XYZ ")) {
+        throw std::runtime_error(path.string() + ": only RGB profiles with an XYZ connection space are supported");
+    }
+    if (!reader.FindTag("rXYZ") || !reader.FindTag("rTRC")) {
+        throw std::runtime_error(path.string() + ": only matrix/TRC profiles are supported");
+    }
+
+    // 配置文件矩阵：列为 R/G/B 原色的 XYZ（D50），把目标线性光映射到 PCS
+    double toXyz[3][3] = {};
+    const char *const colorants[3] = {"rXYZ", "gXYZ", "bXYZ"};
+    const char *const curves[3] = {"rTRC", "gTRC", "bTRC"};
+    std::vector<ToneCurve> trc;
+    for (int channel = 0; channel < 3; ++channel) {
+        const size_t offset = reader.RequireTag(colorants[channel]);
+        if (!reader.HasSignature(offset, "XYZ ")) {
+            throw std::runtime_error(path.string() + ": malformed colorant tag");
+        }
+        for (int row = 0; row < 3; ++row) {
+            toXyz[row][channel] = reader.ReadS15Fixed16(offset + 8 + row * 4);
+        }
+        trc.emplace_back(reader, reader.RequireTag(curves[channel]));
+    }
+    double fromXyz[3][3] = {};
+    if (!Invert3x3(toXyz, fromXyz)) {
+        throw std::runtime_error(path.string() + ": colorant matrix is singular");
+    }
+    double sourceToTarget[3][3] = {};
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            for (int k = 0; k < 3; ++k) {
+                sourceToTarget[row][column] += fromXyz[row][k] * kSrgbToXyzD50[k][column];
+            }
+        }
+    }
+
+    // 每个网格点：sRGB 信号 → 线性光 → 目标原色线性光（钳制到色域内）→ 目标 TRC 的逆
+    std::vector<double> linear(gridSize);
+    for (uint32_t i = 0; i < gridSize; ++i) {
+        linear[i] = SrgbToLinear(static_cast<double>(i) / (gridSize - 1));
+    }
+    std::vector<float> rgb;
+    rgb.reserve(static_cast<size_t>(gridSize) * gridSize * gridSize * 3);
+    for (uint32_t b = 0; b < gridSize; ++b) {
+        for (uint32_t g = 0; g < gridSize; ++g) {
+            for (uint32_t r = 0; r < gridSize; ++r) {
+                const double source[3] = {linear[r], linear[g], linear[b]};
+                for (int channel = 0; channel < 3; ++channel) {
+                    const double target = sourceToTarget[channel][0] * source[0] +
+                                          sourceToTarget[channel][1] * source[1] +
+                                          sourceToTarget[channel][2] * source[2];
+                    rgb.push_back(static_cast<float>(trc[channel].Invert(std::clamp(target, 0.0, 1.0))));
+                }
+            }
+        }
+    }
+
+    ColorLut lut(gridSize, rgb,
+                 path.filename().string() + " (ICC matrix/TRC, " + std::to_string(gridSize) + "^3)");
+    lut.m_iccProfile = std::move(profile);
+    return lut;
+}
+
+std::shared_ptr<const ColorLut> ColorLut::Load(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == ".cube") {
+        return std::make_shared<const ColorLut>(LoadCubeFile(path));
+    }
+    if (extension == ".icc" || extension == ".icm") {
+        return std::make_shared<const ColorLut>(BakeFromIccProfile(path));
+    }
+    throw std::runtime_error("Unknown color LUT type: " + path.string() + " (expected .cube, .icc or .icm)");
+}
+
+std::array<float, 3> ColorLut::Apply(const std::array<float, 3> &signal) const {
+    const float scale = static_cast<float>(m_size - 1);
+    const size_t stride[3] = {1, m_size, static_cast<size_t>(m_size) * m_size};
+    size_t base = 0;
+    float fraction[3] = {};
+    for (int axis = 0; axis < 3; ++axis) {
+        const float position = std::clamp(signal[axis], 0.0f, 1.0f) * scale;
+        const size_t index = (std::min)(static_cast<size_t>(position), static_cast<size_t>(m_size - 2));
+        fraction[axis] = position - static_cast<float>(index);
+        base += index * stride[axis];
+    }
+
+    std::array<float, 3> result = {};
+    for (int corner = 0; corner < 8; ++corner) {
+        size_t offset = base;
+        float weight = 1.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            const bool upper = (corner >> axis) & 1;
+            offset += upper ? stride[axis] : 0;
+            weight *= upper ? fraction[axis] : 1.0f - fraction[axis];
+        }
+        for (int c = 0; c < 3; ++c) {
+            result[c] += weight * m_values[offset * 3 + c];
+        }
+    }
+    return result;
+}
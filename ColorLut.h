@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 色彩管理查找表：把 sRGB 编码的 SDR 信号值映射为目标显示器（或 ICC 配置文件描述的色彩空间）的信号值。
+// 处理着色器在 BGRA8 打包前做一次三线性 3D 纹理采样，代替逐像素的矩阵与传递函数运算；
+// CPU 路径使用同一份半精度量化后的数据与相同的索引方式，两者相差不超过 1 个 8-bit 码值。
+// 查找表只作用于显示编码的 BGRA8 输出，RGBA16F 输出仍是线性 sRGB 原色。
+class ColorLut {
+public:
+    // 由 ICC 配置文件生成时每个轴的网格点数
+    static constexpr uint32_t kIccGridSize = 33;
+    static constexpr uint32_t kMinSize = 2;
+    static constexpr uint32_t kMaxSize = 256;
+
+    // Adobe/Resolve .cube：只接受 3D 表，DOMAIN_MIN/MAX 必须为 0 与 1
+    static ColorLut LoadCubeFile(const std::filesystem::path &path);
+
+    // 矩阵/TRC 形式的 RGB 显示器配置文件（rXYZ/gXYZ/bXYZ + rTRC/gTRC/bTRC），相对色度意图，超出色域的值钳制。
+    // 只有 A2B/B2A 表的配置文件不支持
+    static ColorLut BakeFromIccProfile(const std::filesystem::path &path, uint32_t gridSize = kIccGridSize);
+
+    // 按扩展名选择：.cube 为 3D LUT，.icc / .icm 为 ICC 配置文件。失败时抛出 std::runtime_error
+    static std::shared_ptr<const ColorLut> Load(const std::filesystem::path &path);
+
+    uint32_t Size() const { return m_size; }
+    const std::string &Description() const { return m_description; }
+
+    // 3D 纹理数据：Size()^3 个 RGBA 半精度像素，R 变化最快、B 最慢，alpha 恒为 1
+    const std::vector<uint16_t> &TextureData() const { return m_texels; }
+
+    // 由 ICC 配置文件生成时为原始配置文件数据，供 sink 嵌入输出；.cube 为空
+    const std::vector<uint8_t> &IccProfile() const { return m_iccProfile; }
+
+    // 与着色器中的 ApplyColorLut 相同的三线性插值，输入先钳制到 [0, 1]
+    std::array<float, 3> Apply(const std::array<float, 3> &signal) const;
+
+private:
+    ColorLut(uint32_t size, const std::vector<float> &rgb, std::string description);
+
+    uint32_t m_size = 0;
+    std::vector<uint16_t> m_texels;
+    std::vector<float> m_values; // m_texels 解码后的 RGB，CPU 插值使用
+    std::vector<uint8_t> m_iccProfile;
+    std::string m_description;
+};
@@ -0,0 +1,100 @@
+#include "CostModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// 最大与最小像素数之比低于此值时，样本不足以区分固定开销与每像素成本
+constexpr double kMinPixelSpread = 4.0;
+
+} // namespace
+
+bool CostModel::Add(uint64_t pixels, double ms) {
+    if (m_calibrated && ms > Predict(pixels) * kOutlierRatio && ++m_consecutiveOutliers < kMaxConsecutiveOutliers) {
+        return false;
+    }
+    m_consecutiveOutliers = 0;
+
+    const Sample sample{static_cast<double>(pixels), ms};
+    if (m_samples.size() < kWindow) {
+        m_samples.push_back(sample);
+    } else {
+        m_samples[m_next] = sample;
+    }
+    m_next = (m_next + 1) % kWindow;
+    Refit();
+    m_calibrated = true;
+    return true;
+}
+
+void CostModel::Seed(uint64_t smallPixels, uint64_t largePixels, size_t samplesPerSize) {
+    m_samples.clear();
+    for (uint64_t pixels : {smallPixels, largePixels}) {
+        for (size_t i = 0; i < samplesPerSize && m_samples.size() < kWindow; ++i) {
+            m_samples.push_back({static_cast<double>(pixels), Predict(pixels)});
+        }
+    }
+    m_next = m_samples.size() % kWindow;
+}
+
+void CostModel::Refit() {
+    const double count = static_cast<double>(m_samples.size());
+    double minPixels = m_samples.front().pixels;
+    double maxPixels = m_samples.front().pixels;
+    double meanPixels = 0.0;
+    double meanMs = 0.0;
+    for (const auto &sample : m_samples) {
+        minPixels = (std::min)(minPixels, sample.pixels);
+        maxPixels = (std::max)(maxPixels, sample.pixels);
+        meanPixels += sample.pixels / count;
+        meanMs += sample.ms / count;
+    }
+
+    double slope = m_msPerMegapixel / 1e6;
+    if (maxPixels >= minPixels * kMinPixelSpread) {
+        double covariance = 0.0;
+        double variance = 0.0;
+        for (const auto &sample : m_samples) {
+            covariance += (sample.pixels - meanPixels) * (sample.ms - meanMs);
+            variance += (sample.pixels - meanPixels) * (sample.pixels - meanPixels);
+        }
+        slope = (std::max)(covariance / variance, 0.0);
+    }
+
+    // 两项都不应为负：截距为负时改为过原点拟合
+    double intercept = meanMs - slope * meanPixels;
+    if (intercept < 0.0) {
+        double weighted = 0.0;
+        double squares = 0.0;
+        for (const auto &sample : m_samples) {
+            weighted += sample.pixels * sample.ms;
+            squares += sample.pixels * sample.pixels;
+        }
+        intercept = 0.0;
+        slope = squares > 0.0 ? weighted / squares : 0.0;
+    }
+    m_overheadMs = intercept;
+    m_msPerMegapixel = slope * 1e6;
+}
+
+std::string CostModel::Serialize() const {
+    std::ostringstream text;
+    text.precision(9);
+    text << m_overheadMs << "," << m_msPerMegapixel;
+    return text.str();
+}
+
+std::optional<CostModel> CostModel::Parse(std::string_view text) {
+    std::istringstream stream{std::string(text)};
+    CostModel model;
+    char separator = 0;
+    if (!(stream >> model.m_overheadMs >> separator >> model.m_msPerMegapixel) || separator != ',' ||
+        !std::isfinite(model.m_overheadMs) || !std::isfinite(model.m_msPerMegapixel) || model.m_overheadMs < 0.0 ||
+        model.m_msPerMegapixel < 0.0) {
+        return std::nullopt;
+    }
+    model.m_calibrated = true;
+    return model;
+}
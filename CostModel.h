@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 单个转换后端的延迟模型：预测耗时 = 每次调用的固定开销 + 每像素成本 × 输出像素数。
+// 参数由实测的（像素数，挂钟耗时）样本按最小二乘拟合：标定时在大小两种选区上测量，之后每次实际转换
+// 都加入一个样本，只保留最近 kWindow 个。样本的像素数跨度不足以区分两项时只修正固定开销。
+// 比预测慢 kOutlierRatio 倍以上的样本（首次编译着色器变体、调度抖动）不参与拟合，
+// 连续 kMaxConsecutiveOutliers 个时认为环境已经变化，照常加入
+class CostModel {
+public:
+    static constexpr size_t kWindow = 32;
+    static constexpr double kOutlierRatio = 4.0;
+    static constexpr int kMaxConsecutiveOutliers = 3;
+
+    // 返回 false 表示样本作为离群值被丢弃
+    bool Add(uint64_t pixels, double ms);
+
+    // 从缓存读入的模型没有样本，第一个实测样本会单独决定固定开销。读入后把模型在标定的两种像素数上的
+    // 预测值各作为 samplesPerSize 个样本填入窗口，之后的实测样本与标定结果一起拟合，逐渐替换它们
+    void Seed(uint64_t smallPixels, uint64_t largePixels, size_t samplesPerSize);
+
+    // 加入过样本或从缓存读入后才可用于预测
+    bool IsCalibrated() const { return m_calibrated; }
+    double Predict(uint64_t pixels) const { return m_overheadMs + m_msPerMegapixel * static_cast<double>(pixels) / 1e6; }
+
+    double OverheadMs() const { return m_overheadMs; }
+    double MsPerMegapixel() const { return m_msPerMegapixel; }
+
+    // 调优缓存中的文本形式："<固定开销 ms>,<每百万像素 ms>"
+    std::string Serialize() const;
+    static std::optional<CostModel> Parse(std::string_view text);
+
+private:
+    struct Sample {
+        double pixels;
+        double ms;
+    };
+
+    void Refit();
+
+    std::vector<Sample> m_samples; // 环形缓冲区
+    size_t m_next = 0;
+    int m_consecutiveOutliers = 0;
+    double m_overheadMs = 0.0;
+    double m_msPerMegapixel = 0.0;
+    bool m_calibrated = false;
+};
@@ -0,0 +1,288 @@
+#include "CpuConversion.h"
+#include "TransferLut.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace CpuConversion {
+namespace {
+
+// 与着色器中的同名常量一致
+constexpr float kReferencePeakNits = 1000.0f;
+constexpr float kScRgbReferenceWhiteNits = 80.0f;
+constexpr float kAcesExposure = 0.6f;
+constexpr float kPqM1 = 0.1593017578125f;
+constexpr float kPqM2 = 78.84375f;
+constexpr float kPqC1 = 0.8359375f;
+constexpr float kPqC2 = 18.8515625f;
+constexpr float kPqC3 = 18.6875f;
+constexpr float kPqPeakNits = 10000.0f;
+
+// 每次 WriteRows 交给 sink 的行数
+constexpr uint32_t kRowsPerWrite = 64;
+
+constexpr size_t kSourceBytesPerPixel = 4 * sizeof(uint16_t); // R16G16B16A16_FLOAT
+constexpr uint16_t kHalfOne = 0x3C00;
+
+struct Rgb {
+    float r, g, b;
+};
+
+std::vector<float> BuildHalfTable() {
+    std::vector<float> table(65536);
+    for (uint32_t half = 0; half < table.size(); ++half) {
+        table[half] = TransferLut::HalfToFloat(static_cast<uint16_t>(half));
+    }
+    return table;
+}
+
+// 源像素解码用的 binary16 → float 表，首次使用时生成
+const std::vector<float> &HalfTable() {
+    static const std::vector<float> table = BuildHalfTable();
+    return table;
+}
+
+uint8_t ToUnorm8(float value) { return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); }
+
+Rgb SampleTransfer(TransferLut::Curve curve, Rgb value) {
+    return {TransferLut::Sample(curve, value.r), TransferLut::Sample(curve, value.g),
+            TransferLut::Sample(curve, value.b)};
+}
+
+Rgb Scale(Rgb color, float factor) { return {color.r * factor, color.g * factor, color.b * factor}; }
+
+Rgb SrgbLinearToBt2020Linear(Rgb color) {
+    return {0.6274040f * color.r + 0.3292820f * color.g + 0.0433136f * color.b,
+            0.0690970f * color.r + 0.9195400f * color.g + 0.0113612f * color.b,
+            0.0163916f * color.r + 0.0880132f * color.g + 0.8955950f * color.b};
+}
+
+Rgb Bt2020LinearToBt709Linear(Rgb color) {
+    return {1.6604910f * color.r - 0.5876411f * color.g - 0.0728499f * color.b,
+            -0.1245505f * color.r + 1.1328999f * color.g - 0.0083494f * color.b,
+            -0.0181508f * color.r - 0.1005789f * color.g + 1.1187297f * color.b};
+}
+
+float SrgbToLinear(float signal) {
+    signal = std::clamp(signal, 0.0f, 1.0f);
+    return signal > 0.04045f ? std::pow((signal + 0.055f) / 1.055f, 2.4f) : signal / 12.92f;
+}
+
+float PqEncodeNits(float nits) {
+    const float y = std::pow(std::clamp(nits / kPqPeakNits, 0.0f, 1.0f), kPqM1);
+    return std::pow((kPqC1 + kPqC2 * y) / (1.0f + kPqC3 * y), kPqM2);
+}
+
+float PqDecodeNits(float signal) {
+    const float e = std::pow(std::clamp(signal, 0.0f, 1.0f), 1.0f / kPqM2);
+    return std::pow((std::max)(e - kPqC1, 0.0f) / (kPqC2 - kPqC3 * e), 1.0f / kPqM1) * kPqPeakNits;
+}
+
+// 以下各算子与 ToneMapShaders.h 中的 GLSL 片段逐行对应
+
+Rgb ToneMapHlgRoundTrip(Rgb scRgb, const Parameters &) {
+    const Rgb bt2020Linear = SrgbLinearToBt2020Linear(scRgb);
+    const Rgb interpretedLinear = SampleTransfer(TransferLut::Curve::HlgToDisplayLinear,
+                                                 Scale(bt2020Linear, kScRgbReferenceWhiteNits / kReferencePeakNits));
+    return SampleTransfer(TransferLut::Curve::Bt1886Oetf, Bt2020LinearToBt709Linear(interpretedLinear));
+}
+
+Rgb ToneMapBt2390Eetf(Rgb scRgb, const Parameters &parameters) {
+    const float maxChannel = (std::max)((std::max)(scRgb.r, scRgb.g), scRgb.b);
+    if (maxChannel <= 0.0f) {
+        return {0.0f, 0.0f, 0.0f};
+    }
+
+    const float sourcePq = PqEncodeNits((std::max)(parameters.sourcePeak, parameters.lw) * kScRgbReferenceWhiteNits);
+    const float maxLum = PqEncodeNits(parameters.lw * kScRgbReferenceWhiteNits) / sourcePq;
+    const float ks = (std::max)(1.5f * maxLum - 0.5f, 0.0f);
+
+    const float e1 = (std::min)(PqEncodeNits(maxChannel * kScRgbReferenceWhiteNits) / sourcePq, 1.0f);
+    float e2 = e1;
+    if (e1 > ks) {
+        const float t = (e1 - ks) / (1.0f - ks);
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        e2 = (2.0f * t3 - 3.0f * t2 + 1.0f) * ks + (t3 - 2.0f * t2 + t) * (1.0f - ks) +
+             (-2.0f * t3 + 3.0f * t2) * maxLum;
+    }
+
+    const float mappedNits = PqDecodeNits(e2 * sourcePq);
+    const Rgb mapped = Scale(scRgb, mappedNits / (maxChannel * kScRgbReferenceWhiteNits));
+    return SampleTransfer(TransferLut::Curve::LinearToSrgb, Scale(mapped, 1.0f / parameters.lw));
+}
+
+Rgb ToneMapReinhardExtended(Rgb scRgb, const Parameters &parameters) {
+    const Rgb normalized = Scale(scRgb, 1.0f / parameters.lw);
+    const float luminance = 0.2126f * normalized.r + 0.7152f * normalized.g + 0.0722f * normalized.b;
+    if (luminance <= 0.0f) {
+        return {0.0f, 0.0f, 0.0f};
+    }
+    const float whitePoint = (std::max)(parameters.sourcePeak / parameters.lw, 1.0f);
+    const float mapped = luminance * (1.0f + luminance / (whitePoint * whitePoint)) / (1.0f + luminance);
+    return SampleTransfer(TransferLut::Curve::LinearToSrgb, Scale(normalized, mapped / luminance));
+}
+
+float AcesFit(float x) { return (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f); }
+
+Rgb ToneMapAcesFit(Rgb scRgb, const Parameters &parameters) {
+    const Rgb x = Scale(scRgb, kAcesExposure / parameters.lw);
+    return SampleTransfer(TransferLut::Curve::LinearToSrgb, {AcesFit(x.r), AcesFit(x.g), AcesFit(x.b)});
+}
+
+Rgb ToneMapHardClip(Rgb scRgb, const Parameters &parameters) {
+    return SampleTransfer(TransferLut::Curve::LinearToSrgb, Scale(scRgb, 1.0f / parameters.lw));
+}
+
+using ToneMapFunction = Rgb (*)(Rgb, const Parameters &);
+
+// 按 ToneMapOperator 的值索引，与 ToneMapShaders::kSources 对应
+constexpr std::array<ToneMapFunction, kToneMapOperatorCount> kToneMaps = {
+    ToneMapHlgRoundTrip, ToneMapBt2390Eetf, ToneMapReinhardExtended, ToneMapAcesFit, ToneMapHardClip,
+};
+
+const uint8_t *SourceRow(const CapturedFrame &frame, const SelectionRect &selection, uint32_t row) {
+    return frame.pixelData.data() + static_cast<size_t>(selection.Top() + static_cast<int>(row)) *
+                                        frame.metadata.rowPitch +
+           static_cast<size_t>(selection.Left()) * kSourceBytesPerPixel;
+}
+
+Rgb ReadPixel(const std::vector<float> &halves, const uint8_t *source) {
+    uint16_t pixel[4];
+    std::memcpy(pixel, source, sizeof(pixel));
+    return {halves[pixel[0]], halves[pixel[1]], halves[pixel[2]]};
+}
+
+float Bt709Luminance(Rgb color) { return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b; }
+
+// 统计着色器的亮度：负分量按 0 计
+float NonNegativeLuminance(Rgb color) {
+    return Bt709Luminance({(std::max)(color.r, 0.0f), (std::max)(color.g, 0.0f), (std::max)(color.b, 0.0f)});
+}
+
+// 与 kOutputPackFunctions 中的 GainMapValue 相同；scRgb 已钳制为非负
+float GainMapValue(Rgb scRgb, Rgb signal, const Parameters &parameters, float maxLog2) {
+    const float hdr = Bt709Luminance(Scale(scRgb, 1.0f / parameters.lw));
+    const float sdr = Bt709Luminance({SrgbToLinear(signal.r), SrgbToLinear(signal.g), SrgbToLinear(signal.b)});
+    const float gain = std::log2((hdr + kGainMapOffset) / (sdr + kGainMapOffset));
+    return (gain - kGainMapMinLog2) / (maxLog2 - kGainMapMinLog2);
+}
+
+} // namespace
+
+bool DetectHighlight(const CapturedFrame &frame, const SelectionRect &selection, float threshold) {
+    const auto &halves = HalfTable();
+    const uint32_t width = static_cast<uint32_t>(selection.Width());
+    const uint32_t height = static_cast<uint32_t>(selection.Height());
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *source = SourceRow(frame, selection, y);
+        for (uint32_t x = 0; x < width; ++x) {
+            const Rgb color = ReadPixel(halves, source + x * kSourceBytesPerPixel);
+            if (color.r > threshold || color.g > threshold || color.b > threshold) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+float PeakLuminance(const CapturedFrame &frame, const SelectionRect &selection) {
+    const auto &halves = HalfTable();
+    float peak = 0.0f;
+    for (uint32_t y = 0; y < static_cast<uint32_t>(selection.Height()); ++y) {
+        const uint8_t *source = SourceRow(frame, selection, y);
+        for (uint32_t x = 0; x < static_cast<uint32_t>(selection.Width()); ++x) {
+            const Rgb color = ReadPixel(halves, source + x * kSourceBytesPerPixel);
+            peak = (std::max)(peak, NonNegativeLuminance(color));
+        }
+    }
+    return peak;
+}
+
+LuminanceStatistics MeasureLuminance(const CapturedFrame &frame, const SelectionRect &selection, float threshold) {
+    const auto &halves = HalfTable();
+    double sum = 0.0;
+    double sumSquared = 0.0;
+    uint64_t above = 0;
+    float peak = 0.0f;
+    for (uint32_t y = 0; y < static_cast<uint32_t>(selection.Height()); ++y) {
+        const uint8_t *source = SourceRow(frame, selection, y);
+        for (uint32_t x = 0; x < static_cast<uint32_t>(selection.Width()); ++x) {
+            const Rgb color = ReadPixel(halves, source + x * kSourceBytesPerPixel);
+            const float luminance = NonNegativeLuminance(color);
+            sum += luminance;
+            sumSquared += static_cast<double>(luminance) * luminance;
+            peak = (std::max)(peak, luminance);
+            if (color.r > threshold || color.g > threshold || color.b > threshold) {
+                ++above;
+            }
+        }
+    }
+
+    LuminanceStatistics statistics;
+    statistics.pixelCount = static_cast<uint64_t>(selection.Width()) * static_cast<uint64_t>(selection.Height());
+    if (statistics.pixelCount == 0) {
+        return statistics;
+    }
+    const double count = static_cast<double>(statistics.pixelCount);
+    const double mean = sum / count;
+    statistics.meanNits = mean * kScRgbReferenceWhiteNits;
+    statistics.stdDevNits = std::sqrt((std::max)(sumSquared / count - mean * mean, 0.0)) * kScRgbReferenceWhiteNits;
+    statistics.peakNits = peak * kScRgbReferenceWhiteNits;
+    statistics.aboveSdrWhiteFraction = static_cast<double>(above) / count;
+    return statistics;
+}
+
+void Convert(const CapturedFrame &frame, const SelectionRect &selection, const Parameters &parameters,
+             const ImageInfo &info, ImageSink &sink) {
+    const auto &halves = HalfTable();
+    const ToneMapFunction toneMap = kToneMaps[static_cast<size_t>(info.toneMapOperator)];
+    const size_t rowBytes = info.RowBytes();
+    std::vector<uint8_t> rows(rowBytes * (std::min)(info.height, kRowsPerWrite));
+
+    sink.Begin(info);
+    for (uint32_t firstRow = 0; firstRow < info.height; firstRow += kRowsPerWrite) {
+        const uint32_t rowCount = (std::min)(kRowsPerWrite, info.height - firstRow);
+        for (uint32_t y = 0; y < rowCount; ++y) {
+            const uint8_t *source = SourceRow(frame, selection, firstRow + y);
+            uint8_t *destination = rows.data() + y * rowBytes;
+            for (uint32_t x = 0; x < info.width; ++x) {
+                Rgb color = ReadPixel(halves, source + x * kSourceBytesPerPixel);
+                color = {(std::max)(color.r, 0.0f), (std::max)(color.g, 0.0f), (std::max)(color.b, 0.0f)};
+                Rgb signal = info.hdrPath
+                                       ? toneMap(color, parameters)
+                                       : SampleTransfer(TransferLut::Curve::LinearToSrgb,
+                                                        Scale(color, 1.0f / parameters.lw));
+                if (info.format == OutputPixelFormat::Bgra8GainMap) {
+                    uint8_t *pixel = destination + x * 4;
+                    pixel[0] = ToUnorm8(signal.b);
+                    pixel[1] = ToUnorm8(signal.g);
+                    pixel[2] = ToUnorm8(signal.r);
+                    pixel[3] = ToUnorm8(GainMapValue(color, signal, parameters, info.gainMapMaxLog2));
+                } else if (info.format == OutputPixelFormat::Bgra8) {
+                    if (parameters.colorLut) {
+                        const auto managed = parameters.colorLut->Apply({signal.r, signal.g, signal.b});
+                        signal = {managed[0], managed[1], managed[2]};
+                    }
+                    uint8_t *pixel = destination + x * 4;
+                    pixel[0] = ToUnorm8(signal.b);
+                    pixel[1] = ToUnorm8(signal.g);
+                    pixel[2] = ToUnorm8(signal.r);
+                    pixel[3] = 255;
+                } else {
+                    const uint16_t pixel[4] = {TransferLut::FloatToHalf(SrgbToLinear(signal.r)),
+                                               TransferLut::FloatToHalf(SrgbToLinear(signal.g)),
+                                               TransferLut::FloatToHalf(SrgbToLinear(signal.b)), kHalfOne};
+                    std::memcpy(destination + x * sizeof(pixel), pixel, sizeof(pixel));
+                }
+            }
+        }
+        sink.WriteRows(firstRow, rowCount, rows.data());
+    }
+    sink.End();
+}
+
+} // namespace CpuConversion
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ColorLut.h"
+#include "FrameStatistics.h"
+#include "ImageSink.h"
+#include "ScreenCapture.h"
+#include "SelectionRect.h"
+#include "ToneMapping.h"
+
+#include <cstdint>
+
+// 不经过 GL 的选区转换，直接读取 CapturedFrame。检测阈值、色调映射算子、传递函数查找表与输出打包
+// 都与 ShaderLibrary.cpp 中的着色器一致，输出与 GPU 路径相差不超过 1 个 8-bit 码值（纹理插值精度）。
+// 没有 eglMakeCurrent、dispatch 与映射回读的固定开销，适合图标大小的选区
+namespace CpuConversion {
+
+// 处理着色器的 uniform
+struct Parameters {
+    float lw;         // SDR 白点对应的 scRGB 线性值
+    float sourcePeak; // 显示器峰值亮度对应的 scRGB 线性值
+    const ColorLut *colorLut = nullptr; // 非空时 BGRA8 输出在打包前经过色彩管理查找表
+};
+
+// 与检测着色器相同：选区内任一像素的 R/G/B 超过 threshold 即返回 true
+bool DetectHighlight(const CapturedFrame &frame, const SelectionRect &selection, float threshold);
+
+// 与统计着色器相同的亮度定义：选区内 BT.709 线性亮度的峰值（scRGB 单位）
+float PeakLuminance(const CapturedFrame &frame, const SelectionRect &selection);
+
+// 逐像素扫描得到的亮度统计，作为 FrameStatistics 查表结果的参照
+LuminanceStatistics MeasureLuminance(const CapturedFrame &frame, const SelectionRect &selection, float threshold);
+
+// 按 info（尺寸与选区一致）转换并依次调用 sink 的 Begin / WriteRows / End
+void Convert(const CapturedFrame &frame, const SelectionRect &selection, const Parameters &parameters,
+             const ImageInfo &info, ImageSink &sink);
+
+} // namespace CpuConversion
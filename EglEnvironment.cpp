@@ -0,0 +1,92 @@
+#include "EglEnvironment.h"
+#include "Logger.h"
+
+#include <EGL/eglext.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+EGLDisplay OpenDisplay() {
+#ifndef _WIN32
+    // 无窗口系统的 Linux 主机（CI、服务器）上默认 display 无法初始化，优先使用 Mesa 的 surfaceless 平台
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && std::string(clientExtensions).find("EGL_MESA_platform_surfaceless") != std::string::npos) {
+        auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+                return display;
+            }
+        }
+    }
+#endif
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY) {
+        throw std::runtime_error("eglGetDisplay failed");
+    }
+    if (!eglInitialize(display, nullptr, nullptr)) {
+        throw std::runtime_error("eglInitialize failed");
+    }
+    return display;
+}
+
+} // namespace
+
+EglEnvironment::EglEnvironment() {
+    m_display = OpenDisplay();
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_NONE
+    };
+    EGLint configCount = 0;
+    EGLConfig config;
+    if (!eglChooseConfig(m_display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        eglTerminate(m_display);
+        throw std::runtime_error("eglChooseConfig failed");
+    }
+
+    // 优先 GLES 3.1（计算着色器）；只有 3.0 时 OutputModule 仅使用片元后端
+    for (EGLint minorVersion : {1, 0}) {
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+            EGL_CONTEXT_MINOR_VERSION_KHR, minorVersion,
+            EGL_NONE
+        };
+        m_rootContext = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (m_rootContext != EGL_NO_CONTEXT) {
+            break;
+        }
+    }
+    if (m_rootContext == EGL_NO_CONTEXT) {
+        eglTerminate(m_display);
+        throw std::runtime_error("eglCreateContext failed");
+    }
+
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    m_dummySurface = eglCreatePbufferSurface(m_display, config, surfaceAttribs);
+    if (m_dummySurface == EGL_NO_SURFACE) {
+        eglDestroyContext(m_display, m_rootContext);
+        eglTerminate(m_display);
+        throw std::runtime_error("eglCreatePbufferSurface failed");
+    }
+    LOG("EGL root environment created.");
+}
+
+EglEnvironment::~EglEnvironment() {
+    if (m_display != EGL_NO_DISPLAY) {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_dummySurface != EGL_NO_SURFACE) eglDestroySurface(m_display, m_dummySurface);
+        if (m_rootContext != EGL_NO_CONTEXT) eglDestroyContext(m_display, m_rootContext);
+        eglTerminate(m_display);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+// 根 EGL 环境：display、1×1 PBuffer surface 以及 GLES 3.1 根 context。
+// 各模块的 context 都与根 context 共享对象，纹理因此可以在模块之间直接传递。
+class EglEnvironment {
+public:
+    // 失败时抛出 std::runtime_error
+    EglEnvironment();
+    ~EglEnvironment();
+
+    EglEnvironment(const EglEnvironment &) = delete;
+    EglEnvironment &operator=(const EglEnvironment &) = delete;
+
+    EGLDisplay Display() const { return m_display; }
+    EGLSurface DummySurface() const { return m_dummySurface; }
+    EGLContext RootContext() const { return m_rootContext; }
+
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLSurface m_dummySurface = EGL_NO_SURFACE;
+    EGLContext m_rootContext = EGL_NO_CONTEXT;
+};
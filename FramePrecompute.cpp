@@ -0,0 +1,139 @@
+#include "FramePrecompute.h"
+#include "CpuConversion.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace {
+
+class FramePrecomputeImpl final : public FramePrecompute {
+public:
+    FramePrecomputeImpl(OutputModule &outputModule, std::shared_ptr<const GpuFrame> gpuFrame,
+                        const DisplayHdrInfo &hdrInfo, ToneMapOperator op)
+        : m_gpuFrame(std::move(gpuFrame)), m_op(op) {
+        m_worker = std::thread([this, &outputModule, hdrInfo] { Run(outputModule, hdrInfo); });
+    }
+
+    ~FramePrecomputeImpl() override { m_worker.join(); }
+
+    bool Wait() override {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [&] { return m_done; });
+        return m_succeeded;
+    }
+
+    bool TryCrop(const SelectionRect &selection, ImageSink &sink) override {
+        if (!Wait() || sink.PreferredFormat() != OutputPixelFormat::Bgra8) {
+            return false;
+        }
+        const int left = (std::max)(selection.Left(), 0);
+        const int top = (std::max)(selection.Top(), 0);
+        const int right = (std::min)(selection.Right(), static_cast<int>(m_gpuFrame->Width()));
+        const int bottom = (std::min)(selection.Bottom(), static_cast<int>(m_gpuFrame->Height()));
+        const SelectionRect clamped = {left, top, right, bottom};
+        if (!clamped.IsValid()) {
+            return false;
+        }
+
+        const bool useHdrPath = HasHighlight(clamped);
+        const ConvertedImage &source = useHdrPath ? m_result.hdr : m_result.sdr;
+
+        ImageInfo info = source.info;
+        info.width = static_cast<uint32_t>(clamped.Width());
+        info.height = static_cast<uint32_t>(clamped.Height());
+        const size_t sourceRowBytes = source.info.RowBytes();
+        const size_t offsetBytes = static_cast<size_t>(left) * BytesPerPixel(info.format);
+
+        // 选区占满整行时源数据本身就是连续的；否则逐行交给 sink，不做中间拷贝
+        sink.Begin(info);
+        const uint8_t *firstRow = source.pixels.data() + static_cast<size_t>(top) * sourceRowBytes + offsetBytes;
+        if (info.width == source.info.width) {
+            sink.WriteRows(0, info.height, firstRow);
+        } else {
+            for (uint32_t row = 0; row < info.height; ++row) {
+                sink.WriteRows(row, 1, firstRow + row * sourceRowBytes);
+            }
+        }
+        sink.End();
+        LOG("Precomputed frame: cropped (" + std::to_string(left) + "," + std::to_string(top) + ")-(" +
+            std::to_string(right) + "," + std::to_string(bottom) + "), path=" + (useHdrPath ? "HDR" : "linear-sRGB"));
+        return true;
+    }
+
+private:
+    void Run(OutputModule &outputModule, const DisplayHdrInfo &hdrInfo) {
+        const auto start = std::chrono::steady_clock::now();
+        PrecomputedFrame result;
+        bool succeeded = true;
+        try {
+            result = outputModule.PrecomputeFrame(*m_gpuFrame, hdrInfo, m_op);
+        } catch (const std::exception &ex) {
+            LOG("Frame precompute failed: " + std::string(ex.what()));
+            succeeded = false;
+        }
+        if (succeeded) {
+            LOG("Frame precompute finished in " +
+                std::to_string(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) +
+                " ms.");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = std::move(result);
+            m_succeeded = succeeded;
+            m_done = true;
+        }
+        m_finished.notify_all();
+    }
+
+    // 与检测 pass 相同的判定：完全落在选区内的 tile 直接取索引，与选区边界相交且有高光的 tile 读取交集的源像素
+    bool HasHighlight(const SelectionRect &selection) const {
+        constexpr int kTile = static_cast<int>(PrecomputedFrame::kTileSize);
+        const int frameWidth = static_cast<int>(m_gpuFrame->Width());
+        const int frameHeight = static_cast<int>(m_gpuFrame->Height());
+        for (int tileY = selection.Top() / kTile; tileY <= (selection.Bottom() - 1) / kTile; ++tileY) {
+            for (int tileX = selection.Left() / kTile; tileX <= (selection.Right() - 1) / kTile; ++tileX) {
+                if (m_result.highlightTiles[static_cast<size_t>(tileY) * m_result.tilesX + tileX] == 0) {
+                    continue;
+                }
+                const SelectionRect tile = {tileX * kTile, tileY * kTile, (std::min)((tileX + 1) * kTile, frameWidth),
+                                            (std::min)((tileY + 1) * kTile, frameHeight)};
+                const SelectionRect overlap = {(std::max)(tile.x1, selection.Left()),
+                                               (std::max)(tile.y1, selection.Top()),
+                                               (std::min)(tile.x2, selection.Right()),
+                                               (std::min)(tile.y2, selection.Bottom())};
+                if (overlap.Width() == tile.Width() && overlap.Height() == tile.Height()) {
+                    return true;
+                }
+                if (CpuConversion::DetectHighlight(m_gpuFrame->GetCpuFrame(), overlap, m_result.detectionThreshold)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::shared_ptr<const GpuFrame> m_gpuFrame;
+    ToneMapOperator m_op;
+
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+    bool m_done = false;
+    bool m_succeeded = false;
+    PrecomputedFrame m_result; // m_done 之后只读
+    std::thread m_worker;
+};
+
+} // namespace
+
+std::unique_ptr<FramePrecompute> FramePrecompute::Create(OutputModule &outputModule,
+                                                         std::shared_ptr<const GpuFrame> gpuFrame,
+                                                         const DisplayHdrInfo &hdrInfo, ToneMapOperator op) {
+    return std::make_unique<FramePrecomputeImpl>(outputModule, std::move(gpuFrame), hdrInfo, op);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "GpuFrame.h"
+#include "ImageSink.h"
+#include "OutputModule.h"
+#include "SelectionRect.h"
+#include "SystemInfo.h"
+
+#include <cstdint>
+#include <memory>
+
+// 整帧预转换：创建后立即在后台线程调用 OutputModule::PrecomputeFrame，预览窗口显示期间完成。
+// 确认选区时只需按 tile 索引判断路径（边界上有高光的 tile 直接读取 CPU 侧帧数据精确判断），
+// 再从对应路径的整帧结果逐行裁剪写入 sink。只适用于 1x BGRA8 输出。
+// 生存期内由后台线程独占 OutputModule（它不是线程安全的），调用方在 Wait 返回或本对象销毁后才能再使用它
+class FramePrecompute {
+public:
+    virtual ~FramePrecompute() = default;
+
+    // 阻塞直到预转换结束，返回是否成功
+    virtual bool Wait() = 0;
+
+    // 等待预转换结束后裁剪 selection 写入 sink；预转换失败、选区为空或 sink 不是 BGRA8 时返回 false，不写 sink
+    virtual bool TryCrop(const SelectionRect &selection, ImageSink &sink) = 0;
+
+    static std::unique_ptr<FramePrecompute> Create(OutputModule &outputModule,
+                                                   std::shared_ptr<const GpuFrame> gpuFrame,
+                                                   const DisplayHdrInfo &hdrInfo, ToneMapOperator op);
+};
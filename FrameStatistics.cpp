@@ -0,0 +1,189 @@
+#include "FrameStatistics.h"
+#include "CpuConversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t kTile = FrameStatisticsTiles::kTileSize;
+constexpr double kScRgbReferenceWhiteNits = 80.0;
+
+SelectionRect ClampToFrame(const SelectionRect &selection, const GpuFrame &gpuFrame) {
+    return {(std::max)(selection.Left(), 0), (std::max)(selection.Top(), 0),
+            (std::min)(selection.Right(), static_cast<int>(gpuFrame.Width())),
+            (std::min)(selection.Bottom(), static_cast<int>(gpuFrame.Height()))};
+}
+
+} // namespace
+
+FrameStatistics::Sums &FrameStatistics::Sums::operator+=(const Sums &other) {
+    luminance += other.luminance;
+    luminanceSquared += other.luminanceSquared;
+    aboveThreshold += other.aboveThreshold;
+    return *this;
+}
+
+FrameStatistics::Sums &FrameStatistics::Sums::operator-=(const Sums &other) {
+    luminance -= other.luminance;
+    luminanceSquared -= other.luminanceSquared;
+    aboveThreshold -= other.aboveThreshold;
+    return *this;
+}
+
+FrameStatistics::FrameStatistics(std::shared_ptr<const GpuFrame> gpuFrame, float detectionThreshold,
+                                 FrameStatisticsTiles tiles)
+    : m_gpuFrame(std::move(gpuFrame)), m_detectionThreshold(detectionThreshold), m_tiles(std::move(tiles)) {
+    const uint32_t tilesX = m_tiles.tilesX;
+    const uint32_t tilesY = m_tiles.tilesY;
+    const size_t pixels = static_cast<size_t>(tilesX) * tilesY * kTile * kTile;
+    if (tilesX != (m_gpuFrame->Width() + kTile - 1) / kTile || tilesY != (m_gpuFrame->Height() + kTile - 1) / kTile ||
+        m_tiles.sums.size() != 2 * pixels || m_tiles.counts.size() != pixels ||
+        m_tiles.peaks.size() != static_cast<size_t>(tilesX) * tilesY ||
+        m_tiles.offsets.size() != m_tiles.peaks.size()) {
+        throw std::runtime_error("Frame statistics tiles do not match the frame size");
+    }
+
+    // 块总和的前缀和
+    const size_t tileStride = tilesX + 1;
+    m_tileTable.assign(tileStride * (tilesY + 1), Sums{});
+    for (uint32_t tileY = 0; tileY < tilesY; ++tileY) {
+        Sums row;
+        for (uint32_t tileX = 0; tileX < tilesX; ++tileX) {
+            row += LocalSum(tileX, tileY, kTile - 1, kTile - 1);
+            Sums &entry = m_tileTable[(tileY + 1) * tileStride + tileX + 1];
+            entry = m_tileTable[tileY * tileStride + tileX + 1];
+            entry += row;
+        }
+    }
+
+    // 块行内逐像素行、块列内逐像素列的跨块前缀和
+    m_rowTable.assign(static_cast<size_t>(tilesY) * kTile * tileStride, Sums{});
+    for (uint32_t y = 0; y < tilesY * kTile; ++y) {
+        Sums *row = &m_rowTable[static_cast<size_t>(y) * tileStride];
+        for (uint32_t tileX = 0; tileX < tilesX; ++tileX) {
+            row[tileX + 1] = row[tileX];
+            row[tileX + 1] += LocalSum(tileX, y / kTile, kTile - 1, y % kTile);
+        }
+    }
+    const size_t columnStride = tilesY + 1;
+    m_columnTable.assign(static_cast<size_t>(tilesX) * kTile * columnStride, Sums{});
+    for (uint32_t x = 0; x < tilesX * kTile; ++x) {
+        Sums *column = &m_columnTable[static_cast<size_t>(x) * columnStride];
+        for (uint32_t tileY = 0; tileY < tilesY; ++tileY) {
+            column[tileY + 1] = column[tileY];
+            column[tileY + 1] += LocalSum(x / kTile, tileY, x % kTile, kTile - 1);
+        }
+    }
+}
+
+// Σ(l - c) 与 Σ(l - c)² 还原为 Σl = Σ(l - c) + n·c、Σl² = Σ(l - c)² + 2c·Σ(l - c) + n·c²，n 只计帧内像素
+FrameStatistics::Sums FrameStatistics::LocalSum(uint32_t tileX, uint32_t tileY, uint32_t x, uint32_t y) const {
+    const size_t tile = static_cast<size_t>(tileY) * m_tiles.tilesX + tileX;
+    const size_t index = tile * kTile * kTile + y * kTile + x;
+    const double centered = m_tiles.sums[2 * index];
+    const double centeredSquared = m_tiles.sums[2 * index + 1];
+    const double offset = m_tiles.offsets[tile];
+    const uint32_t columns = (std::min)(x + 1, m_gpuFrame->Width() - tileX * kTile);
+    const uint32_t rows = (std::min)(y + 1, m_gpuFrame->Height() - tileY * kTile);
+    const double count = static_cast<double>(columns) * rows;
+    return {centered + count * offset, centeredSquared + 2.0 * offset * centered + count * offset * offset,
+            static_cast<double>(m_tiles.counts[index])};
+}
+
+// 左上方的完整块、同一块行中左侧各块的上半部分、同一块列中上方各块的左半部分，加上所在块内的部分
+FrameStatistics::Sums FrameStatistics::PrefixSum(uint32_t px, uint32_t py) const {
+    const uint32_t tileX = px / kTile;
+    const uint32_t tileY = py / kTile;
+    const uint32_t localX = px % kTile;
+    const uint32_t localY = py % kTile;
+    Sums sum = m_tileTable[static_cast<size_t>(tileY) * (m_tiles.tilesX + 1) + tileX];
+    if (localY > 0) {
+        sum += m_rowTable[static_cast<size_t>(py - 1) * (m_tiles.tilesX + 1) + tileX];
+    }
+    if (localX > 0) {
+        sum += m_columnTable[static_cast<size_t>(px - 1) * (m_tiles.tilesY + 1) + tileY];
+    }
+    if (localX > 0 && localY > 0) {
+        sum += LocalSum(tileX, tileY, localX - 1, localY - 1);
+    }
+    return sum;
+}
+
+FrameStatistics::Sums FrameStatistics::RectSum(const SelectionRect &rect) const {
+    const auto left = static_cast<uint32_t>(rect.Left());
+    const auto top = static_cast<uint32_t>(rect.Top());
+    const auto right = static_cast<uint32_t>(rect.Right());
+    const auto bottom = static_cast<uint32_t>(rect.Bottom());
+    Sums sum = PrefixSum(right, bottom);
+    sum -= PrefixSum(left, bottom);
+    sum -= PrefixSum(right, top);
+    sum += PrefixSum(left, top);
+    return sum;
+}
+
+// 完全落在矩形内的块直接取峰值；与边界相交的块只有峰值高于当前结果时才读取交集的源像素
+double FrameStatistics::PeakLuminance(const SelectionRect &rect) const {
+    const int tile = static_cast<int>(kTile);
+    const int frameWidth = static_cast<int>(m_gpuFrame->Width());
+    const int frameHeight = static_cast<int>(m_gpuFrame->Height());
+    std::vector<SelectionRect> partialTiles;
+    float peak = 0.0f;
+    for (int tileY = rect.Top() / tile; tileY <= (rect.Bottom() - 1) / tile; ++tileY) {
+        for (int tileX = rect.Left() / tile; tileX <= (rect.Right() - 1) / tile; ++tileX) {
+            const SelectionRect bounds = {tileX * tile, tileY * tile, (std::min)((tileX + 1) * tile, frameWidth),
+                                          (std::min)((tileY + 1) * tile, frameHeight)};
+            const SelectionRect overlap = {(std::max)(bounds.x1, rect.Left()), (std::max)(bounds.y1, rect.Top()),
+                                           (std::min)(bounds.x2, rect.Right()), (std::min)(bounds.y2, rect.Bottom())};
+            const float tilePeak = m_tiles.peaks[static_cast<size_t>(tileY) * m_tiles.tilesX + tileX];
+            if (overlap.Width() == bounds.Width() && overlap.Height() == bounds.Height()) {
+                peak = (std::max)(peak, tilePeak);
+            } else {
+                partialTiles.push_back(overlap);
+            }
+        }
+    }
+    for (const SelectionRect &overlap : partialTiles) {
+        const int tileX = overlap.Left() / tile;
+        const int tileY = overlap.Top() / tile;
+        if (m_tiles.peaks[static_cast<size_t>(tileY) * m_tiles.tilesX + tileX] > peak) {
+            peak = (std::max)(peak, CpuConversion::PeakLuminance(m_gpuFrame->GetCpuFrame(), overlap));
+        }
+    }
+    return peak * kScRgbReferenceWhiteNits;
+}
+
+LuminanceStatistics FrameStatistics::Query(const SelectionRect &selection) const {
+    const SelectionRect rect = ClampToFrame(selection, *m_gpuFrame);
+    LuminanceStatistics statistics;
+    if (!rect.IsValid()) {
+        return statistics;
+    }
+
+    const Sums sum = RectSum(rect);
+    statistics.pixelCount = static_cast<uint64_t>(rect.Width()) * static_cast<uint64_t>(rect.Height());
+    const double count = static_cast<double>(statistics.pixelCount);
+    const double mean = sum.luminance / count;
+    statistics.meanNits = mean * kScRgbReferenceWhiteNits;
+    statistics.stdDevNits =
+        std::sqrt((std::max)(sum.luminanceSquared / count - mean * mean, 0.0)) * kScRgbReferenceWhiteNits;
+    statistics.peakNits = PeakLuminance(rect);
+    statistics.aboveSdrWhiteFraction = sum.aboveThreshold / count;
+    return statistics;
+}
+
+bool FrameStatistics::HasHighlight(const SelectionRect &selection) const {
+    const SelectionRect rect = ClampToFrame(selection, *m_gpuFrame);
+    return rect.IsValid() && RectSum(rect).aboveThreshold > 0.0; // 计数以 double 累加，没有舍入误差
+}
+
+uint64_t FrameStatistics::EstimateBytes(uint32_t width, uint32_t height) {
+    const uint64_t tilesX = (width + kTile - 1) / kTile;
+    const uint64_t tilesY = (height + kTile - 1) / kTile;
+    const uint64_t tilePixels = tilesX * tilesY * kTile * kTile;
+    const uint64_t perPixel = 2 * sizeof(float) + sizeof(uint16_t);
+    const uint64_t crossTile = (tilesY * kTile * (tilesX + 1) + tilesX * kTile * (tilesY + 1) +
+                                (tilesX + 1) * (tilesY + 1)) * sizeof(Sums);
+    return tilePixels * perPixel + crossTile + tilesX * tilesY * 2 * sizeof(float);
+}
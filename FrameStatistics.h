@@ -0,0 +1,77 @@
+#pragma once
+
+#include "GpuFrame.h"
+#include "SelectionRect.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 一个矩形内的亮度统计。亮度为 BT.709 线性亮度（负分量按 0 计），换算为 nits（scRGB 1.0 = 80 nits）
+struct LuminanceStatistics {
+    uint64_t pixelCount = 0;
+    double meanNits = 0.0;
+    double stdDevNits = 0.0;
+    double peakNits = 0.0;
+    double aboveSdrWhiteFraction = 0.0; // 任一通道超过检测阈值的像素比例，非 0 时检测 pass 会选择 HDR 路径
+};
+
+// OutputModule::ComputeFrameStatistics 在 GPU 上生成的原始数据：帧按 kTileSize 分块，每块一张块内的
+// 包含式求和面积表，以及每块的亮度峰值。亮度以块的偏移值（块内的平均亮度）为原点累加，帧外像素等于偏移值，
+// 即对和没有贡献。块按行优先排列，亮度均为 scRGB 单位
+struct FrameStatisticsTiles {
+    static constexpr uint32_t kTileSize = 32;
+
+    uint32_t tilesX = 0;
+    uint32_t tilesY = 0;
+    std::vector<float> sums;      // 每个像素 (Σ (亮度 - 偏移), Σ (亮度 - 偏移)²)，块内行优先
+    std::vector<uint16_t> counts; // 每个像素 Σ 超过阈值的像素数，排列同 sums
+    std::vector<float> peaks;     // 每块的亮度峰值
+    std::vector<float> offsets;   // 每块的偏移值
+};
+
+// 整帧的亮度求和面积表：任意矩形的均值、方差与超过 SDR 白的比例都是常数次查表，与矩形大小无关。
+// 块内的表由 GPU 以 float 累加（每块至多 1024 项，且以块内像素为原点），在 CPU 上还原为 double 后
+// 再组合块之间的前缀和，因此大帧的右下角与平坦区域的方差都不会损失精度。峰值不可相减，取完全落在矩形内的
+// 块的峰值，与边界相交且可能更高的块读取 CPU 侧帧数据精确计算，开销与矩形周长成正比。
+// 构建后只读，可以在多个线程上同时查询
+class FrameStatistics {
+public:
+    FrameStatistics(std::shared_ptr<const GpuFrame> gpuFrame, float detectionThreshold, FrameStatisticsTiles tiles);
+
+    // selection 先钳制到帧内，为空时返回全 0
+    LuminanceStatistics Query(const SelectionRect &selection) const;
+
+    // 选区内是否有像素超过检测阈值，与检测 pass 的结果相同
+    bool HasHighlight(const SelectionRect &selection) const;
+
+    const GpuFrame &Frame() const { return *m_gpuFrame; }
+    float DetectionThreshold() const { return m_detectionThreshold; }
+
+    // 块内的表与块间前缀和所需的内存
+    static uint64_t EstimateBytes(uint32_t width, uint32_t height);
+
+private:
+    struct Sums {
+        double luminance = 0.0;
+        double luminanceSquared = 0.0;
+        double aboveThreshold = 0.0;
+
+        Sums &operator+=(const Sums &other);
+        Sums &operator-=(const Sums &other);
+    };
+
+    // 块 (tileX, tileY) 内 (x, y) 处的包含式前缀和，已还原为以 0 为原点
+    Sums LocalSum(uint32_t tileX, uint32_t tileY, uint32_t x, uint32_t y) const;
+    // 帧内 x < px、y < py 的像素之和，0 <= px <= 宽，0 <= py <= 高
+    Sums PrefixSum(uint32_t px, uint32_t py) const;
+    Sums RectSum(const SelectionRect &rect) const;
+    double PeakLuminance(const SelectionRect &rect) const;
+
+    std::shared_ptr<const GpuFrame> m_gpuFrame;
+    float m_detectionThreshold;
+    FrameStatisticsTiles m_tiles;
+    std::vector<Sums> m_tileTable;   // (tilesY + 1) x (tilesX + 1)，块总和的排除式前缀和
+    std::vector<Sums> m_rowTable;    // 每个像素行 x (tilesX + 1)：同一块行中左侧各块在该行及以上的和
+    std::vector<Sums> m_columnTable; // 每个像素列 x (tilesY + 1)：同一块列中上方各块在该列及以左的和
+};
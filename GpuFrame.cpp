@@ -8,6 +8,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -35,8 +36,10 @@ std::string DescribeEglError(EGLint error) {
 
 class GpuFrameImpl final : public GpuFrame {
 public:
-    GpuFrameImpl(const CapturedFrame &frame, EGLDisplay display, EGLSurface dummySurface, EGLContext context)
-        : m_display(display), m_surface(dummySurface), m_context(context) {
+    GpuFrameImpl(std::shared_ptr<const CapturedFrame> cpuFrame, EGLDisplay display, EGLSurface dummySurface,
+                 EGLContext context)
+        : m_display(display), m_surface(dummySurface), m_context(context), m_cpuFrame(std::move(cpuFrame)) {
+        const CapturedFrame &frame = *m_cpuFrame;
         LOG("GpuFrame: 上传纹理 " + std::to_string(frame.metadata.width) +
             "x" + std::to_string(frame.metadata.height) + "...");
 
@@ -102,6 +105,7 @@ public:
     GLuint      GetTextureId() const override { return m_texture;  }
     uint32_t    Width()        const override { return m_width;    }
     uint32_t    Height()       const override { return m_height;   }
+    const CapturedFrame &GetCpuFrame() const override { return *m_cpuFrame; }
 
 private:
     EGLDisplay  m_display = EGL_NO_DISPLAY;
@@ -110,10 +114,12 @@ private:
     GLuint      m_texture = 0;
     uint32_t    m_width   = 0;
     uint32_t    m_height  = 0;
+    std::shared_ptr<const CapturedFrame> m_cpuFrame;
 };
 
 } // namespace
 
-std::shared_ptr<GpuFrame> GpuFrame::Create(const CapturedFrame &frame, EGLDisplay display, EGLSurface dummySurface, EGLContext context) {
-    return std::make_shared<GpuFrameImpl>(frame, display, dummySurface, context);
+std::shared_ptr<GpuFrame> GpuFrame::Create(std::shared_ptr<const CapturedFrame> frame, EGLDisplay display,
+                                           EGLSurface dummySurface, EGLContext context) {
+    return std::make_shared<GpuFrameImpl>(std::move(frame), display, dummySurface, context);
 }
@@ -23,6 +23,10 @@ public:
     virtual uint32_t Width() const = 0;
     virtual uint32_t Height() const = 0;
 
+    // 上传所用的 CPU 侧帧数据，随本对象一起保留，供小选区的 CPU 转换直接读取
+    virtual const CapturedFrame &GetCpuFrame() const = 0;
+
     // 从 CPU 内存数据创建 GpuFrame：需要在已有的 EGL 环境下调用
-    static std::shared_ptr<GpuFrame> Create(const CapturedFrame &frame, EGLDisplay display, EGLSurface dummySurface, EGLContext context);
+    static std::shared_ptr<GpuFrame> Create(std::shared_ptr<const CapturedFrame> frame, EGLDisplay display,
+                                            EGLSurface dummySurface, EGLContext context);
 };
@@ -0,0 +1,202 @@
+#include "GpuTimer.h"
+#include "Logger.h"
+
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+bool HasGlExtension(const char *name) {
+    const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+    if (!extensions) {
+        return false;
+    }
+    const size_t length = std::strlen(name);
+    for (const char *found = std::strstr(extensions, name); found; found = std::strstr(found + length, name)) {
+        const bool startsWord = found == extensions || found[-1] == ' ';
+        const bool endsWord = found[length] == ' ' || found[length] == '\0';
+        if (startsWord && endsWord) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t CpuTicks() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+
+double TicksToMs(int64_t ticks) {
+    using Period = std::chrono::steady_clock::period;
+    return static_cast<double>(ticks) * 1000.0 * Period::num / Period::den;
+}
+
+// 已排序样本的最近秩百分位
+double Percentile(const std::vector<double> &sorted, double fraction) {
+    const size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[(std::min)(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+void TimingStats::Add(std::string_view stage, bool gpuTimed, double ms) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_stages.begin(), m_stages.end(), [&](const Stage &entry) { return entry.name == stage; });
+    if (it == m_stages.end()) {
+        m_stages.push_back(Stage{std::string(stage)});
+        it = m_stages.end() - 1;
+    }
+
+    it->gpuTimed = gpuTimed;
+    it->last = ms;
+    if (it->samples.size() < kTimingWindow) {
+        it->samples.push_back(ms);
+    } else {
+        it->samples[it->next] = ms;
+    }
+    it->next = (it->next + 1) % kTimingWindow;
+}
+
+std::vector<StageTimingStats> TimingStats::Snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<StageTimingStats> result;
+    for (const auto &stage : m_stages) {
+        std::vector<double> sorted = stage.samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        StageTimingStats stats{};
+        stats.stage    = stage.name;
+        stats.gpuTimed = stage.gpuTimed;
+        stats.samples  = sorted.size();
+        stats.lastMs   = stage.last;
+        stats.p50Ms    = Percentile(sorted, 0.50);
+        stats.p90Ms    = Percentile(sorted, 0.90);
+        stats.p99Ms    = Percentile(sorted, 0.99);
+        stats.maxMs    = sorted.back();
+        result.push_back(stats);
+    }
+    return result;
+}
+
+std::string TimingStats::Describe() const {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (const auto &stats : Snapshot()) {
+        stream << (first ? "" : "; ") << stats.stage << (stats.gpuTimed ? " [gpu] " : " [cpu] ") << stats.lastMs
+               << " ms (p50 " << stats.p50Ms << ", p90 " << stats.p90Ms << ", p99 " << stats.p99Ms << ", n="
+               << stats.samples << ")";
+        first = false;
+    }
+    return stream.str();
+}
+
+GpuStageTimer::GpuStageTimer(TimingStats &stats) : m_stats(stats) {
+    if (HasGlExtension("GL_EXT_disjoint_timer_query")) {
+        m_getQueryObjectui64v =
+            reinterpret_cast<GetQueryObjectui64vProc>(eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    }
+    if (m_getQueryObjectui64v) {
+        LOG("GpuStageTimer: using GL_EXT_disjoint_timer_query.");
+    } else {
+        LOG("GpuStageTimer: GL_EXT_disjoint_timer_query unavailable, falling back to CPU timing with glFinish.");
+    }
+    // 清掉之前遗留的 disjoint 状态
+    if (HasGpuTimer()) {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+}
+
+GpuStageTimer::~GpuStageTimer() {
+    for (const auto &pending : m_pending) {
+        m_freeQueries.push_back(pending.query);
+    }
+    if (!m_freeQueries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+    }
+}
+
+GLuint GpuStageTimer::AcquireQuery() {
+    if (m_freeQueries.empty()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        return query;
+    }
+    const GLuint query = m_freeQueries.back();
+    m_freeQueries.pop_back();
+    return query;
+}
+
+void GpuStageTimer::Begin(const char *stage) {
+    m_activeStage = stage;
+    m_cpuStartTicks = CpuTicks();
+    if (HasGpuTimer()) {
+        m_activeQuery = AcquireQuery();
+        glBeginQuery(GL_TIME_ELAPSED_EXT, m_activeQuery);
+    }
+}
+
+void GpuStageTimer::End() {
+    if (!m_activeStage) {
+        return;
+    }
+    if (HasGpuTimer()) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        m_pending.push_back({m_activeQuery, m_activeStage, m_cpuStartTicks});
+        m_activeQuery = 0;
+    } else {
+        glFinish();
+        m_stats.Add(m_activeStage, false, TicksToMs(CpuTicks() - m_cpuStartTicks));
+    }
+    m_activeStage = nullptr;
+}
+
+void GpuStageTimer::Collect(bool wait) {
+    if (!HasGpuTimer() || m_pending.empty()) {
+        return;
+    }
+
+    const int64_t now = CpuTicks();
+    size_t completed = 0;
+    size_t implausible = 0;
+    std::vector<std::pair<const char *, double>> results;
+    for (const auto &pending : m_pending) {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && !wait) {
+            break;
+        }
+        uint64_t elapsedNs = 0;
+        m_getQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsedNs);
+        m_freeQueries.push_back(pending.query);
+        ++completed;
+
+        // GPU 耗时不可能超过从 Begin 到现在的挂钟时间；部分驱动的首个查询会返回这类无效值
+        const double ms = static_cast<double>(elapsedNs) / 1e6;
+        if (ms > TicksToMs(now - pending.cpuBeginTicks)) {
+            ++implausible;
+            continue;
+        }
+        results.emplace_back(pending.stage, ms);
+    }
+    if (implausible != 0) {
+        LOG("GpuStageTimer: dropped " + std::to_string(implausible) + " implausible samples.");
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(completed));
+
+    // 期间发生过 disjoint 事件（如频率切换、GPU 重置）时结果不可信，整批丢弃
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        LOG("GpuStageTimer: disjoint event, dropping " + std::to_string(results.size()) + " samples.");
+        return;
+    }
+    for (const auto &[stage, ms] : results) {
+        m_stats.Add(stage, true, ms);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 单个阶段最近 kTimingWindow 次的耗时统计
+struct StageTimingStats {
+    std::string stage;
+    bool gpuTimed;  // true：GPU 计时查询；false：CPU 挂钟时间（扩展不可用，或阶段本身发生在 CPU 侧）
+    size_t samples; // 窗口内的样本数
+    double lastMs;
+    double p50Ms;
+    double p90Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+// 按阶段保存滚动窗口内的耗时样本。线程安全，统计可在任意线程读取
+class TimingStats {
+public:
+    static constexpr size_t kTimingWindow = 128;
+
+    void Add(std::string_view stage, bool gpuTimed, double ms);
+    std::vector<StageTimingStats> Snapshot() const;
+    // 单行摘要，用于日志
+    std::string Describe() const;
+
+private:
+    struct Stage {
+        std::string name;
+        bool gpuTimed = false;
+        std::vector<double> samples{}; // 环形缓冲区
+        size_t next = 0;
+        double last = 0.0;
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Stage> m_stages; // 保持首次出现的顺序
+};
+
+// 基于 EXT_disjoint_timer_query 的 GPU 阶段计时，结果写入 TimingStats。
+// 构造、Begin/End、Collect 与析构都要求创建时的 context 为 current。
+// 扩展不可用时（如软件 GL）退化为 CPU 计时：阶段结束时 glFinish，统计中标记 gpuTimed=false。
+// GL_TIME_ELAPSED 查询不能嵌套，阶段必须依次排列。
+class GpuStageTimer {
+public:
+    explicit GpuStageTimer(TimingStats &stats);
+    ~GpuStageTimer();
+
+    GpuStageTimer(const GpuStageTimer &) = delete;
+    GpuStageTimer &operator=(const GpuStageTimer &) = delete;
+
+    bool HasGpuTimer() const { return m_getQueryObjectui64v != nullptr; }
+
+    // stage 须为字符串字面量，查询完成前只保存指针
+    void Begin(const char *stage);
+    void End();
+
+    // 取回已完成的查询结果；wait 为 false 时不阻塞，未完成的留待下次
+    void Collect(bool wait);
+
+    // 在作用域内计时一个阶段
+    class Scope {
+    public:
+        Scope(GpuStageTimer *timer, const char *stage) : m_timer(timer) {
+            if (m_timer) m_timer->Begin(stage);
+        }
+        ~Scope() {
+            if (m_timer) m_timer->End();
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        GpuStageTimer *m_timer;
+    };
+
+private:
+    using GetQueryObjectui64vProc = void(GL_APIENTRY *)(GLuint id, GLenum pname, uint64_t *params);
+
+    struct PendingQuery {
+        GLuint query;
+        const char *stage;
+        int64_t cpuBeginTicks;
+    };
+
+    GLuint AcquireQuery();
+
+    TimingStats &m_stats;
+    GetQueryObjectui64vProc m_getQueryObjectui64v = nullptr;
+    std::vector<GLuint> m_freeQueries;
+    std::vector<PendingQuery> m_pending;
+    GLuint m_activeQuery = 0;
+    const char *m_activeStage = nullptr;
+    int64_t m_cpuStartTicks = 0;
+};
@@ -0,0 +1,659 @@
+#include "HeadlessCommands.h"
+#include "BatchConverter.h"
+#include "CpuConversion.h"
+#include "EglEnvironment.h"
+#include "FramePrecompute.h"
+#include "GpuFrame.h"
+#include "OutputModule.h"
+#include "QoiCodec.h"
+#include "RawFrameFile.h"
+#include "TransferLut.h"
+#include "TuningCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::filesystem::path PathFromUtf8(const std::string &text) {
+    return std::filesystem::path(std::u8string(text.begin(), text.end()));
+}
+
+void PrintBatchUsage() {
+    std::cerr << "Usage: printscr --batch <input-dir> <output-dir> [--format png|exr|uhdr|qoi|qoi16] "
+                 "[--tonemap <name>] [--local-tonemap] [--threads N] [--jpeg-quality N] [--sdr-white <nits>] "
+                 "[--scale <factor|Npx>]... [--filter lanczos|box] [--backend auto|compute|fragment|cpu|vulkan] "
+                 "[--region x,y,w,h]... [--redact x,y,w,h]... [--redact-style mosaic|blur] [--redact-size N] "
+                 "[--color-lut <file.cube|.icc>] [--gpu-timing]"
+              << std::endl;
+}
+
+std::optional<BatchOptions> ParseBatchArguments(const std::vector<std::string> &args) {
+    if (args.size() < 3 || args[0] != "--batch") {
+        return std::nullopt;
+    }
+
+    BatchOptions options;
+    options.inputDirectory = PathFromUtf8(args[1]);
+    options.outputDirectory = PathFromUtf8(args[2]);
+    bool explicitScales = false;
+
+    for (size_t i = 3; i < args.size(); ++i) {
+        const std::string &name = args[i];
+        if (name == "--gpu-timing") {
+            options.stageTiming = true;
+            continue;
+        }
+        if (name == "--local-tonemap") {
+            options.conversion.localToneMapping = true;
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            std::cerr << "Missing value for " << name << std::endl;
+            return std::nullopt;
+        }
+        const std::string &value = args[++i];
+
+        if (name == "--format") {
+            if (value == "png") {
+                options.outputFormat = BatchOutputFormat::Png;
+            } else if (value == "exr") {
+                options.outputFormat = BatchOutputFormat::Exr;
+            } else if (value == "uhdr") {
+                options.outputFormat = BatchOutputFormat::UltraHdr;
+            } else if (value == "qoi") {
+                options.outputFormat = BatchOutputFormat::Qoi;
+            } else if (value == "qoi16") {
+                options.outputFormat = BatchOutputFormat::Qoi16;
+            } else {
+                std::cerr << "Unknown output format: " << value << std::endl;
+                return std::nullopt;
+            }
+        } else if (name == "--tonemap") {
+            auto op = ParseToneMapOperator(value);
+            if (!op) {
+                std::cerr << "Unknown tone-mapping operator: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.conversion.toneMapOperator = *op;
+        } else if (name == "--scale") {
+            auto scale = ParseOutputScale(value);
+            if (!scale) {
+                std::cerr << "Invalid output scale: " << value << std::endl;
+                return std::nullopt;
+            }
+            // 第一个 --scale 替换默认的 1x 输出
+            if (!explicitScales) {
+                options.scales.clear();
+                explicitScales = true;
+            }
+            options.scales.push_back(*scale);
+        } else if (name == "--filter") {
+            auto filter = ParseScaleFilter(value);
+            if (!filter) {
+                std::cerr << "Unknown scale filter: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.conversion.scaleFilter = *filter;
+        } else if (name == "--backend") {
+            auto backend = ParseConversionBackend(value);
+            if (!backend) {
+                std::cerr << "Unknown conversion backend: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.conversion.backend = *backend;
+        } else if (name == "--region") {
+            auto region = ParseSelectionRect(value);
+            if (!region) {
+                std::cerr << "Invalid region: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.regions.push_back(*region);
+        } else if (name == "--redact") {
+            auto rect = ParseSelectionRect(value);
+            if (!rect) {
+                std::cerr << "Invalid redaction rectangle: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.conversion.redactions.push_back(*rect);
+        } else if (name == "--redact-style") {
+            auto style = ParseRedactionStyle(value);
+            if (!style) {
+                std::cerr << "Unknown redaction style: " << value << std::endl;
+                return std::nullopt;
+            }
+            options.conversion.redactionStyle = *style;
+        } else if (name == "--redact-size") {
+            options.conversion.redactionSize = static_cast<uint32_t>(std::stoul(value));
+        } else if (name == "--color-lut") {
+            try {
+                options.conversion.colorLut = ColorLut::Load(PathFromUtf8(value));
+            } catch (const std::exception &ex) {
+                std::cerr << "Cannot load color LUT: " << ex.what() << std::endl;
+                return std::nullopt;
+            }
+        } else if (name == "--threads") {
+            options.encoderThreads = static_cast<unsigned>(std::stoul(value));
+        } else if (name == "--sdr-white") {
+            options.sdrWhiteOverride = std::stof(value);
+        } else if (name == "--jpeg-quality") {
+            options.jpegQuality = std::clamp(std::stoi(value), 1, 100);
+        } else {
+            std::cerr << "Unknown option: " << name << std::endl;
+            return std::nullopt;
+        }
+    }
+    if (!options.regions.empty() && explicitScales) {
+        std::cerr << "--region cannot be combined with --scale" << std::endl;
+        return std::nullopt;
+    }
+    if (options.outputFormat == BatchOutputFormat::UltraHdr && explicitScales) {
+        std::cerr << "--format uhdr supports only 1x output" << std::endl;
+        return std::nullopt;
+    }
+    return options;
+}
+
+void PrintPrecomputeBenchmarkUsage() {
+    std::cerr << "Usage: printscr --bench-precompute <frame.scrgb> [--tonemap <name>] [--iterations N] "
+                 "[--region x,y,w,h]..."
+              << std::endl;
+}
+
+void PrintStatisticsBenchmarkUsage() {
+    std::cerr << "Usage: printscr --bench-statistics <frame.scrgb> [--queries N] [--region x,y,w,h]..." << std::endl;
+}
+
+void PrintLosslessBenchmarkUsage() {
+    std::cerr << "Usage: printscr --bench-lossless <frame.scrgb> [--tonemap <name>] [--iterations N]" << std::endl;
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+template <typename Function>
+double MedianMs(int iterations, Function &&function) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return Median(std::move(samples));
+}
+
+void PrintTransferLutReport(const char *path, const TransferLut::VerifyReport &report) {
+    std::cout << path << ":" << std::endl;
+    for (const auto &chain : report.chains) {
+        std::cout << "  " << TransferLut::ChainName(chain.chain) << ": max code error=" << chain.maxCodeError
+                  << ", max fractional error=" << chain.maxFractionalError << " codes" << std::endl;
+    }
+}
+
+} // namespace
+
+void PrintStageTimings(const std::vector<StageTimingStats> &timings) {
+    if (timings.empty()) {
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Stage timing (last " << TimingStats::kTimingWindow << " samples):" << std::endl;
+    for (const auto &stats : timings) {
+        std::cout << "  " << std::left << std::setw(12) << stats.stage << std::right
+                  << (stats.gpuTimed ? " gpu " : " cpu ") << "p50 " << stats.p50Ms << " ms, p90 " << stats.p90Ms
+                  << " ms, p99 " << stats.p99Ms << " ms, max " << stats.maxMs << " ms (n=" << stats.samples << ")"
+                  << std::endl;
+    }
+}
+
+// CPU 查表链与 GPU 上实际采样 R16F 纹理的结果都要与精确结果比较；GPU 读回的是 8-bit 码值，
+// 其连续误差包含输出量化（最多 0.5 个码值）
+int RunTransferLutVerifier() {
+    const TransferLut::VerifyReport cpuReport = TransferLut::Verify();
+    PrintTransferLutReport("CPU", cpuReport);
+
+    bool withinBudget = cpuReport.withinBudget;
+    try {
+        EglEnvironment egl;
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        const TransferLut::VerifyReport gpuReport = outputModule->VerifyTransferLut();
+        PrintTransferLutReport("GPU", gpuReport);
+        withinBudget = withinBudget && gpuReport.withinBudget;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: GPU check failed: " << ex.what() << std::endl;
+        return 1;
+    }
+    std::cout << (withinBudget ? "Transfer LUTs within budget." : "Transfer LUTs exceed error budget!") << std::endl;
+    return withinBudget ? 0 : 1;
+}
+
+int RunAutotuneCommand() {
+    try {
+        EglEnvironment egl;
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        const AutotuneReport report = outputModule->RunAutotune();
+
+        std::cout << std::fixed << std::setprecision(3);
+        if (!report.kernels.empty()) {
+            std::cout << "Kernel variants (p50, " << (report.kernels.front().gpuTimed ? "gpu" : "cpu with glFinish")
+                      << "), fastest processing first:" << std::endl;
+            for (const auto &result : report.kernels) {
+                std::cout << "  " << std::left << std::setw(12) << result.kernel << std::right << " detect "
+                          << result.detectMs << " ms, process " << result.processMs << " ms" << std::endl;
+            }
+        }
+        if (!report.costModels.empty()) {
+            std::cout << "Cost models (end-to-end latency per call):" << std::endl;
+            for (const auto &model : report.costModels) {
+                std::cout << "  " << std::left << std::setw(12) << ConversionBackendName(model.backend) << std::right
+                          << " " << model.overheadMs << " ms + " << model.msPerMegapixel << " ms/MP" << std::endl;
+            }
+        }
+        std::cout << "GPU backend when the cost models do not apply: " << ConversionBackendName(report.selected)
+                  << std::endl;
+        if (!report.kernels.empty() || !report.costModels.empty()) {
+            std::cout << "Saved to " << TuningCache::DefaultPath().string() << std::endl;
+        }
+        return 0;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
+
+int RunPrecomputeBenchmark(const std::vector<std::string> &args) {
+    if (args.size() < 2 || args[0] != "--bench-precompute") {
+        PrintPrecomputeBenchmarkUsage();
+        return 1;
+    }
+    ConversionOptions options;
+    int iterations = 10;
+    std::vector<SelectionRect> selections;
+    try {
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--tonemap" && ParseToneMapOperator(args[i + 1])) {
+                options.toneMapOperator = *ParseToneMapOperator(args[i + 1]);
+            } else if (args[i] == "--iterations") {
+                iterations = (std::max)(std::stoi(args[i + 1]), 1);
+            } else if (args[i] == "--region" && ParseSelectionRect(args[i + 1])) {
+                selections.push_back(*ParseSelectionRect(args[i + 1]));
+            } else {
+                PrintPrecomputeBenchmarkUsage();
+                return 1;
+            }
+        }
+        if (args.size() % 2 != 0) {
+            PrintPrecomputeBenchmarkUsage();
+            return 1;
+        }
+    } catch (const std::exception &) {
+        PrintPrecomputeBenchmarkUsage();
+        return 1;
+    }
+
+    try {
+        const RawFrameFile raw = ReadRawFrameFile(PathFromUtf8(args[1]));
+        EglEnvironment egl;
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        std::shared_ptr<const GpuFrame> gpuFrame =
+            GpuFrame::Create(raw.frame, egl.Display(), egl.DummySurface(), egl.RootContext());
+        const int width = static_cast<int>(gpuFrame->Width());
+        const int height = static_cast<int>(gpuFrame->Height());
+        if (selections.empty()) {
+            // 整帧、居中的四分之一、以及不与 tile 对齐的中小选区
+            selections = {{0, 0, width, height},
+                          {width / 4, height / 4, width * 3 / 4, height * 3 / 4},
+                          {37, 29, (std::min)(37 + 512, width), (std::min)(29 + 512, height)},
+                          {5, 3, (std::min)(5 + 64, width), (std::min)(3 + 64, height)}};
+        }
+
+        // 预热：调优、着色器编译与延迟模型标定不计入
+        {
+            MemorySink sink;
+            outputModule->ConvertSelectionToSink(*gpuFrame, selections.front(), raw.hdrInfo, options, sink);
+            FramePrecompute::Create(*outputModule, gpuFrame, raw.hdrInfo, options.toneMapOperator)->Wait();
+        }
+
+        std::unique_ptr<FramePrecompute> precompute;
+        const double precomputeMs = MedianMs(3, [&] {
+            precompute = FramePrecompute::Create(*outputModule, gpuFrame, raw.hdrInfo, options.toneMapOperator);
+            if (!precompute->Wait()) {
+                throw std::runtime_error("Frame precompute failed");
+            }
+        });
+        const double megabyte = 1024.0 * 1024.0;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Frame " << width << "x" << height << ": precompute " << precomputeMs << " ms (p50), "
+                  << PrecomputedFrame::EstimateBytes(gpuFrame->Width(), gpuFrame->Height()) / megabyte << " MiB"
+                  << std::endl;
+        std::cout << "Confirm-to-sink latency (p50 of " << iterations << "), current path vs crop:" << std::endl;
+
+        bool allIdentical = true;
+        ConversionOptions computeOptions = options;
+        computeOptions.backend = ConversionBackend::Compute;
+        for (const auto &selection : selections) {
+            MemorySink direct;
+            MemorySink cropped;
+            const double directMs = MedianMs(iterations, [&] {
+                outputModule->ConvertSelectionToSink(*gpuFrame, selection, raw.hdrInfo, options, direct);
+            });
+            const double cropMs = MedianMs(iterations, [&] {
+                if (!precompute->TryCrop(selection, cropped)) {
+                    throw std::runtime_error("Crop failed");
+                }
+            });
+
+            // 预转换使用计算着色器，以计算后端的结果为参照
+            MemorySink reference;
+            outputModule->ConvertSelectionToSink(*gpuFrame, selection, raw.hdrInfo, computeOptions, reference);
+            const bool identical = reference.Image().pixels == cropped.Image().pixels &&
+                                   reference.Image().info.hdrPath == cropped.Image().info.hdrPath;
+            allIdentical = allIdentical && identical;
+            std::cout << "  " << std::left << std::setw(12)
+                      << (std::to_string(selection.Width()) + "x" + std::to_string(selection.Height())) << std::right
+                      << " current " << std::setw(9) << directMs << " ms, crop " << std::setw(9) << cropMs
+                      << " ms, path " << (cropped.Image().info.hdrPath ? "HDR" : "SDR")
+                      << (identical ? ", identical to compute backend" : ", DIFFERS from compute backend")
+                      << std::endl;
+        }
+        return allIdentical ? 0 : 1;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
+
+int RunStatisticsBenchmark(const std::vector<std::string> &args) {
+    if (args.size() < 2 || args[0] != "--bench-statistics" || args.size() % 2 != 0) {
+        PrintStatisticsBenchmarkUsage();
+        return 1;
+    }
+    int queries = 200;
+    std::vector<SelectionRect> selections;
+    try {
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--queries") {
+                queries = (std::max)(std::stoi(args[i + 1]), 1);
+            } else if (args[i] == "--region" && ParseSelectionRect(args[i + 1])) {
+                selections.push_back(*ParseSelectionRect(args[i + 1]));
+            } else {
+                PrintStatisticsBenchmarkUsage();
+                return 1;
+            }
+        }
+    } catch (const std::exception &) {
+        PrintStatisticsBenchmarkUsage();
+        return 1;
+    }
+
+    try {
+        const RawFrameFile raw = ReadRawFrameFile(PathFromUtf8(args[1]));
+        EglEnvironment egl;
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        std::shared_ptr<const GpuFrame> gpuFrame =
+            GpuFrame::Create(raw.frame, egl.Display(), egl.DummySurface(), egl.RootContext());
+        const int width = static_cast<int>(gpuFrame->Width());
+        const int height = static_cast<int>(gpuFrame->Height());
+        if (selections.empty()) {
+            selections = {{0, 0, width, height}, {width / 4, height / 4, width * 3 / 4, height * 3 / 4}};
+        }
+        // 固定种子的随机矩形，大多不与块边界对齐
+        std::mt19937 random(20261018);
+        for (int i = 0; i < queries; ++i) {
+            std::uniform_int_distribution<int> x(0, width - 1);
+            std::uniform_int_distribution<int> y(0, height - 1);
+            const int x1 = x(random);
+            const int y1 = y(random);
+            const int x2 = std::uniform_int_distribution<int>(x1 + 1, width)(random);
+            const int y2 = std::uniform_int_distribution<int>(y1 + 1, height)(random);
+            selections.push_back({x1, y1, x2, y2});
+        }
+
+        outputModule->ComputeFrameStatistics(gpuFrame, raw.hdrInfo); // 预热：着色器编译不计入
+        std::shared_ptr<const FrameStatistics> statistics;
+        const double buildMs =
+            MedianMs(3, [&] { statistics = outputModule->ComputeFrameStatistics(gpuFrame, raw.hdrInfo); });
+
+        std::vector<LuminanceStatistics> results(selections.size());
+        const double queryMs = MedianMs(5, [&] {
+            for (size_t i = 0; i < selections.size(); ++i) {
+                results[i] = statistics->Query(selections[i]);
+            }
+        });
+        // 只查求和面积表（不含峰值的边界扫描）
+        size_t highlighted = 0;
+        const double highlightMs = MedianMs(5, [&] {
+            highlighted = 0;
+            for (const auto &selection : selections) {
+                highlighted += statistics->HasHighlight(selection) ? 1 : 0;
+            }
+        });
+        std::vector<LuminanceStatistics> references(selections.size());
+        const double scanMs = MedianMs(1, [&] {
+            for (size_t i = 0; i < selections.size(); ++i) {
+                references[i] = CpuConversion::MeasureLuminance(gpuFrame->GetCpuFrame(), selections[i],
+                                                                statistics->DetectionThreshold());
+            }
+        });
+
+        // 块内以 float 累加，着色器的 dot 与 CPU 的亮度计算舍入也不同，均值与峰值按相对误差比较；方差的误差
+        // 主要来自均值的舍入（约为 2·均值·δ均值），按均值的平方比较。计数与逐像素扫描完全一致
+        const auto close = [](double value, double reference, double scale, double tolerance) {
+            return std::abs(value - reference) <= tolerance * (std::max)(std::abs(scale), 1.0);
+        };
+        size_t mismatches = 0;
+        for (size_t i = 0; i < selections.size(); ++i) {
+            const LuminanceStatistics &value = results[i];
+            const LuminanceStatistics &reference = references[i];
+            const bool highlight = statistics->HasHighlight(selections[i]);
+            const bool matches = value.pixelCount == reference.pixelCount &&
+                                 close(value.meanNits, reference.meanNits, reference.meanNits, 1e-5) &&
+                                 close(value.stdDevNits * value.stdDevNits, reference.stdDevNits * reference.stdDevNits,
+                                       reference.meanNits * reference.meanNits, 1e-5) &&
+                                 close(value.peakNits, reference.peakNits, reference.peakNits, 1e-5) &&
+                                 value.aboveSdrWhiteFraction == reference.aboveSdrWhiteFraction &&
+                                 highlight == (reference.aboveSdrWhiteFraction > 0.0);
+            if (!matches) {
+                ++mismatches;
+            }
+            if (i < 2 || !matches) {
+                const SelectionRect &selection = selections[i];
+                std::cout << "  " << std::left << std::setw(22)
+                          << (std::to_string(selection.Left()) + "," + std::to_string(selection.Top()) + " " +
+                              std::to_string(selection.Width()) + "x" + std::to_string(selection.Height()))
+                          << std::right << std::fixed << std::setprecision(2) << " mean " << value.meanNits
+                          << " nits, stddev " << value.stdDevNits << ", peak " << value.peakNits << ", above white "
+                          << value.aboveSdrWhiteFraction * 100.0 << "%" << std::endl;
+                if (!matches) {
+                    std::cout << "    MISMATCH, per-pixel scan: mean " << reference.meanNits << " nits, stddev "
+                              << reference.stdDevNits << ", peak " << reference.peakNits << ", above white "
+                              << reference.aboveSdrWhiteFraction * 100.0 << "%" << std::endl;
+                }
+            }
+        }
+
+        // 确认选区时用求和面积表代替检测 pass（计算后端，整帧）
+        ConversionOptions options;
+        options.backend = ConversionBackend::Compute;
+        ConversionOptions withStatistics = options;
+        withStatistics.statistics = statistics;
+        const SelectionRect fullFrame = {0, 0, width, height};
+        MemorySink detected;
+        MemorySink looked;
+        outputModule->ConvertSelectionToSink(*gpuFrame, fullFrame, raw.hdrInfo, options, detected);
+        const double detectedMs = MedianMs(3, [&] {
+            outputModule->ConvertSelectionToSink(*gpuFrame, fullFrame, raw.hdrInfo, options, detected);
+        });
+        const double lookedMs = MedianMs(3, [&] {
+            outputModule->ConvertSelectionToSink(*gpuFrame, fullFrame, raw.hdrInfo, withStatistics, looked);
+        });
+        const bool identical = detected.Image().pixels == looked.Image().pixels &&
+                               detected.Image().info.hdrPath == looked.Image().info.hdrPath;
+
+        const double megabyte = 1024.0 * 1024.0;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Frame " << width << "x" << height << ": build " << buildMs << " ms (p50), "
+                  << FrameStatistics::EstimateBytes(gpuFrame->Width(), gpuFrame->Height()) / megabyte << " MiB"
+                  << std::endl;
+        std::cout << selections.size() << " rectangles (" << highlighted << " with highlights): query "
+                  << queryMs * 1000.0 / selections.size() << " us each, highlight test "
+                  << highlightMs * 1000.0 / selections.size() << " us each, per-pixel scan "
+                  << scanMs * 1000.0 / selections.size() << " us each, " << mismatches << " mismatches" << std::endl;
+        std::cout << "Full-frame compute conversion: detect pass " << detectedMs << " ms, statistics lookup "
+                  << lookedMs << " ms, " << (identical ? "identical" : "DIFFERENT") << " output" << std::endl;
+        return mismatches == 0 && identical ? 0 : 1;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
+
+int RunLosslessBenchmark(const std::vector<std::string> &args) {
+    if (args.size() < 2 || args[0] != "--bench-lossless" || args.size() % 2 != 0) {
+        PrintLosslessBenchmarkUsage();
+        return 1;
+    }
+    ConversionOptions options;
+    int iterations = 5;
+    try {
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--tonemap" && ParseToneMapOperator(args[i + 1])) {
+                options.toneMapOperator = *ParseToneMapOperator(args[i + 1]);
+            } else if (args[i] == "--iterations") {
+                iterations = (std::max)(std::stoi(args[i + 1]), 1);
+            } else {
+                PrintLosslessBenchmarkUsage();
+                return 1;
+            }
+        }
+    } catch (const std::exception &) {
+        PrintLosslessBenchmarkUsage();
+        return 1;
+    }
+
+    try {
+        const RawFrameFile raw = ReadRawFrameFile(PathFromUtf8(args[1]));
+        EglEnvironment egl;
+        auto outputModule = OutputModule::Create(egl.Display(), egl.DummySurface(), egl.RootContext());
+        std::shared_ptr<const GpuFrame> gpuFrame =
+            GpuFrame::Create(raw.frame, egl.Display(), egl.DummySurface(), egl.RootContext());
+        const SelectionRect full{0, 0, static_cast<int>(gpuFrame->Width()), static_cast<int>(gpuFrame->Height())};
+
+        const unsigned threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+        const std::filesystem::path directory = std::filesystem::temp_directory_path();
+        const double megabyte = 1024.0 * 1024.0;
+        bool allIdentical = true;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Frame " << full.Width() << "x" << full.Height() << ", encode p50 of " << iterations
+                  << ", MB/s of readback pixels:" << std::endl;
+
+        const auto report = [&](const char *name, double ms, uint64_t rawBytes, uint64_t fileBytes) {
+            std::cout << "  " << std::left << std::setw(16) << name << std::right << std::setw(9) << ms << " ms "
+                      << std::setw(9) << rawBytes / megabyte / (ms / 1000.0) << " MB/s " << std::setw(9)
+                      << fileBytes / megabyte << " MiB (" << std::setprecision(1)
+                      << 100.0 * fileBytes / rawBytes << "%)" << std::setprecision(2) << std::endl;
+        };
+
+        // 同一帧分别转换为 PNG 与 EXR 路径使用的像素格式，只测编码阶段：转换与回读两者相同
+        for (OutputPixelFormat format : {OutputPixelFormat::Bgra8, OutputPixelFormat::Rgba16F}) {
+            MemorySink converted(format);
+            outputModule->ConvertSelectionToSink(*gpuFrame, full, raw.hdrInfo, options, converted);
+            const ConvertedImage &image = converted.Image();
+            const uint64_t rawBytes = image.pixels.size();
+            const bool bgra8 = format == OutputPixelFormat::Bgra8;
+            std::cout << (bgra8 ? "BGRA8" : "RGBA16F") << ":" << std::endl;
+
+            const std::filesystem::path referencePath =
+                directory / (bgra8 ? "printscr-bench.png" : "printscr-bench.exr");
+            uint64_t referenceBytes = 0;
+            const double referenceMs = MedianMs(iterations, [&] {
+                if (bgra8) {
+                    PngFileSink sink(referencePath);
+                    image.ReplayInto(sink);
+                    referenceBytes = sink.BytesWritten();
+                } else {
+                    ExrFileSink sink(referencePath);
+                    image.ReplayInto(sink);
+                    referenceBytes = sink.BytesWritten();
+                }
+            });
+            report(bgra8 ? "png (deflate)" : "exr (raw)", referenceMs, rawBytes, referenceBytes);
+
+            const std::filesystem::path qoiPath = directory / "printscr-bench.pqoi";
+            std::vector<unsigned> threadCounts{1};
+            if (threads > 1) {
+                threadCounts.push_back(threads);
+            }
+            for (unsigned count : threadCounts) {
+                uint64_t qoiBytes = 0;
+                const double qoiMs = MedianMs(iterations, [&] {
+                    QoiFileSink sink(qoiPath, format, count);
+                    image.ReplayInto(sink);
+                    qoiBytes = sink.BytesWritten();
+                });
+                report(("pqoi x" + std::to_string(count)).c_str(), qoiMs, rawBytes, qoiBytes);
+            }
+
+            ConvertedImage decoded;
+            const double decodeMs = MedianMs(iterations, [&] { decoded = QoiCodec::Decode(qoiPath, threads); });
+            const bool identical = decoded.pixels == image.pixels && decoded.info.width == image.info.width &&
+                                   decoded.info.height == image.info.height && decoded.info.format == format;
+            allIdentical = allIdentical && identical;
+            std::cout << "  pqoi decode x" << threads << " " << decodeMs << " ms, "
+                      << rawBytes / megabyte / (decodeMs / 1000.0) << " MB/s, "
+                      << (identical ? "round trip identical" : "round trip DIFFERS") << std::endl;
+
+            std::filesystem::remove(referencePath);
+            std::filesystem::remove(qoiPath);
+        }
+        return allIdentical ? 0 : 1;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
+
+int RunBatchCommand(const std::vector<std::string> &args) {
+    std::optional<BatchOptions> options;
+    try {
+        options = ParseBatchArguments(args);
+    } catch (const std::exception &) {
+        options.reset();
+    }
+    if (!options) {
+        PrintBatchUsage();
+        return 1;
+    }
+
+    try {
+        EglEnvironment egl;
+        const BatchStats stats = RunBatchConversion(egl, *options);
+
+        const double seconds = stats.seconds > 0.0 ? stats.seconds : 1e-9;
+        const double megabyte = 1024.0 * 1024.0;
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Converted " << stats.framesConverted << " frames (" << stats.framesFailed << " failed) into "
+                  << stats.imagesWritten << " images (" << stats.imagesFailed << " failed) in " << stats.seconds
+                  << " s" << std::endl;
+        std::cout << "Throughput: " << stats.framesConverted / seconds << " frames/s, "
+                  << stats.inputBytes / megabyte / seconds << " MB/s in, " << stats.outputBytes / megabyte / seconds
+                  << " MB/s out" << std::endl;
+        std::cout << "Stage busy: read " << stats.readBusySeconds / seconds * 100.0 << "%, gpu "
+                  << stats.gpuBusySeconds / seconds * 100.0 << "%, encode "
+                  << stats.encodeBusySeconds / seconds * 100.0 << "% (summed over threads)" << std::endl;
+        PrintStageTimings(stats.stageTimings);
+        return stats.framesFailed == 0 && stats.imagesFailed == 0 ? 0 : 1;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "GpuTimer.h"
+
+#include <string>
+#include <vector>
+
+// 不依赖截屏与预览窗口的命令行模式，Windows 与 Linux 入口共用。
+// args 为去掉程序名之后的参数，编码为 UTF-8。
+
+// --verify-transfer-luts
+int RunTransferLutVerifier();
+
+// --batch <input-dir> <output-dir> [--format png|exr|uhdr|qoi|qoi16] [--tonemap <name>] [--local-tonemap] [--threads N]
+//         [--jpeg-quality N] [--sdr-white <nits>] [--scale <factor|Npx>]... [--filter lanczos|box]
+//         [--backend auto|compute|fragment|cpu|vulkan] [--region x,y,w,h]... [--redact x,y,w,h]...
+//         [--redact-style mosaic|blur] [--redact-size N] [--color-lut <file.cube|.icc>] [--gpu-timing]
+int RunBatchCommand(const std::vector<std::string> &args);
+
+// --bench-precompute <frame.scrgb> [--tonemap <name>] [--iterations N] [--region x,y,w,h]...
+// 对比整帧预转换后的裁剪与当前逐选区转换的确认延迟，并校验裁剪结果与计算后端逐字节一致
+int RunPrecomputeBenchmark(const std::vector<std::string> &args);
+
+// --bench-statistics <frame.scrgb> [--queries N] [--region x,y,w,h]...
+// 生成整帧亮度求和面积表，对给定与随机矩形比较查表与逐像素扫描的耗时并校验结果一致，
+// 再比较整帧转换用查表代替检测 pass 的耗时
+int RunStatisticsBenchmark(const std::vector<std::string> &args);
+
+// --bench-lossless <frame.scrgb> [--tonemap <name>] [--iterations N]
+// 对同一帧的 BGRA8 与 RGBA16F 结果比较 PNG / EXR 与 QoiCodec（单线程与全部线程）的编码耗时、吞吐与文件大小，
+// 并校验 QoiCodec 解码后与原像素逐字节一致
+int RunLosslessBenchmark(const std::vector<std::string> &args);
+
+// --autotune：重新测量 kernel 变体与转换后端，把结果写入调优缓存并打印
+int RunAutotuneCommand();
+
+// 打印逐阶段计时的滚动统计，空列表时不输出
+void PrintStageTimings(const std::vector<StageTimingStats> &timings);
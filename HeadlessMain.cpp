@@ -0,0 +1,45 @@
+#include "HeadlessCommands.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 非 Windows 平台的入口：只提供不需要截屏与预览窗口的命令
+int main(int argc, char *argv[]) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (!args.empty() && args[0] == "--verify-transfer-luts") {
+        return RunTransferLutVerifier();
+    }
+    if (!args.empty() && args[0] == "--batch") {
+        return RunBatchCommand(args);
+    }
+    if (!args.empty() && args[0] == "--autotune") {
+        return RunAutotuneCommand();
+    }
+    if (!args.empty() && args[0] == "--bench-precompute") {
+        return RunPrecomputeBenchmark(args);
+    }
+    if (!args.empty() && args[0] == "--bench-statistics") {
+        return RunStatisticsBenchmark(args);
+    }
+    if (!args.empty() && args[0] == "--bench-lossless") {
+        return RunLosslessBenchmark(args);
+    }
+
+    std::cerr << "Usage:" << std::endl
+              << "  printscr --verify-transfer-luts" << std::endl
+              << "  printscr --autotune" << std::endl
+              << "  printscr --bench-precompute <frame.scrgb> [--tonemap <name>] [--iterations N] "
+                 "[--region x,y,w,h]..."
+              << std::endl
+              << "  printscr --bench-statistics <frame.scrgb> [--queries N] [--region x,y,w,h]..." << std::endl
+              << "  printscr --bench-lossless <frame.scrgb> [--tonemap <name>] [--iterations N]" << std::endl
+              << "  printscr --batch <input-dir> <output-dir> [--format png|exr|uhdr|qoi|qoi16] [--tonemap <name>] "
+                 "[--local-tonemap] [--threads N] [--jpeg-quality N] [--sdr-white <nits>] [--scale <factor|Npx>]... "
+                 "[--filter lanczos|box] [--backend auto|compute|fragment|cpu|vulkan] [--region x,y,w,h]... "
+                 "[--redact x,y,w,h]... [--redact-style mosaic|blur] [--redact-size N] [--color-lut <file.cube|.icc>] "
+                 "[--gpu-timing]"
+              << std::endl;
+    return 1;
+}
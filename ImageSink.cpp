@@ -0,0 +1,581 @@
+#include "ImageSink.h"
+#include "JpegEncoder.h"
+#include "QoiCodec.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace {
+
+constexpr int kPngCompressionLevel = 3;
+constexpr size_t kPngIdatChunkSize = 1 << 16;
+constexpr uint8_t kPngFilterSub = 1;
+
+void AppendBigEndian32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+template <typename T> void AppendLittleEndian(std::vector<uint8_t> &out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+    }
+}
+
+void AppendString(std::vector<uint8_t> &out, const char *text) {
+    out.insert(out.end(), text, text + std::strlen(text) + 1);
+}
+
+void AppendExrAttribute(std::vector<uint8_t> &out, const char *name, const char *type,
+                        const std::vector<uint8_t> &value) {
+    AppendString(out, name);
+    AppendString(out, type);
+    AppendLittleEndian<int32_t>(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void AppendBigEndian16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// XMP 的 APP1 负载：命名空间标识 + NUL + XML
+std::vector<uint8_t> XmpPayload(const std::string &xml) {
+    std::vector<uint8_t> payload;
+    AppendString(payload, "http://ns.adobe.com/xap/1.0/");
+    payload.insert(payload.end(), xml.begin(), xml.end());
+    return payload;
+}
+
+constexpr const char *kXmpHeader = R"(<x:xmpmeta xmlns:x="adobe:ns:meta/" x:xmptk="printscr">
+<rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">
+<rdf:Description rdf:about="" xmlns:hdrgm="http://ns.adobe.com/hdr-gain-map/1.0/")";
+
+constexpr const char *kXmpFooter = R"(
+</rdf:RDF>
+</x:xmpmeta>)";
+
+// 主图像：声明 hdrgm 版本，并以 Container:Directory 指出紧随其后的增益图长度
+std::string PrimaryXmp(size_t gainMapBytes) {
+    return std::string(kXmpHeader) + R"(
+ xmlns:Container="http://ns.google.com/photos/1.0/container/"
+ xmlns:Item="http://ns.google.com/photos/1.0/container/item/"
+ hdrgm:Version="1.0">
+<Container:Directory><rdf:Seq>
+<rdf:li rdf:parseType="Resource"><Container:Item Item:Semantic="Primary" Item:Mime="image/jpeg"/></rdf:li>
+<rdf:li rdf:parseType="Resource"><Container:Item Item:Semantic="GainMap" Item:Mime="image/jpeg" Item:Length=")" +
+           std::to_string(gainMapBytes) + R"("/></rdf:li>
+</rdf:Seq></Container:Directory>
+</rdf:Description>)" + kXmpFooter;
+}
+
+// 增益图：量化范围与偏移，与 ImageSink.h 中 Bgra8GainMap 的定义一致；基础图像是 SDR
+std::string GainMapXmp(float maxLog2) {
+    return std::string(kXmpHeader) + R"(
+ hdrgm:Version="1.0" hdrgm:GainMapMin=")" + std::to_string(kGainMapMinLog2) + R"(" hdrgm:GainMapMax=")" +
+           std::to_string(maxLog2) + R"(" hdrgm:Gamma="1.0" hdrgm:OffsetSDR=")" + std::to_string(kGainMapOffset) +
+           R"(" hdrgm:OffsetHDR=")" + std::to_string(kGainMapOffset) + R"(" hdrgm:HDRCapacityMin="0.0"
+ hdrgm:HDRCapacityMax=")" + std::to_string(maxLog2) + R"(" hdrgm:BaseRenditionIsHDR="False"/>)" + kXmpFooter;
+}
+
+// MPF（CIPA DC-007）的 APP2 负载：大端 TIFF 头 + 3 项 IFD + 两个 MP Entry。
+// 偏移以 TIFF 头为基准，主图像的偏移固定为 0；各项长度固定，先以 0 占位，主图像编码完再回填
+constexpr size_t kMpfTiffHeaderOffset = 4; // "MPF\0" 之后
+
+std::vector<uint8_t> MpfPayload(uint32_t primaryBytes, uint32_t gainMapBytes, uint32_t gainMapOffset) {
+    constexpr uint32_t kEntryCount = 3;
+    constexpr uint32_t kMpEntryOffset = 8 + 2 + kEntryCount * 12 + 4;
+    std::vector<uint8_t> payload = {'M', 'P', 'F', 0, 'M', 'M', 0, 0x2A};
+    AppendBigEndian32(payload, 8);
+    AppendBigEndian16(payload, kEntryCount);
+    AppendBigEndian16(payload, 0xB000); // MPFVersion, UNDEFINED x4
+    AppendBigEndian16(payload, 7);
+    AppendBigEndian32(payload, 4);
+    payload.insert(payload.end(), {'0', '1', '0', '0'});
+    AppendBigEndian16(payload, 0xB001); // NumberOfImages, LONG x1
+    AppendBigEndian16(payload, 4);
+    AppendBigEndian32(payload, 1);
+    AppendBigEndian32(payload, 2);
+    AppendBigEndian16(payload, 0xB002); // MPEntry, UNDEFINED x32
+    AppendBigEndian16(payload, 7);
+    AppendBigEndian32(payload, 32);
+    AppendBigEndian32(payload, kMpEntryOffset);
+    AppendBigEndian32(payload, 0); // 没有下一个 IFD
+
+    AppendBigEndian32(payload, 0x00030000); // 主图像：Baseline MP Primary Image
+    AppendBigEndian32(payload, primaryBytes);
+    AppendBigEndian32(payload, 0);
+    AppendBigEndian32(payload, 0);
+    AppendBigEndian32(payload, 0x00000000); // 增益图
+    AppendBigEndian32(payload, gainMapBytes);
+    AppendBigEndian32(payload, gainMapOffset);
+    AppendBigEndian32(payload, 0);
+    return payload;
+}
+
+void CheckFormat(const ImageInfo &info, OutputPixelFormat expected, const char *sinkName) {
+    if (info.format != expected) {
+        throw std::runtime_error(std::string(sinkName) + ": unexpected pixel format");
+    }
+}
+
+} // namespace
+
+void ConvertedImage::ReplayInto(ImageSink &sink) const {
+    sink.Begin(info);
+    if (info.height > 0) {
+        sink.WriteRows(0, info.height, pixels.data());
+    }
+    sink.End();
+}
+
+void MemorySink::Begin(const ImageInfo &info) {
+    CheckFormat(info, m_format, "MemorySink");
+    m_image.info = info;
+    m_image.pixels.resize(info.RowBytes() * info.height);
+}
+
+void MemorySink::WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_image.info.RowBytes();
+    std::memcpy(m_image.pixels.data() + firstRow * rowBytes, rows, rowCount * rowBytes);
+}
+
+struct PngFileSink::DeflateState {
+    z_stream stream{};
+    std::vector<uint8_t> output = std::vector<uint8_t>(kPngIdatChunkSize);
+    bool initialized = false;
+
+    ~DeflateState() {
+        if (initialized) {
+            deflateEnd(&stream);
+        }
+    }
+};
+
+PngFileSink::PngFileSink(std::filesystem::path path, std::vector<uint8_t> iccProfile)
+    : m_path(std::move(path)), m_iccProfile(std::move(iccProfile)) {}
+
+PngFileSink::~PngFileSink() = default;
+
+void PngFileSink::Begin(const ImageInfo &info) {
+    CheckFormat(info, OutputPixelFormat::Bgra8, "PngFileSink");
+    m_info = info;
+    m_file.open(m_path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        throw std::runtime_error("PngFileSink: cannot open " + m_path.string());
+    }
+
+    static constexpr uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    m_file.write(reinterpret_cast<const char *>(kSignature), sizeof(kSignature));
+    m_bytesWritten = sizeof(kSignature);
+
+    std::vector<uint8_t> header;
+    AppendBigEndian32(header, info.width);
+    AppendBigEndian32(header, info.height);
+    header.push_back(8); // bit depth
+    header.push_back(2); // color type: RGB
+    header.push_back(0); // compression
+    header.push_back(0); // filter
+    header.push_back(0); // interlace
+    WriteChunk("IHDR", header.data(), header.size());
+
+    if (m_iccProfile.empty()) {
+        const uint8_t renderingIntent = 0; // perceptual
+        WriteChunk("sRGB", &renderingIntent, 1);
+    } else {
+        // iCCP：配置文件名 + NUL + 压缩方法 0（zlib）+ 压缩后的配置文件
+        std::vector<uint8_t> chunk;
+        AppendString(chunk, "ICC Profile");
+        chunk.push_back(0);
+        uLongf compressedSize = compressBound(static_cast<uLong>(m_iccProfile.size()));
+        const size_t prefixSize = chunk.size();
+        chunk.resize(prefixSize + compressedSize);
+        if (compress2(chunk.data() + prefixSize, &compressedSize, m_iccProfile.data(),
+                      static_cast<uLong>(m_iccProfile.size()), kPngCompressionLevel) != Z_OK) {
+            throw std::runtime_error("PngFileSink: failed to compress ICC profile");
+        }
+        chunk.resize(prefixSize + compressedSize);
+        WriteChunk("iCCP", chunk.data(), chunk.size());
+    }
+
+    m_deflate = std::make_unique<DeflateState>();
+    if (deflateInit(&m_deflate->stream, kPngCompressionLevel) != Z_OK) {
+        throw std::runtime_error("PngFileSink: deflateInit failed");
+    }
+    m_deflate->initialized = true;
+    m_rowBuffer.resize(1 + static_cast<size_t>(info.width) * 3);
+}
+
+void PngFileSink::WriteRows(uint32_t, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_info.RowBytes();
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        const uint8_t *src = rows + row * rowBytes;
+        uint8_t *dst = m_rowBuffer.data();
+        dst[0] = kPngFilterSub;
+        uint8_t previous[3] = {0, 0, 0};
+        for (uint32_t x = 0; x < m_info.width; ++x) {
+            const uint8_t rgb[3] = {src[x * 4 + 2], src[x * 4 + 1], src[x * 4 + 0]};
+            for (int c = 0; c < 3; ++c) {
+                dst[1 + x * 3 + c] = static_cast<uint8_t>(rgb[c] - previous[c]);
+                previous[c] = rgb[c];
+            }
+        }
+        Deflate(m_rowBuffer.data(), m_rowBuffer.size(), false);
+    }
+}
+
+void PngFileSink::End() {
+    Deflate(nullptr, 0, true);
+    WriteChunk("IEND", nullptr, 0);
+    m_deflate.reset();
+    m_file.close();
+    if (!m_file) {
+        throw std::runtime_error("PngFileSink: failed to write " + m_path.string());
+    }
+}
+
+void PngFileSink::Deflate(const uint8_t *data, size_t size, bool finish) {
+    z_stream &stream = m_deflate->stream;
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    for (;;) {
+        if (stream.avail_out == 0 || stream.next_out == nullptr) {
+            stream.next_out = m_deflate->output.data();
+            stream.avail_out = static_cast<uInt>(m_deflate->output.size());
+        }
+        const int result = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (result == Z_STREAM_ERROR) {
+            throw std::runtime_error("PngFileSink: deflate failed");
+        }
+
+        const size_t pending = m_deflate->output.size() - stream.avail_out;
+        const bool bufferFull = stream.avail_out == 0;
+        if (bufferFull || (finish && result == Z_STREAM_END)) {
+            if (pending > 0) {
+                WriteChunk("IDAT", m_deflate->output.data(), pending);
+            }
+            stream.next_out = m_deflate->output.data();
+            stream.avail_out = static_cast<uInt>(m_deflate->output.size());
+        }
+
+        if (finish ? result == Z_STREAM_END : (stream.avail_in == 0 && !bufferFull)) {
+            break;
+        }
+    }
+}
+
+void PngFileSink::WriteChunk(const char type[4], const uint8_t *data, size_t size) {
+    std::vector<uint8_t> prefix;
+    AppendBigEndian32(prefix, static_cast<uint32_t>(size));
+    prefix.insert(prefix.end(), type, type + 4);
+
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(type), 4);
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+    std::vector<uint8_t> suffix;
+    AppendBigEndian32(suffix, static_cast<uint32_t>(crc));
+
+    m_file.write(reinterpret_cast<const char *>(prefix.data()), static_cast<std::streamsize>(prefix.size()));
+    if (size > 0) {
+        m_file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+    }
+    m_file.write(reinterpret_cast<const char *>(suffix.data()), static_cast<std::streamsize>(suffix.size()));
+    m_bytesWritten += prefix.size() + size + suffix.size();
+}
+
+ExrFileSink::ExrFileSink(std::filesystem::path path) : m_path(std::move(path)) {}
+
+void ExrFileSink::Begin(const ImageInfo &info) {
+    CheckFormat(info, OutputPixelFormat::Rgba16F, "ExrFileSink");
+    m_info = info;
+    m_file.open(m_path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        throw std::runtime_error("ExrFileSink: cannot open " + m_path.string());
+    }
+
+    std::vector<uint8_t> header = {0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0};
+
+    // 通道按字母序排列：A, B, G, R；类型均为 HALF
+    std::vector<uint8_t> channels;
+    for (const char *name : {"A", "B", "G", "R"}) {
+        AppendString(channels, name);
+        AppendLittleEndian<int32_t>(channels, 1); // HALF
+        AppendLittleEndian<uint32_t>(channels, 0); // pLinear + reserved
+        AppendLittleEndian<int32_t>(channels, 1);
+        AppendLittleEndian<int32_t>(channels, 1);
+    }
+    channels.push_back(0);
+    AppendExrAttribute(header, "channels", "chlist", channels);
+    AppendExrAttribute(header, "compression", "compression", {0});
+
+    std::vector<uint8_t> window;
+    AppendLittleEndian<int32_t>(window, 0);
+    AppendLittleEndian<int32_t>(window, 0);
+    AppendLittleEndian<int32_t>(window, static_cast<int32_t>(info.width) - 1);
+    AppendLittleEndian<int32_t>(window, static_cast<int32_t>(info.height) - 1);
+    AppendExrAttribute(header, "dataWindow", "box2i", window);
+    AppendExrAttribute(header, "displayWindow", "box2i", window);
+    AppendExrAttribute(header, "lineOrder", "lineOrder", {0});
+
+    std::vector<uint8_t> one;
+    AppendLittleEndian<uint32_t>(one, 0x3F800000u); // 1.0f
+    AppendExrAttribute(header, "pixelAspectRatio", "float", one);
+    AppendExrAttribute(header, "screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+    AppendExrAttribute(header, "screenWindowWidth", "float", one);
+    header.push_back(0);
+
+    // 未压缩时每个 chunk 恰好一行，大小固定，偏移表可直接算出
+    const uint64_t lineDataBytes = static_cast<uint64_t>(info.width) * 4 * sizeof(uint16_t);
+    const uint64_t firstChunk = header.size() + static_cast<uint64_t>(info.height) * sizeof(uint64_t);
+    for (uint32_t y = 0; y < info.height; ++y) {
+        AppendLittleEndian<uint64_t>(header, firstChunk + y * (8 + lineDataBytes));
+    }
+
+    m_file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    m_bytesWritten = header.size();
+    m_lineBuffer.resize(8 + lineDataBytes);
+}
+
+void ExrFileSink::WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_info.RowBytes();
+    const uint32_t width = m_info.width;
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        std::vector<uint8_t> &line = m_lineBuffer;
+        line.clear();
+        AppendLittleEndian<int32_t>(line, static_cast<int32_t>(firstRow + row));
+        AppendLittleEndian<int32_t>(line, static_cast<int32_t>(width * 4 * sizeof(uint16_t)));
+
+        const uint8_t *src = rows + row * rowBytes;
+        // 输入为交错的 R, G, B, A；按 A, B, G, R 的通道顺序拆为平面
+        for (int channel : {3, 2, 1, 0}) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint8_t *half = src + (x * 4 + channel) * sizeof(uint16_t);
+                line.push_back(half[0]);
+                line.push_back(half[1]);
+            }
+        }
+        m_file.write(reinterpret_cast<const char *>(line.data()), static_cast<std::streamsize>(line.size()));
+        m_bytesWritten += line.size();
+    }
+}
+
+void ExrFileSink::End() {
+    m_file.close();
+    if (!m_file) {
+        throw std::runtime_error("ExrFileSink: failed to write " + m_path.string());
+    }
+}
+
+UltraHdrJpegSink::UltraHdrJpegSink(std::filesystem::path path, int quality, unsigned threads)
+    : m_path(std::move(path)), m_quality(quality), m_threads(threads) {}
+
+void UltraHdrJpegSink::Begin(const ImageInfo &info) {
+    CheckFormat(info, OutputPixelFormat::Bgra8GainMap, "UltraHdrJpegSink");
+    m_info = info;
+    m_pixels.resize(info.RowBytes() * info.height);
+}
+
+void UltraHdrJpegSink::WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_info.RowBytes();
+    std::memcpy(m_pixels.data() + firstRow * rowBytes, rows, rowCount * rowBytes);
+}
+
+void UltraHdrJpegSink::End() {
+    const JpegEncoder::Options options{m_quality, m_threads};
+    const size_t rowBytes = m_info.RowBytes();
+    const std::vector<uint8_t> gainMap =
+        JpegEncoder::Encode(m_pixels.data(), m_info.width, m_info.height, rowBytes, JpegEncoder::Source::Alpha,
+                            options, {JpegEncoder::MakeAppSegment(1, XmpPayload(GainMapXmp(m_info.gainMapMaxLog2)))});
+
+    const std::vector<uint8_t> xmp = JpegEncoder::MakeAppSegment(1, XmpPayload(PrimaryXmp(gainMap.size())));
+    std::vector<uint8_t> primary = JpegEncoder::Encode(m_pixels.data(), m_info.width, m_info.height, rowBytes,
+                                                       JpegEncoder::Source::Bgr, options,
+                                                       {xmp, JpegEncoder::MakeAppSegment(2, MpfPayload(0, 0, 0))});
+
+    // MPF 段紧跟在 XMP 段之后；标记与长度占 4 字节
+    const size_t mpfPayloadOffset = JpegEncoder::kSegmentsOffset + xmp.size() + 4;
+    const size_t tiffHeaderOffset = mpfPayloadOffset + kMpfTiffHeaderOffset;
+    const std::vector<uint8_t> mpf =
+        MpfPayload(static_cast<uint32_t>(primary.size()), static_cast<uint32_t>(gainMap.size()),
+                   static_cast<uint32_t>(primary.size() - tiffHeaderOffset));
+    std::copy(mpf.begin(), mpf.end(), primary.begin() + static_cast<std::ptrdiff_t>(mpfPayloadOffset));
+    m_pixels = {};
+
+    std::ofstream file(m_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("UltraHdrJpegSink: cannot open " + m_path.string());
+    }
+    file.write(reinterpret_cast<const char *>(primary.data()), static_cast<std::streamsize>(primary.size()));
+    file.write(reinterpret_cast<const char *>(gainMap.data()), static_cast<std::streamsize>(gainMap.size()));
+    file.close();
+    if (!file) {
+        throw std::runtime_error("UltraHdrJpegSink: failed to write " + m_path.string());
+    }
+    m_bytesWritten = primary.size() + gainMap.size();
+}
+
+QoiFileSink::QoiFileSink(std::filesystem::path path, OutputPixelFormat format, unsigned threads)
+    : m_path(std::move(path)), m_format(format), m_threads(threads) {}
+
+void QoiFileSink::Begin(const ImageInfo &info) {
+    CheckFormat(info, m_format, "QoiFileSink");
+    m_info = info;
+    m_file.open(m_path, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        throw std::runtime_error("QoiFileSink: cannot open " + m_path.string());
+    }
+    // 条带表先写 0，End 时回填
+    const std::vector<uint8_t> header = QoiCodec::EncodeHeader(info, {});
+    m_file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    m_bytesWritten = header.size();
+    m_pendingRows.clear();
+    m_bandBytes.clear();
+}
+
+void QoiFileSink::WriteBands(const uint8_t *rows, uint32_t rowCount) {
+    for (const std::vector<uint8_t> &band :
+         QoiCodec::EncodeBands(rows, m_info.width, rowCount, m_info.format, m_threads)) {
+        m_file.write(reinterpret_cast<const char *>(band.data()), static_cast<std::streamsize>(band.size()));
+        m_bandBytes.push_back(static_cast<uint32_t>(band.size()));
+        m_bytesWritten += band.size();
+    }
+}
+
+void QoiFileSink::WriteRows(uint32_t, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_info.RowBytes();
+    const size_t bandBytes = rowBytes * QoiCodec::kBandRows;
+
+    // 先补齐上次剩下的不完整条带
+    if (!m_pendingRows.empty()) {
+        const uint32_t pendingRows = static_cast<uint32_t>(m_pendingRows.size() / rowBytes);
+        const uint32_t take = (std::min)(rowCount, QoiCodec::kBandRows - pendingRows);
+        m_pendingRows.insert(m_pendingRows.end(), rows, rows + take * rowBytes);
+        rows += take * rowBytes;
+        rowCount -= take;
+        if (m_pendingRows.size() < bandBytes) {
+            return;
+        }
+        WriteBands(m_pendingRows.data(), QoiCodec::kBandRows);
+        m_pendingRows.clear();
+    }
+
+    const uint32_t wholeRows = rowCount / QoiCodec::kBandRows * QoiCodec::kBandRows;
+    if (wholeRows > 0) {
+        WriteBands(rows, wholeRows);
+    }
+    m_pendingRows.assign(rows + wholeRows * rowBytes, rows + rowCount * rowBytes);
+}
+
+void QoiFileSink::End() {
+    if (!m_pendingRows.empty()) {
+        WriteBands(m_pendingRows.data(), static_cast<uint32_t>(m_pendingRows.size() / m_info.RowBytes()));
+        m_pendingRows = {};
+    }
+    const std::vector<uint8_t> header = QoiCodec::EncodeHeader(m_info, m_bandBytes);
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    m_file.close();
+    if (!m_file) {
+        throw std::runtime_error("QoiFileSink: failed to write " + m_path.string());
+    }
+}
+
+#ifdef _WIN32
+ClipboardSink::~ClipboardSink() {
+    if (m_dibMemory) {
+        GlobalUnlock(m_dibMemory);
+        GlobalFree(m_dibMemory);
+    }
+}
+
+void ClipboardSink::Begin(const ImageInfo &info) {
+    CheckFormat(info, OutputPixelFormat::Bgra8, "ClipboardSink");
+    m_info = info;
+
+    const SIZE_T headerSize = sizeof(BITMAPV5HEADER);
+    const SIZE_T pixelBytes = static_cast<SIZE_T>(info.RowBytes()) * info.height;
+    m_dibMemory = GlobalAlloc(GMEM_MOVEABLE, headerSize + pixelBytes + m_iccProfile.size());
+    if (!m_dibMemory) {
+        throw std::runtime_error("GlobalAlloc failed for clipboard bitmap");
+    }
+
+    void *memory = GlobalLock(m_dibMemory);
+    if (!memory) {
+        GlobalFree(m_dibMemory);
+        m_dibMemory = nullptr;
+        throw std::runtime_error("GlobalLock failed for clipboard bitmap");
+    }
+
+    auto *header = static_cast<BITMAPV5HEADER *>(memory);
+    std::memset(header, 0, headerSize);
+    header->bV5Size = sizeof(BITMAPV5HEADER);
+    header->bV5Width = static_cast<LONG>(info.width);
+    header->bV5Height = -static_cast<LONG>(info.height);
+    header->bV5Planes = 1;
+    header->bV5BitCount = 32;
+    header->bV5Compression = BI_BITFIELDS;
+    header->bV5SizeImage = static_cast<DWORD>(pixelBytes);
+    header->bV5RedMask = 0x00FF0000;
+    header->bV5GreenMask = 0x0000FF00;
+    header->bV5BlueMask = 0x000000FF;
+    header->bV5AlphaMask = 0xFF000000;
+    if (m_iccProfile.empty()) {
+        header->bV5CSType = LCS_sRGB;
+    } else {
+        // 配置文件紧接在像素之后，bV5ProfileData 为相对于头部起始的偏移
+        header->bV5CSType = PROFILE_EMBEDDED;
+        header->bV5Intent = LCS_GM_GRAPHICS;
+        header->bV5ProfileData = static_cast<DWORD>(headerSize + pixelBytes);
+        header->bV5ProfileSize = static_cast<DWORD>(m_iccProfile.size());
+        std::memcpy(reinterpret_cast<uint8_t *>(header) + headerSize + pixelBytes, m_iccProfile.data(),
+                    m_iccProfile.size());
+    }
+
+    m_pixels = reinterpret_cast<uint8_t *>(header + 1);
+}
+
+void ClipboardSink::WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) {
+    const size_t rowBytes = m_info.RowBytes();
+    std::memcpy(m_pixels + firstRow * rowBytes, rows, rowCount * rowBytes);
+}
+
+void ClipboardSink::End() {
+    GlobalUnlock(m_dibMemory);
+    m_pixels = nullptr;
+
+    if (!OpenClipboard(nullptr)) {
+        GlobalFree(m_dibMemory);
+        m_dibMemory = nullptr;
+        throw std::runtime_error("OpenClipboard failed");
+    }
+
+    if (!EmptyClipboard()) {
+        CloseClipboard();
+        GlobalFree(m_dibMemory);
+        m_dibMemory = nullptr;
+        throw std::runtime_error("EmptyClipboard failed");
+    }
+
+    if (!SetClipboardData(CF_DIBV5, m_dibMemory)) {
+        CloseClipboard();
+        GlobalFree(m_dibMemory);
+        m_dibMemory = nullptr;
+        throw std::runtime_error("SetClipboardData failed");
+    }
+
+    // 提交成功后内存归系统所有
+    m_dibMemory = nullptr;
+    CloseClipboard();
+}
+#endif
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "ToneMapping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// OutputModule 的输出像素格式
+enum class OutputPixelFormat : uint32_t {
+    Bgra8        = 0, // 8-bit BGRA，sRGB 编码，alpha 恒为 255
+    Rgba16F      = 1, // 半精度 RGBA，线性光；即 Bgra8 结果经 sRGB EOTF 解码后的值
+    Bgra8GainMap = 2, // BGR 与 Bgra8 相同（不经过色彩管理查找表），alpha 为 Ultra HDR 增益图
+};
+
+constexpr size_t kOutputPixelFormatCount = 3;
+
+constexpr size_t BytesPerPixel(OutputPixelFormat format) { return format == OutputPixelFormat::Rgba16F ? 8 : 4; }
+
+// Bgra8GainMap 的 alpha：log2((HDR 亮度 + kGainMapOffset) / (SDR 亮度 + kGainMapOffset))，亮度以 SDR 白为 1，
+// 在 [kGainMapMinLog2, GainMapMaxLog2] 上线性量化到 [0, 255]。处理着色器的 GainMapValue 使用相同的常量
+constexpr float kGainMapMinLog2 = -1.0f;
+constexpr float kGainMapOffset = 1.0f / 64.0f;
+
+// 显示器峰值相对 SDR 白的档数，至少 1 档
+inline float GainMapMaxLog2(float lw, float sourcePeak) { return (std::max)(std::log2(sourcePeak / lw), 1.0f); }
+
+struct ImageInfo {
+    uint32_t width;
+    uint32_t height;
+    OutputPixelFormat format;
+    bool hdrPath;               // 检测结果：是否走了色调映射路径
+    ToneMapOperator toneMapOperator;
+    float gainMapMaxLog2 = 0.0f; // 仅 Bgra8GainMap：增益图量化范围的上限，见 GainMapMaxLog2
+
+    size_t RowBytes() const { return static_cast<size_t>(width) * BytesPerPixel(format); }
+};
+
+// 转换结果的接收端。调用顺序固定为 Begin → WriteRows（按行号递增，可多次）→ End。
+// rows 指向 rowCount 行紧凑排列的像素，仅在本次调用期间有效（可能直接指向映射中的 GPU 缓冲区）。
+class ImageSink {
+public:
+    virtual ~ImageSink() = default;
+
+    virtual OutputPixelFormat PreferredFormat() const { return OutputPixelFormat::Bgra8; }
+
+    virtual void Begin(const ImageInfo &info) = 0;
+    virtual void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) = 0;
+    virtual void End() = 0;
+};
+
+// 完整保存在内存中的转换结果
+struct ConvertedImage {
+    ImageInfo info{};
+    std::vector<uint8_t> pixels;
+
+    // 把整幅图像一次性写入另一个 sink
+    void ReplayInto(ImageSink &sink) const;
+};
+
+class MemorySink final : public ImageSink {
+public:
+    explicit MemorySink(OutputPixelFormat format = OutputPixelFormat::Bgra8) : m_format(format) {}
+
+    OutputPixelFormat PreferredFormat() const override { return m_format; }
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override {}
+
+    ConvertedImage &Image() { return m_image; }
+
+private:
+    OutputPixelFormat m_format;
+    ConvertedImage m_image;
+};
+
+// 8-bit RGB PNG，行数据边到达边压缩。iccProfile 非空时写入 iCCP 块代替 sRGB 块
+class PngFileSink final : public ImageSink {
+public:
+    explicit PngFileSink(std::filesystem::path path, std::vector<uint8_t> iccProfile = {});
+    ~PngFileSink() override;
+
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override;
+
+    uint64_t BytesWritten() const { return m_bytesWritten; }
+
+private:
+    struct DeflateState;
+
+    void WriteChunk(const char type[4], const uint8_t *data, size_t size);
+    void Deflate(const uint8_t *data, size_t size, bool finish);
+
+    std::filesystem::path m_path;
+    std::vector<uint8_t> m_iccProfile;
+    std::ofstream m_file;
+    std::unique_ptr<DeflateState> m_deflate;
+    std::vector<uint8_t> m_rowBuffer;
+    ImageInfo m_info{};
+    uint64_t m_bytesWritten = 0;
+};
+
+// 半精度 RGBA 的未压缩 scanline OpenEXR；每行偏移可预先算出，因而同样支持流式写入
+class ExrFileSink final : public ImageSink {
+public:
+    explicit ExrFileSink(std::filesystem::path path);
+
+    OutputPixelFormat PreferredFormat() const override { return OutputPixelFormat::Rgba16F; }
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override;
+
+    uint64_t BytesWritten() const { return m_bytesWritten; }
+
+private:
+    std::filesystem::path m_path;
+    std::ofstream m_file;
+    std::vector<uint8_t> m_lineBuffer;
+    ImageInfo m_info{};
+    uint64_t m_bytesWritten = 0;
+};
+
+// Ultra HDR（JPEG + 增益图）：BGR 为 SDR 基础图像，alpha 为处理着色器同一次 dispatch 算出的增益图，
+// 分别由内置的 JpegEncoder 编码为彩色与灰度 JPEG，按 Ultra HDR 1.0 的容器格式拼接：主图像带 hdrgm XMP
+// （含 Container:Directory）与 MPF 索引，增益图紧随其后并带自己的 hdrgm 元数据。不支持增益图的查看器只显示基础图像。
+// 编码需要整幅图像，行数据先缓存到 End；threads 为 JPEG 编码线程数，0 表示使用 hardware_concurrency
+class UltraHdrJpegSink final : public ImageSink {
+public:
+    explicit UltraHdrJpegSink(std::filesystem::path path, int quality = 90, unsigned threads = 0);
+
+    OutputPixelFormat PreferredFormat() const override { return OutputPixelFormat::Bgra8GainMap; }
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override;
+
+    uint64_t BytesWritten() const { return m_bytesWritten; }
+
+private:
+    std::filesystem::path m_path;
+    int m_quality;
+    unsigned m_threads;
+    std::vector<uint8_t> m_pixels;
+    ImageInfo m_info{};
+    uint64_t m_bytesWritten = 0;
+};
+
+// QoiCodec 格式的快速无损文件，支持所有输出格式（Rgba16F 按位无损）。完整的条带直接从 rows（通常是映射中的
+// 回读缓冲区）并行编码并写出，不足一个条带的剩余行先缓存；End 时写出最后一个条带并回填文件头中的条带表。
+// threads 为编码线程数，0 表示使用 hardware_concurrency
+class QoiFileSink final : public ImageSink {
+public:
+    explicit QoiFileSink(std::filesystem::path path, OutputPixelFormat format = OutputPixelFormat::Bgra8,
+                         unsigned threads = 0);
+
+    OutputPixelFormat PreferredFormat() const override { return m_format; }
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override;
+
+    uint64_t BytesWritten() const { return m_bytesWritten; }
+
+private:
+    void WriteBands(const uint8_t *rows, uint32_t rowCount);
+
+    std::filesystem::path m_path;
+    OutputPixelFormat m_format;
+    unsigned m_threads;
+    std::ofstream m_file;
+    std::vector<uint8_t> m_pendingRows;
+    std::vector<uint32_t> m_bandBytes;
+    ImageInfo m_info{};
+    uint64_t m_bytesWritten = 0;
+};
+
+#ifdef _WIN32
+// 写入系统剪贴板（CF_DIBV5）。Begin 时直接分配全局内存，行数据到达即拷入，End 时提交。
+// iccProfile 非空时作为 PROFILE_EMBEDDED 附在像素之后，否则标记为 LCS_sRGB
+class ClipboardSink final : public ImageSink {
+public:
+    explicit ClipboardSink(std::vector<uint8_t> iccProfile = {}) : m_iccProfile(std::move(iccProfile)) {}
+    ~ClipboardSink() override;
+
+    void Begin(const ImageInfo &info) override;
+    void WriteRows(uint32_t firstRow, uint32_t rowCount, const uint8_t *rows) override;
+    void End() override;
+
+private:
+    std::vector<uint8_t> m_iccProfile;
+    void *m_dibMemory = nullptr;
+    uint8_t *m_pixels = nullptr;
+    ImageInfo m_info{};
+};
+#endif
@@ -0,0 +1,511 @@
+#include "JpegEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRINTSCR_JPEG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace JpegEncoder {
+
+namespace {
+
+constexpr uint32_t kMaxDimension = 65535;
+
+// 之字形扫描序号 → 块内自然顺序（行优先）的下标
+constexpr std::array<uint8_t, 64> kZigzag = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Annex K.1 的量化表，自然顺序
+constexpr std::array<uint8_t, 64> kLuminanceQuantization = {
+    16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,  14, 13, 16, 24, 40,  57,
+    69, 56, 14, 17, 22,  29,  51,  87,  80, 62, 18, 22, 37,  56,  68,  109, 103, 77, 24, 35, 55,  64,
+    81, 104, 113, 92, 49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+};
+
+constexpr std::array<uint8_t, 64> kChrominanceQuantization = {
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24, 26, 56, 99, 99, 99,
+    99, 99, 47, 66, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+};
+
+// Annex K.3 的 Huffman 表：各码长的码字数与按码长排列的符号
+struct HuffmanSpec {
+    std::array<uint8_t, 16> counts;
+    const uint8_t *symbols;
+    size_t symbolCount;
+};
+
+constexpr uint8_t kDcSymbols[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+constexpr uint8_t kLuminanceAcSymbols[] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71,
+    0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83,
+    0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+constexpr uint8_t kChrominanceAcSymbols[] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22,
+    0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+    0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36,
+    0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+    0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+constexpr HuffmanSpec kLuminanceDc = {{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0}, kDcSymbols, 12};
+constexpr HuffmanSpec kChrominanceDc = {{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}, kDcSymbols, 12};
+constexpr HuffmanSpec kLuminanceAc = {{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d}, kLuminanceAcSymbols, 162};
+constexpr HuffmanSpec kChrominanceAc = {
+    {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}, kChrominanceAcSymbols, 162};
+
+static_assert(sizeof(kLuminanceAcSymbols) == 162 && sizeof(kChrominanceAcSymbols) == 162,
+              "Annex K AC tables have 162 symbols");
+
+// AAN 的各频率缩放因子：cos(k * pi / 16) * sqrt(2)，k = 0 时为 1
+constexpr std::array<float, 8> kAanScale = {1.0f,         1.387039845f, 1.306562965f, 1.175875602f,
+                                            1.0f,         0.785694958f, 0.541196100f, 0.275899379f};
+
+struct HuffmanTable {
+    std::array<uint16_t, 256> codes{};
+    std::array<uint8_t, 256> lengths{};
+};
+
+HuffmanTable BuildHuffmanTable(const HuffmanSpec &spec) {
+    HuffmanTable table;
+    uint32_t code = 0;
+    size_t symbol = 0;
+    for (size_t length = 1; length <= 16; ++length) {
+        for (uint8_t i = 0; i < spec.counts[length - 1]; ++i) {
+            table.codes[spec.symbols[symbol]] = static_cast<uint16_t>(code++);
+            table.lengths[spec.symbols[symbol]] = static_cast<uint8_t>(length);
+            ++symbol;
+        }
+        code <<= 1;
+    }
+    return table;
+}
+
+// 一个分量用到的表：量化倒数（自然顺序，已乘入 AAN 缩放与 DCT 的 1/8）与 DC/AC Huffman 表
+struct ComponentTables {
+    std::array<uint8_t, 64> quantization{};
+    alignas(16) std::array<float, 64> reciprocals{};
+    HuffmanTable dc;
+    HuffmanTable ac;
+};
+
+ComponentTables BuildComponentTables(const std::array<uint8_t, 64> &base, int quality, const HuffmanSpec &dc,
+                                     const HuffmanSpec &ac) {
+    quality = std::clamp(quality, 1, 100);
+    const int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    ComponentTables tables;
+    for (size_t i = 0; i < 64; ++i) {
+        const int value = std::clamp((base[i] * scale + 50) / 100, 1, 255);
+        tables.quantization[i] = static_cast<uint8_t>(value);
+        tables.reciprocals[i] = 1.0f / (static_cast<float>(value) * kAanScale[i / 8] * kAanScale[i % 8] * 8.0f);
+    }
+    tables.dc = BuildHuffmanTable(dc);
+    tables.ac = BuildHuffmanTable(ac);
+    return tables;
+}
+
+// 一维 AAN 前向 DCT（jfdctflt 的蝶形），输出带 kAanScale 缩放。V 为 float 或 4 路向量，对每一路独立计算
+template <typename V> void ForwardDct8(V *d) {
+    const V tmp0 = d[0] + d[7];
+    const V tmp7 = d[0] - d[7];
+    const V tmp1 = d[1] + d[6];
+    const V tmp6 = d[1] - d[6];
+    const V tmp2 = d[2] + d[5];
+    const V tmp5 = d[2] - d[5];
+    const V tmp3 = d[3] + d[4];
+    const V tmp4 = d[3] - d[4];
+
+    // 偶数部分
+    const V tmp10 = tmp0 + tmp3;
+    const V tmp13 = tmp0 - tmp3;
+    const V tmp11 = tmp1 + tmp2;
+    const V tmp12 = tmp1 - tmp2;
+    d[0] = tmp10 + tmp11;
+    d[4] = tmp10 - tmp11;
+    const V z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[2] = tmp13 + z1;
+    d[6] = tmp13 - z1;
+
+    // 奇数部分
+    const V odd10 = tmp4 + tmp5;
+    const V odd11 = tmp5 + tmp6;
+    const V odd12 = tmp6 + tmp7;
+    const V z5 = (odd10 - odd12) * 0.382683433f;
+    const V z2 = odd10 * 0.541196100f + z5;
+    const V z4 = odd12 * 1.306562965f + z5;
+    const V z3 = odd11 * 0.707106781f;
+    const V z11 = tmp7 + z3;
+    const V z13 = tmp7 - z3;
+    d[5] = z13 + z2;
+    d[3] = z13 - z2;
+    d[1] = z11 + z4;
+    d[7] = z11 - z4;
+}
+
+#ifdef PRINTSCR_JPEG_SSE2
+struct Float4 {
+    __m128 v;
+};
+
+Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+Float4 operator*(Float4 a, float b) { return {_mm_mul_ps(a.v, _mm_set1_ps(b))}; }
+
+// 8x8 块以左右两半各 8 个向量表示，转置时交换四个 4x4 子块
+void Transpose8x8(Float4 *left, Float4 *right) {
+    _MM_TRANSPOSE4_PS(left[0].v, left[1].v, left[2].v, left[3].v);
+    _MM_TRANSPOSE4_PS(right[0].v, right[1].v, right[2].v, right[3].v);
+    _MM_TRANSPOSE4_PS(left[4].v, left[5].v, left[6].v, left[7].v);
+    _MM_TRANSPOSE4_PS(right[4].v, right[5].v, right[6].v, right[7].v);
+    for (size_t i = 0; i < 4; ++i) {
+        std::swap(right[i], left[4 + i]);
+    }
+}
+
+// 二维 DCT 与量化：先对列（一次 4 列）再对行，量化以 cvtps 按当前舍入模式（就近舍入到偶数）取整
+void TransformBlock(const float *block, const ComponentTables &tables, int16_t *coefficients) {
+    Float4 left[8];
+    Float4 right[8];
+    for (size_t row = 0; row < 8; ++row) {
+        left[row].v = _mm_loadu_ps(block + row * 8);
+        right[row].v = _mm_loadu_ps(block + row * 8 + 4);
+    }
+    ForwardDct8(left);
+    ForwardDct8(right);
+    Transpose8x8(left, right);
+    ForwardDct8(left);
+    ForwardDct8(right);
+    Transpose8x8(left, right);
+
+    for (size_t row = 0; row < 8; ++row) {
+        const __m128i low = _mm_cvtps_epi32(_mm_mul_ps(left[row].v, _mm_load_ps(&tables.reciprocals[row * 8])));
+        const __m128i high =
+            _mm_cvtps_epi32(_mm_mul_ps(right[row].v, _mm_load_ps(&tables.reciprocals[row * 8 + 4])));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(coefficients + row * 8), _mm_packs_epi32(low, high));
+    }
+}
+#else
+void TransformBlock(const float *block, const ComponentTables &tables, int16_t *coefficients) {
+    float data[64];
+    std::copy(block, block + 64, data);
+    float line[8];
+    for (size_t column = 0; column < 8; ++column) {
+        for (size_t i = 0; i < 8; ++i) {
+            line[i] = data[i * 8 + column];
+        }
+        ForwardDct8(line);
+        for (size_t i = 0; i < 8; ++i) {
+            data[i * 8 + column] = line[i];
+        }
+    }
+    for (size_t row = 0; row < 8; ++row) {
+        ForwardDct8(data + row * 8);
+    }
+    for (size_t i = 0; i < 64; ++i) {
+        const float value = std::clamp(std::nearbyint(data[i] * tables.reciprocals[i]), -32768.0f, 32767.0f);
+        coefficients[i] = static_cast<int16_t>(value);
+    }
+}
+#endif
+
+// 熵编码的位输出：满 8 位即写出字节，0xFF 之后补 0x00
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t> &out) : m_out(out) {}
+
+    void Put(uint32_t bits, int length) {
+        m_buffer = (m_buffer << length) | bits;
+        m_count += length;
+        while (m_count >= 8) {
+            const uint8_t byte = static_cast<uint8_t>(m_buffer >> (m_count - 8));
+            m_out.push_back(byte);
+            if (byte == 0xFF) {
+                m_out.push_back(0);
+            }
+            m_count -= 8;
+        }
+    }
+
+    // restart 区间结束：剩余位以 1 补齐到字节边界
+    void Flush() {
+        const int padding = (8 - m_count % 8) % 8;
+        Put((1u << padding) - 1, padding);
+    }
+
+private:
+    std::vector<uint8_t> &m_out;
+    uint64_t m_buffer = 0;
+    int m_count = 0;
+};
+
+int BitLength(int value) {
+    unsigned magnitude = static_cast<unsigned>(value < 0 ? -value : value);
+    int length = 0;
+    while (magnitude != 0) {
+        ++length;
+        magnitude >>= 1;
+    }
+    return length;
+}
+
+// 负数以 value - 1 的低位表示
+void PutValue(BitWriter &writer, int value, int length) {
+    if (length > 0) {
+        writer.Put(static_cast<uint32_t>(value < 0 ? value - 1 : value) & ((1u << length) - 1), length);
+    }
+}
+
+void EncodeBlock(BitWriter &writer, const int16_t *coefficients, int &dcPredictor, const ComponentTables &tables) {
+    const int dc = coefficients[0];
+    const int difference = dc - dcPredictor;
+    dcPredictor = dc;
+    const int dcLength = BitLength(difference);
+    writer.Put(tables.dc.codes[dcLength], tables.dc.lengths[dcLength]);
+    PutValue(writer, difference, dcLength);
+
+    int run = 0;
+    for (size_t k = 1; k < 64; ++k) {
+        const int value = coefficients[kZigzag[k]];
+        if (value == 0) {
+            ++run;
+            continue;
+        }
+        for (; run > 15; run -= 16) {
+            writer.Put(tables.ac.codes[0xF0], tables.ac.lengths[0xF0]);
+        }
+        const int length = BitLength(value);
+        const size_t symbol = static_cast<size_t>((run << 4) | length);
+        writer.Put(tables.ac.codes[symbol], tables.ac.lengths[symbol]);
+        PutValue(writer, value, length);
+        run = 0;
+    }
+    if (run > 0) {
+        writer.Put(tables.ac.codes[0x00], tables.ac.lengths[0x00]);
+    }
+}
+
+struct EncodeContext {
+    const uint8_t *pixels;
+    uint32_t width;
+    uint32_t height;
+    size_t rowBytes;
+    Source source;
+    const ComponentTables *luminance;
+    const ComponentTables *chrominance;
+};
+
+// 一个 restart 区间（一个 MCU 行）的熵编码数据。越过图像边缘的像素复制最后一行/列
+std::vector<uint8_t> EncodeMcuRow(const EncodeContext &context, uint32_t mcuRow) {
+    std::vector<uint8_t> out;
+    BitWriter writer(out);
+    int dcPredictors[3] = {};
+    alignas(16) float planes[3][64];
+    alignas(16) int16_t coefficients[64];
+
+    for (uint32_t blockX = 0; blockX < context.width; blockX += 8) {
+        for (uint32_t y = 0; y < 8; ++y) {
+            const uint32_t sourceY = (std::min)(mcuRow * 8 + y, context.height - 1);
+            const uint8_t *row = context.pixels + sourceY * context.rowBytes;
+            for (uint32_t x = 0; x < 8; ++x) {
+                const uint8_t *pixel = row + (std::min)(blockX + x, context.width - 1) * 4;
+                if (context.source == Source::Alpha) {
+                    planes[0][y * 8 + x] = static_cast<float>(pixel[3]) - 128.0f;
+                    continue;
+                }
+                const float b = pixel[0];
+                const float g = pixel[1];
+                const float r = pixel[2];
+                planes[0][y * 8 + x] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+                planes[1][y * 8 + x] = -0.168735892f * r - 0.331264108f * g + 0.5f * b;
+                planes[2][y * 8 + x] = 0.5f * r - 0.418687589f * g - 0.081312411f * b;
+            }
+        }
+
+        const size_t componentCount = context.source == Source::Alpha ? 1 : 3;
+        for (size_t component = 0; component < componentCount; ++component) {
+            const ComponentTables &tables = component == 0 ? *context.luminance : *context.chrominance;
+            TransformBlock(planes[component], tables, coefficients);
+            EncodeBlock(writer, coefficients, dcPredictors[component], tables);
+        }
+    }
+    writer.Flush();
+    return out;
+}
+
+void AppendMarker(std::vector<uint8_t> &out, uint8_t marker) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+}
+
+void AppendUint16(std::vector<uint8_t> &out, size_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void AppendHuffmanTable(std::vector<uint8_t> &out, uint8_t classAndId, const HuffmanSpec &spec) {
+    out.push_back(classAndId);
+    out.insert(out.end(), spec.counts.begin(), spec.counts.end());
+    out.insert(out.end(), spec.symbols, spec.symbols + spec.symbolCount);
+}
+
+} // namespace
+
+std::vector<uint8_t> MakeAppSegment(uint8_t n, const std::vector<uint8_t> &payload) {
+    if (n > 15 || payload.size() > 65533) {
+        throw std::runtime_error("JPEG APP" + std::to_string(n) + " segment too large");
+    }
+    std::vector<uint8_t> segment;
+    AppendMarker(segment, static_cast<uint8_t>(0xE0 + n));
+    AppendUint16(segment, payload.size() + 2);
+    segment.insert(segment.end(), payload.begin(), payload.end());
+    return segment;
+}
+
+std::vector<uint8_t> Encode(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowBytes, Source source,
+                            const Options &options, const std::vector<std::vector<uint8_t>> &segments) {
+    if (width == 0 || height == 0 || width > kMaxDimension || height > kMaxDimension) {
+        throw std::runtime_error("JPEG: unsupported image size " + std::to_string(width) + "x" +
+                                 std::to_string(height));
+    }
+    const bool color = source == Source::Bgr;
+    const ComponentTables luminance =
+        BuildComponentTables(kLuminanceQuantization, options.quality, kLuminanceDc, kLuminanceAc);
+    const ComponentTables chrominance =
+        BuildComponentTables(kChrominanceQuantization, options.quality, kChrominanceDc, kChrominanceAc);
+
+    // 各 MCU 行独立编码：线程按序领取行号，结果按行号存放。
+    // 任一线程出错（如内存不足）时其余线程停止领取，全部 join 之后在调用线程重新抛出第一个异常
+    const uint32_t mcuRows = (height + 7) / 8;
+    const uint32_t mcusPerRow = (width + 7) / 8;
+    const EncodeContext context{pixels, width, height, rowBytes, source, &luminance, &chrominance};
+    std::vector<std::vector<uint8_t>> intervals(mcuRows);
+    std::atomic<uint32_t> nextRow{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    const auto worker = [&] {
+        try {
+            for (uint32_t row = nextRow++; row < mcuRows; row = nextRow++) {
+                intervals[row] = EncodeMcuRow(context, row);
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+            nextRow = mcuRows;
+        }
+    };
+    const unsigned threads = (std::min)(
+        options.threads != 0 ? options.threads : (std::max)(std::thread::hardware_concurrency(), 1u), mcuRows);
+    std::vector<std::thread> helpers;
+    for (unsigned i = 1; i < threads; ++i) {
+        try {
+            helpers.emplace_back(worker);
+        } catch (const std::system_error &) {
+            break; // 无法再创建线程时由已有的线程完成剩余的行
+        }
+    }
+    worker();
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::vector<uint8_t> out;
+    AppendMarker(out, 0xD8); // SOI
+    const std::vector<uint8_t> jfif = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+    const std::vector<uint8_t> app0 = MakeAppSegment(0, jfif);
+    out.insert(out.end(), app0.begin(), app0.end());
+    for (const auto &segment : segments) {
+        out.insert(out.end(), segment.begin(), segment.end());
+    }
+
+    // DQT：表内按之字形顺序
+    AppendMarker(out, 0xDB);
+    AppendUint16(out, 2 + (color ? 2 : 1) * 65);
+    for (size_t table = 0; table < (color ? 2u : 1u); ++table) {
+        out.push_back(static_cast<uint8_t>(table));
+        const auto &quantization = table == 0 ? luminance.quantization : chrominance.quantization;
+        for (size_t k = 0; k < 64; ++k) {
+            out.push_back(quantization[kZigzag[k]]);
+        }
+    }
+
+    // SOF0：每个分量 1x1 采样，亮度用表 0，色度用表 1
+    const size_t componentCount = color ? 3 : 1;
+    AppendMarker(out, 0xC0);
+    AppendUint16(out, 8 + 3 * componentCount);
+    out.push_back(8);
+    AppendUint16(out, height);
+    AppendUint16(out, width);
+    out.push_back(static_cast<uint8_t>(componentCount));
+    for (size_t component = 0; component < componentCount; ++component) {
+        out.push_back(static_cast<uint8_t>(component + 1));
+        out.push_back(0x11);
+        out.push_back(component == 0 ? 0 : 1);
+    }
+
+    AppendMarker(out, 0xC4);
+    AppendUint16(out, 2 + (color ? 2 : 1) * (2 * 17 + 12 + 162));
+    AppendHuffmanTable(out, 0x00, kLuminanceDc);
+    AppendHuffmanTable(out, 0x10, kLuminanceAc);
+    if (color) {
+        AppendHuffmanTable(out, 0x01, kChrominanceDc);
+        AppendHuffmanTable(out, 0x11, kChrominanceAc);
+    }
+
+    // DRI：每个 MCU 行一个 restart 区间
+    AppendMarker(out, 0xDD);
+    AppendUint16(out, 4);
+    AppendUint16(out, mcusPerRow);
+
+    AppendMarker(out, 0xDA);
+    AppendUint16(out, 6 + 2 * componentCount);
+    out.push_back(static_cast<uint8_t>(componentCount));
+    for (size_t component = 0; component < componentCount; ++component) {
+        out.push_back(static_cast<uint8_t>(component + 1));
+        out.push_back(component == 0 ? 0x00 : 0x11);
+    }
+    out.push_back(0);
+    out.push_back(63);
+    out.push_back(0);
+
+    for (uint32_t row = 0; row < mcuRows; ++row) {
+        out.insert(out.end(), intervals[row].begin(), intervals[row].end());
+        if (row + 1 < mcuRows) {
+            AppendMarker(out, static_cast<uint8_t>(0xD0 + row % 8)); // RSTn
+        }
+    }
+    AppendMarker(out, 0xD9); // EOI
+    return out;
+}
+
+} // namespace JpegEncoder
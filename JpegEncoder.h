@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 内置的 baseline JPEG 编码器（JFIF，8-bit，Annex K 的标准 Huffman 表），Ultra HDR 输出使用，不依赖外部编解码库。
+// 彩色图像为 4:4:4 YCbCr：截图以文字与细线为主，不做色度子采样。
+// 每个 MCU 行是一个 restart 区间：各区间的 DCT、量化与熵编码互不依赖，分给多个线程并行，最后以 RSTn 标记按序拼接。
+// DCT 为 AAN 浮点蝶形，量化乘以预先算好的倒数（AAN 的缩放因子已并入）；x86 上以 SSE2 一次处理 4 列，
+// 其他平台使用运算顺序相同的标量实现，两者输出逐字节一致
+namespace JpegEncoder {
+
+// 输入像素每个 4 字节，按 B, G, R, A 排列
+enum class Source {
+    Bgr,   // 编码 BGR 为 YCbCr，忽略 A
+    Alpha, // 只把 A 编码为灰度图
+};
+
+struct Options {
+    int quality = 90;     // 1..100，按 IJG 的方式缩放标准量化表
+    unsigned threads = 0; // 0 表示使用 hardware_concurrency
+};
+
+// 附加标记段写在 SOI 与 JFIF APP0 之后，第一个附加段在码流中的偏移
+constexpr size_t kSegmentsOffset = 20;
+
+// pixels 为 height 行、每行 rowBytes 字节的图像。segments 为完整的标记段（含 0xFF 标记与长度），依次原样写入。
+// 返回从 SOI 到 EOI 的完整码流；尺寸超出 JPEG 的范围时抛出 std::runtime_error
+std::vector<uint8_t> Encode(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowBytes, Source source,
+                            const Options &options, const std::vector<std::vector<uint8_t>> &segments = {});
+
+// 把 payload 包装为 APPn 标记段；payload 超过 65533 字节时抛出 std::runtime_error
+std::vector<uint8_t> MakeAppSegment(uint8_t n, const std::vector<uint8_t> &payload);
+
+} // namespace JpegEncoder
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// 检测 / 处理 compute shader 的 kernel 变体：工作组形状、每个 invocation 处理的像素块，以及是否用 textureGather 读取。
+// 每行多于 1 个像素时输出使用向量存储（uvec2 / uvec4），要求输出宽度是 pixelsX 的整数倍。
+struct KernelConfig {
+    const char *name;
+    uint32_t localSizeX;
+    uint32_t localSizeY;
+    uint32_t pixelsX;
+    uint32_t pixelsY;
+    bool gather; // 2x2 像素块用三次 textureGather（R/G/B）代替四次 texelFetch
+
+    // 输出宽度为 width 时能否使用该变体
+    constexpr bool SupportsWidth(uint32_t width) const { return pixelsX == 1 || width % pixelsX == 0; }
+
+    constexpr uint32_t DispatchX(uint32_t width) const {
+        const uint32_t invocations = (width + pixelsX - 1) / pixelsX;
+        return (invocations + localSizeX - 1) / localSizeX;
+    }
+
+    constexpr uint32_t DispatchY(uint32_t height) const {
+        const uint32_t invocations = (height + pixelsY - 1) / pixelsY;
+        return (invocations + localSizeY - 1) / localSizeY;
+    }
+};
+
+// 变体集合变化时递增，使已保存的调优结果失效
+constexpr uint32_t kKernelFamilyVersion = 1;
+
+constexpr std::array<KernelConfig, 9> kKernelConfigs = {{
+    {"16x16", 16, 16, 1, 1, false},
+    {"8x8", 8, 8, 1, 1, false},
+    {"32x8", 32, 8, 1, 1, false},
+    {"16x16/4x1", 16, 16, 4, 1, false},
+    {"32x4/4x1", 32, 4, 4, 1, false},
+    {"8x8/2x2", 8, 8, 2, 2, false},
+    {"16x16/2x2", 16, 16, 2, 2, false},
+    {"8x8/2x2g", 8, 8, 2, 2, true},
+    {"16x16/2x2g", 16, 16, 2, 2, true},
+}};
+
+constexpr size_t kKernelConfigCount = kKernelConfigs.size();
+
+// 原先固定的 16x16、每像素一次 uint 存储；没有调优结果时使用，缩放路径的中间纹理也始终使用它
+constexpr size_t kDefaultKernelConfig = 0;
+
+static_assert(kKernelConfigs[kDefaultKernelConfig].pixelsX == 1 && kKernelConfigs[kDefaultKernelConfig].pixelsY == 1,
+              "Default kernel must accept any width");
+
+inline std::optional<size_t> FindKernelConfig(std::string_view name) {
+    for (size_t i = 0; i < kKernelConfigs.size(); ++i) {
+        if (name == kKernelConfigs[i].name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// 单写单读的最新值槽（三缓冲）。写端与读端各自持有一个槽，第三个槽的下标放在原子变量中，
+// 双方各用一次原子交换换槽，都不会阻塞；读端总是取到最后一次完整写入的值，其间被覆盖的值直接丢弃
+template <typename T>
+class LatestValue {
+public:
+    // 只在写线程调用
+    void Publish(const T &value) {
+        m_slots[m_writeIndex] = value;
+        const uint8_t previous =
+            m_shared.exchange(static_cast<uint8_t>(m_writeIndex | kFresh), std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+
+    // 只在读线程调用：自上次读取后有新值时写入 value 并返回 true
+    bool Take(T &value) {
+        if ((m_shared.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        const uint8_t previous = m_shared.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & kIndexMask;
+        value = m_slots[m_readIndex];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t kIndexMask = 3;
+    static constexpr uint8_t kFresh = 4;
+
+    std::array<T, 3> m_slots{};
+    std::atomic<uint8_t> m_shared{0}; // 交换中的槽位下标，带 kFresh 表示读端尚未取走
+    uint8_t m_writeIndex = 1;
+    uint8_t m_readIndex = 2;
+};
@@ -26,7 +26,11 @@ public:
 
         std::stringstream ss;
         struct tm timeinfo;
+#ifdef _WIN32
         localtime_s(&timeinfo, &time);
+#else
+        localtime_r(&time, &timeinfo);
+#endif
         ss << "[" << std::put_time(&timeinfo, "%Y-%m-%d %H:%M:%S") << "." << std::setfill('0') << std::setw(3)
            << ms.count() << "] " << message << std::endl;
 
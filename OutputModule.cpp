@@ -1,179 +1,105 @@
 #include "OutputModule.h"
+#include "CostModel.h"
+#include "CpuConversion.h"
 #include "GpuFrame.h"
+#include "KernelConfig.h"
 #include "Logger.h"
+#include "ShaderLibrary.h"
+#include "TransferLut.h"
+#include "TuningCache.h"
+#include "VulkanConverter.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES3/gl31.h>
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <initializer_list>
+#include <limits>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
-#include <windows.h>
 
 namespace {
 
-constexpr float kBt1886Gamma = 2.4f;
 constexpr float kReferencePeakNits = 1000.0f;
 constexpr float kSdrReferenceWhiteNits = 80.0f;
 constexpr float kMinLw = 0.000001f;
 constexpr float kDefaultLw = 1.0f;
 constexpr GLuint kLocalSizeX = 16;
 constexpr GLuint kLocalSizeY = 16;
+constexpr GLuint kTransferLutUnit = 1;
+constexpr GLuint kColorLutUnit = 2;
+constexpr GLuint kRedactionPatchUnit = 3; // 打码覆盖的 patch 纹理，见 BindRedactionOverlay
+
+// 重采样 tile：每个工作组沿重采样方向产生 kResampleTileOutputs 个输出，覆盖 kResampleTileLines 条扫描线。
+// 与 ShaderLibrary.cpp 中 kResampleShaderMain 的同名常量对应
+constexpr GLuint kResampleTileOutputs = 64;
+constexpr GLuint kResampleTileLines = 4;
+constexpr int kResampleTileCapacity = 160;
+
+// 局部色调映射的双边网格：与 ShaderLibrary.cpp 中 kLocalToneMapCommon 的 kCellSize / kBins 对应；
+// 模糊 pass 的工作组为 kLocalToneMapBlurGroup x kLocalToneMapBlurGroup 个单元
+constexpr uint32_t kLocalToneMapCellSize = 32;
+constexpr uint32_t kLocalToneMapBins = 12;
+constexpr GLuint kLocalToneMapBlurGroup = 8;
+
+// 多区域批量转换：与 ShaderLibrary.cpp 中 kRegionBatchCommon 的 kRegionTileSize / kRegionRgba16F 对应。
+// tile 序列按 kRegionDispatchWidth 个工作组一行铺成二维 dispatch，避免超过单维工作组数上限
+constexpr uint32_t kRegionTileSize = 16;
+constexpr uint32_t kRegionRgba16FFlag = 1;
+constexpr uint32_t kRegionDispatchWidth = 256;
+
+// 超过 kStreamingThresholdBytes 的 1x 计算输出按水平条带流式处理：每个条带约 kStreamingStripBytes，
+// kStreamingRingSize 个条带缓冲区轮流使用，峰值缓冲区占用为两者之积
+constexpr size_t kStreamingThresholdBytes = 32u << 20;
+constexpr size_t kStreamingStripBytes = 4u << 20;
+constexpr size_t kStreamingRingSize = 3;
+constexpr GLuint64 kFenceWaitTimeoutNs = 1000000000;
+constexpr float kLanczosRadius = 3.0f;
+constexpr float kBoxRadius = 0.5f;
+
+// 区域表的一项，布局与 kRegionBatchCommon 中的 Region 相同（std430，两个 16 字节向量）
+struct GpuRegion {
+    int32_t rect[4];       // 左上角 x, y，宽，高
+    uint32_t placement[4]; // 首个 tile 序号，每行 tile 数，输出偏移（uint 为单位），标志位
+};
 
-constexpr const char *kDetectionShaderSource = R"(#version 310 es
-precision highp float;
-precision highp int;
-
-layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
-
-layout(binding = 0) uniform highp sampler2D u_source;
-
-layout(std430, binding = 0) buffer DetectionBuffer {
-    uint foundHighlight;
-} u_detection;
-
-uniform ivec2 u_selectionOrigin;
-uniform ivec2 u_outputSize;
-uniform float u_lw;
+static_assert(sizeof(GpuRegion) == 32, "GpuRegion must match the std430 Region layout");
 
-void main() {
-    ivec2 gid = ivec2(gl_GlobalInvocationID.xy);
-    if (gid.x >= u_outputSize.x || gid.y >= u_outputSize.y) {
-        return;
-    }
+struct OutputSize {
+    uint32_t width;
+    uint32_t height;
+};
 
-    vec3 color = texelFetch(u_source, u_selectionOrigin + gid, 0).rgb;
-    if (any(greaterThan(color, vec3(u_lw)))) {
-        atomicOr(u_detection.foundHighlight, 1u);
+OutputSize ResolveOutputSize(const OutputScale &scale, uint32_t width, uint32_t height) {
+    float factor = scale.factor;
+    if (scale.maxDimension != 0) {
+        factor = (std::min)(1.0f, static_cast<float>(scale.maxDimension) / static_cast<float>((std::max)(width, height)));
     }
-}
-)";
-
-constexpr const char *kProcessingShaderSource = R"(#version 310 es
-precision highp float;
-precision highp int;
-
-layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
-
-layout(binding = 0) uniform highp sampler2D u_source;
-
-layout(std430, binding = 0) buffer OutputBuffer {
-    uint pixels[];
-} u_output;
-
-uniform ivec2 u_selectionOrigin;
-uniform ivec2 u_outputSize;
-uniform float u_lw;
-uniform bool u_useHlgPath;
-
-const float kBt1886Gamma = 2.4;
-const float kHlgA = 0.17883277;
-const float kHlgB = 1.0 - 4.0 * kHlgA;
-const float kHlgC = 0.55991073;
-const float kReferencePeakNits = 1000.0;
-const float kScRgbReferenceWhiteNits = 80.0;
-const float kSrgbLinearThreshold = 0.0031308;
-const float kSrgbLowSlope = 12.92;
-const float kSrgbHighScale = 1.055;
-const float kSrgbHighOffset = 0.055;
-
-vec3 SrgbLinearToBt2020Linear(vec3 color) {
-    return vec3(
-        0.6274040 * color.r + 0.3292820 * color.g + 0.0433136 * color.b,
-        0.0690970 * color.r + 0.9195400 * color.g + 0.0113612 * color.b,
-        0.0163916 * color.r + 0.0880132 * color.g + 0.8955950 * color.b
-    );
-}
-
-vec3 Bt2020LinearToBt709Linear(vec3 color) {
-    return vec3(
-        1.6604910 * color.r - 0.5876411 * color.g - 0.0728499 * color.b,
-        -0.1245505 * color.r + 1.1328999 * color.g - 0.0083494 * color.b,
-        -0.0181508 * color.r - 0.1005789 * color.g + 1.1187297 * color.b
-    );
-}
-
-float Clamp01(float value) {
-    return clamp(value, 0.0, 1.0);
-}
-
-float HlgOetf(float linearValue) {
-    linearValue = Clamp01(linearValue);
-    if (linearValue <= (1.0 / 12.0)) {
-        return sqrt(3.0 * linearValue);
+    if (!(factor > 0.0f) || factor > 1.0f) {
+        throw std::runtime_error("Output scale must be in (0, 1]");
     }
-    return kHlgA * log(12.0 * linearValue - kHlgB) + kHlgC;
-}
-
-float Bt1886Eotf(float signalValue) {
-    return pow(Clamp01(signalValue), kBt1886Gamma);
-}
-
-float Bt1886Oetf(float linearValue) {
-    return pow(Clamp01(linearValue), 1.0 / kBt1886Gamma);
+    return {(std::max)(1u, static_cast<uint32_t>(std::lround(width * factor))),
+            (std::max)(1u, static_cast<uint32_t>(std::lround(height * factor)))};
 }
 
-float LinearToSrgb(float linearValue) {
-    linearValue = Clamp01(linearValue);
-    if (linearValue <= kSrgbLinearThreshold) {
-        return linearValue * kSrgbLowSlope;
-    }
-    return kSrgbHighScale * pow(linearValue, 1.0 / 2.4) - kSrgbHighOffset;
+// 一个工作组在重采样方向上需要读取的源像素数，必须放得进 shared memory 中的 tile
+int ResampleTileSpan(float scale, ScaleFilter filter) {
+    const float radius = filter == ScaleFilter::Box ? kBoxRadius : kLanczosRadius;
+    const float support = radius * (std::max)(1.0f / scale, 1.0f);
+    return static_cast<int>(std::ceil((kResampleTileOutputs - 1) / scale + 2.0f * support)) + 2;
 }
 
-void main() {
-    ivec2 gid = ivec2(gl_GlobalInvocationID.xy);
-    if (gid.x >= u_outputSize.x || gid.y >= u_outputSize.y) {
-        return;
-    }
-
-    int pixelIndex = gid.y * u_outputSize.x + gid.x;
-    vec3 color = max(texelFetch(u_source, u_selectionOrigin + gid, 0).rgb, vec3(0.0));
-    vec3 outputColor;
-
-    if (u_useHlgPath) {
-        vec3 bt2020Linear = SrgbLinearToBt2020Linear(color);
-        // Windows advanced color scRGB capture is absolute-referred:
-        // a linear value of 1.0 corresponds to 80 nits.
-        vec3 hlg = vec3(
-            HlgOetf(bt2020Linear.r * kScRgbReferenceWhiteNits / kReferencePeakNits),
-            HlgOetf(bt2020Linear.g * kScRgbReferenceWhiteNits / kReferencePeakNits),
-            HlgOetf(bt2020Linear.b * kScRgbReferenceWhiteNits / kReferencePeakNits)
-        );
-        vec3 interpretedLinear = vec3(
-            Bt1886Eotf(hlg.r),
-            Bt1886Eotf(hlg.g),
-            Bt1886Eotf(hlg.b)
-        );
-        vec3 bt709Linear = Bt2020LinearToBt709Linear(interpretedLinear);
-        outputColor = vec3(
-            Bt1886Oetf(bt709Linear.r),
-            Bt1886Oetf(bt709Linear.g),
-            Bt1886Oetf(bt709Linear.b)
-        );
-    } else {
-        vec3 normalized = clamp(color / u_lw, vec3(0.0), vec3(1.0));
-        outputColor = vec3(
-            LinearToSrgb(normalized.r),
-            LinearToSrgb(normalized.g),
-            LinearToSrgb(normalized.b)
-        );
-    }
-
-    u_output.pixels[pixelIndex] = packUnorm4x8(vec4(
-        outputColor.b,
-        outputColor.g,
-        outputColor.r,
-        1.0
-    ));
-}
-)";
-
 SelectionRect ClampSelectionToFrame(const SelectionRect &selection, uint32_t frameWidth, uint32_t frameHeight) {
     SelectionRect clamped = selection;
     clamped.x1 = std::clamp(clamped.x1, 0, static_cast<int>(frameWidth));
@@ -183,57 +109,30 @@ SelectionRect ClampSelectionToFrame(const SelectionRect &selection, uint32_t fra
     return clamped;
 }
 
-void WriteBitmapToClipboard(const std::vector<uint8_t> &bgraPixels, int width, int height) {
-    const SIZE_T headerSize = sizeof(BITMAPV5HEADER);
-    const SIZE_T pixelBytes = static_cast<SIZE_T>(width) * static_cast<SIZE_T>(height) * 4;
-    HGLOBAL dibMemory = GlobalAlloc(GMEM_MOVEABLE, headerSize + pixelBytes);
-    if (!dibMemory) {
-        throw std::runtime_error("GlobalAlloc failed for clipboard bitmap");
-    }
-
-    void *memory = GlobalLock(dibMemory);
-    if (!memory) {
-        GlobalFree(dibMemory);
-        throw std::runtime_error("GlobalLock failed for clipboard bitmap");
-    }
-
-    auto *header = static_cast<BITMAPV5HEADER *>(memory);
-    std::memset(header, 0, headerSize);
-    header->bV5Size = sizeof(BITMAPV5HEADER);
-    header->bV5Width = width;
-    header->bV5Height = -height;
-    header->bV5Planes = 1;
-    header->bV5BitCount = 32;
-    header->bV5Compression = BI_BITFIELDS;
-    header->bV5SizeImage = static_cast<DWORD>(pixelBytes);
-    header->bV5RedMask = 0x00FF0000;
-    header->bV5GreenMask = 0x0000FF00;
-    header->bV5BlueMask = 0x000000FF;
-    header->bV5AlphaMask = 0xFF000000;
-    header->bV5CSType = LCS_sRGB;
-
-    auto *dstPixels = reinterpret_cast<uint8_t *>(header + 1);
-    std::memcpy(dstPixels, bgraPixels.data(), pixelBytes);
-    GlobalUnlock(dibMemory);
-
-    if (!OpenClipboard(nullptr)) {
-        GlobalFree(dibMemory);
-        throw std::runtime_error("OpenClipboard failed");
-    }
-
-    if (!EmptyClipboard()) {
-        CloseClipboard();
-        GlobalFree(dibMemory);
-        throw std::runtime_error("EmptyClipboard failed");
+// 求和面积表属于被转换的帧且阈值相同时，由它判断选区有无高光；否则返回空，照常运行检测
+std::optional<bool> HighlightFromStatistics(const ConversionOptions &options, const GpuFrame &gpuFrame,
+                                            const SelectionRect &selection, float threshold) {
+    if (!options.statistics || &options.statistics->Frame() != &gpuFrame ||
+        options.statistics->DetectionThreshold() != threshold) {
+        return std::nullopt;
     }
+    return options.statistics->HasHighlight(selection);
+}
 
-    if (!SetClipboardData(CF_DIBV5, dibMemory)) {
-        CloseClipboard();
-        GlobalFree(dibMemory);
-        throw std::runtime_error("SetClipboardData failed");
+// 打码矩形与选区的交集（帧坐标）；不相交的矩形被丢弃
+std::vector<SelectionRect> RedactionsInSelection(const std::vector<SelectionRect> &redactions,
+                                                 const SelectionRect &selection) {
+    std::vector<SelectionRect> result;
+    for (const auto &rect : redactions) {
+        const int left = (std::max)(rect.Left(), selection.Left());
+        const int top = (std::max)(rect.Top(), selection.Top());
+        const int right = (std::min)(rect.Right(), selection.Right());
+        const int bottom = (std::min)(rect.Bottom(), selection.Bottom());
+        if (right > left && bottom > top) {
+            result.push_back({left, top, right, bottom});
+        }
     }
-
-    CloseClipboard();
+    return result;
 }
 
 std::string DescribeEglError(EGLint error) {
@@ -311,9 +210,9 @@ float ResolveSdrWhiteNits(float sdrWhiteNits) {
     return sdrWhiteNits;
 }
 
-GLuint CompileComputeProgram(const char *shaderSource) {
-    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
-    glShaderSource(shader, 1, &shaderSource, nullptr);
+GLuint CompileShader(GLenum type, ShaderLibrary::ShaderSource source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, static_cast<GLsizei>(source.count), source.parts, nullptr);
     glCompileShader(shader);
 
     GLint compileStatus = GL_FALSE;
@@ -321,25 +220,397 @@ GLuint CompileComputeProgram(const char *shaderSource) {
     if (compileStatus != GL_TRUE) {
         const std::string infoLog = GetShaderInfoLog(shader);
         glDeleteShader(shader);
-        throw std::runtime_error("Failed to compile compute shader: " + infoLog);
+        const char *stage = type == GL_COMPUTE_SHADER ? "compute" : type == GL_VERTEX_SHADER ? "vertex" : "fragment";
+        throw std::runtime_error(std::string("Failed to compile ") + stage + " shader: " + infoLog);
     }
+    return shader;
+}
 
+// 链接后删除传入的 shader
+GLuint LinkProgram(std::initializer_list<GLuint> shaders) {
     GLuint program = glCreateProgram();
-    glAttachShader(program, shader);
+    for (GLuint shader : shaders) {
+        glAttachShader(program, shader);
+    }
     glLinkProgram(program);
-    glDeleteShader(shader);
+    for (GLuint shader : shaders) {
+        glDeleteShader(shader);
+    }
 
     GLint linkStatus = GL_FALSE;
     glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
     if (linkStatus != GL_TRUE) {
         const std::string infoLog = GetProgramInfoLog(program);
         glDeleteProgram(program);
-        throw std::runtime_error("Failed to link compute shader program: " + infoLog);
+        throw std::runtime_error("Failed to link shader program: " + infoLog);
     }
 
     return program;
 }
 
+GLuint CompileComputeProgram(ShaderLibrary::ShaderSource source) {
+    return LinkProgram({CompileShader(GL_COMPUTE_SHADER, source)});
+}
+
+GLuint CompileRenderProgram(ShaderLibrary::ShaderSource vertexSource, ShaderLibrary::ShaderSource fragmentSource) {
+    const GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = 0;
+    try {
+        fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    } catch (...) {
+        glDeleteShader(vertexShader);
+        throw;
+    }
+    return LinkProgram({vertexShader, fragmentShader});
+}
+
+GLuint CreateTransferLutTexture() {
+    const auto data = TransferLut::BuildTextureData();
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, static_cast<GLsizei>(TransferLut::kSize),
+                 static_cast<GLsizei>(TransferLut::kCurveCount), 0, GL_RED, GL_HALF_FLOAT, data.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// 色彩管理查找表：RGBA16F 3D 纹理，三线性过滤
+GLuint CreateColorLutTexture(const ColorLut &lut) {
+    const GLsizei size = static_cast<GLsizei>(lut.Size());
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, size, size, size, 0, GL_RGBA, GL_HALF_FLOAT,
+                 lut.TextureData().data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return texture;
+}
+
+float ComputeSourcePeak(const DisplayHdrInfo &hdrInfo, float lw) {
+    const float peakNits = hdrInfo.peakBrightness > 0.0f ? hdrInfo.peakBrightness : kReferencePeakNits;
+    return (std::max)(peakNits / kSdrReferenceWhiteNits, lw);
+}
+
+struct ScopedBuffer {
+    GLuint id = 0;
+    ~ScopedBuffer() { if (id != 0) glDeleteBuffers(1, &id); }
+};
+
+// 分配 count 个 T 的 SSBO，供着色器写入后由 ReadBackStorage 读回
+template <typename T>
+void AllocateStorage(ScopedBuffer &buffer, size_t count) {
+    glGenBuffers(1, &buffer.id);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(count * sizeof(T)), nullptr, GL_DYNAMIC_COPY);
+}
+
+template <typename T>
+std::vector<T> ReadBackStorage(const ScopedBuffer &buffer, size_t count) {
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(count * sizeof(T));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer.id);
+    const auto *mapped = static_cast<const T *>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+    if (!mapped) {
+        throw std::runtime_error("Failed to map SSBO for readback");
+    }
+    std::vector<T> values(mapped, mapped + count);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return values;
+}
+
+// 流式处理的一个条带缓冲区，fence 在该条带的处理 dispatch 之后插入
+struct StreamingSlot {
+    ScopedBuffer buffer;
+    GLsync fence = nullptr;
+    ~StreamingSlot() { ResetFence(nullptr); }
+    void ResetFence(GLsync sync) {
+        if (fence != nullptr) glDeleteSync(fence);
+        fence = sync;
+    }
+};
+
+// 等待 fence 发出信号；超时只是为了周期性地返回，出错时抛出
+void WaitForFence(GLsync fence) {
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceWaitTimeoutNs);
+    }
+    if (status == GL_WAIT_FAILED) {
+        throw std::runtime_error("glClientWaitSync failed");
+    }
+}
+
+struct ScopedTexture {
+    GLuint id = 0;
+    ~ScopedTexture() { Reset(0); }
+    void Reset(GLuint texture) {
+        if (id != 0) glDeleteTextures(1, &id);
+        id = texture;
+    }
+};
+
+// 片元后端的 RGBA8 渲染目标，大小与选区相同
+struct RenderTarget {
+    GLuint framebuffer = 0;
+    GLuint renderbuffer = 0;
+
+    ~RenderTarget() {
+        if (framebuffer != 0) glDeleteFramebuffers(1, &framebuffer);
+        if (renderbuffer != 0) glDeleteRenderbuffers(1, &renderbuffer);
+    }
+
+    void Create(uint32_t width, uint32_t height) {
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+        const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            throw std::runtime_error("Fragment backend framebuffer incomplete: " + std::to_string(status));
+        }
+    }
+};
+
+// 缩放路径的 RGBA16F 中间纹理，只通过 texelFetch / imageStore 访问
+GLuint CreateIntermediateTexture(uint32_t width, uint32_t height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// 局部色调映射的双边网格：每个单元 kLocalToneMapBins 档，RGBA16F 可线性过滤，切片时由硬件做三线性插值
+GLuint CreateLocalToneMapGrid(uint32_t cellsX, uint32_t cellsY) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_3D, texture);
+    glTexStorage3D(GL_TEXTURE_3D, 1, GL_RGBA16F, static_cast<GLsizei>(cellsX), static_cast<GLsizei>(cellsY),
+                   static_cast<GLsizei>(kLocalToneMapBins));
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    return texture;
+}
+
+GLuint DispatchCount(uint32_t size, GLuint localSize) { return (size + localSize - 1) / localSize; }
+
+// 打码模糊着色器沿模糊方向的工作组大小，与 kRedactionBlurMain 一致
+constexpr GLuint kRedactionBlurGroupSize = 64;
+
+// 自动调优：在合成画面上测量每个 kernel 变体，按渲染器保存排名（逗号分隔的变体名，最快在前）
+constexpr uint32_t kAutotuneWidth = 1920;
+constexpr uint32_t kAutotuneHeight = 1088;
+constexpr int kAutotuneIterations = 5;
+
+std::string KernelRankingKey(const char *pass) {
+    return "kernels.v" + std::to_string(kKernelFamilyVersion) + "." + pass;
+}
+
+constexpr const char *kBackendTuningKey = "backend.v1";
+
+// 延迟模型：标定时在两种正方形选区上端到端测量，取自标定画面右下角以覆盖 HDR 路径。
+// 标定失败的后端在缓存中记为 kUnavailableCostModel，之后不再尝试
+constexpr std::array<uint32_t, 2> kCostCalibrationSizes = {64, 1024};
+constexpr std::array<ConversionBackend, 3> kRoutedBackends = {ConversionBackend::Compute, ConversionBackend::Fragment,
+                                                               ConversionBackend::Cpu};
+constexpr const char *kUnavailableCostModel = "unavailable";
+
+std::string CostModelKey(ConversionBackend backend) {
+    return std::string("cost.v1.") + ConversionBackendName(backend);
+}
+
+constexpr SelectionRect kAutotuneSelection{0, 0, static_cast<int>(kAutotuneWidth), static_cast<int>(kAutotuneHeight)};
+
+DisplayHdrInfo AutotuneHdrInfo() {
+    return DisplayHdrInfo{kSdrReferenceWhiteNits, kReferencePeakNits, 0.0f, kReferencePeakNits, kReferencePeakNits};
+}
+
+// 任何名字无法识别时整条排名作废，重新调优
+std::vector<size_t> ParseKernelRanking(const std::optional<std::string> &text) {
+    std::vector<size_t> ranking;
+    if (!text) {
+        return ranking;
+    }
+    std::istringstream stream(*text);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        const auto index = FindKernelConfig(name);
+        if (!index) {
+            return {};
+        }
+        ranking.push_back(*index);
+    }
+    return ranking;
+}
+
+std::string FormatKernelRanking(const std::vector<size_t> &ranking) {
+    std::string text;
+    for (size_t index : ranking) {
+        text += (text.empty() ? "" : ",") + std::string(kKernelConfigs[index].name);
+    }
+    return text;
+}
+
+// 排名中第一个能处理该宽度的变体；都不行时使用默认变体
+size_t SelectKernelConfig(const std::vector<size_t> &ranking, uint32_t width) {
+    for (size_t index : ranking) {
+        if (kKernelConfigs[index].SupportsWidth(width)) {
+            return index;
+        }
+    }
+    return kDefaultKernelConfig;
+}
+
+std::string RendererTuningSection() {
+    const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    return std::string(renderer ? renderer : "unknown") + " | " + (version ? version : "unknown");
+}
+
+// 自动调优用的合成 scRGB 画面：对角渐变，右下角超过 SDR 白以覆盖 HDR 路径的取值范围
+GLuint CreateAutotuneTexture() {
+    std::vector<float> pixels(static_cast<size_t>(kAutotuneWidth) * kAutotuneHeight * 4);
+    for (uint32_t y = 0; y < kAutotuneHeight; ++y) {
+        for (uint32_t x = 0; x < kAutotuneWidth; ++x) {
+            float *px = &pixels[(static_cast<size_t>(y) * kAutotuneWidth + x) * 4];
+            px[0] = 4.0f * static_cast<float>(x) / kAutotuneWidth;
+            px[1] = 4.0f * static_cast<float>(y) / kAutotuneHeight;
+            px[2] = 2.0f * static_cast<float>(x + y) / (kAutotuneWidth + kAutotuneHeight);
+            px[3] = 1.0f;
+        }
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, kAutotuneWidth, kAutotuneHeight);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kAutotuneWidth, kAutotuneHeight, GL_RGBA, GL_FLOAT, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// 延迟模型标定用的 CPU 侧帧：与 CreateAutotuneTexture 相同的对角渐变
+std::shared_ptr<CapturedFrame> CreateCalibrationFrame() {
+    const uint32_t size = kCostCalibrationSizes.back();
+    auto frame = std::make_shared<CapturedFrame>();
+    frame->metadata = {size, size, size * 4 * static_cast<uint32_t>(sizeof(uint16_t))};
+    frame->pixelData.resize(static_cast<size_t>(frame->metadata.rowPitch) * size);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint16_t pixel[4] = {
+                TransferLut::FloatToHalf(4.0f * x / size),
+                TransferLut::FloatToHalf(4.0f * y / size),
+                TransferLut::FloatToHalf(2.0f * (x + y) / (2.0f * size)),
+                TransferLut::FloatToHalf(1.0f),
+            };
+            std::memcpy(&frame->pixelData[(static_cast<size_t>(y) * size + x) * sizeof(pixel)], pixel, sizeof(pixel));
+        }
+    }
+    return frame;
+}
+
+bool AllOutputsUnscaled(const std::vector<ScaledOutput> &outputs, uint32_t width, uint32_t height) {
+    return std::all_of(outputs.begin(), outputs.end(), [&](const ScaledOutput &output) {
+        const OutputSize size = ResolveOutputSize(output.scale, width, height);
+        return size.width == width && size.height == height;
+    });
+}
+
+double StageP50(const TimingStats &stats, const char *stage) {
+    for (const auto &entry : stats.Snapshot()) {
+        if (entry.stage == stage) {
+            return entry.p50Ms;
+        }
+    }
+    return 0.0;
+}
+
+// 打码 program 的索引
+enum RedactionProgram : size_t {
+    kRedactBlurHorizontal,
+    kRedactBlurVertical,
+    kRedactMosaic,
+    kRedactionProgramCount,
+};
+
+ShaderLibrary::ShaderSource RedactionShader(size_t program) {
+    switch (program) {
+    case kRedactBlurHorizontal:
+        return ShaderLibrary::RedactionBlurShader(false);
+    case kRedactBlurVertical:
+        return ShaderLibrary::RedactionBlurShader(true);
+    default:
+        return ShaderLibrary::RedactionMosaicShader();
+    }
+}
+
+// 选区副本（局部色调映射的结果）：尺寸与选区相同，坐标以选区左上角为原点。
+// 只替换了纹理，GetCpuFrame 仍是原始帧，因此只能交给 GL 后端。纹理由调用者管理
+class SelectionCopyFrame final : public GpuFrame {
+public:
+    SelectionCopyFrame(const GpuFrame &source, EGLDisplay display, EGLSurface surface, EGLContext context,
+                       GLuint texture, uint32_t width, uint32_t height)
+        : m_source(source), m_display(display), m_surface(surface), m_context(context), m_texture(texture),
+          m_width(width), m_height(height) {}
+
+    EGLDisplay GetDisplay() const override { return m_display; }
+    EGLContext GetContext() const override { return m_context; }
+    EGLSurface GetSurface() const override { return m_surface; }
+    GLuint GetTextureId() const override { return m_texture; }
+    uint32_t Width() const override { return m_width; }
+    uint32_t Height() const override { return m_height; }
+    const CapturedFrame &GetCpuFrame() const override { return m_source.GetCpuFrame(); }
+
+private:
+    const GpuFrame &m_source;
+    EGLDisplay m_display;
+    EGLSurface m_surface;
+    EGLContext m_context;
+    GLuint m_texture;
+    uint32_t m_width;
+    uint32_t m_height;
+};
+
+// 一次转换的打码覆盖（见 ShaderLibrary.cpp 的 kRedactionOverlay）：各矩形打码后拼排在 patches 中。
+// 只作用于读取 source 纹理的 pass；局部色调映射的副本已经打码，读取它时不再覆盖
+struct RedactionOverlay {
+    GLuint source = 0;
+    GLuint patches = 0;
+    std::vector<GLint> rects;   // 每个矩形 4 个值：帧坐标的左、上、右、下
+    std::vector<GLint> origins; // 每个矩形 2 个值：在 patches 中的左上角
+};
+
 class OutputModuleImpl final : public OutputModule {
 public:
     OutputModuleImpl(EGLDisplay display, EGLSurface dummySurface, EGLContext context)
@@ -347,142 +618,2125 @@ public:
         if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
             throw std::runtime_error("OutputModuleImpl: eglMakeCurrent failed during init");
         }
-        m_detectProgram  = CompileComputeProgram(kDetectionShaderSource);
-        m_processProgram = CompileComputeProgram(kProcessingShaderSource);
+        GLint majorVersion = 0;
+        GLint minorVersion = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+        glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &m_maxRenderbufferSize);
+        m_computeSupported = majorVersion > 3 || (majorVersion == 3 && minorVersion >= 1);
+        m_tuningSection = RendererTuningSection();
+        if (m_computeSupported) {
+            GetDetectionProgram(kDefaultKernelConfig);
+            m_reduceProgram = CompileComputeProgram(ShaderLibrary::ReduceShader());
+        } else {
+            LOG("OutputModuleImpl: OpenGL ES " + std::to_string(majorVersion) + "." + std::to_string(minorVersion) +
+                " context without compute shaders, only the fragment backend is available.");
+        }
+        m_transferLut   = CreateTransferLutTexture();
         eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 
     ~OutputModuleImpl() {
         if (eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
-            if (m_detectProgram  != 0) glDeleteProgram(m_detectProgram);
-            if (m_processProgram != 0) glDeleteProgram(m_processProgram);
+            m_timer.reset();
+            for (GLuint program : m_detectPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            if (m_reduceProgram != 0) glDeleteProgram(m_reduceProgram);
+            if (m_tileDetectProgram != 0) glDeleteProgram(m_tileDetectProgram);
+            if (m_frameStatisticsProgram != 0) glDeleteProgram(m_frameStatisticsProgram);
+            for (GLuint program : m_processPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            for (GLuint program : m_resamplePrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            for (GLuint program : m_fragmentPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            if (m_fragmentDetectProgram != 0) glDeleteProgram(m_fragmentDetectProgram);
+            if (m_regionDetectProgram != 0) glDeleteProgram(m_regionDetectProgram);
+            for (GLuint program : m_regionProcessPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            for (GLuint program : m_redactionPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            for (GLuint program : m_localToneMapPrograms) {
+                if (program != 0) glDeleteProgram(program);
+            }
+            if (m_transferLut != 0) glDeleteTextures(1, &m_transferLut);
+            if (m_colorLutTexture != 0) glDeleteTextures(1, &m_colorLutTexture);
             eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         } else {
             LOG("OutputModuleImpl: eglMakeCurrent failed during destroy, shader program might leak");
         }
     }
 
-    void CopySelectionToClipboard(const GpuFrame &gpuFrame, const SelectionRect &selection,
-                                  const DisplayHdrInfo &hdrInfo) override {
+    void ConvertSelectionToSink(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                                ImageSink &sink) override {
+        ConvertSelectionToSinks(gpuFrame, selection, hdrInfo, options, {ScaledOutput{OutputScale{}, &sink}});
+    }
+
+    void ConvertSelectionToSinks(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                 const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                                 const std::vector<ScaledOutput> &outputs) override {
         const SelectionRect clampedSelection = ClampSelectionToFrame(selection, gpuFrame.Width(), gpuFrame.Height());
         if (!clampedSelection.IsValid()) {
             throw std::runtime_error("Selection is empty after clamping");
         }
 
-        const int   outputWidth   = clampedSelection.Width();
-        const int   outputHeight  = clampedSelection.Height();
-        const float sdrWhiteNits  = ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel);
+        // 全部输出为 1x 时，Auto 由延迟模型在计算、片元与 CPU 后端中选择；打码与局部色调映射只能使用 GL 后端
+        const uint32_t width = static_cast<uint32_t>(clampedSelection.Width());
+        const uint32_t height = static_cast<uint32_t>(clampedSelection.Height());
+        const std::vector<SelectionRect> redactions = RedactionsInSelection(options.redactions, clampedSelection);
+        std::optional<CostRoute> route;
+        ConversionOptions resolvedOptions = options;
+        const bool glOnly = !redactions.empty() || options.localToneMapping;
+        if (glOnly && (options.backend == ConversionBackend::Cpu || options.backend == ConversionBackend::Vulkan)) {
+            const char *feature = redactions.empty() ? "local tone mapping" : "redaction";
+            throw std::runtime_error(std::string(ConversionBackendName(options.backend)) +
+                                     " backend does not support " + feature);
+        }
+        if (options.backend == ConversionBackend::Auto && !glOnly && AllOutputsUnscaled(outputs, width, height) &&
+            CostModelsReady()) {
+            route = RouteByCost(outputs, width, height);
+            resolvedOptions.backend = route->backend;
+        }
+
+        const float sdrWhiteNits = ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel);
+        LOG("Converting selection, backend=" + std::string(ConversionBackendName(resolvedOptions.backend)) +
+            ". Rect=(" + std::to_string(clampedSelection.Left()) + "," + std::to_string(clampedSelection.Top()) +
+            ")-(" + std::to_string(clampedSelection.Right()) + "," + std::to_string(clampedSelection.Bottom()) +
+            "), SDR white=" + std::to_string(sdrWhiteNits) +
+            ", operator=" +
+            (options.localToneMapping ? "local" : GetToneMapOperatorInfo(options.toneMapOperator).name) +
+            (redactions.empty() ? "" : ", " + std::to_string(redactions.size()) + " redacted rects"));
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!redactions.empty()) {
+            // 只把打码矩形处理到 patch 纹理，检测与处理读取源帧时以它覆盖矩形内的像素；
+            // 整帧统计来自未打码的源帧，不能用来判断选区有无高光
+            resolvedOptions.statistics = nullptr;
+            BuildRedactionOverlay(gpuFrame, redactions, options);
+        }
+        try {
+            RunConversion(gpuFrame, clampedSelection, hdrInfo, resolvedOptions, outputs);
+        } catch (...) {
+            ReleaseRedactionOverlay();
+            throw;
+        }
+        ReleaseRedactionOverlay();
+        if (route) {
+            RecordCost(*route, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                   .count());
+        }
+    }
+
+    void ConvertRegionsToSinks(const GpuFrame &gpuFrame, const DisplayHdrInfo &hdrInfo,
+                               const ConversionOptions &options, const std::vector<RegionOutput> &regions) override {
+        if (regions.empty()) {
+            return;
+        }
+        std::vector<SelectionRect> selections;
+        for (size_t i = 0; i < regions.size(); ++i) {
+            const SelectionRect clamped =
+                ClampSelectionToFrame(regions[i].selection, gpuFrame.Width(), gpuFrame.Height());
+            if (!clamped.IsValid()) {
+                throw std::runtime_error("Region " + std::to_string(i) + " is empty after clamping");
+            }
+            selections.push_back(clamped);
+        }
+        // 批量处理着色器没有色彩管理、增益图与局部色调映射变体，也直接读取源帧，这些情况逐区域转换
+        const bool gainMap = std::any_of(regions.begin(), regions.end(), [](const RegionOutput &region) {
+            return region.sink->PreferredFormat() == OutputPixelFormat::Bgra8GainMap;
+        });
+        if (options.colorLut || gainMap || !options.redactions.empty() || options.localToneMapping) {
+            LOG(std::string(options.colorLut                ? "Color LUT set"
+                            : gainMap                       ? "Gain map output"
+                            : !options.redactions.empty()   ? "Redaction set"
+                                                            : "Local tone mapping set") +
+                ", converting " + std::to_string(regions.size()) + " regions one by one.");
+            for (const auto &region : regions) {
+                ConvertSelectionToSinks(gpuFrame, region.selection, hdrInfo, options,
+                                        {ScaledOutput{OutputScale{}, region.sink}});
+            }
+            return;
+        }
+        RequireCompute("Multi-region conversion");
+
+        LOG("Converting " + std::to_string(regions.size()) + " regions in one batch, SDR white=" +
+            std::to_string(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel)) +
+            ", operator=" + GetToneMapOperatorInfo(options.toneMapOperator).name);
+
+        MakeCurrent("ConvertRegionsToSinks");
+        size_t hdrRegions = 0;
+        try {
+            hdrRegions = RunRegionBatch(gpuFrame, selections, regions, hdrInfo, options.toneMapOperator);
+            if (m_timer) {
+                m_timer->Collect(true);
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
 
-        LOG("Copying selection to clipboard via compute shader. Rect=(" + std::to_string(clampedSelection.Left()) +
-            "," + std::to_string(clampedSelection.Top()) + ")-(" + std::to_string(clampedSelection.Right()) + "," +
-            std::to_string(clampedSelection.Bottom()) + "), SDR white=" + std::to_string(sdrWhiteNits));
+        if (m_timer) {
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+        LOG("Region batch done: " + std::to_string(hdrRegions) + " of " + std::to_string(regions.size()) +
+            " regions used the HDR path.");
+    }
 
-        std::vector<uint8_t> bgraPixels = ConvertSelection(gpuFrame, clampedSelection, sdrWhiteNits);
-        WriteBitmapToClipboard(bgraPixels, outputWidth, outputHeight);
+#ifdef _WIN32
+    void CopySelectionToClipboard(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                  const DisplayHdrInfo &hdrInfo, const ConversionOptions &options) override {
+        ClipboardSink sink(options.colorLut ? options.colorLut->IccProfile() : std::vector<uint8_t>{});
+        ConvertSelectionToSinks(gpuFrame, selection, hdrInfo, options, {ScaledOutput{options.clipboardScale, &sink}});
         LOG("Selection copied to clipboard as 8-bit bitmap from SSBO output.");
     }
+#endif
+
+    PrecomputedFrame PrecomputeFrame(const GpuFrame &gpuFrame, const DisplayHdrInfo &hdrInfo,
+                                     ToneMapOperator op) override {
+        const SelectionRect fullFrame = {0, 0, static_cast<int>(gpuFrame.Width()), static_cast<int>(gpuFrame.Height())};
+        PrecomputedFrame result;
+        result.tilesX = (gpuFrame.Width() + PrecomputedFrame::kTileSize - 1) / PrecomputedFrame::kTileSize;
+        result.tilesY = (gpuFrame.Height() + PrecomputedFrame::kTileSize - 1) / PrecomputedFrame::kTileSize;
+        result.detectionThreshold = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel)) * 1.01f; // 容差
+        LOG("Precomputing " + std::to_string(gpuFrame.Width()) + "x" + std::to_string(gpuFrame.Height()) +
+            " frame, operator=" + GetToneMapOperatorInfo(op).name);
+
+        MakeCurrent("PrecomputeFrame");
+        try {
+            RequireCompute("Frame precompute");
+            EnsureTuning();
+            result.highlightTiles = RunTileDetection(gpuFrame, result.tilesX, result.tilesY,
+                                                     result.detectionThreshold);
+            MemorySink sdrSink;
+            MemorySink hdrSink;
+            RunProcessing(gpuFrame, fullFrame, hdrInfo, false, op, sdrSink);
+            RunProcessing(gpuFrame, fullFrame, hdrInfo, true, op, hdrSink);
+            result.sdr = std::move(sdrSink.Image());
+            result.hdr = std::move(hdrSink.Image());
+            if (m_timer) {
+                m_timer->Collect(true);
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        if (m_timer) {
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+        return result;
+    }
+
+    std::shared_ptr<const FrameStatistics> ComputeFrameStatistics(std::shared_ptr<const GpuFrame> gpuFrame,
+                                                                  const DisplayHdrInfo &hdrInfo) override {
+        constexpr uint32_t kTile = FrameStatisticsTiles::kTileSize;
+        FrameStatisticsTiles tiles;
+        tiles.tilesX = DispatchCount(gpuFrame->Width(), kTile);
+        tiles.tilesY = DispatchCount(gpuFrame->Height(), kTile);
+        const size_t tileCount = static_cast<size_t>(tiles.tilesX) * tiles.tilesY;
+        const size_t pixelCount = tileCount * kTile * kTile;
+        const float threshold = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel)) * 1.01f; // 容差
+
+        MakeCurrent("ComputeFrameStatistics");
+        try {
+            RequireCompute("Frame statistics");
+            ScopedBuffer sumBuffer;
+            ScopedBuffer countBuffer;
+            ScopedBuffer peakBuffer;
+            ScopedBuffer offsetBuffer;
+            AllocateStorage<float>(sumBuffer, 2 * pixelCount);
+            AllocateStorage<uint16_t>(countBuffer, pixelCount);
+            AllocateStorage<float>(peakBuffer, tileCount);
+            AllocateStorage<float>(offsetBuffer, tileCount);
+
+            const GLuint program = GetFrameStatisticsProgram();
+            {
+                GpuStageTimer::Scope timing(m_timer.get(), "statistics");
+                glUseProgram(program);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, gpuFrame->GetTextureId());
+                glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+                glUniform1f(glGetUniformLocation(program, "u_threshold"), threshold);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sumBuffer.id);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countBuffer.id);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, peakBuffer.id);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, offsetBuffer.id);
+                glDispatchCompute(tiles.tilesX, tiles.tilesY, 1);
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            }
+            UnbindTextures();
+
+            const auto readbackStart = std::chrono::steady_clock::now();
+            tiles.sums = ReadBackStorage<float>(sumBuffer, 2 * pixelCount);
+            tiles.counts = ReadBackStorage<uint16_t>(countBuffer, pixelCount);
+            tiles.peaks = ReadBackStorage<float>(peakBuffer, tileCount);
+            tiles.offsets = ReadBackStorage<float>(offsetBuffer, tileCount);
+            if (m_timer) {
+                m_timingStats.Add("statistics-readback", false, std::chrono::duration<double, std::milli>(
+                                                                    std::chrono::steady_clock::now() - readbackStart)
+                                                                    .count());
+                m_timer->Collect(true);
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        if (m_timer) {
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+        return std::make_shared<const FrameStatistics>(std::move(gpuFrame), threshold, std::move(tiles));
+    }
+
+    std::vector<ToneMapComparison> CompareToneMapOperators(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                                           const DisplayHdrInfo &hdrInfo, int iterations) override {
+        const SelectionRect clampedSelection = ClampSelectionToFrame(selection, gpuFrame.Width(), gpuFrame.Height());
+        if (!clampedSelection.IsValid()) {
+            throw std::runtime_error("Selection is empty after clamping");
+        }
+        iterations = (std::max)(iterations, 1);
+
+        MakeCurrent("CompareToneMapOperators");
+        std::vector<std::vector<uint8_t>> outputs;
+        std::vector<double> averageMs;
+        try {
+            RequireCompute("CompareToneMapOperators");
+            EnsureTuning();
+            for (const auto &info : GetToneMapOperators()) {
+                MemorySink sink;
+                // 首次运行用于预热（驱动延迟编译、缓冲区分配），不计入耗时
+                RunProcessing(gpuFrame, clampedSelection, hdrInfo, true, info.op, sink);
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations; ++i) {
+                    RunProcessing(gpuFrame, clampedSelection, hdrInfo, true, info.op, sink);
+                }
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                averageMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count() / iterations);
+                outputs.push_back(std::move(sink.Image().pixels));
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        // 以 HardClip 为参照：其未饱和的像素视为 SDR 内容，衡量各算子对 SDR 部分的改动
+        const auto &reference = outputs[static_cast<size_t>(ToneMapOperator::HardClip)];
+        const size_t pixelCount = reference.size() / 4;
+
+        std::vector<ToneMapComparison> results;
+        for (size_t index = 0; index < outputs.size(); ++index) {
+            const auto &pixels = outputs[index];
+            double lumaSum = 0.0;
+            double deviationSum = 0.0;
+            size_t clipped = 0;
+            size_t sdrPixels = 0;
+            for (size_t i = 0; i < pixelCount; ++i) {
+                const uint8_t *px = &pixels[i * 4];
+                const uint8_t *ref = &reference[i * 4];
+                lumaSum += 0.0722 * px[0] + 0.7152 * px[1] + 0.2126 * px[2];
+                if (px[0] == 255 || px[1] == 255 || px[2] == 255) {
+                    ++clipped;
+                }
+                if (ref[0] < 255 && ref[1] < 255 && ref[2] < 255) {
+                    deviationSum += (std::abs(px[0] - ref[0]) + std::abs(px[1] - ref[1]) + std::abs(px[2] - ref[2])) / 3.0;
+                    ++sdrPixels;
+                }
+            }
+
+            ToneMapComparison result{};
+            result.op              = GetToneMapOperators()[index].op;
+            result.averageMs       = averageMs[index];
+            result.meanLuma        = lumaSum / static_cast<double>(pixelCount);
+            result.clippedFraction = static_cast<double>(clipped) / static_cast<double>(pixelCount);
+            result.sdrDeviation    = sdrPixels > 0 ? deviationSum / static_cast<double>(sdrPixels) : 0.0;
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    void SetTimingEnabled(bool enabled) override { m_timingEnabled = enabled; }
+
+    std::vector<StageTimingStats> GetTimingStats() const override { return m_timingStats.Snapshot(); }
+
+    AutotuneReport RunAutotune() override {
+        MakeCurrent("RunAutotune");
+        AutotuneReport report{};
+        TuningCache cache;
+        try {
+            const std::string section = RendererTuningSection();
+            if (m_computeSupported) {
+                report.kernels = BenchmarkKernels(cache, section);
+            } else {
+                m_tunedBackend = ConversionBackend::Fragment;
+            }
+            m_tuned = true;
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        // 延迟模型的标定是完整的转换调用，在 context 释放之后进行
+        CalibrateCostModels(cache);
+        m_costModelsLoaded = true;
+        m_costModelsComplete = true;
+        report.selected = m_tunedBackend;
+        for (ConversionBackend backend : kRoutedBackends) {
+            const CostModel &model = CostModelFor(backend);
+            if (model.IsCalibrated()) {
+                report.costModels.push_back({backend, model.OverheadMs(), model.MsPerMegapixel()});
+            }
+        }
+        return report;
+    }
+
+    void PrepareTuning() override {
+        TuningCache cache;
+        MakeCurrent("PrepareTuning");
+        try {
+            EnsureTuning();
+            if (m_computeSupported && (m_detectRanking.empty() || m_processRanking.empty())) {
+                BenchmarkKernels(cache, m_tuningSection);
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        EnsureCostModels();
+        if (m_costModelsComplete) {
+            return;
+        }
+        LOG("Calibrating conversion backends for " + m_tuningSection + ".");
+        CalibrateCostModels(cache);
+        m_costModelsComplete = true;
+    }
+
+    TransferLut::VerifyReport VerifyTransferLut() override {
+        // 每个片元一个输入点，kVerifySamples + 1 个点排成 1024 列
+        constexpr uint32_t kWidth = 1024;
+        constexpr uint32_t kHeight = (TransferLut::kVerifySamples + kWidth) / kWidth;
+
+        MakeCurrent("VerifyTransferLut");
+        std::array<std::vector<uint8_t>, TransferLut::kVerifyPasses> pixels;
+        GLuint program = 0;
+        try {
+            program = CompileRenderProgram(ShaderLibrary::FullscreenVertexShader(),
+                                           ShaderLibrary::TransferLutCheckShader());
+            RenderTarget target;
+            target.Create(kWidth, kHeight);
+            glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+            glViewport(0, 0, kWidth, kHeight);
+            glDisable(GL_BLEND);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_STENCIL_TEST);
+            glDisable(GL_SCISSOR_TEST);
+            glUseProgram(program);
+            glUniform1i(glGetUniformLocation(program, "u_width"), static_cast<GLint>(kWidth));
+            glUniform1f(glGetUniformLocation(program, "u_sampleCount"),
+                        static_cast<float>(TransferLut::kVerifySamples));
+            BindLookupTables(program);
+            for (int pass = 0; pass < TransferLut::kVerifyPasses; ++pass) {
+                glUniform1i(glGetUniformLocation(program, "u_squared"), pass == 1 ? 1 : 0);
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+                pixels[pass].resize(static_cast<size_t>(kWidth) * kHeight * 4);
+                glReadPixels(0, 0, kWidth, kHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels[pass].data());
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            UnbindTextures();
+            glUseProgram(0);
+            glDeleteProgram(program);
+        } catch (...) {
+            if (program != 0) glDeleteProgram(program);
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        // Chain 的取值与着色器写入的 r、g、b 通道一一对应
+        return TransferLut::VerifyCodes([&](TransferLut::Chain chain, int pass, int index) {
+            return static_cast<int>(pixels[pass][static_cast<size_t>(index) * 4 + static_cast<size_t>(chain)]);
+        });
+    }
 
 private:
-    std::vector<uint8_t> ConvertSelection(const GpuFrame &gpuFrame, const SelectionRect &selection, float sdrWhiteNits) {
-        struct ScopedBuffer {
-            GLuint id = 0;
-            ~ScopedBuffer() { if (id != 0) glDeleteBuffers(1, &id); }
-        };
+    // 延迟模型对一次调用的选择与预测，转换完成后用实测耗时校验并更新模型
+    struct CostRoute {
+        ConversionBackend backend;
+        uint64_t pixels;
+        double predictedMs;
+    };
+
+    void RunConversion(const GpuFrame &gpuFrame, const SelectionRect &selection, const DisplayHdrInfo &hdrInfo,
+                       const ConversionOptions &options, const std::vector<ScaledOutput> &outputs) {
+        if (options.backend == ConversionBackend::Cpu) {
+            ConvertSelectionOnCpu(gpuFrame, selection, hdrInfo, options, outputs);
+        } else if (options.backend == ConversionBackend::Vulkan) {
+            ConvertSelectionOnVulkan(gpuFrame, selection, hdrInfo, options, outputs);
+        } else {
+            ConvertSelection(gpuFrame, selection, hdrInfo, options, outputs);
+        }
+    }
 
-        const GLsizei outputWidth  = static_cast<GLsizei>(selection.Width());
-        const GLsizei outputHeight = static_cast<GLsizei>(selection.Height());
-        const size_t  outputPixels = static_cast<size_t>(outputWidth) * static_cast<size_t>(outputHeight);
-        const float   lw           = ComputeLw(sdrWhiteNits);
-        const GLuint  dispatchX    = (static_cast<GLuint>(outputWidth)  + kLocalSizeX - 1) / kLocalSizeX;
-        const GLuint  dispatchY    = (static_cast<GLuint>(outputHeight) + kLocalSizeY - 1) / kLocalSizeY;
+    CostModel &CostModelFor(ConversionBackend backend) {
+        return m_costModels[static_cast<size_t>(
+            std::find(kRoutedBackends.begin(), kRoutedBackends.end(), backend) - kRoutedBackends.begin())];
+    }
+
+    // 在可用的后端中选择预测延迟最低者；片元后端只在全部输出为 BGRA8 且不超过渲染缓冲上限时参与
+    CostRoute RouteByCost(const std::vector<ScaledOutput> &outputs, uint32_t width, uint32_t height) {
+        const uint64_t pixels = static_cast<uint64_t>(width) * height * outputs.size();
+        const uint32_t maxSize = static_cast<uint32_t>(m_maxRenderbufferSize);
+        const bool fragmentEligible =
+            width <= maxSize && height <= maxSize &&
+            std::all_of(outputs.begin(), outputs.end(), [](const ScaledOutput &output) {
+                return output.sink->PreferredFormat() == OutputPixelFormat::Bgra8;
+            });
+
+        CostRoute best{ConversionBackend::Cpu, pixels, std::numeric_limits<double>::infinity()};
+        std::string predictions;
+        for (ConversionBackend backend : kRoutedBackends) {
+            const CostModel &model = CostModelFor(backend);
+            if (!model.IsCalibrated() || (backend == ConversionBackend::Compute && !m_computeSupported) ||
+                (backend == ConversionBackend::Fragment && !fragmentEligible)) {
+                continue;
+            }
+            const double predictedMs = model.Predict(pixels);
+            predictions += (predictions.empty() ? "" : ", ") + std::string(ConversionBackendName(backend)) + " " +
+                           std::to_string(predictedMs) + " ms";
+            if (predictedMs < best.predictedMs) {
+                best = {backend, pixels, predictedMs};
+            }
+        }
+        LOG("Cost model: " + std::to_string(width) + "x" + std::to_string(height) + " x" +
+            std::to_string(outputs.size()) + " -> " + ConversionBackendName(best.backend) + " (predicted " +
+            predictions + ")");
+        return best;
+    }
+
+    void RecordCost(const CostRoute &route, double actualMs) {
+        const bool accepted = CostModelFor(route.backend).Add(route.pixels, actualMs);
+        const double error = route.predictedMs > 0.0 ? (actualMs - route.predictedMs) / route.predictedMs : 0.0;
+        LOG("Cost model: " + std::string(ConversionBackendName(route.backend)) + " took " +
+            std::to_string(actualMs) + " ms, predicted " + std::to_string(route.predictedMs) + " ms (error " +
+            (error >= 0.0 ? "+" : "") + std::to_string(error * 100.0) + "%)" +
+            (accepted ? "" : ", discarded as outlier"));
+    }
+
+    bool CostModelsReady() {
+        EnsureCostModels();
+        return m_costModelsComplete;
+    }
+
+    // 从调优缓存读取各后端的延迟模型，只读一次。缺少任何一个时不在这里标定（会阻塞这次转换），
+    // 由 PrepareTuning 或 RunAutotune 补齐
+    void EnsureCostModels() {
+        if (m_costModelsLoaded) {
+            return;
+        }
+        TuningCache cache;
+        bool complete = true;
+        for (ConversionBackend backend : kRoutedBackends) {
+            if (backend == ConversionBackend::Compute && !m_computeSupported) {
+                continue;
+            }
+            const auto text = cache.Get(m_tuningSection, CostModelKey(backend));
+            if (text && *text == kUnavailableCostModel) {
+                continue;
+            }
+            auto model = CostModel::Parse(text.value_or(""));
+            if (model) {
+                model->Seed(uint64_t{kCostCalibrationSizes.front()} * kCostCalibrationSizes.front(),
+                            uint64_t{kCostCalibrationSizes.back()} * kCostCalibrationSizes.back(), kAutotuneIterations);
+                CostModelFor(backend) = *model;
+            } else {
+                complete = false;
+            }
+        }
+        if (!complete) {
+            LOG("No cost model for " + m_tuningSection + " in " + cache.Path().string() + ", auto uses the " +
+                ConversionBackendName(m_tunedBackend) + " backend until calibrated (--autotune or daemon start).");
+        }
+        m_costModelsComplete = complete;
+        m_costModelsLoaded = true;
+    }
+
+    // 在标定画面上端到端测量每个后端（含 eglMakeCurrent、检测、处理、回读与 sink），两种尺寸各预热 1 次、
+    // 计时 kAutotuneIterations 次，全部样本拟合为延迟模型并写入调优缓存，再由模型选出 GPU 后端。
+    // 调用时 context 不能为 current
+    void CalibrateCostModels(TuningCache &cache) {
+        const auto gpuFrame = GpuFrame::Create(CreateCalibrationFrame(), m_display, m_surface, m_context);
+        const int frameSize = static_cast<int>(kCostCalibrationSizes.back());
+        const DisplayHdrInfo hdrInfo = AutotuneHdrInfo();
+        for (ConversionBackend backend : kRoutedBackends) {
+            if (backend == ConversionBackend::Compute && !m_computeSupported) {
+                continue;
+            }
+            CostModel model;
+            ConversionOptions options;
+            options.backend = backend;
+            try {
+                for (uint32_t size : kCostCalibrationSizes) {
+                    const SelectionRect selection{frameSize - static_cast<int>(size), frameSize - static_cast<int>(size),
+                                                  frameSize, frameSize};
+                    for (int i = 0; i <= kAutotuneIterations; ++i) {
+                        MemorySink sink;
+                        const auto start = std::chrono::steady_clock::now();
+                        RunConversion(*gpuFrame, selection, hdrInfo, options, {ScaledOutput{OutputScale{}, &sink}});
+                        const auto elapsed = std::chrono::steady_clock::now() - start;
+                        if (i != 0) {
+                            model.Add(static_cast<uint64_t>(size) * size,
+                                      std::chrono::duration<double, std::milli>(elapsed).count());
+                        }
+                    }
+                }
+            } catch (const std::exception &e) {
+                LOG(std::string("Cost model: ") + ConversionBackendName(backend) + " backend unavailable: " + e.what());
+                CostModelFor(backend) = CostModel{};
+                cache.Set(m_tuningSection, CostModelKey(backend), kUnavailableCostModel);
+                continue;
+            }
+            CostModelFor(backend) = model;
+            cache.Set(m_tuningSection, CostModelKey(backend), model.Serialize());
+            LOG(std::string("Cost model for ") + ConversionBackendName(backend) + ": " +
+                std::to_string(model.OverheadMs()) + " ms per call + " + std::to_string(model.MsPerMegapixel()) +
+                " ms per megapixel");
+        }
+        SelectTunedBackend(cache);
+    }
+
+    // 不经过延迟模型时（缩放输出、打码、局部色调映射，或尚未标定）Auto 使用的 GPU 后端：
+    // 计算与片元后端中在自动调优画面尺寸上预测较快者，写入调优缓存
+    void SelectTunedBackend(TuningCache &cache) {
+        const CostModel &compute = CostModelFor(ConversionBackend::Compute);
+        if (!m_computeSupported || !compute.IsCalibrated()) {
+            return;
+        }
+        const CostModel &fragment = CostModelFor(ConversionBackend::Fragment);
+        const uint64_t pixels = uint64_t{kAutotuneWidth} * kAutotuneHeight;
+        m_tunedBackend = fragment.IsCalibrated() && fragment.Predict(pixels) < compute.Predict(pixels)
+                             ? ConversionBackend::Fragment
+                             : ConversionBackend::Compute;
+        cache.Set(m_tuningSection, kBackendTuningKey, ConversionBackendName(m_tunedBackend));
+        LOG(std::string("Selected GPU backend from cost models: ") + ConversionBackendName(m_tunedBackend));
+    }
+
+    // CPU 后端：检测与转换都直接读取帧数据，不使用 GL context
+    void ConvertSelectionOnCpu(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                               const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                               const std::vector<ScaledOutput> &outputs) {
+        const uint32_t width = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        if (!AllOutputsUnscaled(outputs, width, height)) {
+            throw std::runtime_error("CPU backend supports only 1x outputs");
+        }
+        const CapturedFrame &frame = gpuFrame.GetCpuFrame();
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+
+        const auto detectStart = std::chrono::steady_clock::now();
+        const float threshold = lw * 1.01f; // 容差，与检测着色器一致
+        const std::optional<bool> known = HighlightFromStatistics(options, gpuFrame, selection, threshold);
+        const bool useHdrPath = known ? *known : CpuConversion::DetectHighlight(frame, selection, threshold);
+        const auto convertStart = std::chrono::steady_clock::now();
+        const CpuConversion::Parameters parameters{lw, ComputeSourcePeak(hdrInfo, lw), options.colorLut.get()};
+        for (const auto &output : outputs) {
+            ImageInfo info{};
+            info.width           = width;
+            info.height          = height;
+            info.format          = output.sink->PreferredFormat();
+            info.hdrPath         = useHdrPath;
+            info.toneMapOperator = options.toneMapOperator;
+            info.gainMapMaxLog2  = GainMapMaxLog2(lw, parameters.sourcePeak);
+            CpuConversion::Convert(frame, selection, parameters, info, *output.sink);
+        }
+
+        if (m_timingEnabled) {
+            m_timingStats.Add("cpu-detect", false,
+                              std::chrono::duration<double, std::milli>(convertStart - detectStart).count());
+            m_timingStats.Add("cpu-convert", false, std::chrono::duration<double, std::milli>(
+                                                        std::chrono::steady_clock::now() - convertStart)
+                                                        .count());
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+        if (useHdrPath) {
+            LOG("CPU output path selected: HDR, operator=" +
+                std::string(GetToneMapOperatorInfo(options.toneMapOperator).displayName));
+        } else {
+            LOG("CPU output path selected: linear-sRGB");
+        }
+    }
+
+    // Vulkan 后端：独立的 Vulkan 设备，与 CPU 后端一样从 CPU 侧帧数据上传选区，不使用 GL context
+    // 未启用 PRINTSCR_VULKAN 时只抛出异常，参数不被使用
+    void ConvertSelectionOnVulkan([[maybe_unused]] const GpuFrame &gpuFrame,
+                                  [[maybe_unused]] const SelectionRect &selection,
+                                  [[maybe_unused]] const DisplayHdrInfo &hdrInfo,
+                                  [[maybe_unused]] const ConversionOptions &options,
+                                  [[maybe_unused]] const std::vector<ScaledOutput> &outputs) {
+#ifdef PRINTSCR_HAVE_VULKAN
+        const uint32_t width = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        if (!AllOutputsUnscaled(outputs, width, height)) {
+            throw std::runtime_error("Vulkan backend supports only 1x outputs");
+        }
+        if (options.colorLut) {
+            throw std::runtime_error("Vulkan backend does not support color LUTs");
+        }
+        if (!m_vulkan) {
+            m_vulkan = VulkanConverter::Create();
+        }
+
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const VulkanConverter::Parameters parameters{lw, ComputeSourcePeak(hdrInfo, lw),
+                                                     lw * 1.01f}; // 容差，与检测着色器一致
+        bool useHdrPath = false;
+        for (const auto &output : outputs) {
+            useHdrPath = m_vulkan->Convert(gpuFrame.GetCpuFrame(), selection, parameters, options.toneMapOperator,
+                                           output.sink->PreferredFormat(), *output.sink,
+                                           m_timingEnabled ? &m_timingStats : nullptr);
+        }
 
-        std::vector<uint8_t> bgraPixels(outputPixels * 4);
+        if (m_timingEnabled) {
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+        if (useHdrPath) {
+            LOG("Vulkan output path selected: HDR, operator=" +
+                std::string(GetToneMapOperatorInfo(options.toneMapOperator).displayName));
+        } else {
+            LOG("Vulkan output path selected: linear-sRGB");
+        }
+#else
+        throw std::runtime_error("Vulkan backend not available: built without PRINTSCR_VULKAN");
+#endif
+    }
 
+    void MakeCurrent(const char *caller) {
         if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
-            throw std::runtime_error("ConvertSelection: eglMakeCurrent failed");
+            throw std::runtime_error(std::string(caller) + ": eglMakeCurrent failed");
         }
+        // 计时器的查询对象属于本 context，只能在 current 时创建或销毁
+        if (m_timingEnabled && !m_timer) {
+            m_timer = std::make_unique<GpuStageTimer>(m_timingStats);
+        } else if (!m_timingEnabled && m_timer) {
+            m_timer.reset();
+        }
+    }
 
-        const GLuint sourceTexture = gpuFrame.GetTextureId();
+    void ReleaseCurrent() { eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); }
+
+    // 变体按需编译并缓存，调用时 context 必须为 current
+    GLuint GetDetectionProgram(size_t config) {
+        GLuint &program = m_detectPrograms[config];
+        if (program == 0) {
+            program = CompileComputeProgram(ShaderLibrary::DetectionShader(config));
+        }
+        return program;
+    }
+
+    GLuint GetProcessingProgram(size_t variant, size_t config) {
+        GLuint &program = m_processPrograms[variant * kKernelConfigCount + config];
+        if (program == 0) {
+            program = CompileComputeProgram(ShaderLibrary::ProcessingShader(variant, config));
+        }
+        return program;
+    }
+
+    GLuint GetTileDetectionProgram() {
+        if (m_tileDetectProgram == 0) {
+            m_tileDetectProgram = CompileComputeProgram(ShaderLibrary::TileDetectionShader());
+        }
+        return m_tileDetectProgram;
+    }
+
+    GLuint GetFrameStatisticsProgram() {
+        if (m_frameStatisticsProgram == 0) {
+            m_frameStatisticsProgram = CompileComputeProgram(ShaderLibrary::FrameStatisticsShader());
+        }
+        return m_frameStatisticsProgram;
+    }
+
+    GLuint GetRedactionProgram(size_t index) {
+        GLuint &program = m_redactionPrograms[index];
+        if (program == 0) {
+            program = CompileComputeProgram(RedactionShader(index));
+        }
+        return program;
+    }
+
+    GLuint GetLocalToneMapProgram(ShaderLibrary::LocalToneMapStage stage) {
+        GLuint &program = m_localToneMapPrograms[static_cast<size_t>(stage)];
+        if (program == 0) {
+            program = CompileComputeProgram(ShaderLibrary::LocalToneMapShader(stage));
+        }
+        return program;
+    }
+
+    GLuint GetRegionDetectionProgram() {
+        if (m_regionDetectProgram == 0) {
+            m_regionDetectProgram = CompileComputeProgram(ShaderLibrary::RegionDetectionShader());
+        }
+        return m_regionDetectProgram;
+    }
+
+    GLuint GetRegionProcessingProgram(ToneMapOperator op) {
+        GLuint &program = m_regionProcessPrograms[static_cast<size_t>(op)];
+        if (program == 0) {
+            program = CompileComputeProgram(ShaderLibrary::RegionProcessingShader(op));
+        }
+        return program;
+    }
+
+    GLuint GetFragmentProgram(size_t variant) {
+        GLuint &program = m_fragmentPrograms[variant];
+        if (program == 0) {
+            program = CompileRenderProgram(ShaderLibrary::FullscreenVertexShader(),
+                                           ShaderLibrary::FragmentProcessingShader(variant));
+        }
+        return program;
+    }
+
+    GLuint GetFragmentDetectionProgram() {
+        if (m_fragmentDetectProgram == 0) {
+            m_fragmentDetectProgram = CompileRenderProgram(ShaderLibrary::FullscreenVertexShader(),
+                                                           ShaderLibrary::FragmentDetectionShader());
+        }
+        return m_fragmentDetectProgram;
+    }
+
+    void RequireCompute(const char *feature) const {
+        if (!m_computeSupported) {
+            throw std::runtime_error(std::string(feature) + " requires an OpenGL ES 3.1 context with compute shaders");
+        }
+    }
+
+    // Auto 取调优结果；片元后端受渲染缓冲尺寸上限约束，超出时退回计算后端
+    ConversionBackend ResolveBackend(ConversionBackend requested, uint32_t width, uint32_t height) const {
+        ConversionBackend backend = requested == ConversionBackend::Auto ? m_tunedBackend : requested;
+        if (backend == ConversionBackend::Compute) {
+            RequireCompute("Compute backend");
+        }
+        const uint32_t maxSize = static_cast<uint32_t>(m_maxRenderbufferSize);
+        if (backend == ConversionBackend::Fragment && (width > maxSize || height > maxSize)) {
+            RequireCompute("Selection larger than GL_MAX_RENDERBUFFER_SIZE");
+            LOG("Selection exceeds GL_MAX_RENDERBUFFER_SIZE (" + std::to_string(maxSize) +
+                "), using the compute backend.");
+            backend = ConversionBackend::Compute;
+        }
+        return backend;
+    }
+
+    // 读取本渲染器的 kernel 排名与后端选择，只读一次。缓存中没有排名时不在这里测量（会阻塞这次转换），
+    // 排名留空，SelectKernelConfig 使用默认变体，由 PrepareTuning 或 RunAutotune 补齐。调用时 context 必须为 current
+    void EnsureTuning() {
+        if (m_tuned) {
+            return;
+        }
+        if (!m_computeSupported) {
+            m_tunedBackend = ConversionBackend::Fragment;
+            m_tuned = true;
+            return;
+        }
+
+        TuningCache cache;
+        const std::string section = RendererTuningSection();
+        m_detectRanking = ParseKernelRanking(cache.Get(section, KernelRankingKey("detect")));
+        m_processRanking = ParseKernelRanking(cache.Get(section, KernelRankingKey("process")));
+        if (m_detectRanking.empty() || m_processRanking.empty()) {
+            m_detectRanking.clear();
+            m_processRanking.clear();
+            LOG("No kernel tuning for " + section + " in " + cache.Path().string() +
+                "; using the default kernel until tuned (--autotune or daemon start).");
+        }
+
+        // GPU 后端由延迟模型标定时选出；还没有标定时使用计算后端
+        const auto backend = ParseConversionBackend(cache.Get(section, kBackendTuningKey).value_or(""));
+        if (backend && (*backend == ConversionBackend::Compute || *backend == ConversionBackend::Fragment)) {
+            m_tunedBackend = *backend;
+        }
+        m_tuned = true;
+        if (!m_detectRanking.empty()) {
+            LOG("Tuning for " + section + ": backend=" + ConversionBackendName(m_tunedBackend) + ", detect=" +
+                FormatKernelRanking(m_detectRanking) + ", process=" + FormatKernelRanking(m_processRanking));
+        }
+    }
+
+    // 在合成画面上测量全部变体（每个预热 1 次、计时 kAutotuneIterations 次，取 p50），更新排名并写入调优缓存。
+    // 处理 pass 以最常用的 SDR → BGRA8 变体为代表；编译失败的变体不进入排名
+    std::vector<KernelBenchmark> BenchmarkKernels(TuningCache &cache, const std::string &section) {
+        LOG("Autotuning " + std::to_string(kKernelConfigCount) + " kernel variants on " + section);
+
+        ScopedTexture source;
+        source.Reset(CreateAutotuneTexture());
+        const SelectionRect &selection = kAutotuneSelection;
+        const DisplayHdrInfo hdrInfo = AutotuneHdrInfo();
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const size_t processVariant =
+            ShaderLibrary::ProcessingVariantFor(OutputPixelFormat::Bgra8, false, ToneMapOperator{});
 
         ScopedBuffer detectionBuffer;
+        glGenBuffers(1, &detectionBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
         ScopedBuffer outputBuffer;
+        glGenBuffers(1, &outputBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(kAutotuneWidth) * kAutotuneHeight * 4,
+                     nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // 阶段名直接使用变体名（静态字符串），检测与处理各用一份统计
+        TimingStats detectStats;
+        TimingStats processStats;
+        GpuStageTimer detectTimer(detectStats);
+        GpuStageTimer processTimer(processStats);
+        std::vector<size_t> candidates;
+        for (size_t config = 0; config < kKernelConfigCount; ++config) {
+            const KernelConfig &kernel = kKernelConfigs[config];
+            GLuint detectProgram = 0;
+            GLuint processProgram = 0;
+            try {
+                detectProgram = GetDetectionProgram(config);
+                processProgram = GetProcessingProgram(processVariant, config);
+            } catch (const std::exception &e) {
+                LOG(std::string("Autotune: skipping kernel ") + kernel.name + ": " + e.what());
+                continue;
+            }
+            candidates.push_back(config);
+
+            for (int i = 0; i <= kAutotuneIterations; ++i) {
+                // 第 0 次为预热，不计时
+                GpuStageTimer::Scope timing(i == 0 ? nullptr : &detectTimer, kernel.name);
+                DispatchDetection(detectProgram, kernel, source.id, selection, hdrInfo, detectionBuffer.id);
+            }
+            for (int i = 0; i <= kAutotuneIterations; ++i) {
+                GpuStageTimer::Scope timing(i == 0 ? nullptr : &processTimer, kernel.name);
+                DispatchProcessing(processProgram, kernel, source.id, selection, lw, hdrInfo, outputBuffer.id);
+            }
+            detectTimer.Collect(false);
+            processTimer.Collect(false);
+        }
+        glFinish();
+        detectTimer.Collect(true);
+        processTimer.Collect(true);
+        UnbindTextures();
+        if (candidates.empty()) {
+            throw std::runtime_error("Autotune: no kernel variant compiled");
+        }
+
+        std::vector<KernelBenchmark> results;
+        for (size_t config : candidates) {
+            KernelBenchmark result{};
+            result.kernel    = kKernelConfigs[config].name;
+            result.gpuTimed  = detectTimer.HasGpuTimer();
+            result.detectMs  = StageP50(detectStats, kKernelConfigs[config].name);
+            result.processMs = StageP50(processStats, kKernelConfigs[config].name);
+            results.push_back(result);
+        }
+
+        auto rank = [&](double KernelBenchmark::*field) {
+            std::vector<size_t> order(candidates.size());
+            for (size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(),
+                             [&](size_t a, size_t b) { return results[a].*field < results[b].*field; });
+            std::vector<size_t> ranking;
+            for (size_t i : order) {
+                ranking.push_back(candidates[i]);
+            }
+            return ranking;
+        };
+        m_detectRanking = rank(&KernelBenchmark::detectMs);
+        m_processRanking = rank(&KernelBenchmark::processMs);
+
+        cache.Set(section, KernelRankingKey("detect"), FormatKernelRanking(m_detectRanking));
+        cache.Set(section, KernelRankingKey("process"), FormatKernelRanking(m_processRanking));
+        LOG("Kernel ranking saved to " + cache.Path().string() + ": detect=" + FormatKernelRanking(m_detectRanking) +
+            ", process=" + FormatKernelRanking(m_processRanking));
+
+        std::stable_sort(results.begin(), results.end(),
+                         [](const KernelBenchmark &a, const KernelBenchmark &b) { return a.processMs < b.processMs; });
+        return results;
+    }
+
+    GLuint GetResampleProgram(size_t variant) {
+        GLuint &program = m_resamplePrograms[variant];
+        if (program == 0) {
+            program = CompileComputeProgram(ShaderLibrary::ResampleShader(variant));
+        }
+        return program;
+    }
+
+    void ConvertSelection(const GpuFrame &gpuFrame, const SelectionRect &selection, const DisplayHdrInfo &hdrInfo,
+                          const ConversionOptions &options, const std::vector<ScaledOutput> &outputs) {
+        MakeCurrent("ConvertSelection");
+
+        const uint32_t width  = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        const ToneMapOperator op = options.toneMapOperator;
+        bool useHlgPath = false;
+        ConversionBackend backend = ConversionBackend::Compute;
+        const bool colorLut = options.colorLut != nullptr;
+        try {
+            EnsureTuning();
+            backend = ResolveBackend(options.backend, width, height);
+            if (colorLut) {
+                UseColorLut(options.colorLut);
+            }
+
+            // 片元后端的检测与处理共用一个选区大小的渲染目标
+            RenderTarget renderTarget;
+            if (backend == ConversionBackend::Fragment) {
+                renderTarget.Create(width, height);
+            }
+            const float threshold = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel)) * 1.01f; // 容差
+            if (const std::optional<bool> known = HighlightFromStatistics(options, gpuFrame, selection, threshold)) {
+                useHlgPath = *known;
+            } else if (backend == ConversionBackend::Fragment) {
+                useHlgPath = RunFragmentDetection(renderTarget, gpuFrame, selection, hdrInfo);
+            } else {
+                useHlgPath = RunDetection(gpuFrame, selection, hdrInfo);
+            }
+
+            // 局部色调映射：HDR 选区先压缩为 SDR 范围内的 scRGB 副本，之后按 SDR 路径处理。
+            // 增益图需要色调映射前的颜色，带增益图的输出仍读取源帧并使用全局算子
+            ScopedTexture localImage;
+            if (useHlgPath && options.localToneMapping) {
+                RequireCompute("Local tone mapping");
+                localImage.Reset(RunLocalToneMapping(gpuFrame, selection, hdrInfo));
+            }
+            const SelectionCopyFrame localFrame(gpuFrame, m_display, m_surface, m_context, localImage.id, width,
+                                                height);
+            const SelectionRect localSelection{0, 0, static_cast<int>(width), static_cast<int>(height)};
+
+            // 所有缩放输出共用一张色调映射后的线性光中间纹理，首次需要时生成
+            ScopedTexture linearImage;
+            for (const auto &output : outputs) {
+                const OutputSize size = ResolveOutputSize(output.scale, width, height);
+                const OutputPixelFormat format = output.sink->PreferredFormat();
+                const bool local = localImage.id != 0 && format != OutputPixelFormat::Bgra8GainMap;
+                const GpuFrame &source = local ? localFrame : gpuFrame;
+                const SelectionRect &sourceSelection = local ? localSelection : selection;
+                const bool hdrPath = useHlgPath && !local;
+                if (size.width == width && size.height == height) {
+                    if (backend == ConversionBackend::Fragment && format == OutputPixelFormat::Bgra8) {
+                        RunFragmentProcessing(renderTarget, source, sourceSelection, hdrInfo, hdrPath, op, colorLut,
+                                              *output.sink);
+                    } else {
+                        RequireCompute("16-bit output");
+                        RunProcessing(source, sourceSelection, hdrInfo, hdrPath, op, *output.sink, colorLut);
+                    }
+                    continue;
+                }
+
+                if (format == OutputPixelFormat::Bgra8GainMap) {
+                    throw std::runtime_error("Gain map output supports only 1x");
+                }
+                RequireCompute("Scaled output");
+                if (linearImage.id == 0) {
+                    linearImage.Reset(RunLinearize(source, sourceSelection, hdrInfo, hdrPath, op));
+                }
+                LOG("Resampling to " + std::to_string(size.width) + "x" + std::to_string(size.height) + " (" +
+                    (options.scaleFilter == ScaleFilter::Box ? "box" : "lanczos3") + ", linear light).");
+                ResampleToSink(linearImage.id, width, height, size, options.scaleFilter, hdrPath, op, colorLut,
+                               *output.sink);
+            }
+            if (m_timer) {
+                // 回读已经与 GPU 同步，此时所有查询结果都已可用
+                m_timer->Collect(true);
+            }
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+
+        if (m_timer) {
+            LOG("Stage timing: " + m_timingStats.Describe());
+        }
+
+        const std::string backendName = backend == ConversionBackend::Fragment ? "Fragment" : "Compute";
+        if (useHlgPath && options.localToneMapping) {
+            LOG(backendName + " shader output path selected: HDR, local tone mapping (bilateral grid).");
+        } else if (useHlgPath) {
+            LOG(backendName + " shader output path selected: HDR, operator=" +
+                GetToneMapOperatorInfo(options.toneMapOperator).displayName +
+                ". Detection uses the current SDR white threshold; tone mapping uses the fixed scRGB absolute "
+                "scale (1.0 = 80 nits).");
+        } else {
+            LOG(backendName + " shader output path selected: linear-sRGB");
+        }
+    }
+
+    bool RunDetection(const GpuFrame &gpuFrame, const SelectionRect &selection, const DisplayHdrInfo &hdrInfo) {
+        const size_t config = SelectKernelConfig(m_detectRanking, static_cast<uint32_t>(selection.Width()));
+
+        ScopedBuffer detectionBuffer;
 
         uint32_t detectionFlag = 0;
         glGenBuffers(1, &detectionBuffer.id);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer.id);
         glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(detectionFlag), &detectionFlag, GL_DYNAMIC_COPY);
 
-        glUseProgram(m_detectProgram);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sourceTexture);
-        glUniform1i(glGetUniformLocation(m_detectProgram, "u_source"), 0);
-        glUniform2i(glGetUniformLocation(m_detectProgram, "u_selectionOrigin"), selection.Left(), selection.Top());
-        glUniform2i(glGetUniformLocation(m_detectProgram, "u_outputSize"), outputWidth, outputHeight);
-        glUniform1f(glGetUniformLocation(m_detectProgram, "u_lw"), lw * 1.01f); // 容差
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, detectionBuffer.id);
-        glDispatchCompute(dispatchX, dispatchY, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        const GLuint program = GetDetectionProgram(config);
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "detect");
+            DispatchDetection(program, kKernelConfigs[config], gpuFrame.GetTextureId(), selection, hdrInfo,
+                              detectionBuffer.id);
+        }
 
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer.id);
         auto *mappedDetection = static_cast<const uint32_t *>(
             glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(uint32_t), GL_MAP_READ_BIT));
         if (!mappedDetection) {
-            eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
             throw std::runtime_error("Failed to map detection SSBO");
         }
-        const bool useHlgPath = (*mappedDetection != 0u);
+        const bool foundHighlight = (*mappedDetection != 0u);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return foundHighlight;
+    }
+
+    // 整帧的检测 tile 索引，每个 tile 一个标志
+    std::vector<uint8_t> RunTileDetection(const GpuFrame &gpuFrame, uint32_t tilesX, uint32_t tilesY,
+                                          float threshold) {
+        const std::vector<uint32_t> zeros(static_cast<size_t>(tilesX) * tilesY, 0u);
+        const GLsizeiptr bufferBytes = static_cast<GLsizeiptr>(zeros.size() * sizeof(uint32_t));
+
+        ScopedBuffer tileBuffer;
+        glGenBuffers(1, &tileBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bufferBytes, zeros.data(), GL_DYNAMIC_COPY);
+
+        const GLuint program = GetTileDetectionProgram();
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "tile-detect");
+            glUseProgram(program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, gpuFrame.GetTextureId());
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform1f(glGetUniformLocation(program, "u_lw"), threshold);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, tileBuffer.id);
+            glDispatchCompute(tilesX, tilesY, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileBuffer.id);
+        auto *mapped = static_cast<const uint32_t *>(
+            glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bufferBytes, GL_MAP_READ_BIT));
+        if (!mapped) {
+            throw std::runtime_error("Failed to map tile detection SSBO");
+        }
+        std::vector<uint8_t> tiles(zeros.size());
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            tiles[i] = mapped[i] != 0u ? 1 : 0;
+        }
         glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return tiles;
+    }
+
+    // 检测 pass 本身：调用者负责绑定前清零 detectionBuffer 并在之后读取
+    void DispatchDetection(GLuint program, const KernelConfig &kernel, GLuint sourceTexture,
+                           const SelectionRect &selection, const DisplayHdrInfo &hdrInfo, GLuint detectionBuffer) {
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sourceTexture);
+        glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+        glUniform2i(glGetUniformLocation(program, "u_selectionOrigin"), selection.Left(), selection.Top());
+        glUniform2i(glGetUniformLocation(program, "u_outputSize"), selection.Width(), selection.Height());
+        glUniform1f(glGetUniformLocation(program, "u_lw"), lw * 1.01f); // 容差
+        BindRedactionOverlay(program, sourceTexture);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, detectionBuffer);
+        glDispatchCompute(kernel.DispatchX(static_cast<uint32_t>(selection.Width())),
+                          kernel.DispatchY(static_cast<uint32_t>(selection.Height())), 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // 运行处理 pass，并把映射后的输出缓冲区直接交给 sink，不经过中间拷贝
+    // colorLut 为 true 时 BGRA8 输出使用色彩管理变体，查找表纹理需已由 UseColorLut 准备好
+    void RunProcessing(const GpuFrame &gpuFrame, const SelectionRect &selection, const DisplayHdrInfo &hdrInfo,
+                       bool useHdrPath, ToneMapOperator op, ImageSink &sink, bool colorLut = false) {
+        const GLsizei outputWidth  = static_cast<GLsizei>(selection.Width());
+        const GLsizei outputHeight = static_cast<GLsizei>(selection.Height());
+        const float   lw           = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const size_t  config       = SelectKernelConfig(m_processRanking, static_cast<uint32_t>(outputWidth));
+        const KernelConfig &kernel = kKernelConfigs[config];
+        const GLuint  program      = GetProcessingProgram(
+            ShaderLibrary::ProcessingVariantFor(ShaderLibrary::ProcessingTargetFor(sink.PreferredFormat(), colorLut),
+                                                useHdrPath, op),
+            config);
+
+        ImageInfo info{};
+        info.width           = static_cast<uint32_t>(outputWidth);
+        info.height          = static_cast<uint32_t>(outputHeight);
+        info.format          = sink.PreferredFormat();
+        info.hdrPath         = useHdrPath;
+        info.toneMapOperator = op;
+        info.gainMapMaxLog2  = GainMapMaxLog2(lw, ComputeSourcePeak(hdrInfo, lw));
+        const size_t outputBytes = info.RowBytes() * info.height;
+        if (outputBytes > kStreamingThresholdBytes) {
+            StreamProcessing(program, kernel, gpuFrame.GetTextureId(), selection, lw, hdrInfo, info, sink);
+            return;
+        }
+
+        ScopedBuffer outputBuffer;
+
+        glGenBuffers(1, &outputBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(outputBytes), nullptr, GL_DYNAMIC_COPY);
+
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "process");
+            DispatchProcessing(program, kernel, gpuFrame.GetTextureId(), selection, lw, hdrInfo, outputBuffer.id);
+        }
+        UnbindTextures();
+
+        ReadBackToSink(GL_SHADER_STORAGE_BUFFER, outputBuffer.id, info, sink);
+    }
+
+    // 大选区的处理 pass：按水平条带依次 dispatch，每个条带写入环形中的一个小缓冲区并插入 fence。
+    // CPU 等待最早的 fence、映射该条带并交给 sink 时，GPU 已在处理其后的条带；缓冲区与映射大小都以条带为界，
+    // sink 在第一个条带完成后就开始收到行数据。各条带只是选区的子矩形，输出与整块处理逐字节一致
+    void StreamProcessing(GLuint program, const KernelConfig &kernel, GLuint sourceTexture,
+                          const SelectionRect &selection, float lw, const DisplayHdrInfo &hdrInfo,
+                          const ImageInfo &info, ImageSink &sink) {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t rowBytes = info.RowBytes();
+        // 条带高度取工作组覆盖行数的整数倍，条带之间不产生不满的工作组
+        const uint32_t rowAlignment = kernel.localSizeY * kernel.pixelsY;
+        const uint32_t stripRows = static_cast<uint32_t>(
+            (std::max)(kStreamingStripBytes / rowBytes / rowAlignment, size_t{1}) * rowAlignment);
+        const uint32_t stripCount = (info.height + stripRows - 1) / stripRows;
+
+        std::array<StreamingSlot, kStreamingRingSize> ring;
+        for (size_t i = 0; i < (std::min)(ring.size(), size_t{stripCount}); ++i) {
+            glGenBuffers(1, &ring[i].buffer.id);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, ring[i].buffer.id);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(rowBytes * stripRows), nullptr,
+                         GL_DYNAMIC_COPY);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        auto stripHeight = [&](uint32_t strip) { return (std::min)(stripRows, info.height - strip * stripRows); };
+        uint32_t dispatched = 0;
+        auto dispatchNext = [&] {
+            StreamingSlot &slot = ring[dispatched % ring.size()];
+            SelectionRect strip = selection;
+            strip.y1 = selection.Top() + static_cast<int>(dispatched * stripRows);
+            strip.y2 = strip.y1 + static_cast<int>(stripHeight(dispatched));
+            {
+                GpuStageTimer::Scope timing(m_timer.get(), "process-strip");
+                DispatchProcessing(program, kernel, sourceTexture, strip, lw, hdrInfo, slot.buffer.id);
+            }
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            slot.ResetFence(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+            glFlush();
+            ++dispatched;
+        };
+        while (dispatched < (std::min)(ring.size(), size_t{stripCount})) {
+            dispatchNext();
+        }
+
+        LOG("Streaming " + std::to_string(info.width) + "x" + std::to_string(info.height) + " output in " +
+            std::to_string(stripCount) + " strips of " + std::to_string(stripRows) + " rows.");
+
+        // Begin 可能分配整幅图像的目标内存（剪贴板），与前几个条带的 GPU 工作重叠
+        sink.Begin(info);
+        const auto readbackStart = std::chrono::steady_clock::now();
+        double fenceWaitMs = 0.0;
+        for (uint32_t strip = 0; strip < stripCount; ++strip) {
+            StreamingSlot &slot = ring[strip % ring.size()];
+            const auto waitStart = std::chrono::steady_clock::now();
+            WaitForFence(slot.fence);
+            slot.ResetFence(nullptr);
+            fenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart)
+                               .count();
+
+            const uint32_t rows = stripHeight(strip);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer.id);
+            const auto *mappedPixels = static_cast<const uint8_t *>(glMapBufferRange(
+                GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(rowBytes * rows), GL_MAP_READ_BIT));
+            if (!mappedPixels) {
+                throw std::runtime_error("Failed to map output strip");
+            }
+            try {
+                sink.WriteRows(strip * stripRows, rows, mappedPixels);
+            } catch (...) {
+                glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+                throw;
+            }
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            if (strip == 0 && m_timer) {
+                m_timingStats.Add("first-rows", false, std::chrono::duration<double, std::milli>(
+                                                           std::chrono::steady_clock::now() - start)
+                                                           .count());
+            }
+            // 该条带的缓冲区已经空出，立即排入下一个条带
+            if (dispatched < stripCount) {
+                dispatchNext();
+            }
+        }
+        UnbindTextures();
+
+        const auto commitStart = std::chrono::steady_clock::now();
+        sink.End();
+
+        // readback 为排空全部条带的时间，其中 fence-wait 为 CPU 等待 GPU 的部分
+        if (m_timer) {
+            m_timingStats.Add("readback", false,
+                              std::chrono::duration<double, std::milli>(commitStart - readbackStart).count());
+            m_timingStats.Add("fence-wait", false, fenceWaitMs);
+            m_timingStats.Add("sink-commit", false, std::chrono::duration<double, std::milli>(
+                                                        std::chrono::steady_clock::now() - commitStart)
+                                                        .count());
+        }
+    }
+
+    void DispatchProcessing(GLuint program, const KernelConfig &kernel, GLuint sourceTexture,
+                            const SelectionRect &selection, float lw, const DisplayHdrInfo &hdrInfo,
+                            GLuint outputBuffer) {
+        BindProcessingInputs(program, sourceTexture, selection, lw, hdrInfo);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, outputBuffer);
+        glDispatchCompute(kernel.DispatchX(static_cast<uint32_t>(selection.Width())),
+                          kernel.DispatchY(static_cast<uint32_t>(selection.Height())), 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
 
+    // 多区域批量转换：区域表 → 一次检测 dispatch → 一次处理 dispatch → 一次映射，依次交给各 sink。
+    // 返回走 HDR 路径的区域数
+    size_t RunRegionBatch(const GpuFrame &gpuFrame, const std::vector<SelectionRect> &selections,
+                          const std::vector<RegionOutput> &regions, const DisplayHdrInfo &hdrInfo,
+                          ToneMapOperator op) {
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const size_t regionCount = regions.size();
+
+        std::vector<GpuRegion> table(regionCount);
+        std::vector<ImageInfo> infos(regionCount);
+        uint64_t tileCount = 0;
+        uint64_t outputWords = 0;
+        for (size_t i = 0; i < regionCount; ++i) {
+            const SelectionRect &selection = selections[i];
+            ImageInfo &info = infos[i];
+            info.width = static_cast<uint32_t>(selection.Width());
+            info.height = static_cast<uint32_t>(selection.Height());
+            info.format = regions[i].sink->PreferredFormat();
+            info.toneMapOperator = op;
+
+            const uint32_t tilesX = (info.width + kRegionTileSize - 1) / kRegionTileSize;
+            const uint32_t tilesY = (info.height + kRegionTileSize - 1) / kRegionTileSize;
+            table[i] = {{selection.Left(), selection.Top(), selection.Width(), selection.Height()},
+                        {static_cast<uint32_t>(tileCount), tilesX, static_cast<uint32_t>(outputWords),
+                         info.format == OutputPixelFormat::Rgba16F ? kRegionRgba16FFlag : 0u}};
+            tileCount += static_cast<uint64_t>(tilesX) * tilesY;
+            outputWords += info.RowBytes() * info.height / sizeof(uint32_t);
+            if (tileCount > INT32_MAX || outputWords > UINT32_MAX) {
+                throw std::runtime_error("Region batch too large");
+            }
+        }
+
+        ScopedBuffer regionBuffer;
+        glGenBuffers(1, &regionBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, regionBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(table.size() * sizeof(GpuRegion)),
+                     table.data(), GL_STATIC_DRAW);
+
+        const std::vector<uint32_t> detectionFlags(regionCount, 0u);
+        ScopedBuffer detectionBuffer;
+        glGenBuffers(1, &detectionBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(regionCount * sizeof(uint32_t)),
+                     detectionFlags.data(), GL_DYNAMIC_COPY);
+
+        ScopedBuffer outputBuffer;
         glGenBuffers(1, &outputBuffer.id);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputBuffer.id);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(outputPixels * sizeof(uint32_t)), nullptr,
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(outputWords * sizeof(uint32_t)), nullptr,
                      GL_DYNAMIC_COPY);
 
-        glUseProgram(m_processProgram);
+        const GLuint dispatchX = static_cast<GLuint>((std::min)(tileCount, uint64_t{kRegionDispatchWidth}));
+        const GLuint dispatchY = static_cast<GLuint>((tileCount + dispatchX - 1) / dispatchX);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, regionBuffer.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, detectionBuffer.id);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sourceTexture);
-        glUniform1i(glGetUniformLocation(m_processProgram, "u_source"), 0);
-        glUniform2i(glGetUniformLocation(m_processProgram, "u_selectionOrigin"), selection.Left(), selection.Top());
-        glUniform2i(glGetUniformLocation(m_processProgram, "u_outputSize"), outputWidth, outputHeight);
-        glUniform1f(glGetUniformLocation(m_processProgram, "u_lw"), lw);
-        glUniform1i(glGetUniformLocation(m_processProgram, "u_useHlgPath"), useHlgPath ? 1 : 0);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, outputBuffer.id);
-        glDispatchCompute(dispatchX, dispatchY, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glBindTexture(GL_TEXTURE_2D, gpuFrame.GetTextureId());
+
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "detect");
+            const GLuint program = GetRegionDetectionProgram();
+            glUseProgram(program);
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform1i(glGetUniformLocation(program, "u_regionCount"), static_cast<GLint>(regionCount));
+            glUniform1i(glGetUniformLocation(program, "u_tileCount"), static_cast<GLint>(tileCount));
+            glUniform1f(glGetUniformLocation(program, "u_lw"), lw * 1.01f); // 容差，与单选区检测一致
+            glDispatchCompute(dispatchX, dispatchY, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        {
+            // 检测结果留在 GPU 上由处理 pass 直接读取，两次 dispatch 之间没有回读
+            GpuStageTimer::Scope timing(m_timer.get(), "process");
+            const GLuint program = GetRegionProcessingProgram(op);
+            glUseProgram(program);
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform1i(glGetUniformLocation(program, "u_regionCount"), static_cast<GLint>(regionCount));
+            glUniform1i(glGetUniformLocation(program, "u_tileCount"), static_cast<GLint>(tileCount));
+            glUniform1f(glGetUniformLocation(program, "u_lw"), lw);
+            glUniform1f(glGetUniformLocation(program, "u_sourcePeak"), ComputeSourcePeak(hdrInfo, lw));
+            BindLookupTables(program);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, outputBuffer.id);
+            glDispatchCompute(dispatchX, dispatchY, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        UnbindTextures();
+
+        const auto readbackStart = std::chrono::steady_clock::now();
+        size_t hdrRegions = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer.id);
+        const auto *mappedDetection = static_cast<const uint32_t *>(glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(regionCount * sizeof(uint32_t)), GL_MAP_READ_BIT));
+        if (!mappedDetection) {
+            throw std::runtime_error("Failed to map detection SSBO");
+        }
+        for (size_t i = 0; i < regionCount; ++i) {
+            infos[i].hdrPath = mappedDetection[i] != 0u;
+            hdrRegions += infos[i].hdrPath ? 1 : 0;
+        }
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputBuffer.id);
-        auto *mappedPixels = static_cast<const uint32_t *>(
-            glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0,
-                             static_cast<GLsizeiptr>(outputPixels * sizeof(uint32_t)), GL_MAP_READ_BIT));
+        const auto *mappedPixels = static_cast<const uint8_t *>(glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(outputWords * sizeof(uint32_t)), GL_MAP_READ_BIT));
         if (!mappedPixels) {
-            eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-            throw std::runtime_error("Failed to map output SSBO");
+            throw std::runtime_error("Failed to map output buffer");
+        }
+        try {
+            for (size_t i = 0; i < regionCount; ++i) {
+                regions[i].sink->Begin(infos[i]);
+                regions[i].sink->WriteRows(0, infos[i].height,
+                                           mappedPixels + static_cast<size_t>(table[i].placement[2]) * sizeof(uint32_t));
+            }
+        } catch (...) {
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            throw;
         }
-        std::memcpy(bgraPixels.data(), mappedPixels, outputPixels * sizeof(uint32_t));
         glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // End 可能是耗时的提交，全部放在解除映射之后
+        const auto commitStart = std::chrono::steady_clock::now();
+        for (const auto &region : regions) {
+            region.sink->End();
+        }
+        if (m_timer) {
+            m_timingStats.Add("readback", false,
+                              std::chrono::duration<double, std::milli>(commitStart - readbackStart).count());
+            m_timingStats.Add("sink-commit", false, std::chrono::duration<double, std::milli>(
+                                                        std::chrono::steady_clock::now() - commitStart)
+                                                        .count());
+        }
+        return hdrRegions;
+    }
+
+    // 片元后端的检测：颜色写入关闭，只看是否有片元通过阈值
+    bool RunFragmentDetection(const RenderTarget &target, const GpuFrame &gpuFrame, const SelectionRect &selection,
+                              const DisplayHdrInfo &hdrInfo) {
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const GLuint program = GetFragmentDetectionProgram();
+
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "detect");
+            glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+            DrawFragmentPass(program, target, gpuFrame.GetTextureId(), selection, lw * 1.01f, hdrInfo); // 容差
+            glEndQuery(GL_ANY_SAMPLES_PASSED);
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        UnbindTextures();
+
+        GLuint anyPassed = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &anyPassed);
+        glDeleteQueries(1, &query);
+        return anyPassed != GL_FALSE;
+    }
+
+    // 片元后端的处理：绘制到 RGBA8 目标，glReadPixels 异步读入 PBO，映射后交给 sink
+    void RunFragmentProcessing(const RenderTarget &target, const GpuFrame &gpuFrame, const SelectionRect &selection,
+                               const DisplayHdrInfo &hdrInfo, bool useHdrPath, ToneMapOperator op, bool colorLut,
+                               ImageSink &sink) {
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+        const GLuint program = GetFragmentProgram(
+            ShaderLibrary::FragmentVariantFor(ShaderLibrary::PathVariantFor(useHdrPath, op), colorLut));
+
+        ImageInfo info{};
+        info.width           = static_cast<uint32_t>(selection.Width());
+        info.height          = static_cast<uint32_t>(selection.Height());
+        info.format          = OutputPixelFormat::Bgra8;
+        info.hdrPath         = useHdrPath;
+        info.toneMapOperator = op;
+
+        ScopedBuffer pixelBuffer;
+        glGenBuffers(1, &pixelBuffer.id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.id);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(info.RowBytes() * info.height), nullptr,
+                     GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "process");
+            DrawFragmentPass(program, target, gpuFrame.GetTextureId(), selection, lw, hdrInfo);
+        }
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "pack");
+            ReadFramebufferToBuffer(pixelBuffer.id, info.width, info.height);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        UnbindTextures();
+
+        ReadBackToSink(GL_PIXEL_PACK_BUFFER, pixelBuffer.id, info, sink);
+    }
+
+    // 在选区大小的视口上画覆盖全屏的三角形，结果留在 target 中（target 保持绑定）
+    void DrawFragmentPass(GLuint program, const RenderTarget &target, GLuint sourceTexture,
+                          const SelectionRect &selection, float lw, const DisplayHdrInfo &hdrInfo) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        glViewport(0, 0, selection.Width(), selection.Height());
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_SCISSOR_TEST);
+        BindProcessingInputs(program, sourceTexture, selection, lw, hdrInfo);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    // 当前读帧缓冲 → PBO；行宽 width * 4 字节总是满足默认的 4 字节对齐
+    void ReadFramebufferToBuffer(GLuint pixelBuffer, uint32_t width, uint32_t height) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+        glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE,
+                     nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void BindProcessingInputs(GLuint program, GLuint sourceTexture, const SelectionRect &selection, float lw,
+                              const DisplayHdrInfo &hdrInfo) {
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sourceTexture);
+        glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+        glUniform2i(glGetUniformLocation(program, "u_selectionOrigin"), selection.Left(), selection.Top());
+        glUniform2i(glGetUniformLocation(program, "u_outputSize"), selection.Width(), selection.Height());
+        glUniform1f(glGetUniformLocation(program, "u_lw"), lw);
+        glUniform1f(glGetUniformLocation(program, "u_sourcePeak"), ComputeSourcePeak(hdrInfo, lw));
+        BindLookupTables(program);
+        BindRedactionOverlay(program, sourceTexture);
+    }
+
+    // 打码覆盖只在读取被打码的源帧时生效，其余情况（包括调优与标定）矩形数为 0
+    void BindRedactionOverlay(GLuint program, GLuint sourceTexture) {
+        const RedactionOverlay &overlay = m_redactionOverlay;
+        const bool active = overlay.patches != 0 && sourceTexture == overlay.source;
+        const GLsizei count = active ? static_cast<GLsizei>(overlay.origins.size() / 2) : 0;
+        glActiveTexture(GL_TEXTURE0 + kRedactionPatchUnit);
+        glBindTexture(GL_TEXTURE_2D, active ? overlay.patches : 0);
+        glUniform1i(glGetUniformLocation(program, "u_redactionPatches"), kRedactionPatchUnit);
+        glUniform1i(glGetUniformLocation(program, "u_redactionCount"), count);
+        if (count > 0) {
+            glUniform4iv(glGetUniformLocation(program, "u_redactionRects"), count, overlay.rects.data());
+            glUniform2iv(glGetUniformLocation(program, "u_redactionPatchOrigins"), count, overlay.origins.data());
+        }
+    }
+
+    // 传递函数查找表，以及（只有色彩管理变体声明了 u_colorLut）当前的色彩管理查找表
+    void BindLookupTables(GLuint program) {
+        glActiveTexture(GL_TEXTURE0 + kTransferLutUnit);
+        glBindTexture(GL_TEXTURE_2D, m_transferLut);
+        glUniform1i(glGetUniformLocation(program, "u_transferLut"), kTransferLutUnit);
+        const GLint colorLutLocation = glGetUniformLocation(program, "u_colorLut");
+        if (colorLutLocation != -1) {
+            glActiveTexture(GL_TEXTURE0 + kColorLutUnit);
+            glBindTexture(GL_TEXTURE_3D, m_colorLutTexture);
+            glUniform1i(colorLutLocation, kColorLutUnit);
+            glUniform1f(glGetUniformLocation(program, "u_colorLutSize"), static_cast<float>(m_colorLut->Size()));
+        }
+    }
+
+    // 同一张查找表只上传一次；换用另一张时替换纹理
+    void UseColorLut(const std::shared_ptr<const ColorLut> &lut) {
+        if (lut == m_colorLut) {
+            return;
+        }
+        if (m_colorLutTexture != 0) {
+            glDeleteTextures(1, &m_colorLutTexture);
+        }
+        m_colorLutTexture = CreateColorLutTexture(*lut);
+        m_colorLut = lut;
+        LOG("Color LUT uploaded: " + lut->Description());
+    }
+
+    void UnbindTextures() {
+        glActiveTexture(GL_TEXTURE0 + kRedactionPatchUnit);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0 + kColorLutUnit);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glActiveTexture(GL_TEXTURE0 + kTransferLutUnit);
         glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
-        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    // 映射输出缓冲区（SSBO 或 PBO）并直接交给 sink，不经过中间拷贝
+    void ReadBackToSink(GLenum target, GLuint buffer, const ImageInfo &info, ImageSink &sink) {
+        const auto readbackStart = std::chrono::steady_clock::now();
+        const size_t outputBytes = info.RowBytes() * info.height;
+        glBindBuffer(target, buffer);
+        auto *mappedPixels = static_cast<const uint8_t *>(
+            glMapBufferRange(target, 0, static_cast<GLsizeiptr>(outputBytes), GL_MAP_READ_BIT));
+        if (!mappedPixels) {
+            throw std::runtime_error("Failed to map output buffer");
+        }
+        try {
+            sink.Begin(info);
+            sink.WriteRows(0, info.height, mappedPixels);
+        } catch (...) {
+            glUnmapBuffer(target);
+            throw;
+        }
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+
+        // End 可能是耗时的提交（剪贴板、文件），放在解除映射之后
+        const auto commitStart = std::chrono::steady_clock::now();
+        sink.End();
+
+        // 映射会等待 GPU 完成，所以 readback 包含尚未完成的 GPU 工作与拷贝
+        if (m_timer) {
+            m_timingStats.Add("readback", false,
+                              std::chrono::duration<double, std::milli>(commitStart - readbackStart).count());
+            m_timingStats.Add("sink-commit", false, std::chrono::duration<double, std::milli>(
+                                                        std::chrono::steady_clock::now() - commitStart)
+                                                        .count());
+        }
+    }
 
-        if (useHlgPath) {
-            LOG("Compute shader output path selected: HLG. Detection still uses the current SDR white threshold, "
-                "but HLG encoding now uses the fixed scRGB absolute scale (1.0 = 80 nits).");
-        } else {
-            LOG("Compute shader output path selected: linear-sRGB");
+    // 把整个选区色调映射为线性光并写入新建的 RGBA16F 纹理，返回的纹理由调用者释放
+    GLuint RunLinearize(const GpuFrame &gpuFrame, const SelectionRect &selection, const DisplayHdrInfo &hdrInfo,
+                        bool useHdrPath, ToneMapOperator op) {
+        const uint32_t width  = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        const float    lw     = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+
+        ScopedTexture linearImage;
+        linearImage.Reset(CreateIntermediateTexture(width, height));
+
+        // 中间纹理逐像素 imageStore，始终使用默认变体
+        const GLuint program = GetProcessingProgram(
+            ShaderLibrary::ProcessingVariantFor(ShaderLibrary::kLinearImageTarget, useHdrPath, op), kDefaultKernelConfig);
+        BindProcessingInputs(program, gpuFrame.GetTextureId(), selection, lw, hdrInfo);
+        glBindImageTexture(0, linearImage.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "linearize");
+            glDispatchCompute(DispatchCount(width, kLocalSizeX), DispatchCount(height, kLocalSizeY), 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        UnbindTextures();
+
+        const GLuint texture = linearImage.id;
+        linearImage.id = 0;
+        return texture;
+    }
+
+    // 局部色调映射的三个 pass，返回选区大小的 RGBA16F 纹理（scRGB，坐标以选区左上角为原点），所有权交给调用者。
+    // 网格只有选区的 1/1024 大小，模糊 pass 的开销可以忽略，主要开销是读取两次选区与写出一次副本
+    GLuint RunLocalToneMapping(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                               const DisplayHdrInfo &hdrInfo) {
+        using ShaderLibrary::LocalToneMapStage;
+        const uint32_t width = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        const uint32_t cellsX = DispatchCount(width, kLocalToneMapCellSize);
+        const uint32_t cellsY = DispatchCount(height, kLocalToneMapCellSize);
+        const float lw = ComputeLw(ResolveSdrWhiteNits(hdrInfo.sdrWhiteLevel));
+
+        ScopedTexture grid;
+        ScopedTexture blurredGrid;
+        grid.Reset(CreateLocalToneMapGrid(cellsX, cellsY));
+        blurredGrid.Reset(CreateLocalToneMapGrid(cellsX, cellsY));
+        ScopedTexture peak;
+        ScopedTexture dilatedPeak;
+        peak.Reset(CreateIntermediateTexture(cellsX, cellsY));
+        dilatedPeak.Reset(CreateIntermediateTexture(cellsX, cellsY));
+        ScopedTexture output;
+        output.Reset(CreateIntermediateTexture(width, height));
+
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "local-grid");
+            const GLuint program = GetLocalToneMapProgram(LocalToneMapStage::Grid);
+            glUseProgram(program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, gpuFrame.GetTextureId());
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform2i(glGetUniformLocation(program, "u_selectionOrigin"), selection.Left(), selection.Top());
+            glUniform2i(glGetUniformLocation(program, "u_outputSize"), selection.Width(), selection.Height());
+            glUniform1f(glGetUniformLocation(program, "u_lw"), lw);
+            glUniform1f(glGetUniformLocation(program, "u_threshold"), lw * 1.01f); // 与检测 pass 相同的容差
+            BindRedactionOverlay(program, gpuFrame.GetTextureId());
+            glBindImageTexture(0, grid.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glBindImageTexture(1, peak.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glDispatchCompute(cellsX, cellsY, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "local-blur");
+            const GLuint program = GetLocalToneMapProgram(LocalToneMapStage::Blur);
+            glUseProgram(program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_3D, grid.id);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, peak.id);
+            glUniform1i(glGetUniformLocation(program, "u_grid"), 0);
+            glUniform1i(glGetUniformLocation(program, "u_peak"), 1);
+            glUniform3i(glGetUniformLocation(program, "u_gridSize"), static_cast<GLint>(cellsX),
+                        static_cast<GLint>(cellsY), static_cast<GLint>(kLocalToneMapBins));
+            glBindImageTexture(0, blurredGrid.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glBindImageTexture(1, dilatedPeak.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glDispatchCompute(DispatchCount(cellsX, kLocalToneMapBlurGroup),
+                              DispatchCount(cellsY, kLocalToneMapBlurGroup), kLocalToneMapBins);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "local-apply");
+            const GLuint program = GetLocalToneMapProgram(LocalToneMapStage::Apply);
+            glUseProgram(program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, gpuFrame.GetTextureId());
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_3D, blurredGrid.id);
+            // 峰值在单元之间双线性插值，使白点随位置平滑变化
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, dilatedPeak.id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform1i(glGetUniformLocation(program, "u_grid"), 1);
+            glUniform1i(glGetUniformLocation(program, "u_peak"), 2);
+            glUniform2i(glGetUniformLocation(program, "u_selectionOrigin"), selection.Left(), selection.Top());
+            glUniform2i(glGetUniformLocation(program, "u_outputSize"), selection.Width(), selection.Height());
+            glUniform1f(glGetUniformLocation(program, "u_lw"), lw);
+            glUniform2f(glGetUniformLocation(program, "u_gridScale"),
+                        1.0f / static_cast<float>(cellsX * kLocalToneMapCellSize),
+                        1.0f / static_cast<float>(cellsY * kLocalToneMapCellSize));
+            BindRedactionOverlay(program, gpuFrame.GetTextureId());
+            glBindImageTexture(0, output.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glDispatchCompute(DispatchCount(width, kLocalSizeX), DispatchCount(height, kLocalSizeY), 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        UnbindTextures();
+
+        const GLuint texture = output.id;
+        output.id = 0;
+        return texture;
+    }
+
+    // 把与选区相交的打码矩形（帧坐标）逐个打码到一张 RGBA16F patch 纹理，结果存入 m_redactionOverlay。
+    // patch 按矩形顺序逐行排放，行宽不超过 GL_MAX_TEXTURE_SIZE；纹理与 dispatch 都只覆盖打码矩形，
+    // 开销与打码面积成正比，与选区大小无关。调用时 context 不能为 current，之后须调用 ReleaseRedactionOverlay
+    void BuildRedactionOverlay(const GpuFrame &gpuFrame, const std::vector<SelectionRect> &redactions,
+                               const ConversionOptions &options) {
+        if (redactions.size() > kMaxRedactionRects) {
+            throw std::runtime_error("At most " + std::to_string(kMaxRedactionRects) +
+                                     " redaction rectangles per selection are supported");
+        }
+        MakeCurrent("BuildRedactionOverlay");
+        try {
+            RequireCompute("Redaction");
+            GLint maxSize = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+            RedactionOverlay overlay;
+            overlay.source = gpuFrame.GetTextureId();
+            int rowX = 0;
+            int rowY = 0;
+            int rowHeight = 0;
+            int patchesWidth = 0;
+            for (const auto &rect : redactions) {
+                if (rowX + rect.Width() > maxSize) {
+                    rowY += rowHeight;
+                    rowX = 0;
+                    rowHeight = 0;
+                }
+                overlay.rects.insert(overlay.rects.end(), {rect.Left(), rect.Top(), rect.Right(), rect.Bottom()});
+                overlay.origins.insert(overlay.origins.end(), {rowX, rowY});
+                rowX += rect.Width();
+                rowHeight = (std::max)(rowHeight, rect.Height());
+                patchesWidth = (std::max)(patchesWidth, rowX);
+            }
+            if (rowY + rowHeight > maxSize) {
+                throw std::runtime_error("Redaction rectangles do not fit in one texture");
+            }
+
+            ScopedTexture patches;
+            patches.Reset(CreateIntermediateTexture(static_cast<uint32_t>(patchesWidth),
+                                                    static_cast<uint32_t>(rowY + rowHeight)));
+            {
+                GpuStageTimer::Scope timing(m_timer.get(), "redact");
+                if (options.redactionStyle == RedactionStyle::Gaussian) {
+                    RedactWithBlur(overlay.source, patches.id, redactions, overlay.origins,
+                                   std::clamp(options.redactionSize, 1u, kMaxRedactionBlurRadius));
+                } else {
+                    RedactWithMosaic(overlay.source, patches.id, redactions, overlay.origins,
+                                     std::clamp(options.redactionSize, 2u, kMaxRedactionMosaicBlock));
+                }
+            }
+            UnbindTextures();
+            overlay.patches = patches.id;
+            patches.id = 0;
+            m_redactionOverlay = std::move(overlay);
+        } catch (...) {
+            ReleaseCurrent();
+            throw;
+        }
+        ReleaseCurrent();
+    }
+
+    // 删除 patch 纹理；没有打码覆盖时什么也不做。调用时 context 不能为 current
+    void ReleaseRedactionOverlay() {
+        if (m_redactionOverlay.patches != 0 && eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+            glDeleteTextures(1, &m_redactionOverlay.patches);
+            ReleaseCurrent();
+        }
+        m_redactionOverlay = RedactionOverlay{};
+    }
+
+    // 水平 pass 把源帧中的矩形写入临时纹理，垂直 pass 再写入矩形的 patch；临时纹理按最大的矩形分配，所有矩形共用
+    void RedactWithBlur(GLuint source, GLuint patches, const std::vector<SelectionRect> &redactions,
+                        const std::vector<GLint> &origins, uint32_t radius) {
+        int scratchWidth = 0;
+        int scratchHeight = 0;
+        for (const auto &rect : redactions) {
+            scratchWidth = (std::max)(scratchWidth, rect.Width());
+            scratchHeight = (std::max)(scratchHeight, rect.Height());
+        }
+        ScopedTexture scratch;
+        scratch.Reset(
+            CreateIntermediateTexture(static_cast<uint32_t>(scratchWidth), static_cast<uint32_t>(scratchHeight)));
+
+        const auto dispatch = [&](size_t index, GLuint input, GLuint output, const SelectionRect &rect,
+                                  const GLint *inputOrigin, const GLint *outputOrigin) {
+            const GLuint program = GetRedactionProgram(index);
+            glUseProgram(program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, input);
+            glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+            glUniform2i(glGetUniformLocation(program, "u_sourceOrigin"), inputOrigin[0], inputOrigin[1]);
+            glUniform2i(glGetUniformLocation(program, "u_destinationOrigin"), outputOrigin[0], outputOrigin[1]);
+            glUniform2i(glGetUniformLocation(program, "u_size"), rect.Width(), rect.Height());
+            glUniform1i(glGetUniformLocation(program, "u_radius"), static_cast<GLint>(radius));
+            glUniform1f(glGetUniformLocation(program, "u_sigma"), static_cast<float>(radius) / 2.0f);
+            glBindImageTexture(0, output, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            const uint32_t width = static_cast<uint32_t>(rect.Width());
+            const uint32_t height = static_cast<uint32_t>(rect.Height());
+            if (index == kRedactBlurVertical) {
+                glDispatchCompute(width, DispatchCount(height, kRedactionBlurGroupSize), 1);
+            } else {
+                glDispatchCompute(DispatchCount(width, kRedactionBlurGroupSize), height, 1);
+            }
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        };
+
+        const GLint scratchOrigin[2] = {0, 0};
+        for (size_t i = 0; i < redactions.size(); ++i) {
+            const SelectionRect &rect = redactions[i];
+            const GLint rectOrigin[2] = {rect.Left(), rect.Top()};
+            dispatch(kRedactBlurHorizontal, source, scratch.id, rect, rectOrigin, scratchOrigin);
+            dispatch(kRedactBlurVertical, scratch.id, patches, rect, scratchOrigin, &origins[i * 2]);
+        }
+    }
+
+    // 每个块一个工作组，从源帧读取，写入矩形的 patch
+    void RedactWithMosaic(GLuint source, GLuint patches, const std::vector<SelectionRect> &redactions,
+                          const std::vector<GLint> &origins, uint32_t block) {
+        const GLuint program = GetRedactionProgram(kRedactMosaic);
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+        glUniform1i(glGetUniformLocation(program, "u_block"), static_cast<GLint>(block));
+        glBindImageTexture(0, patches, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        for (size_t i = 0; i < redactions.size(); ++i) {
+            const SelectionRect &rect = redactions[i];
+            glUniform2i(glGetUniformLocation(program, "u_sourceOrigin"), rect.Left(), rect.Top());
+            glUniform2i(glGetUniformLocation(program, "u_destinationOrigin"), origins[i * 2], origins[i * 2 + 1]);
+            glUniform2i(glGetUniformLocation(program, "u_size"), rect.Width(), rect.Height());
+            glDispatchCompute(DispatchCount(static_cast<uint32_t>(rect.Width()), block),
+                              DispatchCount(static_cast<uint32_t>(rect.Height()), block), 1);
         }
-        return bgraPixels;
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+
+    // 线性光中间纹理 → 预缩小 → 水平 pass → 垂直 pass（含编码）→ sink
+    void ResampleToSink(GLuint linearImage, uint32_t width, uint32_t height, OutputSize size, ScaleFilter filter,
+                        bool useHdrPath, ToneMapOperator op, bool colorLut, ImageSink &sink) {
+        ImageInfo info{};
+        info.width           = size.width;
+        info.height          = size.height;
+        info.format          = sink.PreferredFormat();
+        info.hdrPath         = useHdrPath;
+        info.toneMapOperator = op;
+
+        ScopedBuffer outputBuffer;
+        glGenBuffers(1, &outputBuffer.id);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, outputBuffer.id);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(info.RowBytes() * info.height), nullptr,
+                     GL_DYNAMIC_COPY);
+
+        {
+            GpuStageTimer::Scope timing(m_timer.get(), "resample");
+            DispatchResample(linearImage, width, height, size, filter, info.format, colorLut, outputBuffer.id);
+        }
+        ReadBackToSink(GL_SHADER_STORAGE_BUFFER, outputBuffer.id, info, sink);
+    }
+
+    // 预缩小 + 水平 pass + 垂直 pass，结果写入 outputBuffer
+    void DispatchResample(GLuint linearImage, uint32_t width, uint32_t height, OutputSize size, ScaleFilter filter,
+                          OutputPixelFormat format, bool colorLut, GLuint outputBuffer) {
+        // 比例低于 0.5 的轴先做 2 倍盒式预缩小，保证滤波器足迹放得进 shared memory 中的 tile
+        ScopedTexture reduced[2];
+        GLuint current = linearImage;
+        uint32_t currentWidth = width;
+        uint32_t currentHeight = height;
+        for (size_t next = 0; size.width * 2 < currentWidth || size.height * 2 < currentHeight; next ^= 1) {
+            const GLint factorX = size.width * 2 < currentWidth ? 2 : 1;
+            const GLint factorY = size.height * 2 < currentHeight ? 2 : 1;
+            const uint32_t reducedWidth = (currentWidth + factorX - 1) / factorX;
+            const uint32_t reducedHeight = (currentHeight + factorY - 1) / factorY;
+            reduced[next].Reset(CreateIntermediateTexture(reducedWidth, reducedHeight));
+
+            glUseProgram(m_reduceProgram);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, current);
+            glUniform1i(glGetUniformLocation(m_reduceProgram, "u_source"), 0);
+            glUniform2i(glGetUniformLocation(m_reduceProgram, "u_sourceSize"), currentWidth, currentHeight);
+            glUniform2i(glGetUniformLocation(m_reduceProgram, "u_outputSize"), reducedWidth, reducedHeight);
+            glUniform2i(glGetUniformLocation(m_reduceProgram, "u_factor"), factorX, factorY);
+            glBindImageTexture(0, reduced[next].id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+            glDispatchCompute(DispatchCount(reducedWidth, kLocalSizeX), DispatchCount(reducedHeight, kLocalSizeY), 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+            current = reduced[next].id;
+            currentWidth = reducedWidth;
+            currentHeight = reducedHeight;
+        }
+
+        const float scaleX = static_cast<float>(size.width) / static_cast<float>(currentWidth);
+        const float scaleY = static_cast<float>(size.height) / static_cast<float>(currentHeight);
+        if (ResampleTileSpan(scaleX, filter) > kResampleTileCapacity ||
+            ResampleTileSpan(scaleY, filter) > kResampleTileCapacity) {
+            throw std::runtime_error("Resample footprint exceeds shared-memory tile");
+        }
+
+        // 水平 pass：currentWidth x currentHeight → size.width x currentHeight
+        ScopedTexture horizontal;
+        horizontal.Reset(CreateIntermediateTexture(size.width, currentHeight));
+        GLuint program =
+            GetResampleProgram(ShaderLibrary::ResampleVariantFor(filter, ShaderLibrary::kResampleHorizontalStage));
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, current);
+        glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+        glUniform2i(glGetUniformLocation(program, "u_sourceSize"), currentWidth, currentHeight);
+        glUniform2i(glGetUniformLocation(program, "u_outputSize"), size.width, currentHeight);
+        glUniform1f(glGetUniformLocation(program, "u_scale"), scaleX);
+        glBindImageTexture(0, horizontal.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glDispatchCompute(DispatchCount(size.width, kResampleTileOutputs),
+                          DispatchCount(currentHeight, kResampleTileLines), 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        // 垂直 pass：size.width x currentHeight → size，同时编码为输出格式
+        program = GetResampleProgram(
+            ShaderLibrary::ResampleVariantFor(filter, ShaderLibrary::ResampleVerticalStage(format, colorLut)));
+        glUseProgram(program);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, horizontal.id);
+        glUniform1i(glGetUniformLocation(program, "u_source"), 0);
+        glUniform2i(glGetUniformLocation(program, "u_sourceSize"), size.width, currentHeight);
+        glUniform2i(glGetUniformLocation(program, "u_outputSize"), size.width, size.height);
+        glUniform1f(glGetUniformLocation(program, "u_scale"), scaleY);
+        BindLookupTables(program);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, outputBuffer);
+        glDispatchCompute(DispatchCount(size.width, kResampleTileLines),
+                          DispatchCount(size.height, kResampleTileOutputs), 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        UnbindTextures();
     }
 
     EGLDisplay m_display = EGL_NO_DISPLAY;
     EGLSurface m_surface = EGL_NO_SURFACE;
     EGLContext m_context = EGL_NO_CONTEXT;
-    GLuint m_detectProgram  = 0;
-    GLuint m_processProgram = 0;
+    GLuint m_reduceProgram = 0;
+    GLuint m_tileDetectProgram = 0;
+    GLuint m_frameStatisticsProgram = 0;
+    std::array<GLuint, kKernelConfigCount> m_detectPrograms{};
+    std::array<GLuint, ShaderLibrary::kProcessingVariantCount * kKernelConfigCount> m_processPrograms{};
+    std::vector<size_t> m_detectRanking;  // kKernelConfigs 下标，最快在前；空表示尚未读取调优结果
+    std::vector<size_t> m_processRanking;
+    std::array<GLuint, ShaderLibrary::kFragmentVariantCount> m_fragmentPrograms{};
+    GLuint m_fragmentDetectProgram = 0;
+    GLuint m_regionDetectProgram = 0;
+    std::array<GLuint, kToneMapOperatorCount> m_regionProcessPrograms{};
+    std::array<GLuint, kRedactionProgramCount> m_redactionPrograms{};
+    std::array<GLuint, ShaderLibrary::kLocalToneMapStageCount> m_localToneMapPrograms{};
+    bool m_computeSupported = false;
+    GLint m_maxRenderbufferSize = 0;
+    bool m_tuned = false;
+    ConversionBackend m_tunedBackend = ConversionBackend::Compute;
+    std::string m_tuningSection;
+    bool m_costModelsLoaded = false;
+    bool m_costModelsComplete = false; // 每个可用后端都有模型，Auto 才按模型选择
+    std::array<CostModel, kRoutedBackends.size()> m_costModels; // 按 kRoutedBackends 的顺序
+    std::array<GLuint, ShaderLibrary::kResampleVariantCount> m_resamplePrograms{};
+    bool m_timingEnabled = false;
+    TimingStats m_timingStats;
+    std::unique_ptr<GpuStageTimer> m_timer;
+    GLuint m_transferLut = 0;
+    // 最近一次使用的色彩管理查找表及其纹理；持有 shared_ptr 保证按指针比较时对象仍然存活
+    std::shared_ptr<const ColorLut> m_colorLut;
+    GLuint m_colorLutTexture = 0;
+    std::unique_ptr<VulkanConverter> m_vulkan; // 首次使用 Vulkan 后端时创建
+    RedactionOverlay m_redactionOverlay; // 只在 ConvertSelectionToSinks 的一次转换期间非空
 };
 
 } // namespace
 
 std::unique_ptr<OutputModule> OutputModule::Create(EGLDisplay display, EGLSurface dummySurface, EGLContext context) { return std::make_unique<OutputModuleImpl>(display, dummySurface, context); }
 
+
+
+std::optional<OutputScale> ParseOutputScale(std::string_view text) {
+    std::string value(text);
+    OutputScale scale;
+    try {
+        size_t parsed = 0;
+        if (value.size() > 2 && value.compare(value.size() - 2, 2, "px") == 0) {
+            value.resize(value.size() - 2);
+            const unsigned long maxDimension = std::stoul(value, &parsed);
+            if (parsed != value.size() || maxDimension == 0) {
+                return std::nullopt;
+            }
+            scale.maxDimension = static_cast<uint32_t>(maxDimension);
+            return scale;
+        }
+        if (!value.empty() && value.back() == 'x') {
+            value.pop_back();
+        }
+        scale.factor = std::stof(value, &parsed);
+        if (parsed != value.size() || !(scale.factor > 0.0f) || scale.factor > 1.0f) {
+            return std::nullopt;
+        }
+        return scale;
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+}
+
+std::optional<ConversionBackend> ParseConversionBackend(std::string_view text) {
+    if (text == "auto") {
+        return ConversionBackend::Auto;
+    }
+    if (text == "compute") {
+        return ConversionBackend::Compute;
+    }
+    if (text == "fragment") {
+        return ConversionBackend::Fragment;
+    }
+    if (text == "cpu") {
+        return ConversionBackend::Cpu;
+    }
+    if (text == "vulkan") {
+        return ConversionBackend::Vulkan;
+    }
+    return std::nullopt;
+}
+
+const char *ConversionBackendName(ConversionBackend backend) {
+    switch (backend) {
+    case ConversionBackend::Compute:
+        return "compute";
+    case ConversionBackend::Fragment:
+        return "fragment";
+    case ConversionBackend::Cpu:
+        return "cpu";
+    case ConversionBackend::Vulkan:
+        return "vulkan";
+    default:
+        return "auto";
+    }
+}
+
+std::optional<ScaleFilter> ParseScaleFilter(std::string_view text) {
+    if (text == "lanczos" || text == "lanczos3") {
+        return ScaleFilter::Lanczos3;
+    }
+    if (text == "box") {
+        return ScaleFilter::Box;
+    }
+    return std::nullopt;
+}
+
+std::optional<RedactionStyle> ParseRedactionStyle(std::string_view text) {
+    if (text == "mosaic") {
+        return RedactionStyle::Mosaic;
+    }
+    if (text == "blur" || text == "gaussian") {
+        return RedactionStyle::Gaussian;
+    }
+    return std::nullopt;
+}
+
+std::optional<SelectionRect> ParseSelectionRect(std::string_view text) {
+    int values[4] = {};
+    const char *position = text.data();
+    const char *end = text.data() + text.size();
+    for (int i = 0; i < 4; ++i) {
+        const auto [next, error] = std::from_chars(position, end, values[i]);
+        if (error != std::errc{} || (i < 3 && (next == end || *next != ','))) {
+            return std::nullopt;
+        }
+        position = i < 3 ? next + 1 : next;
+    }
+    if (position != end || values[2] <= 0 || values[3] <= 0) {
+        return std::nullopt;
+    }
+    return SelectionRect{values[0], values[1], values[0] + values[2], values[1] + values[3]};
+}
+
+std::string OutputScaleSuffix(const OutputScale &scale) {
+    if (scale.maxDimension != 0) {
+        return "@" + std::to_string(scale.maxDimension) + "px";
+    }
+    if (scale.factor == 1.0f) {
+        return {};
+    }
+    std::ostringstream stream;
+    stream << "@" << scale.factor << "x";
+    return stream.str();
+}
@@ -1,16 +1,214 @@
 #pragma once
 
+#include "ColorLut.h"
+#include "FrameStatistics.h"
 #include "GpuFrame.h"
-#include "PreviewModule.h"
+#include "GpuTimer.h"
+#include "ImageSink.h"
+#include "SelectionRect.h"
 #include "SystemInfo.h"
+#include "ToneMapping.h"
+#include "TransferLut.h"
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 缩放输出使用的可分离重采样滤波器；重采样在色调映射之后、输出编码之前的线性光中进行
+enum class ScaleFilter {
+    Lanczos3, // 三瓣 Lanczos，锐利，细线条保留较好
+    Box,      // 面积平均，无振铃
+};
+
+// 输出尺寸，只缩小不放大。maxDimension 非 0 时优先：等比缩放到长边不超过该值（缩略图）
+struct OutputScale {
+    float factor = 1.0f;
+    uint32_t maxDimension = 0;
+};
+
+// 同一次转换的一个输出：尺寸 + 接收端
+struct ScaledOutput {
+    OutputScale scale;
+    ImageSink *sink = nullptr;
+};
+
+// 同一帧中的一个区域及其接收端
+struct RegionOutput {
+    SelectionRect selection;
+    ImageSink *sink = nullptr;
+};
+
+// 1x 输出的转换后端
+enum class ConversionBackend {
+    Auto,     // 全部输出为 1x 时按各后端的延迟模型选择预测最快者，否则使用调优缓存中较快的 GPU 后端
+    Compute,  // 计算着色器写 SSBO，需要 GLES 3.1
+    Fragment, // 片元着色器渲染到 RGBA8 帧缓冲，经 PBO 回读；GLES 3.0 即可，只用于 8-bit 输出
+    Cpu,      // 直接读取 CPU 侧帧数据，不使用 GL；只支持 1x 输出
+    Vulkan,   // Vulkan 计算后端（PRINTSCR_VULKAN 构建），见 VulkanConverter.h；只支持 1x 输出，不参与 Auto 选择
+};
+
+// 打码方式，作用在色调映射之前的 FP16 源上
+enum class RedactionStyle {
+    Mosaic,   // 每个 redactionSize × redactionSize 的块取平均
+    Gaussian, // 可分离高斯模糊，半径 redactionSize，σ = 半径 / 2
+};
+
+constexpr uint32_t kMaxRedactionMosaicBlock = 64;
+constexpr uint32_t kMaxRedactionBlurRadius = 32;
+// 与一个选区相交的打码矩形数上限，与打码覆盖着色器中的 uniform 数组大小一致
+constexpr uint32_t kMaxRedactionRects = 16;
+
+// 单次转换的可选参数
+struct ConversionOptions {
+    // 选区检测到 HDR 高光时使用的色调映射算子
+    ToneMapOperator toneMapOperator = ToneMapOperator::HlgRoundTrip;
+    ScaleFilter scaleFilter = ScaleFilter::Lanczos3;
+    // 复制到剪贴板的图像尺寸
+    OutputScale clipboardScale;
+    // 只影响 1x 输出；缩放输出始终使用计算着色器，片元后端下的 16-bit 输出也是
+    ConversionBackend backend = ConversionBackend::Auto;
+    // 非空时 BGRA8 输出在打包前经过色彩管理查找表（所有后端与缩放输出都支持，多区域批量转换退回逐区域转换）
+    std::shared_ptr<const ColorLut> colorLut;
+    // 非空时这些矩形（帧坐标）在检测与色调映射之前于 GPU 上打码，只处理与选区相交的部分（至多
+    // kMaxRedactionRects 个，有重叠时后面的矩形优先），源帧本身不变。
+    // 需要计算着色器；CPU 与 Vulkan 后端读取未打码的 CPU 侧帧数据，因此不支持，Auto 只在 GL 后端中选择
+    std::vector<SelectionRect> redactions;
+    RedactionStyle redactionStyle = RedactionStyle::Mosaic;
+    uint32_t redactionSize = 16; // 马赛克块边长或模糊半径，按 kMaxRedaction* 钳制
+    // 检测到高光时不再整体切换到 toneMapOperator，而是由低分辨率的双边网格得到随位置平滑变化的曲线：
+    // 附近没有高光的区域保持 SDR 路径的结果，高光区域滚降。需要计算着色器，CPU 与 Vulkan 后端不支持，
+    // Auto 只在 GL 后端中选择；带增益图的输出仍使用 toneMapOperator
+    bool localToneMapping = false;
+    // 非空且属于被转换的帧、检测阈值相同时，由求和面积表直接判断选区有无高光，不再运行检测 pass；
+    // 统计来自未打码的源帧，有打码时不使用，照常检测
+    std::shared_ptr<const FrameStatistics> statistics;
+};
+
+// 解析 "0.5" / "0.5x"（比例）或 "256px"（长边上限）
+std::optional<OutputScale> ParseOutputScale(std::string_view text);
+// 解析 "lanczos" / "box"
+std::optional<ScaleFilter> ParseScaleFilter(std::string_view text);
+// 用于文件名的后缀：1x 为空，其余如 "@0.5x"、"@256px"
+std::string OutputScaleSuffix(const OutputScale &scale);
+// 解析 "mosaic" / "blur"
+std::optional<RedactionStyle> ParseRedactionStyle(std::string_view text);
+// 解析 "x,y,w,h"，宽高为正
+std::optional<SelectionRect> ParseSelectionRect(std::string_view text);
+// 解析 "auto" / "compute" / "fragment" / "cpu" / "vulkan"
+std::optional<ConversionBackend> ParseConversionBackend(std::string_view text);
+const char *ConversionBackendName(ConversionBackend backend);
+
+// CompareToneMapOperators 对单个算子给出的耗时与质量指标
+struct ToneMapComparison {
+    ToneMapOperator op;
+    double averageMs;       // 处理 pass（含回读）的平均耗时
+    double meanLuma;        // 输出 8-bit 亮度均值
+    double clippedFraction; // 任一通道饱和到 255 的像素比例
+    double sdrDeviation;    // 在 HardClip 未饱和的像素上与 HardClip 的平均码值差，衡量对 SDR 内容的改动
+};
+
+// RunAutotune 对单个 kernel 变体的测量结果（p50）
+struct KernelBenchmark {
+    std::string kernel; // KernelConfig::name
+    bool gpuTimed;      // false 表示 GPU 计时不可用，为含 glFinish 的 CPU 时间
+    double detectMs;
+    double processMs;
+};
+
+// 一个后端标定后的延迟模型：预测耗时 = overheadMs + msPerMegapixel × 输出百万像素数
+struct BackendCostModel {
+    ConversionBackend backend;
+    double overheadMs;     // 每次调用的固定开销（eglMakeCurrent、dispatch、缓冲区创建与映射等）
+    double msPerMegapixel;
+};
+
+// PrecomputeFrame 的结果：整帧两条路径各一份 1x BGRA8 输出，以及检测 tile 索引
+struct PrecomputedFrame {
+    static constexpr uint32_t kTileSize = 16;
+
+    ConvertedImage sdr; // 线性 sRGB 路径
+    ConvertedImage hdr; // 色调映射路径
+    uint32_t tilesX = 0;
+    uint32_t tilesY = 0;
+    std::vector<uint8_t> highlightTiles; // 行优先，非 0 表示 tile 内有像素超过 detectionThreshold
+    float detectionThreshold = 0.0f;     // 与检测 pass 相同的 scRGB 线性阈值
+
+    // 两份整帧输出加 tile 索引所需的内存
+    static uint64_t EstimateBytes(uint32_t width, uint32_t height) {
+        const uint64_t tiles = uint64_t{(width + kTileSize - 1) / kTileSize} * ((height + kTileSize - 1) / kTileSize);
+        return 2 * uint64_t{width} * height * BytesPerPixel(OutputPixelFormat::Bgra8) + tiles;
+    }
+};
+
+struct AutotuneReport {
+    std::vector<KernelBenchmark> kernels; // 按处理耗时排序；GLES 3.0 context 下为空
+    ConversionBackend selected; // 不经过延迟模型时（缩放输出、打码、局部色调映射）Auto 解析到的 GPU 后端
+    std::vector<BackendCostModel> costModels;
+};
 
 class OutputModule {
 public:
     virtual ~OutputModule() = default;
 
+    // 转换选区并按 sink.PreferredFormat() 的格式写入 sink。大选区的计算输出按水平条带流式处理，
+    // sink 会收到多次 WriteRows，缓冲区占用与选区大小无关
+    virtual void ConvertSelectionToSink(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                        const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                                        ImageSink &sink) = 0;
+
+    // 一次检测、一次色调映射，同时产生多个尺寸的输出。1x 输出与 ConvertSelectionToSink 完全一致；
+    // 其余输出在线性光下先按 2 倍盒式滤波预缩小，再做可分离重采样，回读量随缩放比例减小
+    virtual void ConvertSelectionToSinks(const GpuFrame &gpuFrame, const SelectionRect &selection,
+                                         const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                                         const std::vector<ScaledOutput> &outputs) = 0;
+
+    // 同一帧的多个区域一起转换（1x，计算着色器）：全部区域的检测与处理各只有一次 dispatch，写入同一个
+    // 打包的输出缓冲区，映射一次后依次交给各区域的 sink，每次调用的固定开销只付一次。每个区域独立检测高光
+    // 并选择路径，检测结果经 ImageInfo::hdrPath 交给 sink；输出与逐个调用 ConvertSelectionToSink 一致
+    virtual void ConvertRegionsToSinks(const GpuFrame &gpuFrame, const DisplayHdrInfo &hdrInfo,
+                                       const ConversionOptions &options,
+                                       const std::vector<RegionOutput> &regions) = 0;
+
+#ifdef _WIN32
     virtual void CopySelectionToClipboard(const GpuFrame &gpuFrame, const SelectionRect &selection,
-                                          const DisplayHdrInfo &hdrInfo) = 0;
+                                          const DisplayHdrInfo &hdrInfo, const ConversionOptions &options) = 0;
+#endif
+
+    // 不做选区检测，把整帧分别按 SDR 与 op 的 HDR 路径转换为 1x BGRA8（计算着色器），并生成检测 tile 索引。
+    // 任意选区的结果都可以从中裁剪得到，与计算后端逐字节一致
+    virtual PrecomputedFrame PrecomputeFrame(const GpuFrame &gpuFrame, const DisplayHdrInfo &hdrInfo,
+                                             ToneMapOperator op) = 0;
+
+    // 整帧一次 dispatch 生成亮度求和面积表（计算着色器），之后任意选区的均值、方差、峰值与超过 SDR 白的比例
+    // 都在 CPU 上查表得到，见 FrameStatistics
+    virtual std::shared_ptr<const FrameStatistics> ComputeFrameStatistics(std::shared_ptr<const GpuFrame> gpuFrame,
+                                                                          const DisplayHdrInfo &hdrInfo) = 0;
+
+    // 对同一选区强制走 HDR 路径，依次运行所有色调映射算子并统计耗时与质量指标
+    virtual std::vector<ToneMapComparison> CompareToneMapOperators(const GpuFrame &gpuFrame,
+                                                                   const SelectionRect &selection,
+                                                                   const DisplayHdrInfo &hdrInfo, int iterations) = 0;
+
+    // 可选的逐阶段计时：检测、处理/重采样 dispatch 使用 GPU 计时查询，回读与 sink 提交使用 CPU 时间。
+    // 默认关闭；开启后每次转换结束时写日志，统计为最近若干次的滚动百分位
+    virtual void SetTimingEnabled(bool enabled) = 0;
+    virtual std::vector<StageTimingStats> GetTimingStats() const = 0;
+
+    // 检测与处理 pass 有多种 kernel 变体（见 KernelConfig.h），1x 输出有计算、片元与 CPU 三个后端。
+    // 首次转换时按渲染器从调优缓存读取 kernel 排名、各后端的延迟模型与由模型得出的 GPU 后端（缺少的部分由
+    // PrepareTuning 补齐）；本函数强制重新测量 kernel 并重新标定延迟模型
+    virtual AutotuneReport RunAutotune() = 0;
+
+    // 缓存中缺少 kernel 排名或延迟模型时在此测量：全部 kernel 变体各运行数次，每个后端在两种尺寸上各完整转换
+    // 6 次，耗时可达数秒。应在非交互的时机调用（守护进程启动时）；在此之前转换使用默认 kernel 变体，
+    // Auto 使用缓存中的 GPU 后端，不经过延迟模型。调用时不能有其他线程在使用本模块
+    virtual void PrepareTuning() = 0;
+
+    // 在 GPU 上按 TransferLut::VerifyInput 逐点运行着色器中的查表链（R16F 纹理的双线性采样），
+    // 读回 8-bit 码值与精确结果比较，见 TransferLut::VerifyCodes
+    virtual TransferLut::VerifyReport VerifyTransferLut() = 0;
 
     static std::unique_ptr<OutputModule> Create(EGLDisplay display, EGLSurface dummySurface, EGLContext context);
 };
@@ -1,105 +1,150 @@
 #include "PreviewModule.h"
 #include "GpuFrame.h"
+#include "LatestValue.h"
 #include "Logger.h"
+#include "ShaderLibrary.h"
 #include "SystemInfo.h"
 
+#include <commctrl.h>
+
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <EGL/eglext_angle.h>
 #include <GLES3/gl3.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
 #include <iostream>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #pragma comment(lib, "user32.lib")
 #pragma comment(lib, "gdi32.lib")
+#pragma comment(lib, "comctl32.lib")
+
+namespace {
+
+// 预览 surface 的颜色格式，都不带深度与模板缓冲
+enum class SurfaceFormat { Rgba8, Rgb10A2, Rgba16F };
+
+struct SurfaceFormatInfo {
+    const char *name;
+    EGLint redBits;
+    EGLint greenBits;
+    EGLint blueBits;
+    EGLint alphaBits;
+    EGLint componentType;
+    uint32_t bytesPerPixel;
+    bool encodeSrgb; // UNORM 格式由合成器按 sRGB 信号解释，浮点格式按线性 scRGB 解释
+};
+
+constexpr std::array<SurfaceFormatInfo, 3> kSurfaceFormats = {{
+    {"RGBA8", 8, 8, 8, 8, EGL_COLOR_COMPONENT_TYPE_FIXED_EXT, 4, true},
+    {"RGB10A2", 10, 10, 10, 2, EGL_COLOR_COMPONENT_TYPE_FIXED_EXT, 4, true},
+    {"RGBA16F", 16, 16, 16, 16, EGL_COLOR_COMPONENT_TYPE_FLOAT_EXT, 8, false},
+}};
+
+const SurfaceFormatInfo &FormatInfo(SurfaceFormat format) { return kSurfaceFormats[static_cast<size_t>(format)]; }
+
+// HDR 模式下才需要浮点 surface 显示超过 SDR 白的部分；SDR 模式按显示器的位深选择
+SurfaceFormat PreferredSurfaceFormat(const DisplayHdrInfo &hdrInfo) {
+    if (hdrInfo.hdrEnabled) {
+        return SurfaceFormat::Rgba16F;
+    }
+    return hdrInfo.bitsPerColor >= 10 ? SurfaceFormat::Rgb10A2 : SurfaceFormat::Rgba8;
+}
+
+// DirectComposition 交换链按双缓冲估算
+constexpr uint64_t kSurfaceBufferCount = 2;
+
+} // namespace
 
 class PreviewWindowImpl : public PreviewWindow {
 public:
     PreviewWindowImpl(EGLDisplay display, EGLSurface dummySurface, EGLContext rootContext)
         : m_display(display), m_dummySurface(dummySurface), m_rootContext(rootContext) {}
 
-    ~PreviewWindowImpl() { CleanupGL(); }
+    ~PreviewWindowImpl() {
+        DestroyPreviewWindow();
+        CleanupGL();
+        if (m_renderEvent) {
+            CloseHandle(m_renderEvent);
+        }
+    }
+
+    bool Prepare() override {
+        const auto start = std::chrono::steady_clock::now();
+        if (!EnsureWindow(SystemInfo::GetPrimaryDisplayHdrInfo())) {
+            return false;
+        }
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        LOG("Preview window prepared in " + std::to_string(elapsed.count()) + " ms.");
+        return true;
+    }
 
     SelectionRect Show(std::shared_ptr<GpuFrame> gpuFrame) override {
         LOG("PreviewWindow::Show called.");
-        m_gpuFrame = gpuFrame;
+        const auto showStart = std::chrono::steady_clock::now();
+        m_lastFirstPresent.reset();
         m_hdrInfo = SystemInfo::GetPrimaryDisplayHdrInfo();
-        LOG("HDR Info: SDR White Level=" + std::to_string(m_hdrInfo.sdrWhiteLevel));
-
-        LOG("Creating Win32 window...");
-        if (!CreateWin32Window()) {
-            LOG("Failed to create Win32 window.");
-            return {};
-        }
-        LOG("Window created.");
-
-        LOG("Initializing EGL Surface...");
-        if (!InitEGLSurface()) {
-            LOG("Failed to initialize EGL surface.");
-            DestroyWindow(m_hwnd);
-            m_hwnd = nullptr;
+        LOG("HDR Info: SDR White Level=" + std::to_string(m_hdrInfo.sdrWhiteLevel) +
+            (m_hdrInfo.hdrEnabled ? ", HDR on" : ", HDR off") + ", " + std::to_string(m_hdrInfo.bitsPerColor) +
+            " bits per color");
+        if (!EnsureWindow(m_hdrInfo)) {
             return {};
         }
-
-        if (m_program == 0) {
-            LOG("Initializing GL (first time)...");
-            if (!InitGL()) {
-                LOG("Failed to initialize GL.");
-                CleanupSurface();
-                DestroyWindow(m_hwnd);
-                m_hwnd = nullptr;
-                return {};
-            }
-            LOG("GL initialized.");
-        } else {
-            // Re-bind texture properly inside InitGL/Render if needed, we just update m_texture here
-            m_texture = m_gpuFrame->GetTextureId();
-        }
+        m_gpuFrame = gpuFrame;
 
         m_running = true;
         m_selectionConfirmed = false;
         m_selection = {0, 0, 0, 0};
-        m_needsRender = true;
-        m_currentSwapInterval = -1;
-
-        // Cache cursors
-        m_cursorCross = LoadCursorW(nullptr, (LPCWSTR)IDC_CROSS);
-        m_cursorArrow = LoadCursorW(nullptr, (LPCWSTR)IDC_ARROW);
-        m_cursorSizeNWSE = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENWSE);
-        m_cursorSizeNESW = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENESW);
-        m_cursorSizeNS = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENS);
-        m_cursorSizeWE = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZEWE);
-        m_cursorSizeAll = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZEALL);
+        m_isDragging = false;
+        m_needsRender = false;
+        m_dpi = GetDpiForWindow(m_hwnd);
+        if (m_dpi == 0)
+            m_dpi = 96;
+        m_statisticsSelection = {0, 0, 0, 0};
+        CreateStatisticsTip();
+
+        // 换入新帧，窗口在第一帧呈现之后才显示，不会闪出上一次截图
+        m_frameGeneration++;
+        PublishInput();
+        PumpUntil([this] { return m_renderedFrame.load() == m_frameGeneration || m_renderFailed; });
+        if (m_renderFailed) {
+            ParkRenderer();
+            return {};
+        }
+        m_lastFirstPresent = std::chrono::steady_clock::now();
+        const std::chrono::duration<double, std::milli> elapsed = *m_lastFirstPresent - showStart;
+        LOG("Preview first frame presented " + std::to_string(elapsed.count()) + " ms after Show.");
+        ShowWindow(m_hwnd, SW_SHOW);
+        SetForegroundWindow(m_hwnd);
 
         LOG("Entering message loop...");
 
+        // 本线程只处理输入：每批消息处理完后把最新状态发布给渲染线程，不等待绘制与 vsync
         MSG msg;
         while (m_running) {
-            if (!m_needsRender) {
-                BOOL waitResult = GetMessage(&msg, nullptr, 0, 0);
-                if (waitResult <= 0) {
-                    m_running = false;
-                    break;
-                }
-
-                if (msg.message == WM_QUIT) {
-                    // Because we might have a lingering WM_QUIT from another part, we just consume it.
-                    // If it was meant for us, m_running will become false eventually anyway.
-                    // Wait, if it's meant for the app, we should probably repost it. Actually,
-                    // we remove WM_QUIT posting from WM_DESTROY, so WM_QUIT should never happen
-                    // unless the app is terminating.
-                    m_running = false;
-                } else {
-                    TranslateMessage(&msg);
-                    DispatchMessage(&msg);
-                }
+            BOOL waitResult = GetMessage(&msg, nullptr, 0, 0);
+            if (waitResult <= 0) {
+                m_running = false;
+                break;
             }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
 
             while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
                 if (msg.message == WM_QUIT) {
+                    // WM_DESTROY 不再 PostQuitMessage，WM_QUIT 只会在应用退出时出现
                     m_running = false;
                 } else {
                     TranslateMessage(&msg);
@@ -110,46 +155,187 @@ public:
             if (!m_running)
                 break;
 
-            UpdateSwapInterval();
+            if (m_needsRender) {
+                UpdateStatisticsTip();
+                PublishInput();
+                m_needsRender = false;
+            }
+        }
 
-            if (!m_needsRender)
-                continue;
+        LOG("Exiting message loop.");
+        ParkRenderer();
 
-            Render();
-            if (!eglSwapBuffers(m_display, m_surface)) {
-                LOG("eglSwapBuffers failed.");
-                break;
+        if (m_timingEnabled) {
+            LOG("Preview timing: " + m_timingStats.Describe());
+        }
+        LOG("Preview hidden. Show returning.");
+        return m_selectionConfirmed && !m_renderFailed ? m_selection : SelectionRect{0, 0, 0, 0};
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> LastFirstPresent() const override {
+        return m_lastFirstPresent;
+    }
+
+    void SetSelectionSettledCallback(SelectionSettledCallback callback) override {
+        m_selectionSettled = std::move(callback);
+    }
+
+    void SetFrameStatistics(std::shared_ptr<const FrameStatistics> statistics) override {
+        m_statistics = std::move(statistics);
+    }
+
+    void SetTimingEnabled(bool enabled) override { m_timingEnabled = enabled; }
+
+    std::vector<StageTimingStats> GetTimingStats() const override { return m_timingStats.Snapshot(); }
+
+private:
+    // 按开关创建/销毁计时器并取回已完成的查询，调用时 m_context 为 current
+    void UpdateTimer() {
+        if (m_timingEnabled && !m_timer) {
+            m_timer = std::make_unique<GpuStageTimer>(m_timingStats);
+        } else if (!m_timingEnabled && m_timer) {
+            m_timer.reset();
+        }
+        if (m_timer) {
+            m_timer->Collect(false);
+        }
+    }
+
+    // 窗口线程发布给渲染线程的输入
+    struct PreviewInput {
+        SelectionRect selection = {0, 0, 0, 0};
+        UINT dpi = 96;
+        uint64_t frame = 0; // 当前帧的代数，0 表示隐藏、渲染线程不再访问帧
+    };
+
+    // 窗口线程调用
+    void PublishInput() {
+        m_input.Publish({m_selection, m_dpi, m_running ? m_frameGeneration : 0});
+        m_inputVersion.fetch_add(1, std::memory_order_release);
+        m_inputVersion.notify_one();
+    }
+
+    void StopRenderThread() {
+        if (!m_renderThread.joinable()) {
+            return;
+        }
+        m_stopRendering = true;
+        m_inputVersion.fetch_add(1, std::memory_order_release);
+        m_inputVersion.notify_one();
+        m_renderThread.join();
+    }
+
+    void RenderThreadMain();
+    bool RenderFrame();
+
+    // 窗口、EGL surface 与渲染线程跨 Show 保留；屏幕尺寸变化或渲染失败后重建
+    bool EnsureWindow(const DisplayHdrInfo &hdrInfo);
+    void DestroyPreviewWindow();
+    // Show 结束时让渲染线程停止访问帧，再隐藏窗口并释放帧
+    void ParkRenderer();
+
+    // 等待渲染线程期间继续处理本线程的消息：创建 surface 时驱动可能向窗口发送消息
+    template <typename Predicate>
+    void PumpUntil(Predicate done) {
+        while (!done()) {
+            MsgWaitForMultipleObjects(1, &m_renderEvent, FALSE, INFINITE, QS_ALLINPUT);
+            MSG msg;
+            while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
             }
+        }
+    }
 
-            m_needsRender = false;
+    // 跟随选区的提示框，只在设置了统计时创建
+    void CreateStatisticsTip() {
+        if (!m_statistics || m_statisticsTip) {
+            return;
+        }
+        m_statisticsTip = CreateWindowExW(WS_EX_TOPMOST, TOOLTIPS_CLASSW, nullptr,
+                                          WS_POPUP | TTS_NOPREFIX | TTS_ALWAYSTIP, CW_USEDEFAULT, CW_USEDEFAULT,
+                                          CW_USEDEFAULT, CW_USEDEFAULT, m_hwnd, nullptr, GetModuleHandle(nullptr),
+                                          nullptr);
+        if (!m_statisticsTip) {
+            LOG("Failed to create statistics tooltip.");
+            return;
         }
+        TOOLINFOW info = {sizeof(TOOLINFOW)};
+        info.uFlags = TTF_TRACK | TTF_ABSOLUTE;
+        info.hwnd = m_hwnd;
+        info.lpszText = const_cast<wchar_t *>(L"");
+        SendMessageW(m_statisticsTip, TTM_ADDTOOLW, 0, reinterpret_cast<LPARAM>(&info));
+    }
 
-        LOG("Exiting message loop. Cleaning up surface...");
-        CleanupSurface();
-        if (m_hwnd) {
-            DestroyWindow(m_hwnd);
-            m_hwnd = nullptr;
+    // 选区变化后查表并更新提示框文字与位置，选区无效时隐藏
+    void UpdateStatisticsTip() {
+        if (!m_statisticsTip) {
+            return;
+        }
+        const SelectionRect &shown = m_statisticsSelection;
+        if (m_selection.Left() == shown.Left() && m_selection.Top() == shown.Top() &&
+            m_selection.Right() == shown.Right() && m_selection.Bottom() == shown.Bottom()) {
+            return;
         }
+        m_statisticsSelection = m_selection;
 
-        // We MUST pump the queue for WM_DESTROY and WM_NCDESTROY otherwise DestroyWindow won't finish its message sending
-        // Actually DestroyWindow is synchronous for messages, but we should handle pending ones if any.
-        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
+        TOOLINFOW info = {sizeof(TOOLINFOW)};
+        info.hwnd = m_hwnd;
+        if (!m_selection.IsValid()) {
+            SendMessageW(m_statisticsTip, TTM_TRACKACTIVATE, FALSE, reinterpret_cast<LPARAM>(&info));
+            return;
         }
 
-        LOG("Surface cleanup done. Show returning.");
-        return m_selectionConfirmed ? m_selection : SelectionRect{0, 0, 0, 0};
+        const LuminanceStatistics statistics = m_statistics->Query(m_selection);
+        wchar_t text[160];
+        swprintf(text, std::size(text), L"%d x %d  mean %.0f nits (\u03c3 %.0f)  peak %.0f nits  > SDR white %.1f%%",
+                 m_selection.Width(), m_selection.Height(), statistics.meanNits, statistics.stdDevNits,
+                 statistics.peakNits, statistics.aboveSdrWhiteFraction * 100.0);
+        info.lpszText = text;
+        SendMessageW(m_statisticsTip, TTM_UPDATETIPTEXTW, 0, reinterpret_cast<LPARAM>(&info));
+
+        POINT anchor = {m_selection.Right() + 8, m_selection.Bottom() + 8};
+        ClientToScreen(m_hwnd, &anchor);
+        SendMessageW(m_statisticsTip, TTM_TRACKPOSITION, 0, MAKELPARAM(anchor.x, anchor.y));
+        SendMessageW(m_statisticsTip, TTM_TRACKACTIVATE, TRUE, reinterpret_cast<LPARAM>(&info));
     }
 
-private:
     bool CreateWin32Window();
     bool InitEGLSurface();
     bool InitGL();
-    void Render();
+    // 与顶点着色器中的 uniform block PreviewGeometry 对应（std140）
+    struct PreviewGeometry {
+        std::array<float, 4> viewTransform{};
+        std::array<std::array<float, 4>, 6> rects{};
+    };
+    static constexpr GLint kFrameRect = 0;
+    static constexpr GLint kSelectionRect = 1;
+    static constexpr GLint kBorderRects = 2; // 左、右、上、下四条
+
+    GLuint Program(ShaderLibrary::PreviewStage stage) const { return m_programs[static_cast<size_t>(stage)]; }
+
+    // 窗口像素坐标（左上为原点）的矩形列表，nullopt 表示整个窗口
+    using DamageRegion = std::optional<std::vector<SelectionRect>>;
+    static constexpr size_t kDamageHistory = 4;
+
+    int BorderWidth() const { return (std::max)(static_cast<int>(std::lround(m_renderInput.dpi / 96.0)), 1); }
+
+    void Render(const DamageRegion &region);
+    void DrawScene();
+    DamageRegion CollectDamage() const;
+    DamageRegion RepaintRegion(const DamageRegion &damage);
+    bool Present(const DamageRegion &damage);
+    std::vector<EGLint> ToEglRects(const std::vector<SelectionRect> &rects) const;
+    void InitDamageSupport();
+    void Draw(ShaderLibrary::PreviewStage stage, GLuint texture, GLint firstRect, GLsizei count);
+    void PrepareFrame();
+    void PrepareDimmedBackground();
+    void ReleaseDimmedBackground();
+    void UpdateSelectionGeometry();
+    bool ChooseSurfaceConfig();
+    void LogSurfaceMemory() const;
     void CleanupSurface();
     void CleanupGL();
-    void UpdateSwapInterval();
 
     static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -161,6 +347,9 @@ private:
     EGLConfig m_config = nullptr;
     EGLSurface m_surface = EGL_NO_SURFACE;
     EGLContext m_context = EGL_NO_CONTEXT;
+    bool m_contextWithoutConfig = false; // EGL_KHR_no_config_context：每次创建 surface 都可以重新选择格式
+    SurfaceFormat m_requestedFormat = SurfaceFormat::Rgba16F; // 窗口线程在启动渲染线程前写入
+    SurfaceFormat m_surfaceFormat = SurfaceFormat::Rgba16F;   // 渲染线程：实际使用的格式
 
     std::shared_ptr<GpuFrame> m_gpuFrame;
     DisplayHdrInfo m_hdrInfo;
@@ -170,18 +359,64 @@ private:
     SelectionRect m_selection = {0, 0, 0, 0};
     bool m_isDragging = false;
     int m_dragMode = 0; // 0: new rect, 1-4: corners, 5-8: edges, 9: move
+    SelectionSettledCallback m_selectionSettled;
 
-    GLuint m_program = 0;
+    std::shared_ptr<const FrameStatistics> m_statistics;
+    HWND m_statisticsTip = nullptr;
+    SelectionRect m_statisticsSelection = {0, 0, 0, 0}; // 提示框当前显示的选区
+
+    std::array<GLuint, ShaderLibrary::kPreviewStageCount> m_programs{}; // 按 PreviewStage 索引
+    std::array<GLint, ShaderLibrary::kPreviewStageCount> m_firstRectLocations{};
+    std::array<GLint, ShaderLibrary::kPreviewStageCount> m_encodeSrgbLocations{};
+    GLint m_sdrWhiteLocation = -1;
     GLuint m_texture = 0;
+    GLuint m_vao = 0;
     GLuint m_vbo = 0;
+    GLuint m_ubo = 0;
+
+    GLuint m_dimmedTexture = 0; // 压暗后的背景，与帧同尺寸，跨 Show 复用
+    GLuint m_dimFramebuffer = 0;
+    GLsizei m_dimmedWidth = 0;
+    GLsizei m_dimmedHeight = 0;
+    bool m_dimmedBackgroundSupported = true;
+
+    SelectionRect m_geometrySelection = {0, 0, 0, 0}; // uniform block 中当前的选区
+    bool m_geometryValid = false;
+    UINT m_dpi = 96;
+
+    // 局部重绘与局部呈现，扩展不可用时对应的指针为空
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC m_swapBuffersWithDamage = nullptr;
+    PFNEGLSETDAMAGEREGIONKHRPROC m_setDamageRegion = nullptr;
+    bool m_bufferAgeSupported = false;
+    bool m_damageSupportQueried = false;
+    bool m_swapPreserved = false;                     // 不支持 buffer age 时，交换后保留内容的后台缓冲区可视为 age 1
+    SelectionRect m_presentedSelection = {0, 0, 0, 0}; // 上一次呈现的选区
+    bool m_fullDamage = true;
+    std::vector<DamageRegion> m_damageHistory; // 最近几帧各自的脏区域，新的在前
 
     int m_windowWidth = 0;
     int m_windowHeight = 0;
 
     int m_lastMouseX = 0;
     int m_lastMouseY = 0;
-    bool m_needsRender = false;
-    EGLint m_currentSwapInterval = -1;
+    bool m_needsRender = false; // 窗口线程：本批消息改变了输入，需要发布
+
+    LatestValue<PreviewInput> m_input;
+    std::atomic<uint64_t> m_inputVersion{0}; // 每次发布加一，渲染线程在其上等待
+    std::atomic<bool> m_stopRendering{false};
+    std::atomic<bool> m_renderFailed{false};
+    std::atomic<bool> m_renderReady{false};
+    std::atomic<uint64_t> m_renderedFrame{0}; // 渲染线程处理完的最新输入中的帧代数
+    HANDLE m_renderEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr); // 上面三者变化时置位
+    std::thread m_renderThread;
+    uint64_t m_frameGeneration = 0;
+    PreviewInput m_renderInput; // 渲染线程：正在绘制的输入
+    uint64_t m_preparedFrame = 0; // 渲染线程：已换入纹理并压暗背景的帧代数
+    std::optional<std::chrono::steady_clock::time_point> m_lastFirstPresent;
+
+    bool m_timingEnabled = false;
+    TimingStats m_timingStats;
+    std::unique_ptr<GpuStageTimer> m_timer;
 
     HCURSOR m_cursorCross = nullptr;
     HCURSOR m_cursorArrow = nullptr;
@@ -200,10 +435,7 @@ private:
         int r = m_selection.Right();
         int b = m_selection.Bottom();
 
-        UINT dpi = GetDpiForWindow(m_hwnd);
-        if (dpi == 0)
-            dpi = 96;
-        const int tol = (3 * dpi) / 96;
+        const int tol = static_cast<int>(3 * m_dpi) / 96;
 
         bool hitL = std::abs(x - l) <= tol;
         bool hitR = std::abs(x - r) <= tol;
@@ -402,7 +634,11 @@ LRESULT CALLBACK PreviewWindowImpl::WndProc(HWND hwnd, UINT msg, WPARAM wParam,
         }
         case WM_LBUTTONUP: {
             // LOG("WM_LBUTTONUP");
+            const bool wasDragging = self->m_isDragging;
             self->m_isDragging = false;
+            if (wasDragging && self->m_selection.IsValid() && self->m_selectionSettled) {
+                self->m_selectionSettled(self->m_selection);
+            }
             return 0;
         }
         case WM_RBUTTONUP: {
@@ -419,6 +655,10 @@ LRESULT CALLBACK PreviewWindowImpl::WndProc(HWND hwnd, UINT msg, WPARAM wParam,
         }
         case WM_ERASEBKGND:
             return 1;
+        case WM_DPICHANGED:
+            self->m_dpi = HIWORD(wParam);
+            self->m_needsRender = true;
+            return 0;
         case WM_DESTROY:
             LOG("WM_DESTROY received.");
             // Do NOT PostQuitMessage(0); here! That will poison the next Show()
@@ -442,7 +682,8 @@ bool PreviewWindowImpl::CreateWin32Window() {
     m_windowWidth = GetSystemMetrics(SM_CXSCREEN);
     m_windowHeight = GetSystemMetrics(SM_CYSCREEN);
 
-    m_hwnd = CreateWindowExW(WS_EX_TOPMOST, L"PrintscrPreview", L"Preview", WS_POPUP | WS_VISIBLE, 0, 0, m_windowWidth,
+    // 创建时不显示，第一帧呈现后由 Show 显示
+    m_hwnd = CreateWindowExW(WS_EX_TOPMOST, L"PrintscrPreview", L"Preview", WS_POPUP, 0, 0, m_windowWidth,
                              m_windowHeight, nullptr, nullptr, GetModuleHandle(nullptr), this);
 
     return m_hwnd != nullptr;
@@ -452,34 +693,17 @@ bool PreviewWindowImpl::InitEGLSurface() {
     if (m_display == EGL_NO_DISPLAY)
         return false;
 
-    if (m_context == EGL_NO_CONTEXT) {
-        EGLint configAttribs[] = {EGL_RED_SIZE,
-                                  16,
-                                  EGL_GREEN_SIZE,
-                                  16,
-                                  EGL_BLUE_SIZE,
-                                  16,
-                                  EGL_ALPHA_SIZE,
-                                  16,
-                                  EGL_DEPTH_SIZE,
-                                  24,
-                                  EGL_STENCIL_SIZE,
-                                  8,
-                                  EGL_RENDERABLE_TYPE,
-                                  EGL_OPENGL_ES3_BIT,
-                                  EGL_SURFACE_TYPE,
-                                  EGL_WINDOW_BIT,
-                                  EGL_COLOR_COMPONENT_TYPE_EXT,
-                                  EGL_COLOR_COMPONENT_TYPE_FLOAT_EXT,
-                                  EGL_NONE};
-
-        EGLint numConfigs;
-        if (!eglChooseConfig(m_display, configAttribs, &m_config, 1, &numConfigs) || numConfigs == 0) {
-            return false;
-        }
+    // 没有 EGL_KHR_no_config_context 时 context 与创建时的 config 绑定，之后的 surface 沿用同一格式
+    if ((m_context == EGL_NO_CONTEXT || m_contextWithoutConfig) && !ChooseSurfaceConfig()) {
+        return false;
+    }
 
+    if (m_context == EGL_NO_CONTEXT) {
+        const char *extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+        m_contextWithoutConfig = extensions && std::strstr(extensions, "EGL_KHR_no_config_context") != nullptr;
         EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
-        m_context = eglCreateContext(m_display, m_config, m_rootContext, contextAttribs);
+        m_context = eglCreateContext(m_display, m_contextWithoutConfig ? EGL_NO_CONFIG_KHR : m_config, m_rootContext,
+                                     contextAttribs);
         if (m_context == EGL_NO_CONTEXT)
             return false;
     }
@@ -492,79 +716,117 @@ bool PreviewWindowImpl::InitEGLSurface() {
     if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context))
         return false;
 
+    if (!m_damageSupportQueried) {
+        InitDamageSupport();
+        m_damageSupportQueried = true;
+    }
+    EGLint swapBehavior = 0;
+    m_swapPreserved = eglQuerySurface(m_display, m_surface, EGL_SWAP_BEHAVIOR, &swapBehavior) &&
+                      swapBehavior == EGL_BUFFER_PRESERVED;
+
+    LogSurfaceMemory();
     return true;
 }
 
-const char *vShaderSource = R"(#version 300 es
-layout(location = 0) in vec2 a_position;
-layout(location = 1) in vec2 a_texCoord;
-out vec2 v_texCoord;
-void main() {
-    gl_Position = vec4(a_position, 0.0, 1.0);
-    v_texCoord = a_texCoord;
-}
-)";
-
-const char *fShaderSource = R"(#version 300 es
-precision highp float;
-uniform sampler2D u_texture;
-uniform vec4 u_selection; // x1, y1, x2, y2 in normalized coords (0 to 1, top-down)
-uniform float u_sdrWhitePointRatio; // sdrWhitePointNits / 80.0
-uniform bool u_hasSelection;
-uniform vec2 u_resolution;
-uniform float u_borderWidth;
-in vec2 v_texCoord;
-out vec4 o_color;
-
-void main() {
-    vec4 color = texture(u_texture, v_texCoord);
-    
-    if (!u_hasSelection) {
-        o_color = color;
-        return;
+// 依次尝试请求的格式、RGBA8 与 RGBA16F，取颜色位数完全一致、深度与模板位数最少的 config
+bool PreviewWindowImpl::ChooseSurfaceConfig() {
+    std::vector<SurfaceFormat> candidates = {m_requestedFormat};
+    for (SurfaceFormat fallback : {SurfaceFormat::Rgba8, SurfaceFormat::Rgba16F}) {
+        if (std::find(candidates.begin(), candidates.end(), fallback) == candidates.end()) {
+            candidates.push_back(fallback);
+        }
     }
 
-    float left = min(u_selection.x, u_selection.z);
-    float right = max(u_selection.x, u_selection.z);
-    float top = min(u_selection.y, u_selection.w);
-    float bottom = max(u_selection.y, u_selection.w);
-
-    bool inside = v_texCoord.x >= left && v_texCoord.x <= right &&
-                  v_texCoord.y >= top && v_texCoord.y <= bottom;
-
-    // Border thickness
-    float thicknessX = u_borderWidth / u_resolution.x;
-    float thicknessY = u_borderWidth / u_resolution.y;
-
-    bool nearLeft = abs(v_texCoord.x - left) < thicknessX;
-    bool nearRight = abs(v_texCoord.x - right) < thicknessX;
-    bool nearTop = abs(v_texCoord.y - top) < thicknessY;
-    bool nearBottom = abs(v_texCoord.y - bottom) < thicknessY;
-    
-    bool inYRange = v_texCoord.y >= top - thicknessY && v_texCoord.y <= bottom + thicknessY;
-    bool inXRange = v_texCoord.x >= left - thicknessX && v_texCoord.x <= right + thicknessX;
-
-    bool onBorder = false;
-    if ((nearLeft || nearRight) && inYRange) onBorder = true;
-    if ((nearTop || nearBottom) && inXRange) onBorder = true;
-
-    if (onBorder) {
-        o_color = vec4(1.0, 0.0, 0.0, 1.0); // Red
-    } else if (inside) {
-        o_color = color;
-    } else {
-        // Compress to SDR range: clamp to sdrWhitePointRatio
-        vec3 clamped = min(color.rgb, vec3(u_sdrWhitePointRatio));
-        // Reduce 80% brightness (20% remaining)
-        o_color = vec4(clamped * 0.2, color.a);
+    for (SurfaceFormat format : candidates) {
+        const SurfaceFormatInfo &info = FormatInfo(format);
+        const EGLint configAttribs[] = {EGL_RED_SIZE,
+                                        info.redBits,
+                                        EGL_GREEN_SIZE,
+                                        info.greenBits,
+                                        EGL_BLUE_SIZE,
+                                        info.blueBits,
+                                        EGL_ALPHA_SIZE,
+                                        info.alphaBits,
+                                        EGL_DEPTH_SIZE,
+                                        0,
+                                        EGL_STENCIL_SIZE,
+                                        0,
+                                        EGL_RENDERABLE_TYPE,
+                                        EGL_OPENGL_ES3_BIT,
+                                        EGL_SURFACE_TYPE,
+                                        EGL_WINDOW_BIT,
+                                        EGL_COLOR_COMPONENT_TYPE_EXT,
+                                        info.componentType,
+                                        EGL_NONE};
+        // 属性中的位数是下限，结果里还有更宽的格式
+        EGLint count = 0;
+        if (!eglChooseConfig(m_display, configAttribs, nullptr, 0, &count) || count == 0) {
+            continue;
+        }
+        std::vector<EGLConfig> configs(count);
+        if (!eglChooseConfig(m_display, configAttribs, configs.data(), count, &count)) {
+            continue;
+        }
+        configs.resize(count);
+        auto attrib = [this](EGLConfig config, EGLint name) {
+            EGLint value = 0;
+            eglGetConfigAttrib(m_display, config, name, &value);
+            return value;
+        };
+        EGLConfig best = nullptr;
+        EGLint bestExtraBits = 0;
+        for (EGLConfig config : configs) {
+            if (attrib(config, EGL_RED_SIZE) != info.redBits || attrib(config, EGL_GREEN_SIZE) != info.greenBits ||
+                attrib(config, EGL_BLUE_SIZE) != info.blueBits || attrib(config, EGL_ALPHA_SIZE) != info.alphaBits) {
+                continue;
+            }
+            const EGLint extraBits = attrib(config, EGL_DEPTH_SIZE) + attrib(config, EGL_STENCIL_SIZE);
+            if (!best || extraBits < bestExtraBits) {
+                best = config;
+                bestExtraBits = extraBits;
+            }
+        }
+        if (!best) {
+            continue;
+        }
+        if (format != m_requestedFormat) {
+            LOG(std::string("Preview surface format ") + FormatInfo(m_requestedFormat).name + " unavailable, using " +
+                info.name + ".");
+        }
+        m_config = best;
+        m_surfaceFormat = format;
+        return true;
     }
+    LOG("No EGL config for the preview surface.");
+    return false;
+}
+
+// 颜色缓冲之外没有深度 / 模板缓冲；同时给出原先固定的 RGBA16F + D24S8 的用量作对比
+void PreviewWindowImpl::LogSurfaceMemory() const {
+    EGLint width = 0;
+    EGLint height = 0;
+    eglQuerySurface(m_display, m_surface, EGL_WIDTH, &width);
+    eglQuerySurface(m_display, m_surface, EGL_HEIGHT, &height);
+    EGLint depthBits = 0;
+    EGLint stencilBits = 0;
+    eglGetConfigAttrib(m_display, m_config, EGL_DEPTH_SIZE, &depthBits);
+    eglGetConfigAttrib(m_display, m_config, EGL_STENCIL_SIZE, &stencilBits);
+
+    const uint64_t pixels = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+    const uint64_t bytes = pixels * (FormatInfo(m_surfaceFormat).bytesPerPixel * kSurfaceBufferCount +
+                                     static_cast<uint64_t>(depthBits + stencilBits + 7) / 8);
+    const uint64_t previousBytes =
+        pixels * (FormatInfo(SurfaceFormat::Rgba16F).bytesPerPixel * kSurfaceBufferCount + 4);
+    auto mib = [](uint64_t value) { return std::to_string(static_cast<double>(value) / (1 << 20)); };
+    LOG(std::string("Preview surface: ") + FormatInfo(m_surfaceFormat).name + ", " + std::to_string(width) + "x" +
+        std::to_string(height) + ", depth " + std::to_string(depthBits) + ", stencil " + std::to_string(stencilBits) +
+        ", about " + mib(bytes) + " MiB (RGBA16F + D24S8: " + mib(previousBytes) + " MiB).");
 }
-)";
 
 bool PreviewWindowImpl::InitGL() {
-    auto createShader = [](GLenum type, const char *source) {
+    auto createShader = [](GLenum type, ShaderLibrary::ShaderSource source) {
         GLuint shader = glCreateShader(type);
-        glShaderSource(shader, 1, &source, nullptr);
+        glShaderSource(shader, static_cast<GLsizei>(source.count), source.parts, nullptr);
         glCompileShader(shader);
         GLint success;
         glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -576,85 +838,463 @@ bool PreviewWindowImpl::InitGL() {
         return shader;
     };
 
-    GLuint vShader = createShader(GL_VERTEX_SHADER, vShaderSource);
-    GLuint fShader = createShader(GL_FRAGMENT_SHADER, fShaderSource);
-    m_program = glCreateProgram();
-    glAttachShader(m_program, vShader);
-    glAttachShader(m_program, fShader);
-    glLinkProgram(m_program);
+    // 每种绘制一个 program，共用顶点着色器与 uniform block；采样器固定在 0 号纹理单元
+    GLuint vShader = createShader(GL_VERTEX_SHADER, ShaderLibrary::PreviewVertexShader());
+    for (size_t i = 0; i < m_programs.size(); ++i) {
+        const auto stage = static_cast<ShaderLibrary::PreviewStage>(i);
+        GLuint fShader = createShader(GL_FRAGMENT_SHADER, ShaderLibrary::PreviewFragmentShader(stage));
+        m_programs[i] = glCreateProgram();
+        glAttachShader(m_programs[i], vShader);
+        glAttachShader(m_programs[i], fShader);
+        glLinkProgram(m_programs[i]);
+        glDeleteShader(fShader);
+
+        glUniformBlockBinding(m_programs[i], glGetUniformBlockIndex(m_programs[i], "PreviewGeometry"), 0);
+        m_firstRectLocations[i] = glGetUniformLocation(m_programs[i], "u_firstRect");
+        m_encodeSrgbLocations[i] = glGetUniformLocation(m_programs[i], "u_encodeSrgb");
+        glUseProgram(m_programs[i]);
+        glUniform1i(glGetUniformLocation(m_programs[i], "u_texture"), 0);
+    }
     glDeleteShader(vShader);
-    glDeleteShader(fShader);
+    m_sdrWhiteLocation = glGetUniformLocation(Program(ShaderLibrary::PreviewStage::Dim), "u_sdrWhitePointRatio");
 
-    // Quad data
-    float vertices[] = {
-        -1.0f, 1.0f, 0.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 1.0f, 1.0f,
-    };
+    // 单位四边形，各矩形由顶点着色器按 uniform block 展开。这个 context 只用于预览，VAO 与 block 绑定一直保持
+    const float corners[] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f};
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
     glGenBuffers(1, &m_vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
 
-    // Texture
-    m_texture = m_gpuFrame->GetTextureId();
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PreviewGeometry), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_ubo);
 
     return true;
 }
 
-void PreviewWindowImpl::UpdateSwapInterval() {
-    EGLint desiredSwapInterval = m_isDragging ? 0 : 1;
-    if (desiredSwapInterval == m_currentSwapInterval) {
+// 渲染线程：初始化 surface 后等待输入，每次被唤醒取最新的输入绘制一帧。交换间隔为 1，呈现阻塞到 vblank
+// 期间到达的输入在下一帧合并为一次，窗口线程不受影响
+void PreviewWindowImpl::RenderThreadMain() {
+    auto signal = [this] { SetEvent(m_renderEvent); };
+    LOG("Initializing EGL Surface...");
+    bool initialized = InitEGLSurface();
+    if (!initialized) {
+        LOG("Failed to initialize EGL surface.");
+    } else if (m_programs[0] == 0) {
+        LOG("Initializing GL (first time)...");
+        initialized = InitGL();
+        LOG(initialized ? "GL initialized." : "Failed to initialize GL.");
+    }
+    if (!initialized) {
+        CleanupSurface();
+        m_renderFailed = true;
+        signal();
         return;
     }
+    eglSwapInterval(m_display, 1);
+    m_renderReady = true;
+    signal();
+
+    uint64_t seen = 0;
+    while (true) {
+        m_inputVersion.wait(seen, std::memory_order_acquire);
+        seen = m_inputVersion.load(std::memory_order_acquire);
+        if (m_stopRendering) {
+            break;
+        }
+        PreviewInput input;
+        if (m_input.Take(input)) {
+            if (input.dpi != m_renderInput.dpi) {
+                m_geometryValid = false;
+                m_fullDamage = true;
+            }
+            m_renderInput = input;
+        }
+        if (m_renderInput.frame != m_preparedFrame) {
+            if (m_renderInput.frame != 0) {
+                PrepareFrame();
+            }
+            m_preparedFrame = m_renderInput.frame;
+        }
+        if (m_renderInput.frame != 0 && !RenderFrame()) {
+            LOG("eglSwapBuffers failed.");
+            m_renderFailed = true;
+            PostMessageW(m_hwnd, WM_CLOSE, 0, 0);
+            signal();
+            break;
+        }
+        m_renderedFrame = m_renderInput.frame;
+        signal();
+    }
 
-    if (eglSwapInterval(m_display, desiredSwapInterval)) {
-        m_currentSwapInterval = desiredSwapInterval;
+    LOG("Render thread exiting. Cleaning up surface...");
+    CleanupSurface();
+}
+
+bool PreviewWindowImpl::EnsureWindow(const DisplayHdrInfo &hdrInfo) {
+    const int width = GetSystemMetrics(SM_CXSCREEN);
+    const int height = GetSystemMetrics(SM_CYSCREEN);
+    const SurfaceFormat format = PreferredSurfaceFormat(hdrInfo);
+    if (m_hwnd && !m_renderFailed && width == m_windowWidth && height == m_windowHeight &&
+        (format == m_requestedFormat || !m_contextWithoutConfig)) {
+        LOG("Reusing preview window.");
+        return true;
+    }
+    if (m_hwnd) {
+        LOG("Recreating preview window.");
+        DestroyPreviewWindow();
     }
+
+    LOG("Creating Win32 window...");
+    if (!CreateWin32Window()) {
+        LOG("Failed to create Win32 window.");
+        return false;
+    }
+    LOG("Window created.");
+
+    m_cursorCross = LoadCursorW(nullptr, (LPCWSTR)IDC_CROSS);
+    m_cursorArrow = LoadCursorW(nullptr, (LPCWSTR)IDC_ARROW);
+    m_cursorSizeNWSE = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENWSE);
+    m_cursorSizeNESW = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENESW);
+    m_cursorSizeNS = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZENS);
+    m_cursorSizeWE = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZEWE);
+    m_cursorSizeAll = LoadCursorW(nullptr, (LPCWSTR)IDC_SIZEALL);
+
+    m_requestedFormat = format;
+    m_running = false;
+    m_stopRendering = false;
+    m_renderFailed = false;
+    m_renderReady = false;
+    m_renderedFrame = 0;
+    m_preparedFrame = 0;
+    m_inputVersion = 0;
+    m_renderThread = std::thread([this] { RenderThreadMain(); });
+    PumpUntil([this] { return m_renderReady || m_renderFailed; });
+    if (m_renderFailed) {
+        DestroyPreviewWindow();
+        return false;
+    }
+    return true;
 }
 
-void PreviewWindowImpl::Render() {
+void PreviewWindowImpl::DestroyPreviewWindow() {
+    StopRenderThread();
+    if (m_statisticsTip) {
+        DestroyWindow(m_statisticsTip);
+        m_statisticsTip = nullptr;
+    }
+    if (m_hwnd) {
+        DestroyWindow(m_hwnd);
+        m_hwnd = nullptr;
+    }
+    // DestroyWindow 同步发送 WM_DESTROY / WM_NCDESTROY，这里只处理残留的消息
+    MSG msg;
+    while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+}
+
+void PreviewWindowImpl::ParkRenderer() {
+    m_running = false;
+    PublishInput();
+    PumpUntil([this] { return m_renderedFrame.load() == 0 || m_renderFailed; });
+    if (m_statisticsTip) {
+        TOOLINFOW info = {sizeof(TOOLINFOW)};
+        info.hwnd = m_hwnd;
+        SendMessageW(m_statisticsTip, TTM_TRACKACTIVATE, FALSE, reinterpret_cast<LPARAM>(&info));
+    }
+    ShowWindow(m_hwnd, SW_HIDE);
+    m_gpuFrame.reset();
+}
+
+bool PreviewWindowImpl::RenderFrame() {
+    UpdateTimer();
+    const DamageRegion damage = CollectDamage();
+    const DamageRegion repaint = RepaintRegion(damage);
+    {
+        GpuStageTimer::Scope timing(m_timer.get(), "preview-draw");
+        Render(repaint);
+    }
+    if (!Present(damage)) {
+        return false;
+    }
+    m_presentedSelection = m_renderInput.selection;
+    m_fullDamage = false;
+    return true;
+}
+
+// 只重画 region 覆盖的像素：每个矩形以 scissor 限定后绘制整个场景，片元开销与脏区域面积成正比
+void PreviewWindowImpl::Render(const DamageRegion &region) {
     glViewport(0, 0, m_windowWidth, m_windowHeight);
-    glClearColor(0, 0, 0, 1);
-    glClear(GL_COLOR_BUFFER_BIT);
+    UpdateSelectionGeometry();
+    if (!region) {
+        DrawScene();
+        return;
+    }
+    glEnable(GL_SCISSOR_TEST);
+    for (const SelectionRect &rect : *region) {
+        glScissor(rect.Left(), m_windowHeight - rect.Bottom(), rect.Width(), rect.Height());
+        DrawScene();
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
 
-    glUseProgram(m_program);
+// 选区外的背景已在 PrepareFrame 中压暗，绘制只有背景复制、选区与边框；选区不变时不更新 uniform block
+void PreviewWindowImpl::DrawScene() {
+    if (!m_renderInput.selection.IsValid()) {
+        Draw(ShaderLibrary::PreviewStage::Image, m_texture, kFrameRect, 1);
+        return;
+    }
+    if (m_dimmedTexture) {
+        Draw(ShaderLibrary::PreviewStage::Image, m_dimmedTexture, kFrameRect, 1);
+    } else {
+        Draw(ShaderLibrary::PreviewStage::Dim, m_texture, kFrameRect, 1);
+    }
+    Draw(ShaderLibrary::PreviewStage::Image, m_texture, kSelectionRect, 1);
+    Draw(ShaderLibrary::PreviewStage::Border, 0, kBorderRects, 4);
+}
 
-    // Uniforms
-    GLint locSelection = glGetUniformLocation(m_program, "u_selection");
-    float x1 = (float)m_selection.x1 / m_windowWidth;
-    float y1 = (float)m_selection.y1 / m_windowHeight;
-    float x2 = (float)m_selection.x2 / m_windowWidth;
-    float y2 = (float)m_selection.y2 / m_windowHeight;
-    glUniform4f(locSelection, x1, y1, x2, y2);
+// 上一次呈现的选区到当前选区之间可能变化的像素：四条边各自新旧位置之间的条带，向外扩展边框宽度。
+// 选区内外的变化与新旧边框都落在条带中。选区出现或消失时整幅背景的压暗状态改变，整个窗口都是脏的
+PreviewWindowImpl::DamageRegion PreviewWindowImpl::CollectDamage() const {
+    const SelectionRect &before = m_presentedSelection;
+    const SelectionRect &after = m_renderInput.selection;
+    if (m_fullDamage || !before.IsValid() || !after.IsValid()) {
+        return std::nullopt;
+    }
 
-    GLint locSdr = glGetUniformLocation(m_program, "u_sdrWhitePointRatio");
-    glUniform1f(locSdr, m_hdrInfo.sdrWhiteLevel / 80.0f);
+    const int margin = BorderWidth() + 1; // 多留 1 像素，归一化坐标的舍入不会落到条带之外
+    const int top = (std::min)(before.Top(), after.Top()) - margin;
+    const int bottom = (std::max)(before.Bottom(), after.Bottom()) + margin;
+    const int left = (std::min)(before.Left(), after.Left()) - margin;
+    const int right = (std::max)(before.Right(), after.Right()) + margin;
+    const std::array<SelectionRect, 4> strips = {{
+        {(std::min)(before.Left(), after.Left()) - margin, top, (std::max)(before.Left(), after.Left()) + margin,
+         bottom},
+        {(std::min)(before.Right(), after.Right()) - margin, top, (std::max)(before.Right(), after.Right()) + margin,
+         bottom},
+        {left, (std::min)(before.Top(), after.Top()) - margin, right, (std::max)(before.Top(), after.Top()) + margin},
+        {left, (std::min)(before.Bottom(), after.Bottom()) - margin, right,
+         (std::max)(before.Bottom(), after.Bottom()) + margin},
+    }};
+
+    std::vector<SelectionRect> damage;
+    for (const SelectionRect &strip : strips) {
+        const SelectionRect clamped = {(std::max)(strip.Left(), 0), (std::max)(strip.Top(), 0),
+                                       (std::min)(strip.Right(), m_windowWidth),
+                                       (std::min)(strip.Bottom(), m_windowHeight)};
+        if (clamped.IsValid()) {
+            damage.push_back(clamped);
+        }
+    }
+    return damage;
+}
 
-    GLint locHasSelection = glGetUniformLocation(m_program, "u_hasSelection");
-    glUniform1i(locHasSelection, m_selection.IsValid() ? 1 : 0);
+// 后台缓冲区保留的是 age 帧之前呈现的内容，需要重画这之后各帧（含本帧）脏区域之和；age 未知时整幅重画。
+// 支持 EGL_KHR_partial_update 时在绘制前把重画区域告诉驱动
+PreviewWindowImpl::DamageRegion PreviewWindowImpl::RepaintRegion(const DamageRegion &damage) {
+    m_damageHistory.insert(m_damageHistory.begin(), damage);
+    if (m_damageHistory.size() > kDamageHistory) {
+        m_damageHistory.pop_back();
+    }
+    if (!damage) {
+        return std::nullopt;
+    }
 
-    GLint locResolution = glGetUniformLocation(m_program, "u_resolution");
-    glUniform2f(locResolution, (float)m_windowWidth, (float)m_windowHeight);
+    EGLint age = 0;
+    if (m_bufferAgeSupported) {
+        if (!eglQuerySurface(m_display, m_surface, EGL_BUFFER_AGE_EXT, &age)) {
+            age = 0;
+        }
+    } else if (m_swapPreserved) {
+        age = 1;
+    }
+    if (age <= 0 || static_cast<size_t>(age) > m_damageHistory.size()) {
+        return std::nullopt;
+    }
 
-    UINT dpi = GetDpiForWindow(m_hwnd);
-    if (dpi == 0)
-        dpi = 96;
-    float borderWidth = std::round((float)dpi / 96.0f);
-    if (borderWidth < 1.0f)
-        borderWidth = 1.0f;
+    std::vector<SelectionRect> repaint;
+    for (size_t i = 0; i < static_cast<size_t>(age); ++i) {
+        if (!m_damageHistory[i]) {
+            return std::nullopt;
+        }
+        repaint.insert(repaint.end(), m_damageHistory[i]->begin(), m_damageHistory[i]->end());
+    }
+    if (m_setDamageRegion) {
+        std::vector<EGLint> rects = ToEglRects(repaint);
+        m_setDamageRegion(m_display, m_surface, rects.data(), static_cast<EGLint>(repaint.size()));
+    }
+    return repaint;
+}
+
+// 合成器只需要从本帧的脏区域读取新内容；其余像素与上一帧相同，无论本帧是否整幅重画
+bool PreviewWindowImpl::Present(const DamageRegion &damage) {
+    if (damage && !damage->empty() && m_swapBuffersWithDamage) {
+        const std::vector<EGLint> rects = ToEglRects(*damage);
+        return m_swapBuffersWithDamage(m_display, m_surface, rects.data(), static_cast<EGLint>(damage->size()));
+    }
+    return eglSwapBuffers(m_display, m_surface);
+}
 
-    GLint locBorderWidth = glGetUniformLocation(m_program, "u_borderWidth");
-    glUniform1f(locBorderWidth, borderWidth);
+// EGL 的矩形为 (x, y, 宽, 高)，原点在左下角
+std::vector<EGLint> PreviewWindowImpl::ToEglRects(const std::vector<SelectionRect> &rects) const {
+    std::vector<EGLint> values;
+    values.reserve(rects.size() * 4);
+    for (const SelectionRect &rect : rects) {
+        values.insert(values.end(), {rect.Left(), m_windowHeight - rect.Bottom(), rect.Width(), rect.Height()});
+    }
+    return values;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+void PreviewWindowImpl::InitDamageSupport() {
+    const char *extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    const std::string list = extensions ? extensions : "";
+    auto has = [&list](const char *name) {
+        return (" " + list + " ").find(std::string(" ") + name + " ") != std::string::npos;
+    };
+    if (has("EGL_KHR_swap_buffers_with_damage")) {
+        m_swapBuffersWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    } else if (has("EGL_EXT_swap_buffers_with_damage")) {
+        m_swapBuffersWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+    if (has("EGL_KHR_partial_update")) {
+        m_setDamageRegion = reinterpret_cast<PFNEGLSETDAMAGEREGIONKHRPROC>(eglGetProcAddress("eglSetDamageRegionKHR"));
+    }
+    // EGL_KHR_partial_update 同样定义了 buffer age 查询
+    m_bufferAgeSupported = has("EGL_EXT_buffer_age") || m_setDamageRegion != nullptr;
+    LOG(std::string("Preview damage support: swap with damage ") + (m_swapBuffersWithDamage ? "yes" : "no") +
+        ", partial update " + (m_setDamageRegion ? "yes" : "no") + ", buffer age " +
+        (m_bufferAgeSupported ? "yes" : "no") + ".");
+}
+
+void PreviewWindowImpl::Draw(ShaderLibrary::PreviewStage stage, GLuint texture, GLint firstRect, GLsizei count) {
+    const size_t index = static_cast<size_t>(stage);
+    glUseProgram(m_programs[index]);
+    glUniform1i(m_firstRectLocations[index], firstRect);
+    if (texture) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+}
+
+void PreviewWindowImpl::PrepareFrame() {
+    m_texture = m_gpuFrame->GetTextureId();
+    m_geometryValid = false;
+    m_fullDamage = true;
+    m_damageHistory.clear();
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
-    glUniform1i(glGetUniformLocation(m_program, "u_texture"), 0);
+    glUseProgram(Program(ShaderLibrary::PreviewStage::Dim));
+    glUniform1f(m_sdrWhiteLocation, m_hdrInfo.sdrWhiteLevel / 80.0f);
+    glUniform1i(m_encodeSrgbLocations[static_cast<size_t>(ShaderLibrary::PreviewStage::Dim)], GL_FALSE);
+
+    // 截图铺满窗口，纹理坐标 (0, 0) 在左上角
+    PreviewGeometry geometry;
+    geometry.viewTransform = {2.0f, -2.0f, -1.0f, 1.0f};
+    geometry.rects[kFrameRect] = {0.0f, 0.0f, 1.0f, 1.0f};
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(geometry), &geometry);
+
+    PrepareDimmedBackground();
+
+    // 压暗背景纹理保持线性，直接写入 surface 的绘制按 surface 的格式编码
+    const bool encodeSrgb = FormatInfo(m_surfaceFormat).encodeSrgb;
+    for (size_t i = 0; i < m_programs.size(); ++i) {
+        const bool dim = static_cast<ShaderLibrary::PreviewStage>(i) == ShaderLibrary::PreviewStage::Dim;
+        glUseProgram(m_programs[i]);
+        glUniform1i(m_encodeSrgbLocations[i], encodeSrgb && !(dim && m_dimmedTexture));
+    }
+}
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+// 以帧的尺寸渲染压暗后的背景。渲染目标的第 0 行在底部，视图变换上下翻转，使两张纹理的纹理坐标一致
+void PreviewWindowImpl::PrepareDimmedBackground() {
+    const GLsizei width = static_cast<GLsizei>(m_gpuFrame->Width());
+    const GLsizei height = static_cast<GLsizei>(m_gpuFrame->Height());
+    if (m_dimmedTexture && (width != m_dimmedWidth || height != m_dimmedHeight)) {
+        ReleaseDimmedBackground();
+    }
+    if (!m_dimmedTexture) {
+        if (!m_dimmedBackgroundSupported) {
+            return;
+        }
+        glGenTextures(1, &m_dimmedTexture);
+        glBindTexture(GL_TEXTURE_2D, m_dimmedTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glGenFramebuffers(1, &m_dimFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_dimFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_dimmedTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            // 不支持渲染到 RGBA16F 时逐帧以 Dim program 绘制整幅背景
+            LOG("RGBA16F render target unavailable; preview dims the background every frame.");
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            ReleaseDimmedBackground();
+            m_dimmedBackgroundSupported = false;
+            return;
+        }
+        m_dimmedWidth = width;
+        m_dimmedHeight = height;
+    }
+
+    const std::array<float, 4> flipped = {2.0f, 2.0f, -1.0f, -1.0f};
+    const std::array<float, 4> normal = {2.0f, -2.0f, -1.0f, 1.0f};
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(flipped), flipped.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, m_dimFramebuffer);
+    glViewport(0, 0, width, height);
+    Draw(ShaderLibrary::PreviewStage::Dim, m_texture, kFrameRect, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(normal), normal.data());
+}
+
+void PreviewWindowImpl::ReleaseDimmedBackground() {
+    if (m_dimFramebuffer) glDeleteFramebuffers(1, &m_dimFramebuffer);
+    if (m_dimmedTexture) glDeleteTextures(1, &m_dimmedTexture);
+    m_dimFramebuffer = 0;
+    m_dimmedTexture = 0;
+    m_dimmedWidth = 0;
+    m_dimmedHeight = 0;
+}
+
+// 选区与四条边框（选区边缘内外各 borderWidth 像素）换算为归一化窗口坐标，只在选区或 DPI 变化时上传
+void PreviewWindowImpl::UpdateSelectionGeometry() {
+    const SelectionRect &selection = m_renderInput.selection;
+    const SelectionRect &shown = m_geometrySelection;
+    if (m_geometryValid && selection.Left() == shown.Left() && selection.Top() == shown.Top() &&
+        selection.Right() == shown.Right() && selection.Bottom() == shown.Bottom()) {
+        return;
+    }
+    m_geometrySelection = selection;
+    m_geometryValid = true;
+    if (!selection.IsValid()) {
+        return;
+    }
+
+    const float border = static_cast<float>(BorderWidth());
+    const float l = static_cast<float>(selection.Left());
+    const float t = static_cast<float>(selection.Top());
+    const float r = static_cast<float>(selection.Right());
+    const float b = static_cast<float>(selection.Bottom());
+    const float sx = 1.0f / static_cast<float>(m_windowWidth);
+    const float sy = 1.0f / static_cast<float>(m_windowHeight);
+    const std::array<std::array<float, 4>, 5> rects = {{
+        {l * sx, t * sy, r * sx, b * sy},
+        {(l - border) * sx, (t - border) * sy, (l + border) * sx, (b + border) * sy},
+        {(r - border) * sx, (t - border) * sy, (r + border) * sx, (b + border) * sy},
+        {(l - border) * sx, (t - border) * sy, (r + border) * sx, (t + border) * sy},
+        {(l - border) * sx, (b - border) * sy, (r + border) * sx, (b + border) * sy},
+    }};
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PreviewGeometry, rects) + kSelectionRect * sizeof(rects[0]),
+                    sizeof(rects), rects.data());
 }
 
 void PreviewWindowImpl::CleanupSurface() {
@@ -673,8 +1313,14 @@ void PreviewWindowImpl::CleanupGL() {
         // Use dummy surface to make current and delete GL objects
         if (m_dummySurface != EGL_NO_SURFACE) {
             eglMakeCurrent(m_display, m_dummySurface, m_dummySurface, m_context);
-            if (m_program) glDeleteProgram(m_program);
+            m_timer.reset();
+            for (GLuint program : m_programs) {
+                if (program) glDeleteProgram(program);
+            }
+            ReleaseDimmedBackground();
+            if (m_vao) glDeleteVertexArrays(1, &m_vao);
             if (m_vbo) glDeleteBuffers(1, &m_vbo);
+            if (m_ubo) glDeleteBuffers(1, &m_ubo);
         }
         eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         eglDestroyContext(m_display, m_context);
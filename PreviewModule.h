@@ -1,29 +1,44 @@
 #pragma once
 
+#include "FrameStatistics.h"
 #include "GpuFrame.h"
+#include "GpuTimer.h"
+#include "SelectionRect.h"
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <vector>
 #include <windows.h>
 
-struct SelectionRect {
-    int x1, y1, x2, y2;
-
-    int Left() const { return (x1 < x2) ? x1 : x2; }
-    int Top() const { return (y1 < y2) ? y1 : y2; }
-    int Right() const { return (x1 < x2) ? x2 : x1; }
-    int Bottom() const { return (y1 < y2) ? y2 : y1; }
-    int Width() const { return Right() - Left(); }
-    int Height() const { return Bottom() - Top(); }
-    bool IsValid() const { return Width() > 0 && Height() > 0; }
-};
-
 class PreviewWindow {
 public:
     virtual ~PreviewWindow() = default;
 
+    // 预先创建隐藏的窗口、EGL surface 与渲染线程并编译着色器，Show 时只换入新帧再显示窗口。
+    // 窗口属于调用线程，两次 Show 之间调用线程须继续处理消息。不调用时第一次 Show 会先执行一次
+    virtual bool Prepare() = 0;
+
     // 在全屏窗口中展示已上传至 GPU 的帧。
     // 此调用阻塞直到用户确认选区或取消。
     // 返回最终选区矩形。
     virtual SelectionRect Show(std::shared_ptr<GpuFrame> gpuFrame) = 0;
 
+    // 最近一次 Show 的第一帧呈现完成（窗口随即显示）的时刻，失败时为空
+    virtual std::optional<std::chrono::steady_clock::time_point> LastFirstPresent() const = 0;
+
+    // 选区稳定（拖拽结束松开鼠标）时在窗口线程上回调，供调用方提前开始转换；传空函数取消
+    using SelectionSettledCallback = std::function<void(const SelectionRect &)>;
+    virtual void SetSelectionSettledCallback(SelectionSettledCallback callback) = 0;
+
+    // 设置后拖拽时在选区旁显示平均 / 峰值亮度与超过 SDR 白的比例，每批输入查表一次；传空指针关闭。
+    // 统计须属于下一次 Show 的帧
+    virtual void SetFrameStatistics(std::shared_ptr<const FrameStatistics> statistics) = 0;
+
+    // 可选的绘制耗时统计（GPU 计时查询，不可用时退化为 CPU 计时），默认关闭。
+    // 结果滞后一到两帧取回，窗口关闭时写日志
+    virtual void SetTimingEnabled(bool enabled) = 0;
+    virtual std::vector<StageTimingStats> GetTimingStats() const = 0;
+
     static std::unique_ptr<PreviewWindow> Create(EGLDisplay display, EGLSurface dummySurface, EGLContext context);
 };
@@ -0,0 +1,320 @@
+#include "QoiCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+namespace QoiCodec {
+
+namespace {
+
+constexpr uint8_t kVersion = 1;
+constexpr size_t kFixedHeaderBytes = 24;
+
+constexpr uint8_t kOpIndex = 0x00; // 00xxxxxx：哈希表下标
+constexpr uint8_t kOpDiff = 0x40;  // 01rrggbb：三个通道各 -2..1
+constexpr uint8_t kOpLuma = 0x80;  // 10gggggg rrrrbbbb：第 2 通道 -32..31，其余相对它 -8..7
+constexpr uint8_t kOpRun = 0xC0;   // 11xxxxxx：重复上一个像素 1..kMaxRun 次
+constexpr uint8_t kOpLumaWide = 0xFD; // 仅 16-bit：第 2 通道与相对差各一个 int8
+constexpr uint8_t kOpRgb = 0xFE;   // 三个通道原值，alpha 不变
+constexpr uint8_t kOpRgba = 0xFF;  // 四个通道原值
+constexpr uint8_t kMask = 0xC0;
+
+template <typename T> struct Pixel {
+    std::array<T, 4> c;
+    bool operator==(const Pixel &) const = default;
+};
+
+// 8-bit 与 QOI 相同，run 可到 62；16-bit 另外占用 0xFD，run 最多 61
+template <typename T> constexpr int kMaxRun = sizeof(T) == 1 ? 62 : 61;
+
+template <typename T> Pixel<T> InitialPixel() {
+    return {{0, 0, 0, std::numeric_limits<T>::max()}};
+}
+
+template <typename T> size_t Hash(const Pixel<T> &p) {
+    return (p.c[0] * 3u + p.c[1] * 5u + p.c[2] * 7u + p.c[3] * 11u) % 64u;
+}
+
+// 按通道宽度回绕的有符号差
+template <typename T> int Delta(T a, T b) { return static_cast<std::make_signed_t<T>>(static_cast<T>(a - b)); }
+
+template <typename T> uint8_t *PutChannels(uint8_t *out, const Pixel<T> &p, size_t count) {
+    std::memcpy(out, p.c.data(), count * sizeof(T));
+    return out + count * sizeof(T);
+}
+
+template <typename T> void EncodeBand(const uint8_t *rows, size_t pixelCount, std::vector<uint8_t> &out) {
+    std::array<Pixel<T>, 64> index{};
+    Pixel<T> previous = InitialPixel<T>();
+    int run = 0;
+    // 循环内直接写指针：先写入按最坏情况（每个像素 1 字节操作码加四个通道）分配、线程内复用的暂存区，
+    // 最后只拷贝实际长度
+    thread_local std::vector<uint8_t> scratch;
+    scratch.resize((std::max)(scratch.size(), pixelCount * (1 + sizeof(Pixel<T>))));
+    uint8_t *cursor = scratch.data();
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        Pixel<T> pixel;
+        std::memcpy(pixel.c.data(), rows + i * sizeof(pixel.c), sizeof(pixel.c));
+        if (pixel == previous) {
+            if (++run == kMaxRun<T>) {
+                *cursor++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *cursor++ = static_cast<uint8_t>(kOpRun | (run - 1));
+            run = 0;
+        }
+
+        const size_t hash = Hash(pixel);
+        if (index[hash] == pixel) {
+            *cursor++ = static_cast<uint8_t>(kOpIndex | hash);
+        } else {
+            index[hash] = pixel;
+            if (pixel.c[3] != previous.c[3]) {
+                *cursor++ = kOpRgba;
+                cursor = PutChannels(cursor, pixel, 4);
+            } else {
+                const int d0 = Delta(pixel.c[0], previous.c[0]);
+                const int d1 = Delta(pixel.c[1], previous.c[1]);
+                const int d2 = Delta(pixel.c[2], previous.c[2]);
+                const int d01 = d0 - d1;
+                const int d21 = d2 - d1;
+                if (d0 >= -2 && d0 <= 1 && d1 >= -2 && d1 <= 1 && d2 >= -2 && d2 <= 1) {
+                    *cursor++ = static_cast<uint8_t>(kOpDiff | (d0 + 2) << 4 | (d1 + 2) << 2 | (d2 + 2));
+                } else if (d1 >= -32 && d1 <= 31 && d01 >= -8 && d01 <= 7 && d21 >= -8 && d21 <= 7) {
+                    *cursor++ = static_cast<uint8_t>(kOpLuma | (d1 + 32));
+                    *cursor++ = static_cast<uint8_t>((d01 + 8) << 4 | (d21 + 8));
+                } else if (sizeof(T) == 2 && d1 >= -128 && d1 <= 127 && d01 >= -128 && d01 <= 127 && d21 >= -128 &&
+                           d21 <= 127) {
+                    *cursor++ = kOpLumaWide;
+                    *cursor++ = static_cast<uint8_t>(d1);
+                    *cursor++ = static_cast<uint8_t>(d01);
+                    *cursor++ = static_cast<uint8_t>(d21);
+                } else {
+                    *cursor++ = kOpRgb;
+                    cursor = PutChannels(cursor, pixel, 3);
+                }
+            }
+        }
+        previous = pixel;
+    }
+    if (run > 0) {
+        *cursor++ = static_cast<uint8_t>(kOpRun | (run - 1));
+    }
+    out.assign(scratch.data(), cursor);
+}
+
+template <typename T> void DecodeBand(const uint8_t *data, size_t size, uint8_t *pixels, size_t pixelCount) {
+    std::array<Pixel<T>, 64> index{};
+    Pixel<T> pixel = InitialPixel<T>();
+    const uint8_t *end = data + size;
+    const auto need = [&](size_t bytes) {
+        if (static_cast<size_t>(end - data) < bytes) {
+            throw std::runtime_error("QoiCodec: truncated band");
+        }
+    };
+
+    for (size_t i = 0; i < pixelCount;) {
+        need(1);
+        const uint8_t op = *data++;
+        int run = 1;
+        if (op == kOpRgba) {
+            need(4 * sizeof(T));
+            std::memcpy(pixel.c.data(), data, 4 * sizeof(T));
+            data += 4 * sizeof(T);
+        } else if (op == kOpRgb) {
+            need(3 * sizeof(T));
+            std::memcpy(pixel.c.data(), data, 3 * sizeof(T));
+            data += 3 * sizeof(T);
+        } else if (sizeof(T) == 2 && op == kOpLumaWide) {
+            need(3);
+            const int d1 = static_cast<int8_t>(data[0]);
+            pixel.c[0] = static_cast<T>(pixel.c[0] + d1 + static_cast<int8_t>(data[1]));
+            pixel.c[1] = static_cast<T>(pixel.c[1] + d1);
+            pixel.c[2] = static_cast<T>(pixel.c[2] + d1 + static_cast<int8_t>(data[2]));
+            data += 3;
+        } else if ((op & kMask) == kOpIndex) {
+            pixel = index[op];
+        } else if ((op & kMask) == kOpDiff) {
+            pixel.c[0] = static_cast<T>(pixel.c[0] + ((op >> 4) & 3) - 2);
+            pixel.c[1] = static_cast<T>(pixel.c[1] + ((op >> 2) & 3) - 2);
+            pixel.c[2] = static_cast<T>(pixel.c[2] + (op & 3) - 2);
+        } else if ((op & kMask) == kOpLuma) {
+            need(1);
+            const int d1 = (op & 0x3F) - 32;
+            pixel.c[0] = static_cast<T>(pixel.c[0] + d1 + (*data >> 4) - 8);
+            pixel.c[1] = static_cast<T>(pixel.c[1] + d1);
+            pixel.c[2] = static_cast<T>(pixel.c[2] + d1 + (*data & 0x0F) - 8);
+            ++data;
+        } else {
+            run = (op & 0x3F) + 1;
+        }
+        if (run == 1) {
+            index[Hash(pixel)] = pixel;
+        }
+        if (static_cast<size_t>(run) > pixelCount - i) {
+            throw std::runtime_error("QoiCodec: run past end of band");
+        }
+        for (int r = 0; r < run; ++r, ++i) {
+            std::memcpy(pixels + i * sizeof(pixel.c), pixel.c.data(), sizeof(pixel.c));
+        }
+    }
+}
+
+// 条带之间互不依赖：线程按序领取条带号。任一条带抛出异常时其余线程不再领取新条带，
+// 第一个异常在全部线程结束后于调用线程重新抛出（辅助线程中未捕获的异常会直接终止进程）
+template <typename Function> void ForEachBand(size_t bandCount, unsigned threads, Function &&function) {
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    const auto worker = [&] {
+        try {
+            for (size_t band = next++; band < bandCount; band = next++) {
+                function(band);
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+            next = bandCount;
+        }
+    };
+    const unsigned count = static_cast<unsigned>((std::min)(
+        size_t{threads != 0 ? threads : (std::max)(std::thread::hardware_concurrency(), 1u)}, bandCount));
+    std::vector<std::thread> helpers;
+    for (unsigned i = 1; i < count; ++i) {
+        try {
+            helpers.emplace_back(worker);
+        } catch (const std::system_error &) {
+            break; // 无法再创建线程时由已有的线程完成剩余的条带
+        }
+    }
+    worker();
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void AppendUint32(std::vector<uint8_t> &out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t ReadUint32(const uint8_t *data) {
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint32_t BandCount(uint32_t height) { return (height + kBandRows - 1) / kBandRows; }
+
+} // namespace
+
+size_t HeaderBytes(uint32_t height) { return kFixedHeaderBytes + size_t{BandCount(height)} * 4; }
+
+std::vector<uint8_t> EncodeHeader(const ImageInfo &info, const std::vector<uint32_t> &bandBytes) {
+    std::vector<uint8_t> header = {'p', 'q', 'o', 'i'};
+    AppendUint32(header, info.width);
+    AppendUint32(header, info.height);
+    header.push_back(static_cast<uint8_t>(info.format));
+    header.push_back(kVersion);
+    header.push_back(0);
+    header.push_back(0);
+    AppendUint32(header, kBandRows);
+    AppendUint32(header, BandCount(info.height));
+    for (uint32_t band = 0; band < BandCount(info.height); ++band) {
+        AppendUint32(header, band < bandBytes.size() ? bandBytes[band] : 0);
+    }
+    return header;
+}
+
+std::vector<std::vector<uint8_t>> EncodeBands(const uint8_t *rows, uint32_t width, uint32_t rowCount,
+                                              OutputPixelFormat format, unsigned threads) {
+    const size_t rowBytes = static_cast<size_t>(width) * BytesPerPixel(format);
+    std::vector<std::vector<uint8_t>> bands(BandCount(rowCount));
+    ForEachBand(bands.size(), threads, [&](size_t band) {
+        const uint32_t firstRow = static_cast<uint32_t>(band) * kBandRows;
+        const size_t pixelCount = size_t{(std::min)(kBandRows, rowCount - firstRow)} * width;
+        const uint8_t *bandRows = rows + firstRow * rowBytes;
+        if (format == OutputPixelFormat::Rgba16F) {
+            EncodeBand<uint16_t>(bandRows, pixelCount, bands[band]);
+        } else {
+            EncodeBand<uint8_t>(bandRows, pixelCount, bands[band]);
+        }
+    });
+    return bands;
+}
+
+ConvertedImage Decode(const std::filesystem::path &path, unsigned threads) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("QoiCodec: cannot open " + path.string());
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < kFixedHeaderBytes || std::memcmp(data.data(), "pqoi", 4) != 0 || data[13] != kVersion) {
+        throw std::runtime_error("QoiCodec: not a pqoi file: " + path.string());
+    }
+
+    ConvertedImage image;
+    image.info.width = ReadUint32(data.data() + 4);
+    image.info.height = ReadUint32(data.data() + 8);
+    image.info.format = static_cast<OutputPixelFormat>(data[12]);
+    const uint32_t bandRows = ReadUint32(data.data() + 16);
+    const uint32_t bandCount = ReadUint32(data.data() + 20);
+    if (data[12] >= kOutputPixelFormatCount || bandRows != kBandRows || bandCount != BandCount(image.info.height) ||
+        data.size() < HeaderBytes(image.info.height)) {
+        throw std::runtime_error("QoiCodec: invalid header in " + path.string());
+    }
+
+    std::vector<size_t> offsets(bandCount + 1, HeaderBytes(image.info.height));
+    for (uint32_t band = 0; band < bandCount; ++band) {
+        offsets[band + 1] = offsets[band] + ReadUint32(data.data() + kFixedHeaderBytes + band * 4);
+    }
+    if (offsets.back() > data.size()) {
+        throw std::runtime_error("QoiCodec: truncated file " + path.string());
+    }
+    // 分配前用条带大小约束头中的尺寸：每个操作码至多产生一个 run 的像素，像素总数不超过文件字节数的 kMaxRun 倍，
+    // 伪造的头无法请求与文件大小不相称的内存
+    const size_t maxRun = image.info.format == OutputPixelFormat::Rgba16F ? kMaxRun<uint16_t> : kMaxRun<uint8_t>;
+    for (uint32_t band = 0; band < bandCount; ++band) {
+        const uint32_t firstRow = band * kBandRows;
+        const size_t pixelCount = size_t{(std::min)(kBandRows, image.info.height - firstRow)} * image.info.width;
+        if (pixelCount > (offsets[band + 1] - offsets[band]) * maxRun) {
+            throw std::runtime_error("QoiCodec: band " + std::to_string(band) + " too small for the declared size in " +
+                                     path.string());
+        }
+    }
+
+    const size_t rowBytes = image.info.RowBytes();
+    image.pixels.resize(rowBytes * image.info.height);
+    ForEachBand(bandCount, threads, [&](size_t band) {
+        const uint32_t firstRow = static_cast<uint32_t>(band) * kBandRows;
+        const size_t pixelCount = size_t{(std::min)(kBandRows, image.info.height - firstRow)} * image.info.width;
+        uint8_t *pixels = image.pixels.data() + firstRow * rowBytes;
+        if (image.info.format == OutputPixelFormat::Rgba16F) {
+            DecodeBand<uint16_t>(data.data() + offsets[band], offsets[band + 1] - offsets[band], pixels, pixelCount);
+        } else {
+            DecodeBand<uint8_t>(data.data() + offsets[band], offsets[band + 1] - offsets[band], pixels, pixelCount);
+        }
+    });
+    return image;
+}
+
+} // namespace QoiCodec
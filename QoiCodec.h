@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ImageSink.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// 高频截图（审计日志）用的快速无损格式：像素编码沿用 QOI 的 index / diff / luma / run 操作，
+// 扩展到 RGBA16F（按半精度的位模式做差分，多一个 8-bit 宽差分操作）。图像按 kBandRows 行分成互不依赖的条带，
+// 每个条带从初始状态开始编码，编码与解码都可以按条带并行。
+//
+// 文件布局（整数均为小端）：magic "pqoi"、u32 宽、u32 高、u8 OutputPixelFormat、u8 版本、u16 保留、
+// u32 条带行数、u32 条带数、每个条带的 u32 字节数，之后依次是各条带的数据。
+// 像素通道按 ImageSink 的内存顺序存储（BGRA8 为 B, G, R, A；RGBA16F 为 R, G, B, A），luma 以第 2 个通道为基准
+namespace QoiCodec {
+
+constexpr uint32_t kBandRows = 64;
+constexpr const char *kFileExtension = ".pqoi";
+
+// 文件头（含条带表）的字节数
+size_t HeaderBytes(uint32_t height);
+std::vector<uint8_t> EncodeHeader(const ImageInfo &info, const std::vector<uint32_t> &bandBytes);
+
+// rows 为 rowCount 行紧凑排列的像素，从条带边界开始；除最后一个外每个条带 kBandRows 行。
+// 返回各条带的编码结果，threads 为 0 时使用 hardware_concurrency
+std::vector<std::vector<uint8_t>> EncodeBands(const uint8_t *rows, uint32_t width, uint32_t rowCount,
+                                              OutputPixelFormat format, unsigned threads);
+
+// 读取并解码整个文件，各条带并行解码。文件损坏时抛出 std::runtime_error
+ConvertedImage Decode(const std::filesystem::path &path, unsigned threads = 0);
+
+} // namespace QoiCodec
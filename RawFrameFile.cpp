@@ -0,0 +1,83 @@
+#include "RawFrameFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'C', 'R', 'G'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kBytesPerPixel = 8; // R16G16B16A16_FLOAT
+
+// 文件按小端序存放，与所有支持的平台一致
+struct RawFrameHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    float sdrWhiteLevel;
+    float peakBrightness;
+};
+
+static_assert(sizeof(RawFrameHeader) == 24, "RawFrameHeader must be tightly packed");
+
+} // namespace
+
+RawFrameFile ReadRawFrameFile(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open raw frame " + path.string());
+    }
+
+    RawFrameHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        throw std::runtime_error("Not a raw scRGB frame: " + path.string());
+    }
+    if (header.width == 0 || header.height == 0) {
+        throw std::runtime_error("Raw frame has empty dimensions: " + path.string());
+    }
+
+    auto frame = std::make_shared<CapturedFrame>();
+    frame->metadata.width = header.width;
+    frame->metadata.height = header.height;
+    frame->metadata.rowPitch = header.width * kBytesPerPixel;
+    frame->pixelData.resize(static_cast<size_t>(frame->metadata.rowPitch) * header.height);
+    file.read(reinterpret_cast<char *>(frame->pixelData.data()), static_cast<std::streamsize>(frame->pixelData.size()));
+    if (!file) {
+        throw std::runtime_error("Raw frame is truncated: " + path.string());
+    }
+
+    RawFrameFile result;
+    result.frame = std::move(frame);
+    result.hdrInfo = {header.sdrWhiteLevel, header.peakBrightness, 0.0f, header.peakBrightness, header.peakBrightness};
+    return result;
+}
+
+void WriteRawFrameFile(const std::filesystem::path &path, const CapturedFrame &frame, const DisplayHdrInfo &hdrInfo) {
+    const size_t tightPitch = static_cast<size_t>(frame.metadata.width) * kBytesPerPixel;
+    if (frame.metadata.rowPitch != tightPitch || frame.pixelData.size() < tightPitch * frame.metadata.height) {
+        throw std::runtime_error("WriteRawFrameFile: frame data is not tightly packed");
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot create raw frame " + path.string());
+    }
+
+    RawFrameHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.width = frame.metadata.width;
+    header.height = frame.metadata.height;
+    header.sdrWhiteLevel = hdrInfo.sdrWhiteLevel;
+    header.peakBrightness = hdrInfo.peakBrightness;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(frame.pixelData.data()),
+               static_cast<std::streamsize>(tightPitch * frame.metadata.height));
+    if (!file) {
+        throw std::runtime_error("Failed to write raw frame " + path.string());
+    }
+}
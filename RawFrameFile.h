@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ScreenCapture.h"
+#include "SystemInfo.h"
+
+#include <filesystem>
+#include <memory>
+
+// 原始 scRGB 帧转储（.scrgb）：固定头部 + 紧凑排列的 R16G16B16A16_FLOAT 像素。
+// 头部同时保存截图时的 SDR 白点与峰值亮度，离线转换可据此复现剪贴板路径的色调映射。
+struct RawFrameFile {
+    std::shared_ptr<CapturedFrame> frame;
+    DisplayHdrInfo hdrInfo;
+};
+
+constexpr const char *kRawFrameExtension = ".scrgb";
+
+// 失败时抛出 std::runtime_error
+RawFrameFile ReadRawFrameFile(const std::filesystem::path &path);
+void WriteRawFrameFile(const std::filesystem::path &path, const CapturedFrame &frame, const DisplayHdrInfo &hdrInfo);
@@ -0,0 +1,13 @@
+#pragma once
+
+struct SelectionRect {
+    int x1, y1, x2, y2;
+
+    int Left() const { return (x1 < x2) ? x1 : x2; }
+    int Top() const { return (y1 < y2) ? y1 : y2; }
+    int Right() const { return (x1 < x2) ? x2 : x1; }
+    int Bottom() const { return (y1 < y2) ? y2 : y1; }
+    int Width() const { return Right() - Left(); }
+    int Height() const { return Bottom() - Top(); }
+    bool IsValid() const { return Width() > 0 && Height() > 0; }
+};
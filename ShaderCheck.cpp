@@ -0,0 +1,271 @@
+#include "EglEnvironment.h"
+#include "ShaderLibrary.h"
+
+#include <EGL/egl.h>
+#include <GLES3/gl31.h>
+
+#ifdef PRINTSCR_HAVE_ANGLE_TRANSLATOR
+#include <ANGLE/ShaderLang.h>
+#endif
+
+#ifdef PRINTSCR_HAVE_VULKAN
+#include <shaderc/shaderc.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 构建期着色器校验：编译并链接 ShaderLibrary 中的每个 program 变体，任一失败时返回 1，使构建失败。
+// 默认交给当前 EGL 实现（Windows 上即运行时使用的 ANGLE）；编译时定义了 PRINTSCR_HAVE_ANGLE_TRANSLATOR
+// 时另外用 ANGLE 的 translator 做一次与驱动无关的前端校验，并可把翻译后的 ESSL 写入 --translated-dir。
+// PRINTSCR_VULKAN 构建时还用 shaderc 把 VulkanPrograms() 编译为 SPIR-V（Vulkan 1.1 目标环境）。
+namespace {
+
+std::string GetShaderLog(GLuint shader) {
+    GLint logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::string infoLog(static_cast<size_t>((std::max)(logLength, 1)), '\0');
+    glGetShaderInfoLog(shader, logLength, nullptr, infoLog.data());
+    return infoLog.c_str();
+}
+
+std::string GetProgramLog(GLuint program) {
+    GLint logLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+    std::string infoLog(static_cast<size_t>((std::max)(logLength, 1)), '\0');
+    glGetProgramInfoLog(program, logLength, nullptr, infoLog.data());
+    return infoLog.c_str();
+}
+
+// 失败时返回 0 并写入 error
+GLuint CompileWithDriver(GLenum type, ShaderLibrary::ShaderSource source, std::string &error) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, static_cast<GLsizei>(source.count), source.parts, nullptr);
+    glCompileShader(shader);
+
+    GLint compileStatus = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+    if (compileStatus != GL_TRUE) {
+        const char *stage = type == GL_COMPUTE_SHADER ? "compute" : type == GL_VERTEX_SHADER ? "vertex" : "fragment";
+        error = std::string(stage) + " shader: " + GetShaderLog(shader);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool CheckWithDriver(const ShaderLibrary::ProgramSource &source, std::string &error) {
+    std::vector<GLuint> shaders;
+    if (source.computeShader.count != 0) {
+        shaders.push_back(CompileWithDriver(GL_COMPUTE_SHADER, source.computeShader, error));
+    } else {
+        shaders.push_back(CompileWithDriver(GL_VERTEX_SHADER, source.vertexShader, error));
+        if (shaders.back() != 0) {
+            shaders.push_back(CompileWithDriver(GL_FRAGMENT_SHADER, source.fragmentShader, error));
+        }
+    }
+
+    bool linked = false;
+    if (std::find(shaders.begin(), shaders.end(), 0u) == shaders.end()) {
+        GLuint program = glCreateProgram();
+        for (GLuint shader : shaders) {
+            glAttachShader(program, shader);
+        }
+        glLinkProgram(program);
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        linked = linkStatus == GL_TRUE;
+        if (!linked) {
+            error = "link: " + GetProgramLog(program);
+        }
+        glDeleteProgram(program);
+    }
+    for (GLuint shader : shaders) {
+        if (shader != 0) {
+            glDeleteShader(shader);
+        }
+    }
+    return linked;
+}
+
+#ifdef PRINTSCR_HAVE_ANGLE_TRANSLATOR
+// ANGLE 前端：按 GLSL ES 规范（3.10 / 3.00）解析并校验，输出 ESSL 目标代码
+class AngleTranslator {
+public:
+    AngleTranslator() {
+        if (!sh::Initialize()) {
+            throw std::runtime_error("sh::Initialize failed");
+        }
+        sh::InitBuiltInResources(&m_resources);
+    }
+
+    ~AngleTranslator() { sh::Finalize(); }
+
+    AngleTranslator(const AngleTranslator &) = delete;
+    AngleTranslator &operator=(const AngleTranslator &) = delete;
+
+    // 成功时返回 true 并写入翻译结果，失败时写入信息日志
+    bool Translate(GLenum type, ShaderLibrary::ShaderSource source, std::string &output) {
+        const ShShaderSpec spec = type == GL_COMPUTE_SHADER ? SH_GLES3_1_SPEC : SH_GLES3_SPEC;
+        ShHandle compiler = sh::ConstructCompiler(type, spec, SH_ESSL_OUTPUT, &m_resources);
+        if (!compiler) {
+            output = "sh::ConstructCompiler failed";
+            return false;
+        }
+        ShCompileOptions options;
+        options.objectCode = true;
+        const bool compiled = sh::Compile(compiler, source.parts, source.count, options);
+        output = compiled ? sh::GetObjectCode(compiler) : sh::GetInfoLog(compiler);
+        sh::Destruct(compiler);
+        return compiled;
+    }
+
+private:
+    ShBuiltInResources m_resources;
+};
+
+std::filesystem::path TranslatedPath(const std::filesystem::path &directory, std::string name, GLenum type) {
+    std::replace(name.begin(), name.end(), '/', '.');
+    const char *extension = type == GL_COMPUTE_SHADER ? ".comp" : type == GL_VERTEX_SHADER ? ".vert" : ".frag";
+    return directory / (name + extension);
+}
+
+bool CheckWithTranslator(AngleTranslator &translator, const ShaderLibrary::ProgramSource &source,
+                         const std::filesystem::path &outputDirectory, std::string &error) {
+    std::vector<std::pair<GLenum, ShaderLibrary::ShaderSource>> stages;
+    if (source.computeShader.count != 0) {
+        stages.emplace_back(GL_COMPUTE_SHADER, source.computeShader);
+    } else {
+        stages.emplace_back(GL_VERTEX_SHADER, source.vertexShader);
+        stages.emplace_back(GL_FRAGMENT_SHADER, source.fragmentShader);
+    }
+    for (const auto &[type, shader] : stages) {
+        std::string output;
+        if (!translator.Translate(type, shader, output)) {
+            error = "translator: " + output;
+            return false;
+        }
+        if (!outputDirectory.empty()) {
+            std::ofstream file(TranslatedPath(outputDirectory, source.name, type), std::ios::binary | std::ios::trunc);
+            file << output;
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef PRINTSCR_HAVE_VULKAN
+// 与 VulkanConverter 运行时使用相同的编译选项
+bool CheckWithShaderc(const ShaderLibrary::ProgramSource &source, std::string &error) {
+    std::string text;
+    for (size_t i = 0; i < source.computeShader.count; ++i) {
+        text += source.computeShader.parts[i];
+    }
+    shaderc_compiler_t compiler = shaderc_compiler_initialize();
+    shaderc_compile_options_t options = shaderc_compile_options_initialize();
+    shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+    shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance);
+    shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, text.data(), text.size(),
+                                                                   shaderc_compute_shader, source.name.c_str(),
+                                                                   "main", options);
+    const bool compiled = shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success;
+    if (!compiled) {
+        error = std::string("shaderc: ") + shaderc_result_get_error_message(result);
+    }
+    shaderc_result_release(result);
+    shaderc_compile_options_release(options);
+    shaderc_compiler_release(compiler);
+    return compiled;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::filesystem::path translatedDirectory;
+    for (int i = 1; i < argc; ++i) {
+        const std::string name = argv[i];
+        if (name == "--translated-dir" && i + 1 < argc) {
+            translatedDirectory = argv[++i];
+        } else {
+            std::cerr << "Usage: printscr_shadercheck [--translated-dir <dir>]" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        EglEnvironment egl;
+        if (!eglMakeCurrent(egl.Display(), egl.DummySurface(), egl.DummySurface(), egl.RootContext())) {
+            throw std::runtime_error("eglMakeCurrent failed");
+        }
+        GLint majorVersion = 0;
+        GLint minorVersion = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+        glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+        const bool computeSupported = majorVersion > 3 || (majorVersion == 3 && minorVersion >= 1);
+        std::cout << "Validating shaders with " << reinterpret_cast<const char *>(glGetString(GL_RENDERER)) << " ("
+                  << reinterpret_cast<const char *>(glGetString(GL_VERSION)) << ")" << std::endl;
+
+#ifdef PRINTSCR_HAVE_ANGLE_TRANSLATOR
+        AngleTranslator translator;
+        if (!translatedDirectory.empty()) {
+            std::filesystem::create_directories(translatedDirectory);
+        }
+#else
+        if (!translatedDirectory.empty()) {
+            std::cerr << "Built without the ANGLE translator, --translated-dir ignored" << std::endl;
+        }
+#endif
+
+        size_t passed = 0;
+        size_t failed = 0;
+        size_t skipped = 0;
+        for (const auto &program : ShaderLibrary::AllPrograms()) {
+            std::string error;
+            bool ok = true;
+#ifdef PRINTSCR_HAVE_ANGLE_TRANSLATOR
+            ok = CheckWithTranslator(translator, program, translatedDirectory, error);
+#endif
+            if (ok && program.computeShader.count != 0 && !computeSupported) {
+                ++skipped;
+                continue;
+            }
+            ok = ok && CheckWithDriver(program, error);
+            if (ok) {
+                ++passed;
+            } else {
+                ++failed;
+                std::cerr << program.name << ": " << error << std::endl;
+            }
+        }
+
+#ifdef PRINTSCR_HAVE_VULKAN
+        for (const auto &program : ShaderLibrary::VulkanPrograms()) {
+            std::string error;
+            if (CheckWithShaderc(program, error)) {
+                ++passed;
+            } else {
+                ++failed;
+                std::cerr << program.name << ": " << error << std::endl;
+            }
+        }
+#endif
+
+        std::cout << "Shader variants: " << passed << " passed, " << failed << " failed";
+        if (skipped != 0) {
+            std::cout << ", " << skipped << " compute variants skipped (no OpenGL ES 3.1 context)";
+        }
+        std::cout << std::endl;
+        eglMakeCurrent(egl.Display(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return failed == 0 ? 0 : 1;
+    } catch (const std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
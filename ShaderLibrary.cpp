@@ -0,0 +1,1750 @@
+#include "ShaderLibrary.h"
+#include "ToneMapShaders.h"
+#include "TransferLut.h"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace ShaderLibrary {
+namespace {
+
+// 处理着色器中的 kTransferLutSize / kTransferLutRows 与之对应
+static_assert(TransferLut::kSize == 256 && TransferLut::kCurveCount == 3,
+              "Transfer LUT layout must match kProcessingShaderCommon");
+// kRedactionOverlay 中的 kMaxRedactionRects 与之对应
+static_assert(kMaxRedactionRects == 16, "Redaction rect limit must match kRedactionOverlay");
+
+// 检测与处理着色器的工作组形状、像素块与读取方式由 KernelConfig 决定，以宏的形式加在源码前。
+// 检测着色器由 kProcessingShaderVersion + kernel 宏 + kDetectionShaderCommon + kRedactionOverlay
+// + kDetectionShaderMain 组成
+constexpr const char *kDetectionShaderCommon = R"(
+precision highp float;
+precision highp int;
+
+layout(local_size_x = PRINTSCR_LOCAL_SIZE_X, local_size_y = PRINTSCR_LOCAL_SIZE_Y, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+layout(std430, binding = 0) buffer DetectionBuffer {
+    uint foundHighlight;
+} u_detection;
+
+uniform ivec2 u_selectionOrigin;
+uniform ivec2 u_outputSize;
+uniform float u_lw;
+)";
+
+constexpr const char *kDetectionShaderMain = R"(
+void main() {
+    ivec2 base = ivec2(gl_GlobalInvocationID.xy) * ivec2(PRINTSCR_PIXELS_X, PRINTSCR_PIXELS_Y);
+    if (base.x >= u_outputSize.x || base.y >= u_outputSize.y) {
+        return;
+    }
+
+    bool found = false;
+#ifdef PRINTSCR_GATHER
+    // 2x2 块：w=(x,y) z=(x+1,y) x=(x,y+1) y=(x+1,y+1)；屏蔽落在选区外的分量。有打码时改用下面的逐像素读取
+    if (u_redactionCount == 0) {
+        vec2 coord = vec2(u_selectionOrigin + base + 1) / vec2(textureSize(u_source, 0));
+        bvec4 valid = bvec4(base.y + 1 < u_outputSize.y,
+                            base.x + 1 < u_outputSize.x && base.y + 1 < u_outputSize.y,
+                            base.x + 1 < u_outputSize.x,
+                            true);
+        vec4 peak = max(max(textureGather(u_source, coord, 0), textureGather(u_source, coord, 1)),
+                        textureGather(u_source, coord, 2));
+        found = any(greaterThan(mix(vec4(0.0), peak, valid), vec4(u_lw)));
+    } else
+#endif
+    {
+        for (int j = 0; j < PRINTSCR_PIXELS_Y; ++j) {
+            for (int i = 0; i < PRINTSCR_PIXELS_X; ++i) {
+                ivec2 pixel = base + ivec2(i, j);
+                if (pixel.x < u_outputSize.x && pixel.y < u_outputSize.y) {
+                    ivec2 position = u_selectionOrigin + pixel;
+                    vec3 color = ApplyRedactions(position, texelFetch(u_source, position, 0)).rgb;
+                    found = found || any(greaterThan(color, vec3(u_lw)));
+                }
+            }
+        }
+    }
+    if (found) {
+        atomicOr(u_detection.foundHighlight, 1u);
+    }
+}
+)";
+
+// 处理着色器由以下片段组成：kProcessingShaderVersion + 变体宏 + kProcessingShaderCommon + kRedactionOverlay
+// + kShaderColorFunctions
+// + （色彩管理变体）kColorLutFunction + （HDR 变体）色调映射算子片段 + kConvertPixelFunction + kOutputPackFunctions
+// + kProcessingShaderMain。
+// 每个算子是独立的 program，SDR 与 HDR 路径的选择发生在 CPU 侧而非逐像素分支。
+constexpr const char *kProcessingShaderVersion = "#version 310 es\n";
+
+constexpr const char *kProcessingShaderCommon = R"(
+precision highp float;
+precision highp int;
+
+layout(local_size_x = PRINTSCR_LOCAL_SIZE_X, local_size_y = PRINTSCR_LOCAL_SIZE_Y, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+#ifdef PRINTSCR_OUTPUT_LINEAR_IMAGE
+// 缩放输出的中间结果：色调映射后的线性光，供重采样 pass 读取
+layout(rgba16f, binding = 0) writeonly uniform highp image2D u_linearOutput;
+#else
+// PRINTSCR_STORE_TYPE 随每行像素数与输出格式变化（uint / uvec2 / uvec4），一次存储写入整行像素块
+layout(std430, binding = 0) buffer OutputBuffer {
+    PRINTSCR_STORE_TYPE pixels[];
+} u_output;
+#endif
+
+uniform ivec2 u_selectionOrigin;
+uniform ivec2 u_outputSize;
+uniform float u_lw;
+uniform float u_sourcePeak;
+)";
+
+// 处理（计算与片元后端）与重采样着色器共用的色彩函数
+constexpr const char *kShaderColorFunctions = R"(
+#ifdef PRINTSCR_VULKAN
+layout(set = 0, binding = 3) uniform highp sampler2D u_transferLut;
+#else
+// 纹理单元由 BindLookupTables 设置：GLSL ES 3.00（片元后端）不支持 sampler 的 binding 布局
+uniform highp sampler2D u_transferLut;
+#endif
+
+const float kReferencePeakNits = 1000.0;
+const float kScRgbReferenceWhiteNits = 80.0;
+const float kTransferLutSize = 256.0;
+const float kTransferLutRows = 3.0;
+const float kCurveHlgToDisplayLinear = 0.0;
+const float kCurveBt1886Oetf = 1.0;
+const float kCurveLinearToSrgb = 2.0;
+
+vec3 SrgbLinearToBt2020Linear(vec3 color) {
+    return vec3(
+        0.6274040 * color.r + 0.3292820 * color.g + 0.0433136 * color.b,
+        0.0690970 * color.r + 0.9195400 * color.g + 0.0113612 * color.b,
+        0.0163916 * color.r + 0.0880132 * color.g + 0.8955950 * color.b
+    );
+}
+
+vec3 Bt2020LinearToBt709Linear(vec3 color) {
+    return vec3(
+        1.6604910 * color.r - 0.5876411 * color.g - 0.0728499 * color.b,
+        -0.1245505 * color.r + 1.1328999 * color.g - 0.0083494 * color.b,
+        -0.0181508 * color.r - 0.1005789 * color.g + 1.1187297 * color.b
+    );
+}
+
+// 传递函数查找表，见 TransferLut.h：每行一条曲线，以 sqrt(x) 为索引
+vec3 SampleTransfer(float row, vec3 linearValue) {
+    vec3 t = sqrt(clamp(linearValue, vec3(0.0), vec3(1.0)));
+    vec3 u = (t * (kTransferLutSize - 1.0) + 0.5) / kTransferLutSize;
+    float v = (row + 0.5) / kTransferLutRows;
+    return vec3(
+        textureLod(u_transferLut, vec2(u.r, v), 0.0).r,
+        textureLod(u_transferLut, vec2(u.g, v), 0.0).r,
+        textureLod(u_transferLut, vec2(u.b, v), 0.0).r
+    );
+}
+
+// 16-bit 输出与缩放中间结果保存 8-bit 结果所对应的线性光，与剪贴板消费者看到的图像一致
+vec3 SrgbToLinear(vec3 signal) {
+    vec3 low = signal / 12.92;
+    vec3 high = pow((signal + 0.055) / 1.055, vec3(2.4));
+    return mix(low, high, greaterThan(signal, vec3(0.04045)));
+}
+)";
+
+// 色彩管理：SDR 信号值 → 目标显示器信号值，一次三线性采样代替矩阵与传递函数运算，见 ColorLut.h。
+// 采样点落在网格点中心，与 ColorLut::Apply 的索引方式一致；纹理单元由 BindLookupTables 设置
+constexpr const char *kColorLutFunction = R"(
+uniform highp sampler3D u_colorLut;
+uniform float u_colorLutSize;
+
+vec3 ApplyColorLut(vec3 signal) {
+    vec3 coord = (clamp(signal, vec3(0.0), vec3(1.0)) * (u_colorLutSize - 1.0) + 0.5) / u_colorLutSize;
+    return textureLod(u_colorLut, coord, 0.0).rgb;
+}
+)";
+
+// 单个 scRGB 像素到 SDR 信号值，两个后端共用；接在色调映射算子片段之后
+constexpr const char *kConvertPixelFunction = R"(
+vec3 ConvertPixel(vec3 color) {
+#ifdef PRINTSCR_HDR_PATH
+    return ToneMap(max(color, vec3(0.0)));
+#else
+    return SampleTransfer(kCurveLinearToSrgb, max(color, vec3(0.0)) / u_lw);
+#endif
+}
+)";
+
+// SDR 信号值到各输出格式，处理与多区域处理着色器共用
+constexpr const char *kOutputPackFunctions = R"(
+uint PackBgra8(vec3 signal) {
+#ifdef PRINTSCR_COLOR_LUT
+    signal = ApplyColorLut(signal);
+#endif
+    return packUnorm4x8(vec4(signal.b, signal.g, signal.r, 1.0));
+}
+
+uvec2 PackRgba16F(vec3 signal) {
+    vec3 linearOutput = SrgbToLinear(clamp(signal, vec3(0.0), vec3(1.0)));
+    return uvec2(packHalf2x16(linearOutput.rg), packHalf2x16(vec2(linearOutput.b, 1.0)));
+}
+
+vec4 LinearOutput(vec3 signal) {
+    return vec4(SrgbToLinear(clamp(signal, vec3(0.0), vec3(1.0))), 1.0);
+}
+
+#ifdef PRINTSCR_OUTPUT_GAIN_MAP
+// 与 ImageSink.h 中的 kGainMapMinLog2、kGainMapOffset 相同
+const float kGainMapMinLog2 = -1.0;
+const float kGainMapOffset = 1.0 / 64.0;
+const vec3 kBt709Luma = vec3(0.2126, 0.7152, 0.0722);
+
+// color 为色调映射前的 scRGB 值，signal 为基础图像的 sRGB 信号值；结果归一化到 [0, 1]
+float GainMapValue(vec3 color, vec3 signal) {
+    float hdr = dot(max(color, vec3(0.0)) / u_lw, kBt709Luma);
+    float sdr = dot(SrgbToLinear(clamp(signal, vec3(0.0), vec3(1.0))), kBt709Luma);
+    float maxLog2 = max(log2(u_sourcePeak / u_lw), 1.0);
+    float gain = log2((hdr + kGainMapOffset) / (sdr + kGainMapOffset));
+    return clamp((gain - kGainMapMinLog2) / (maxLog2 - kGainMapMinLog2), 0.0, 1.0);
+}
+#endif
+
+// 4 字节输出：增益图变体把 alpha 换成增益图，其余与 PackBgra8 相同
+uint PackBgra8Output(vec3 color, vec3 signal) {
+#ifdef PRINTSCR_OUTPUT_GAIN_MAP
+    return packUnorm4x8(vec4(signal.b, signal.g, signal.r, GainMapValue(color, signal)));
+#else
+    return PackBgra8(signal);
+#endif
+}
+)";
+
+constexpr const char *kProcessingShaderMain = R"(
+const int kBlockPixels = PRINTSCR_PIXELS_X * PRINTSCR_PIXELS_Y;
+
+void main() {
+    ivec2 base = ivec2(gl_GlobalInvocationID.xy) * ivec2(PRINTSCR_PIXELS_X, PRINTSCR_PIXELS_Y);
+    if (base.x >= u_outputSize.x || base.y >= u_outputSize.y) {
+        return;
+    }
+
+    // 块内像素按行优先排列；越过选区的像素读取钳制到选区内，但不会被写出
+    vec3 colors[kBlockPixels];
+#ifdef PRINTSCR_GATHER
+    // 有打码时改用下面的逐像素读取
+    if (u_redactionCount == 0) {
+        vec2 coord = vec2(u_selectionOrigin + base + 1) / vec2(textureSize(u_source, 0));
+        vec4 r = textureGather(u_source, coord, 0);
+        vec4 g = textureGather(u_source, coord, 1);
+        vec4 b = textureGather(u_source, coord, 2);
+        colors[0] = vec3(r.w, g.w, b.w);
+        colors[1] = vec3(r.z, g.z, b.z);
+        colors[2] = vec3(r.x, g.x, b.x);
+        colors[3] = vec3(r.y, g.y, b.y);
+    } else
+#endif
+    {
+        for (int j = 0; j < PRINTSCR_PIXELS_Y; ++j) {
+            for (int i = 0; i < PRINTSCR_PIXELS_X; ++i) {
+                ivec2 position = u_selectionOrigin + min(base + ivec2(i, j), u_outputSize - 1);
+                colors[j * PRINTSCR_PIXELS_X + i] = ApplyRedactions(position, texelFetch(u_source, position, 0)).rgb;
+            }
+        }
+    }
+
+    for (int j = 0; j < PRINTSCR_PIXELS_Y; ++j) {
+        int y = base.y + j;
+        if (y >= u_outputSize.y) {
+            break;
+        }
+        int rowIndex = y * u_outputSize.x + base.x;
+        vec3 c0 = ConvertPixel(colors[j * PRINTSCR_PIXELS_X]);
+#if PRINTSCR_PIXELS_X >= 2
+        vec3 c1 = ConvertPixel(colors[j * PRINTSCR_PIXELS_X + 1]);
+#endif
+#if PRINTSCR_PIXELS_X == 4
+        vec3 c2 = ConvertPixel(colors[j * PRINTSCR_PIXELS_X + 2]);
+        vec3 c3 = ConvertPixel(colors[j * PRINTSCR_PIXELS_X + 3]);
+#endif
+
+#if defined(PRINTSCR_OUTPUT_LINEAR_IMAGE)
+        imageStore(u_linearOutput, ivec2(base.x, y), LinearOutput(c0));
+#if PRINTSCR_PIXELS_X >= 2
+        if (base.x + 1 < u_outputSize.x) {
+            imageStore(u_linearOutput, ivec2(base.x + 1, y), LinearOutput(c1));
+        }
+#endif
+#if PRINTSCR_PIXELS_X == 4
+        if (base.x + 2 < u_outputSize.x) {
+            imageStore(u_linearOutput, ivec2(base.x + 2, y), LinearOutput(c2));
+        }
+        if (base.x + 3 < u_outputSize.x) {
+            imageStore(u_linearOutput, ivec2(base.x + 3, y), LinearOutput(c3));
+        }
+#endif
+#elif defined(PRINTSCR_OUTPUT_RGBA16F)
+#if PRINTSCR_PIXELS_X == 1
+        uvec2 halves = PackRgba16F(c0);
+        u_output.pixels[rowIndex * 2] = halves.x;
+        u_output.pixels[rowIndex * 2 + 1] = halves.y;
+#elif PRINTSCR_PIXELS_X == 2
+        u_output.pixels[rowIndex / 2] = uvec4(PackRgba16F(c0), PackRgba16F(c1));
+#else
+        u_output.pixels[rowIndex / 2] = uvec4(PackRgba16F(c0), PackRgba16F(c1));
+        u_output.pixels[rowIndex / 2 + 1] = uvec4(PackRgba16F(c2), PackRgba16F(c3));
+#endif
+#else
+#if PRINTSCR_PIXELS_X == 1
+        u_output.pixels[rowIndex] = PackBgra8Output(colors[j], c0);
+#elif PRINTSCR_PIXELS_X == 2
+        u_output.pixels[rowIndex / 2] =
+            uvec2(PackBgra8Output(colors[j * 2], c0), PackBgra8Output(colors[j * 2 + 1], c1));
+#else
+        u_output.pixels[rowIndex / 4] =
+            uvec4(PackBgra8Output(colors[j * 4], c0), PackBgra8Output(colors[j * 4 + 1], c1),
+                  PackBgra8Output(colors[j * 4 + 2], c2), PackBgra8Output(colors[j * 4 + 3], c3));
+#endif
+#endif
+    }
+}
+)";
+
+// 片元后端：在选区大小的 RGBA8 帧缓冲上画一个覆盖视口的三角形，每个片元对应一个输出像素，
+// 再用 glReadPixels 读入 PBO。只用到 GLES 3.0，不需要计算着色器
+constexpr const char *kFragmentShaderVersion = "#version 300 es\n";
+
+constexpr const char *kFullscreenVertexShader = R"(#version 300 es
+// 不需要顶点缓冲：三个顶点 (-1,-1)、(3,-1)、(-1,3) 覆盖整个视口
+void main() {
+    vec2 position = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+constexpr const char *kFragmentShaderCommon = R"(
+precision highp float;
+precision highp int;
+
+uniform highp sampler2D u_source;
+uniform ivec2 u_selectionOrigin;
+uniform ivec2 u_outputSize;
+uniform float u_lw;
+uniform float u_sourcePeak;
+
+layout(location = 0) out vec4 o_color;
+)";
+
+// 片元后端读取源像素，放在 kRedactionOverlay 之后
+constexpr const char *kFragmentFetchSource = R"(
+vec3 FetchSource() {
+    ivec2 position = u_selectionOrigin + ivec2(gl_FragCoord.xy);
+    return ApplyRedactions(position, texelFetch(u_source, position, 0)).rgb;
+}
+)";
+
+// 检测：只有超过阈值的片元通过，结果由 GL_ANY_SAMPLES_PASSED 查询给出
+constexpr const char *kFragmentDetectionMain = R"(
+void main() {
+    if (!any(greaterThan(FetchSource(), vec3(u_lw)))) {
+        discard;
+    }
+    o_color = vec4(1.0);
+}
+)";
+
+// 按 BGRA 顺序写入 RGBA8 目标，glReadPixels(GL_RGBA, GL_UNSIGNED_BYTE) 读出的字节即与 SSBO 路径相同
+constexpr const char *kFragmentProcessingMain = R"(
+void main() {
+    vec3 signal = ConvertPixel(FetchSource());
+#ifdef PRINTSCR_COLOR_LUT
+    signal = ApplyColorLut(signal);
+#endif
+    o_color = vec4(signal.b, signal.g, signal.r, 1.0);
+}
+)";
+
+// 多区域批量转换：同一帧的 N 个区域展开为 16x16 tile 的一维序列，检测与处理各用一次 dispatch 覆盖全部区域。
+// 区域表给出每个区域的源矩形、首个 tile 序号、每行 tile 数与在打包输出缓冲区中的偏移（uint 为单位）。
+// 工作组按 tile 序号二分查找所属区域；路径与输出格式按区域取自缓冲区，同一工作组内一致，不产生发散
+constexpr const char *kRegionBatchCommon = R"(
+precision highp float;
+precision highp int;
+
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+struct Region {
+    ivec4 rect;      // 源矩形：左上角 xy、宽高 zw
+    uvec4 placement; // x 首个 tile 序号，y 每行 tile 数，z 输出偏移，w 标志位
+};
+
+layout(std430, binding = 1) readonly buffer RegionBuffer {
+    Region regions[];
+} u_regions;
+
+layout(std430, binding = 2) buffer DetectionBuffer {
+    uint found[];
+} u_detection;
+
+uniform int u_regionCount;
+uniform int u_tileCount;
+uniform float u_lw;
+uniform float u_sourcePeak;
+
+const int kRegionTileSize = 16;
+const uint kRegionRgba16F = 1u;
+
+// 当前 invocation 对应的区域与区域内像素坐标；越界时返回 false
+bool LocateRegionPixel(out int region, out ivec2 pixel) {
+    int tile = int(gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x);
+    region = 0;
+    pixel = ivec2(0);
+    if (tile >= u_tileCount) {
+        return false;
+    }
+    int low = 0;
+    int high = u_regionCount - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (int(u_regions.regions[middle].placement.x) <= tile) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    region = low;
+    int local = tile - int(u_regions.regions[region].placement.x);
+    int tilesPerRow = int(u_regions.regions[region].placement.y);
+    pixel = ivec2(local % tilesPerRow, local / tilesPerRow) * kRegionTileSize + ivec2(gl_LocalInvocationID.xy);
+    return all(lessThan(pixel, u_regions.regions[region].rect.zw));
+}
+)";
+
+constexpr const char *kRegionDetectionMain = R"(
+void main() {
+    int region;
+    ivec2 pixel;
+    if (!LocateRegionPixel(region, pixel)) {
+        return;
+    }
+    vec3 color = texelFetch(u_source, u_regions.regions[region].rect.xy + pixel, 0).rgb;
+    if (any(greaterThan(color, vec3(u_lw)))) {
+        atomicOr(u_detection.found[region], 1u);
+    }
+}
+)";
+
+// 与 ConvertPixel 相同的两条路径，按区域的检测结果选择
+constexpr const char *kRegionProcessingMain = R"(
+layout(std430, binding = 0) buffer OutputBuffer {
+    uint pixels[];
+} u_output;
+
+void main() {
+    int region;
+    ivec2 pixel;
+    if (!LocateRegionPixel(region, pixel)) {
+        return;
+    }
+    Region r = u_regions.regions[region];
+    vec3 color = max(texelFetch(u_source, r.rect.xy + pixel, 0).rgb, vec3(0.0));
+    vec3 signal = u_detection.found[region] != 0u ? ToneMap(color)
+                                                  : SampleTransfer(kCurveLinearToSrgb, color / u_lw);
+
+    uint pixelIndex = uint(pixel.y * r.rect.z + pixel.x);
+    if ((r.placement.w & kRegionRgba16F) != 0u) {
+        uvec2 halves = PackRgba16F(signal);
+        u_output.pixels[r.placement.z + pixelIndex * 2u] = halves.x;
+        u_output.pixels[r.placement.z + pixelIndex * 2u + 1u] = halves.y;
+    } else {
+        u_output.pixels[r.placement.z + pixelIndex] = PackBgra8(signal);
+    }
+}
+)";
+
+// 整帧预转换的检测 tile 索引：每个 16x16 工作组对应帧上的一个 tile，tile 内任一像素超过阈值即置位
+constexpr const char *kTileDetectionShaderSource = R"(#version 310 es
+precision highp float;
+precision highp int;
+
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+layout(std430, binding = 0) buffer TileBuffer {
+    uint found[];
+} u_tiles;
+
+uniform float u_lw;
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, textureSize(u_source, 0)))) {
+        return;
+    }
+    if (any(greaterThan(texelFetch(u_source, pixel, 0).rgb, vec3(u_lw)))) {
+        u_tiles.found[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = 1u;
+    }
+}
+)";
+
+// 整帧亮度统计：每个工作组负责一个 32x32 的块，invocation i 先求第 i 行的前缀和，再在 shared memory 中
+// 求第 i 列的前缀和，得到块内的求和面积表；最后按行写出，两个 16-bit 计数打包为一个 uint。
+// 亮度先减去块内的平均亮度再累加，平方和只含偏差部分，float 的舍入不会淹没方差；帧外像素按均值计。
+// 与 FrameStatisticsTiles 的布局一致
+constexpr const char *kFrameStatisticsShaderSource = R"(#version 310 es
+precision highp float;
+precision highp int;
+
+const int kTileSize = 32;
+const int kStride = kTileSize + 1; // 列方向访问错开 bank
+const vec3 kBt709Luma = vec3(0.2126, 0.7152, 0.0722);
+
+layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+layout(std430, binding = 0) writeonly buffer SumBuffer {
+    vec2 sums[];
+} u_sums;
+
+layout(std430, binding = 1) writeonly buffer CountBuffer {
+    uint counts[];
+} u_counts;
+
+layout(std430, binding = 2) writeonly buffer PeakBuffer {
+    float peaks[];
+} u_peaks;
+
+layout(std430, binding = 3) writeonly buffer OffsetBuffer {
+    float offsets[];
+} u_offsets;
+
+uniform float u_threshold; // 与检测 pass 相同的阈值
+
+shared vec2 s_sums[kTileSize * kStride];
+shared float s_counts[kTileSize * kStride];
+shared float s_peaks[kTileSize];
+shared float s_rowSums[kTileSize];
+
+float Luminance(vec3 color) { return dot(max(color, vec3(0.0)), kBt709Luma); }
+
+void main() {
+    int line = int(gl_LocalInvocationID.x);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * kTileSize;
+    ivec2 frameSize = textureSize(u_source, 0);
+    ivec2 validSize = min(frameSize - origin, ivec2(kTileSize));
+
+    float rowSum = 0.0;
+    for (int x = 0; x < validSize.x && line < validSize.y; ++x) {
+        rowSum += Luminance(texelFetch(u_source, origin + ivec2(x, line), 0).rgb);
+    }
+    s_rowSums[line] = rowSum;
+    barrier();
+    float tileSum = 0.0;
+    for (int y = 0; y < kTileSize; ++y) {
+        tileSum += s_rowSums[y];
+    }
+    float offset = tileSum / float(validSize.x * validSize.y);
+
+    vec2 sum = vec2(0.0);
+    float count = 0.0;
+    float peak = 0.0;
+    for (int x = 0; x < kTileSize; ++x) {
+        ivec2 pixel = origin + ivec2(x, line);
+        if (all(lessThan(pixel, frameSize))) {
+            vec3 color = texelFetch(u_source, pixel, 0).rgb;
+            float luminance = Luminance(color);
+            float centered = luminance - offset;
+            sum += vec2(centered, centered * centered);
+            count += any(greaterThan(color, vec3(u_threshold))) ? 1.0 : 0.0;
+            peak = max(peak, luminance);
+        }
+        s_sums[line * kStride + x] = sum;
+        s_counts[line * kStride + x] = count;
+    }
+    s_peaks[line] = peak;
+    barrier();
+
+    for (int y = 1; y < kTileSize; ++y) {
+        s_sums[y * kStride + line] += s_sums[(y - 1) * kStride + line];
+        s_counts[y * kStride + line] += s_counts[(y - 1) * kStride + line];
+    }
+    barrier();
+
+    uint tile = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    uint base = tile * uint(kTileSize * kTileSize) + uint(line * kTileSize);
+    for (int x = 0; x < kTileSize; x += 2) {
+        u_sums.sums[base + uint(x)] = s_sums[line * kStride + x];
+        u_sums.sums[base + uint(x + 1)] = s_sums[line * kStride + x + 1];
+        u_counts.counts[(base + uint(x)) / 2u] =
+            uint(s_counts[line * kStride + x]) | (uint(s_counts[line * kStride + x + 1]) << 16);
+    }
+    if (line == 0) {
+        float tilePeak = 0.0;
+        for (int i = 0; i < kTileSize; ++i) {
+            tilePeak = max(tilePeak, s_peaks[i]);
+        }
+        u_peaks.peaks[tile] = tilePeak;
+        u_offsets.offsets[tile] = offset;
+    }
+}
+)";
+
+// 2 倍盒式预缩小：把比例低于 0.5 的轴先减半，使后续重采样的滤波器足迹有上界
+constexpr const char *kReduceShaderSource = R"(#version 310 es
+precision highp float;
+precision highp int;
+
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+layout(rgba16f, binding = 0) writeonly uniform highp image2D u_reduced;
+
+uniform ivec2 u_sourceSize;
+uniform ivec2 u_outputSize;
+uniform ivec2 u_factor;
+
+void main() {
+    ivec2 gid = ivec2(gl_GlobalInvocationID.xy);
+    if (gid.x >= u_outputSize.x || gid.y >= u_outputSize.y) {
+        return;
+    }
+
+    ivec2 base = gid * u_factor;
+    vec4 sum = vec4(0.0);
+    for (int dy = 0; dy < u_factor.y; ++dy) {
+        for (int dx = 0; dx < u_factor.x; ++dx) {
+            sum += texelFetch(u_source, min(base + ivec2(dx, dy), u_sourceSize - 1), 0);
+        }
+    }
+    imageStore(u_reduced, gid, sum / float(u_factor.x * u_factor.y));
+}
+)";
+
+// 打码：只对与选区相交的矩形做模糊或马赛克，结果写入一张按矩形拼排的 RGBA16F patch 纹理，源帧不变。
+// 检测、处理与局部色调映射读取源帧时经 kRedactionOverlay 改读 patch，打码的工作量只与打码面积成正比。
+// 最多 16 个矩形，与 OutputModule.h 中的 kMaxRedactionRects 一致；有重叠时后面的矩形优先
+constexpr const char *kRedactionOverlay = R"(
+const int kMaxRedactionRects = 16;
+
+uniform highp sampler2D u_redactionPatches;
+uniform int u_redactionCount;                              // 没有打码时为 0
+uniform ivec4 u_redactionRects[kMaxRedactionRects];        // 帧坐标：xy 为左上角，zw 为右下角（不含）
+uniform ivec2 u_redactionPatchOrigins[kMaxRedactionRects]; // 矩形在 u_redactionPatches 中的左上角
+
+// position 为帧坐标，color 为源帧在该处的值
+vec4 ApplyRedactions(ivec2 position, vec4 color) {
+    for (int i = u_redactionCount - 1; i >= 0; --i) {
+        ivec4 rect = u_redactionRects[i];
+        if (all(greaterThanEqual(position, rect.xy)) && all(lessThan(position, rect.zw))) {
+            return texelFetch(u_redactionPatches, u_redactionPatchOrigins[i] + position - rect.xy, 0);
+        }
+    }
+    return color;
+}
+)";
+
+// 打码 pass 共用：只读取矩形内的像素（越界时钳制到边缘），矩形外的内容不会混入；
+// NaN 与无穷大按 0 处理，不让单个坏像素污染整个块
+constexpr const char *kRedactionCommon = R"(
+precision highp float;
+precision highp int;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+layout(rgba16f, binding = 0) writeonly uniform highp image2D u_destination;
+
+uniform ivec2 u_sourceOrigin;      // 矩形在 u_source 中的左上角
+uniform ivec2 u_destinationOrigin; // 矩形在 u_destination 中的左上角
+uniform ivec2 u_size;
+
+vec4 LoadRedacted(ivec2 position) {
+    vec4 value = texelFetch(u_source, u_sourceOrigin + clamp(position, ivec2(0), u_size - 1), 0);
+    value = mix(value, vec4(0.0), isnan(value));
+    return mix(value, vec4(0.0), isinf(value));
+}
+)";
+
+// 可分离高斯模糊的一个方向：每个工作组沿模糊方向处理 64 个像素，先把它们连同两侧各 u_radius 个像素
+// 读入共享内存，每个像素只从纹理读取一次。半径上限 32 与 kMaxRedactionBlurRadius 一致
+constexpr const char *kRedactionBlurMain = R"(
+const int kGroupSize = 64;
+const int kMaxRadius = 32;
+
+#ifdef PRINTSCR_REDACT_VERTICAL
+layout(local_size_x = 1, local_size_y = 64, local_size_z = 1) in;
+const ivec2 kStep = ivec2(0, 1);
+#else
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+const ivec2 kStep = ivec2(1, 0);
+#endif
+
+uniform int u_radius;
+uniform float u_sigma;
+
+shared vec4 s_line[kGroupSize + 2 * kMaxRadius];
+shared float s_weights[kMaxRadius + 1];
+
+void main() {
+    ivec2 gid = ivec2(gl_GlobalInvocationID.xy);
+    int local = int(gl_LocalInvocationIndex);
+    ivec2 lineStart = gid - kStep * local;
+    for (int i = local; i < kGroupSize + 2 * u_radius; i += kGroupSize) {
+        s_line[i] = LoadRedacted(lineStart + kStep * (i - u_radius));
+    }
+    for (int i = local; i <= u_radius; i += kGroupSize) {
+        s_weights[i] = exp(-float(i * i) / (2.0 * u_sigma * u_sigma));
+    }
+    barrier();
+    if (any(greaterThanEqual(gid, u_size))) {
+        return;
+    }
+
+    int center = local + u_radius;
+    vec4 sum = s_line[center] * s_weights[0];
+    float total = s_weights[0];
+    for (int i = 1; i <= u_radius; ++i) {
+        sum += (s_line[center - i] + s_line[center + i]) * s_weights[i];
+        total += 2.0 * s_weights[i];
+    }
+    imageStore(u_destination, u_destinationOrigin + gid, sum / total);
+}
+)";
+
+// 马赛克：每个工作组负责一个 u_block × u_block 的块（矩形边缘的块被裁小），在共享内存中归约出平均值后
+// 写入 patch 中对应的整个块。块边长上限 64
+constexpr const char *kRedactionMosaicMain = R"(
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+uniform int u_block;
+
+shared vec4 s_sums[256];
+
+void main() {
+    ivec2 blockOrigin = ivec2(gl_WorkGroupID.xy) * u_block;
+    ivec2 blockSize = min(ivec2(u_block), u_size - blockOrigin);
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+
+    vec4 sum = vec4(0.0);
+    for (int y = local.y; y < blockSize.y; y += 16) {
+        for (int x = local.x; x < blockSize.x; x += 16) {
+            sum += LoadRedacted(blockOrigin + ivec2(x, y));
+        }
+    }
+    uint index = gl_LocalInvocationIndex;
+    s_sums[index] = sum;
+    barrier();
+    for (uint stride = 128u; stride > 0u; stride >>= 1u) {
+        if (index < stride) {
+            s_sums[index] += s_sums[index + stride];
+        }
+        barrier();
+    }
+
+    vec4 average = s_sums[0] / float(blockSize.x * blockSize.y);
+    for (int y = local.y; y < blockSize.y; y += 16) {
+        for (int x = local.x; x < blockSize.x; x += 16) {
+            imageStore(u_destination, u_destinationOrigin + blockOrigin + ivec2(x, y), average);
+        }
+    }
+}
+)";
+
+// 局部色调映射：选区按 32x32 像素的单元与 12 档 log2 亮度建立双边网格，每格记录 (Σ log2 亮度, 像素数)，
+// 单元中超过检测阈值的像素另记峰值；网格模糊后按像素位置与自身亮度三线性采样，得到保边的基础亮度 b。
+// 每个像素乘以 Reinhard extended 的增益 (1 + b / W²) / (1 + b)，白点 W 取邻近单元的峰值（以 SDR 白为 1，至少为 1）：
+// 附近没有高光时 W = 1，增益恰为 1，像素原样保留；高光区域的基础亮度从 W 滚降到 SDR 白。
+// 结果是 SDR 范围内的 scRGB 副本，之后按 SDR 路径处理
+constexpr const char *kLocalToneMapCommon = R"(
+precision highp float;
+precision highp int;
+
+// 与 OutputModule.cpp 中的 kLocalToneMapCellSize、kLocalToneMapBins 一致
+const int kCellSize = 32;
+const int kBins = 12;
+const float kLogMin = -10.0;
+const float kLogMax = 8.0;
+const vec3 kBt709Luma = vec3(0.2126, 0.7152, 0.0722);
+
+uniform ivec2 u_selectionOrigin;
+uniform ivec2 u_outputSize;
+uniform float u_lw;
+
+// 以 SDR 白为 1 的亮度取 log2，钳制到网格的亮度范围
+float LogLuminance(vec3 color) {
+    return clamp(log2(max(dot(color, kBt709Luma) / u_lw, exp2(kLogMin))), kLogMin, kLogMax);
+}
+
+// 亮度在网格中的坐标：0 为第一档的中心，kBins - 1 为最后一档的中心
+float BinCoordinate(float logLuminance) {
+    return (logLuminance - kLogMin) / (kLogMax - kLogMin) * float(kBins - 1);
+}
+)";
+
+// 每个工作组负责一个单元，每个 invocation 读取 4x4 像素，先在私有数组中按亮度档累加，
+// 再只把非空的档原子地加到共享内存（相邻像素多落在同一档，原子操作比逐像素累加少一个数量级）。
+// log2 亮度以定点数累加（共享内存只支持整数原子操作）；网格保存按单元像素数归一化的齐次坐标
+constexpr const char *kLocalToneMapGridMain = R"(
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+layout(rgba16f, binding = 0) writeonly uniform highp image3D u_grid;
+layout(rgba16f, binding = 1) writeonly uniform highp image2D u_peak;
+
+uniform float u_threshold; // 与检测 pass 相同的阈值
+
+const int kPixelsPerInvocation = 4;
+const float kFixedPointScale = 256.0;
+const float kMaxPeak = 60000.0;
+
+shared int s_sums[kBins];
+shared uint s_counts[kBins];
+shared uint s_peak;
+
+void main() {
+    uint index = gl_LocalInvocationIndex;
+    if (index < uint(kBins)) {
+        s_sums[index] = 0;
+        s_counts[index] = 0u;
+    }
+    if (index == 0u) {
+        s_peak = floatBitsToUint(1.0);
+    }
+    barrier();
+
+    int sums[kBins];
+    uint counts[kBins];
+    for (int bin = 0; bin < kBins; ++bin) {
+        sums[bin] = 0;
+        counts[bin] = 0u;
+    }
+    float peak = 1.0;
+
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * kCellSize + ivec2(gl_LocalInvocationID.xy) * kPixelsPerInvocation;
+    for (int j = 0; j < kPixelsPerInvocation; ++j) {
+        for (int i = 0; i < kPixelsPerInvocation; ++i) {
+            ivec2 pixel = origin + ivec2(i, j);
+            if (any(greaterThanEqual(pixel, u_outputSize))) {
+                continue;
+            }
+            ivec2 position = u_selectionOrigin + pixel;
+            vec3 color = max(ApplyRedactions(position, texelFetch(u_source, position, 0)).rgb, vec3(0.0));
+            float logLuminance = LogLuminance(color);
+            int bin = int(BinCoordinate(logLuminance) + 0.5);
+            sums[bin] += int(logLuminance * kFixedPointScale);
+            counts[bin] += 1u;
+            float channelPeak = max(max(color.r, color.g), color.b);
+            if (channelPeak > u_threshold) {
+                peak = max(peak, min(channelPeak / u_lw, kMaxPeak));
+            }
+        }
+    }
+
+    for (int bin = 0; bin < kBins; ++bin) {
+        if (counts[bin] != 0u) {
+            atomicAdd(s_sums[bin], sums[bin]);
+            atomicAdd(s_counts[bin], counts[bin]);
+        }
+    }
+    if (peak > 1.0) {
+        // 非负 float 的位模式与数值同序
+        atomicMax(s_peak, floatBitsToUint(peak));
+    }
+    barrier();
+
+    ivec2 cell = ivec2(gl_WorkGroupID.xy);
+    if (index < uint(kBins)) {
+        vec2 homogeneous = vec2(float(s_sums[index]) / kFixedPointScale, float(s_counts[index]));
+        imageStore(u_grid, ivec3(cell, int(index)), vec4(homogeneous / float(kCellSize * kCellSize), 0.0, 1.0));
+    }
+    if (index == 0u) {
+        imageStore(u_peak, cell, vec4(uintBitsToFloat(s_peak), 0.0, 0.0, 1.0));
+    }
+}
+)";
+
+// 网格做 3x3x3 的 [1 2 1] 模糊（网格外的格子没有数据，不参与）；峰值取 3x3 单元的最大值，
+// 使高光所在单元的整个范围（双线性插值的足迹）都使用高光的白点
+constexpr const char *kLocalToneMapBlurMain = R"(
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler3D u_grid;
+layout(binding = 1) uniform highp sampler2D u_peak;
+layout(rgba16f, binding = 0) writeonly uniform highp image3D u_blurredGrid;
+layout(rgba16f, binding = 1) writeonly uniform highp image2D u_dilatedPeak;
+
+uniform ivec3 u_gridSize;
+
+void main() {
+    ivec3 gid = ivec3(gl_GlobalInvocationID);
+    if (any(greaterThanEqual(gid, u_gridSize))) {
+        return;
+    }
+
+    vec2 sum = vec2(0.0);
+    float peak = 1.0;
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                ivec3 position = gid + ivec3(dx, dy, dz);
+                if (any(lessThan(position, ivec3(0))) || any(greaterThanEqual(position, u_gridSize))) {
+                    continue;
+                }
+                float weight = float((2 - abs(dx)) * (2 - abs(dy)) * (2 - abs(dz)));
+                sum += texelFetch(u_grid, position, 0).xy * weight;
+                if (dz == 0) {
+                    peak = max(peak, texelFetch(u_peak, position.xy, 0).r);
+                }
+            }
+        }
+    }
+    imageStore(u_blurredGrid, gid, vec4(sum / 64.0, 0.0, 1.0));
+    if (gid.z == 0) {
+        imageStore(u_dilatedPeak, gid.xy, vec4(peak, 0.0, 0.0, 1.0));
+    }
+}
+)";
+
+// 按像素位置与自身亮度对网格三线性采样（硬件插值齐次坐标后相除），邻域没有数据时以像素自身亮度为基础亮度。
+// 保留的细节会把局部峰值推到 SDR 白以上：该处可能出现的最大值为 W × 增益，超过 kShoulder 的 max(R, G, B)
+// 再按以它为白点的 Reinhard extended 压到 [kShoulder, 1]，按比例缩放三个通道以保持色相。W = 1 时不做任何改变
+constexpr const char *kLocalToneMapApplyMain = R"(
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(binding = 0) uniform highp sampler2D u_source;
+layout(binding = 1) uniform highp sampler3D u_grid;
+layout(binding = 2) uniform highp sampler2D u_peak;
+layout(rgba16f, binding = 0) writeonly uniform highp image2D u_destination;
+
+uniform vec2 u_gridScale; // 像素坐标到单元纹理坐标：1 / (kCellSize × 单元数)
+
+const float kMinWeight = 1.0 / 4096.0;
+const float kShoulder = 0.75;
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, u_outputSize))) {
+        return;
+    }
+
+    ivec2 position = u_selectionOrigin + pixel;
+    vec3 color = max(ApplyRedactions(position, texelFetch(u_source, position, 0)).rgb, vec3(0.0));
+    float logLuminance = LogLuminance(color);
+    vec2 cellCoord = (vec2(pixel) + 0.5) * u_gridScale;
+    vec2 grid = textureLod(u_grid, vec3(cellCoord, (BinCoordinate(logLuminance) + 0.5) / float(kBins)), 0.0).xy;
+    float base = exp2(grid.y > kMinWeight ? grid.x / grid.y : logLuminance);
+    float white = max(textureLod(u_peak, cellCoord, 0.0).r, 1.0);
+    float gain = (1.0 + base / (white * white)) / (1.0 + base);
+    color *= gain;
+
+    float limit = white * gain;
+    float peak = max(max(color.r, color.g), color.b) / u_lw;
+    if (limit > 1.0 && peak > kShoulder) {
+        float t = (peak - kShoulder) / (1.0 - kShoulder);
+        float tWhite = (limit - kShoulder) / (1.0 - kShoulder);
+        float compressed = t * (1.0 + t / (tWhite * tWhite)) / (1.0 + t);
+        color *= (kShoulder + compressed * (1.0 - kShoulder)) / peak;
+    }
+    imageStore(u_destination, pixel, vec4(color, 1.0));
+}
+)";
+
+// 可分离重采样：kResampleShaderInputs + kShaderColorFunctions + kResampleShaderMain。
+// 水平 pass 写 RGBA16F 中间纹理；垂直 pass 同时完成编码并写入输出 SSBO
+constexpr const char *kResampleShaderInputs = R"(
+precision highp float;
+precision highp int;
+
+#ifdef PRINTSCR_RESAMPLE_VERTICAL
+layout(local_size_x = 4, local_size_y = 64, local_size_z = 1) in;
+layout(std430, binding = 0) buffer OutputBuffer {
+    uint pixels[];
+} u_output;
+#else
+layout(local_size_x = 64, local_size_y = 4, local_size_z = 1) in;
+layout(rgba16f, binding = 0) writeonly uniform highp image2D u_resampled;
+#endif
+
+layout(binding = 0) uniform highp sampler2D u_source;
+
+uniform ivec2 u_sourceSize;
+uniform ivec2 u_outputSize;
+uniform float u_scale; // 沿重采样方向：输出长度 / 源长度
+)";
+
+constexpr const char *kResampleShaderMain = R"(
+const int kTileOutputs = 64;
+const int kTileLines = 4;
+const int kTileCapacity = 160;
+const float kPi = 3.14159265358979;
+
+#ifdef PRINTSCR_FILTER_BOX
+const float kFilterRadius = 0.5;
+
+float FilterWeight(float x) {
+    return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+}
+#else
+const float kFilterRadius = 3.0;
+
+float FilterWeight(float x) {
+    if (abs(x) < 1e-5) {
+        return 1.0;
+    }
+    if (abs(x) >= kFilterRadius) {
+        return 0.0;
+    }
+    float px = kPi * x;
+    return kFilterRadius * sin(px) * sin(px / kFilterRadius) / (px * px);
+}
+#endif
+
+// 每条扫描线一段：本工作组的输出所需的全部源像素
+shared vec4 s_tile[kTileLines * kTileCapacity];
+
+void main() {
+#ifdef PRINTSCR_RESAMPLE_VERTICAL
+    int line = int(gl_GlobalInvocationID.x);
+    int lineLocal = int(gl_LocalInvocationID.x);
+    int outputIndex = int(gl_GlobalInvocationID.y);
+    int outputLocal = int(gl_LocalInvocationID.y);
+    int tileFirst = int(gl_WorkGroupID.y) * kTileOutputs;
+    int sourceLength = u_sourceSize.y;
+    int outputLength = u_outputSize.y;
+    int lineCount = u_outputSize.x;
+#else
+    int line = int(gl_GlobalInvocationID.y);
+    int lineLocal = int(gl_LocalInvocationID.y);
+    int outputIndex = int(gl_GlobalInvocationID.x);
+    int outputLocal = int(gl_LocalInvocationID.x);
+    int tileFirst = int(gl_WorkGroupID.x) * kTileOutputs;
+    int sourceLength = u_sourceSize.x;
+    int outputLength = u_outputSize.x;
+    int lineCount = u_outputSize.y;
+#endif
+
+    // 缩小时滤波器按 1/scale 拉宽，保证面积覆盖
+    float filterScale = max(1.0 / u_scale, 1.0);
+    float support = kFilterRadius * filterScale;
+    float firstCenter = (float(tileFirst) + 0.5) / u_scale - 0.5;
+    float lastCenter = (float(tileFirst + kTileOutputs - 1) + 0.5) / u_scale - 0.5;
+    int tileStart = int(floor(firstCenter - support));
+    int tileSpan = min(int(ceil(lastCenter + support)) - tileStart + 1, kTileCapacity);
+
+    int sourceLine = min(line, lineCount - 1);
+    for (int i = outputLocal; i < tileSpan; i += kTileOutputs) {
+        int position = clamp(tileStart + i, 0, sourceLength - 1);
+#ifdef PRINTSCR_RESAMPLE_VERTICAL
+        ivec2 coord = ivec2(sourceLine, position);
+#else
+        ivec2 coord = ivec2(position, sourceLine);
+#endif
+        s_tile[lineLocal * kTileCapacity + i] = texelFetch(u_source, coord, 0);
+    }
+    barrier();
+
+    if (line >= lineCount || outputIndex >= outputLength) {
+        return;
+    }
+
+    float center = (float(outputIndex) + 0.5) / u_scale - 0.5;
+    int first = max(int(ceil(center - support)), tileStart);
+    int last = min(int(floor(center + support)), tileStart + tileSpan - 1);
+    vec3 sum = vec3(0.0);
+    float weightSum = 0.0;
+    for (int position = first; position <= last; ++position) {
+        float weight = FilterWeight((float(position) - center) / filterScale);
+        sum += weight * s_tile[lineLocal * kTileCapacity + (position - tileStart)].rgb;
+        weightSum += weight;
+    }
+    // Lanczos 的负瓣可能产生负值或过冲
+    vec3 linearColor = clamp(weightSum > 0.0 ? sum / weightSum : vec3(0.0), vec3(0.0), vec3(1.0));
+
+#ifdef PRINTSCR_RESAMPLE_VERTICAL
+    int pixelIndex = outputIndex * u_outputSize.x + line;
+#ifdef PRINTSCR_OUTPUT_RGBA16F
+    u_output.pixels[pixelIndex * 2] = packHalf2x16(linearColor.rg);
+    u_output.pixels[pixelIndex * 2 + 1] = packHalf2x16(vec2(linearColor.b, 1.0));
+#else
+    vec3 signal = SampleTransfer(kCurveLinearToSrgb, linearColor);
+#ifdef PRINTSCR_COLOR_LUT
+    signal = ApplyColorLut(signal);
+#endif
+    u_output.pixels[pixelIndex] = packUnorm4x8(vec4(signal.b, signal.g, signal.r, 1.0));
+#endif
+#else
+    imageStore(u_resampled, ivec2(outputIndex, line), vec4(linearColor, 1.0));
+#endif
+}
+)";
+
+// 预览窗口：所有绘制共用一个单位四边形，按 gl_InstanceID 从 uniform block 中取矩形（归一化窗口坐标，左上为原点），
+// 纹理坐标与矩形一致。整幅截图、选区与四条边框都是这样的矩形，逐帧只更新 block 中变化的部分
+constexpr const char *kPreviewVertexShader = R"(#version 300 es
+layout(location = 0) in vec2 a_corner; // 单位四边形的角，0 或 1
+layout(std140) uniform PreviewGeometry {
+    vec4 u_viewTransform; // 归一化窗口坐标到裁剪空间：xy 缩放，zw 偏移
+    vec4 u_rects[6];      // 左、上、右、下
+};
+uniform int u_firstRect;
+out vec2 v_texCoord;
+void main() {
+    vec4 rect = u_rects[u_firstRect + gl_InstanceID];
+    v_texCoord = mix(rect.xy, rect.zw, a_corner);
+    gl_Position = vec4(v_texCoord * u_viewTransform.xy + u_viewTransform.zw, 0.0, 1.0);
+}
+)";
+
+// 传递函数查找表的 GPU 校验（OutputModule::VerifyTransferLut）：每个片元按下标生成 TransferLut::VerifyInput，
+// 分别走 sRGB 编码、BT.1886 OETF 与 HLG 往返算子（kHlgRoundTrip 原文，灰阶输入）三条查表链，写入 RGBA8 的 rgb
+constexpr const char *kTransferLutCheckCommon = R"(
+precision highp float;
+precision highp int;
+
+uniform int u_width;
+uniform float u_sampleCount;
+uniform bool u_squared;
+
+layout(location = 0) out vec4 o_color;
+)";
+
+constexpr const char *kTransferLutCheckMain = R"(
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float x = min(float(pixel.y * u_width + pixel.x) / u_sampleCount, 1.0);
+    if (u_squared) {
+        x *= x;
+    }
+    o_color = vec4(SampleTransfer(kCurveLinearToSrgb, vec3(x)).r,
+                   SampleTransfer(kCurveBt1886Oetf, vec3(x)).r,
+                   ToneMap(vec3(x * (kReferencePeakNits / kScRgbReferenceWhiteNits))).r,
+                   1.0);
+}
+)";
+
+constexpr const char *kPreviewFragmentCommon = R"(
+precision highp float;
+uniform sampler2D u_texture;
+// 写入 SDR 的 UNORM surface 时裁剪到 [0, 1] 并做 sRGB 编码，浮点 surface 与压暗背景纹理保持线性
+uniform bool u_encodeSrgb;
+in vec2 v_texCoord;
+out vec4 o_color;
+
+vec4 EncodeOutput(vec4 color) {
+    if (!u_encodeSrgb) {
+        return color;
+    }
+    vec3 c = clamp(color.rgb, 0.0, 1.0);
+    return vec4(mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, c)), color.a);
+}
+)";
+
+// 原样显示纹理：无选区时的整幅截图、选区内部、已压暗的背景
+constexpr const char *kPreviewImageMain = R"(
+void main() {
+    o_color = EncodeOutput(texture(u_texture, v_texCoord));
+}
+)";
+
+// 选区外的背景：压缩到 SDR 范围后只保留 20% 亮度。每次 Show 渲染一次到纹理，不支持浮点渲染目标时逐帧绘制
+constexpr const char *kPreviewDimMain = R"(
+uniform float u_sdrWhitePointRatio; // sdrWhitePointNits / 80.0
+void main() {
+    vec4 color = texture(u_texture, v_texCoord);
+    o_color = EncodeOutput(vec4(min(color.rgb, vec3(u_sdrWhitePointRatio)) * 0.2, color.a));
+}
+)";
+
+constexpr const char *kPreviewBorderMain = R"(
+void main() {
+    o_color = EncodeOutput(vec4(1.0, 0.0, 0.0, 1.0));
+}
+)";
+
+constexpr const char *kHdrPathDefine = "#define PRINTSCR_HDR_PATH 1\n";
+constexpr const char *kRgba16FOutputDefine = "#define PRINTSCR_OUTPUT_RGBA16F 1\n";
+constexpr const char *kLinearImageDefine = "#define PRINTSCR_OUTPUT_LINEAR_IMAGE 1\n";
+constexpr const char *kGainMapOutputDefine = "#define PRINTSCR_OUTPUT_GAIN_MAP 1\n";
+constexpr const char *kColorLutDefine = "#define PRINTSCR_COLOR_LUT 1\n";
+constexpr const char *kFilterBoxDefine = "#define PRINTSCR_FILTER_BOX 1\n";
+constexpr const char *kResampleVerticalDefine = "#define PRINTSCR_RESAMPLE_VERTICAL 1\n";
+constexpr const char *kRedactVerticalDefine = "#define PRINTSCR_REDACT_VERTICAL 1\n";
+
+// 编译期生成的宏定义文本，以 NUL 结尾
+struct DefineText {
+    std::array<char, 192> text{};
+    size_t length = 0;
+
+    constexpr void Append(char c) {
+        if (length + 1 >= text.size()) {
+            throw std::length_error("Shader define text too long");
+        }
+        text[length++] = c;
+    }
+
+    constexpr void Append(std::string_view part) {
+        for (char c : part) {
+            Append(c);
+        }
+    }
+
+    constexpr void AppendNumber(uint32_t value) {
+        char digits[10] = {};
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count > 0) {
+            Append(digits[--count]);
+        }
+    }
+
+    constexpr void AppendDefine(std::string_view name, uint32_t value) {
+        Append("#define ");
+        Append(name);
+        Append(' ');
+        AppendNumber(value);
+        Append('\n');
+    }
+};
+
+// 工作组形状与像素块宏，检测与处理着色器共用
+constexpr DefineText KernelConfigDefines(const KernelConfig &config) {
+    DefineText defines;
+    defines.AppendDefine("PRINTSCR_LOCAL_SIZE_X", config.localSizeX);
+    defines.AppendDefine("PRINTSCR_LOCAL_SIZE_Y", config.localSizeY);
+    defines.AppendDefine("PRINTSCR_PIXELS_X", config.pixelsX);
+    defines.AppendDefine("PRINTSCR_PIXELS_Y", config.pixelsY);
+    if (config.gather) {
+        defines.Append("#define PRINTSCR_GATHER 1\n");
+    }
+    return defines;
+}
+
+constexpr auto kKernelDefines = [] {
+    std::array<DefineText, kKernelConfigCount> defines{};
+    for (size_t kernel = 0; kernel < kKernelConfigCount; ++kernel) {
+        defines[kernel] = KernelConfigDefines(kKernelConfigs[kernel]);
+    }
+    return defines;
+}();
+
+// Vulkan 计算后端（GLSL 4.50）：选区像素紧密排列在存储缓冲区中，uniform 改为 push constant，
+// 以宏映射到共用色彩函数与色调映射片段引用的名字。binding 与 VulkanConverter.cpp 中的描述符布局一致
+constexpr const char *kVulkanShaderVersion = "#version 450\n";
+
+constexpr const char *kVulkanSubgroupExtensions = R"(
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+)";
+
+constexpr const char *kVulkanShaderCommon = R"(
+#define PRINTSCR_VULKAN 1
+
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+// scRGB 半精度 RGBA，行优先，每行 u_outputSize.x 个像素
+layout(std430, set = 0, binding = 0) readonly buffer SourceBuffer {
+    uvec2 texels[];
+} u_source;
+
+// 选区峰值（非负 float 的位模式）
+layout(std430, set = 0, binding = 1) buffer DetectionBuffer {
+    uint peakBits;
+} u_detection;
+
+layout(push_constant) uniform Parameters {
+    ivec2 outputSize;
+    float lw;
+    float sourcePeak;
+    float threshold;
+} u_parameters;
+
+#define u_outputSize u_parameters.outputSize
+#define u_lw u_parameters.lw
+#define u_sourcePeak u_parameters.sourcePeak
+
+vec3 FetchSource(ivec2 pixel) {
+    uvec2 texel = u_source.texels[pixel.y * u_outputSize.x + pixel.x];
+    return vec3(unpackHalf2x16(texel.x), unpackHalf2x16(texel.y).x);
+}
+)";
+
+constexpr const char *kVulkanDetectionMain = R"(
+void main() {
+    // 越界的 invocation 以 0 参与归约，subgroup 操作之前不能提前返回
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    float peak = 0.0;
+    if (all(lessThan(pixel, u_outputSize))) {
+        vec3 color = FetchSource(pixel);
+        peak = max(max(color.r, color.g), color.b);
+    }
+    peak = subgroupMax(peak > 0.0 ? peak : 0.0);
+    // 非负 float 的位模式与数值同序，各 subgroup 的结果直接用整数 atomicMax 合并
+    if (subgroupElect()) {
+        atomicMax(u_detection.peakBits, floatBitsToUint(peak));
+    }
+}
+)";
+
+// 与多区域批量处理相同，检测结果留在设备上，两次 dispatch 之间不回读
+constexpr const char *kVulkanProcessingMain = R"(
+layout(std430, set = 0, binding = 2) writeonly buffer OutputBuffer {
+    uint pixels[];
+} u_output;
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, u_outputSize))) {
+        return;
+    }
+    vec3 color = max(FetchSource(pixel), vec3(0.0));
+    vec3 signal = uintBitsToFloat(u_detection.peakBits) > u_parameters.threshold
+                      ? ToneMap(color)
+                      : SampleTransfer(kCurveLinearToSrgb, color / u_lw);
+
+    uint pixelIndex = uint(pixel.y * u_outputSize.x + pixel.x);
+#ifdef PRINTSCR_OUTPUT_RGBA16F
+    uvec2 halves = PackRgba16F(signal);
+    u_output.pixels[pixelIndex * 2u] = halves.x;
+    u_output.pixels[pixelIndex * 2u + 1u] = halves.y;
+#else
+    u_output.pixels[pixelIndex] = PackBgra8Output(color, signal);
+#endif
+}
+)";
+
+// 每次存储写入一行像素块：BGRA8 每像素 4 字节，RGBA16F 每像素 8 字节
+constexpr const char *OutputStoreTypeDefine(size_t target, const KernelConfig &config) {
+    const bool wide = target == static_cast<size_t>(OutputPixelFormat::Rgba16F);
+    if (config.pixelsX == 1) {
+        return "#define PRINTSCR_STORE_TYPE uint\n";
+    }
+    return (wide || config.pixelsX == 4) ? "#define PRINTSCR_STORE_TYPE uvec4\n" : "#define PRINTSCR_STORE_TYPE uvec2\n";
+}
+
+// 一个变体的片段列表，全部指向静态存储期的字符串
+struct Composition {
+    std::array<const char *, 16> parts{};
+    size_t count = 0;
+
+    constexpr void Add(const char *part) {
+        if (count == parts.size()) {
+            throw std::length_error("Too many shader parts");
+        }
+        parts[count++] = part;
+    }
+};
+
+constexpr Composition ComposeDetection(size_t kernel) {
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kKernelDefines[kernel].text.data());
+    shader.Add(kDetectionShaderCommon);
+    shader.Add(kRedactionOverlay);
+    shader.Add(kDetectionShaderMain);
+    return shader;
+}
+
+constexpr Composition ComposeProcessing(size_t variant, size_t kernel) {
+    const size_t target = variant / kPathVariantCount;
+    const size_t path = variant % kPathVariantCount;
+
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kKernelDefines[kernel].text.data());
+    shader.Add(OutputStoreTypeDefine(target, kKernelConfigs[kernel]));
+    if (path != kSdrPathVariant) {
+        shader.Add(kHdrPathDefine);
+    }
+    if (target == kLinearImageTarget) {
+        shader.Add(kLinearImageDefine);
+    } else if (target == kBgra8ColorLutTarget) {
+        shader.Add(kColorLutDefine);
+    } else if (static_cast<OutputPixelFormat>(target) == OutputPixelFormat::Rgba16F) {
+        shader.Add(kRgba16FOutputDefine);
+    } else if (static_cast<OutputPixelFormat>(target) == OutputPixelFormat::Bgra8GainMap) {
+        shader.Add(kGainMapOutputDefine);
+    }
+    shader.Add(kProcessingShaderCommon);
+    shader.Add(kRedactionOverlay);
+    shader.Add(kShaderColorFunctions);
+    if (target == kBgra8ColorLutTarget) {
+        shader.Add(kColorLutFunction);
+    }
+    if (path != kSdrPathVariant) {
+        shader.Add(ToneMapShaders::kSources[path - 1]);
+    }
+    shader.Add(kConvertPixelFunction);
+    shader.Add(kOutputPackFunctions);
+    shader.Add(kProcessingShaderMain);
+    return shader;
+}
+
+constexpr Composition ComposeResample(size_t variant) {
+    const auto filter = static_cast<ScaleFilter>(variant / kResampleStageCount);
+    const size_t stage = variant % kResampleStageCount;
+
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    if (filter == ScaleFilter::Box) {
+        shader.Add(kFilterBoxDefine);
+    }
+    if (stage != kResampleHorizontalStage) {
+        shader.Add(kResampleVerticalDefine);
+        if (stage == kResampleBgra8ColorLutStage) {
+            shader.Add(kColorLutDefine);
+        } else if (static_cast<OutputPixelFormat>(stage - 1) == OutputPixelFormat::Rgba16F) {
+            shader.Add(kRgba16FOutputDefine);
+        }
+    }
+    shader.Add(kResampleShaderInputs);
+    shader.Add(kShaderColorFunctions);
+    if (stage == kResampleBgra8ColorLutStage) {
+        shader.Add(kColorLutFunction);
+    }
+    shader.Add(kResampleShaderMain);
+    return shader;
+}
+
+constexpr Composition ComposeRegionDetection() {
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kRegionBatchCommon);
+    shader.Add(kRegionDetectionMain);
+    return shader;
+}
+
+constexpr Composition ComposeRegionProcessing(size_t op) {
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kRegionBatchCommon);
+    shader.Add(kShaderColorFunctions);
+    shader.Add(ToneMapShaders::kSources[op]);
+    shader.Add(kOutputPackFunctions);
+    shader.Add(kRegionProcessingMain);
+    return shader;
+}
+
+constexpr Composition ComposeVulkanDetection() {
+    Composition shader;
+    shader.Add(kVulkanShaderVersion);
+    shader.Add(kVulkanSubgroupExtensions);
+    shader.Add(kVulkanShaderCommon);
+    shader.Add(kVulkanDetectionMain);
+    return shader;
+}
+
+constexpr Composition ComposeVulkanProcessing(size_t variant) {
+    const auto format = static_cast<OutputPixelFormat>(variant / kToneMapOperatorCount);
+
+    Composition shader;
+    shader.Add(kVulkanShaderVersion);
+    if (format == OutputPixelFormat::Rgba16F) {
+        shader.Add(kRgba16FOutputDefine);
+    } else if (format == OutputPixelFormat::Bgra8GainMap) {
+        shader.Add(kGainMapOutputDefine);
+    }
+    shader.Add(kVulkanShaderCommon);
+    shader.Add(kShaderColorFunctions);
+    shader.Add(ToneMapShaders::kSources[variant % kToneMapOperatorCount]);
+    shader.Add(kOutputPackFunctions);
+    shader.Add(kVulkanProcessingMain);
+    return shader;
+}
+
+constexpr Composition ComposeFragmentProcessing(size_t variant) {
+    const size_t path = variant % kPathVariantCount;
+    const bool colorLut = variant >= kPathVariantCount;
+
+    Composition shader;
+    shader.Add(kFragmentShaderVersion);
+    if (path != kSdrPathVariant) {
+        shader.Add(kHdrPathDefine);
+    }
+    if (colorLut) {
+        shader.Add(kColorLutDefine);
+    }
+    shader.Add(kFragmentShaderCommon);
+    shader.Add(kRedactionOverlay);
+    shader.Add(kFragmentFetchSource);
+    shader.Add(kShaderColorFunctions);
+    if (colorLut) {
+        shader.Add(kColorLutFunction);
+    }
+    if (path != kSdrPathVariant) {
+        shader.Add(ToneMapShaders::kSources[path - 1]);
+    }
+    shader.Add(kConvertPixelFunction);
+    shader.Add(kFragmentProcessingMain);
+    return shader;
+}
+
+constexpr Composition ComposeSingle(const char *source) {
+    Composition shader;
+    shader.Add(source);
+    return shader;
+}
+
+template <size_t N, typename Compose>
+constexpr std::array<Composition, N> ComposeAll(Compose compose) {
+    std::array<Composition, N> shaders{};
+    for (size_t i = 0; i < N; ++i) {
+        shaders[i] = compose(i);
+    }
+    return shaders;
+}
+
+constexpr auto kDetectionShaders = ComposeAll<kKernelConfigCount>(ComposeDetection);
+constexpr auto kProcessingShaders = ComposeAll<kProcessingVariantCount * kKernelConfigCount>(
+    [](size_t index) { return ComposeProcessing(index / kKernelConfigCount, index % kKernelConfigCount); });
+constexpr auto kResampleShaders = ComposeAll<kResampleVariantCount>(ComposeResample);
+constexpr auto kRegionProcessingShaders = ComposeAll<kToneMapOperatorCount>(ComposeRegionProcessing);
+constexpr auto kFragmentProcessingShaders = ComposeAll<kFragmentVariantCount>(ComposeFragmentProcessing);
+constexpr auto kPreviewFragmentShaders = ComposeAll<kPreviewStageCount>([](size_t stage) {
+    constexpr std::array kMains{kPreviewImageMain, kPreviewDimMain, kPreviewBorderMain};
+    Composition shader;
+    shader.Add(kFragmentShaderVersion);
+    shader.Add(kPreviewFragmentCommon);
+    shader.Add(kMains[stage]);
+    return shader;
+});
+constexpr auto kVulkanProcessingShaders = ComposeAll<kVulkanProcessingVariantCount>(ComposeVulkanProcessing);
+
+constexpr auto kRedactionBlurShaders = ComposeAll<2>([](size_t vertical) {
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    if (vertical != 0) {
+        shader.Add(kRedactVerticalDefine);
+    }
+    shader.Add(kRedactionCommon);
+    shader.Add(kRedactionBlurMain);
+    return shader;
+});
+
+constexpr Composition kReduceShader = ComposeSingle(kReduceShaderSource);
+constexpr Composition kRedactionMosaic = [] {
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kRedactionCommon);
+    shader.Add(kRedactionMosaicMain);
+    return shader;
+}();
+constexpr auto kLocalToneMapShaders = ComposeAll<kLocalToneMapStageCount>([](size_t stage) {
+    constexpr std::array kMains{kLocalToneMapGridMain, kLocalToneMapBlurMain, kLocalToneMapApplyMain};
+    Composition shader;
+    shader.Add(kProcessingShaderVersion);
+    shader.Add(kLocalToneMapCommon);
+    if (static_cast<LocalToneMapStage>(stage) != LocalToneMapStage::Blur) {
+        shader.Add(kRedactionOverlay);
+    }
+    shader.Add(kMains[stage]);
+    return shader;
+});
+constexpr Composition kTileDetection = ComposeSingle(kTileDetectionShaderSource);
+constexpr Composition kFrameStatistics = ComposeSingle(kFrameStatisticsShaderSource);
+constexpr Composition kRegionDetection = ComposeRegionDetection();
+constexpr Composition kFullscreenVertex = ComposeSingle(kFullscreenVertexShader);
+constexpr Composition kPreviewVertex = ComposeSingle(kPreviewVertexShader);
+constexpr Composition kVulkanDetection = ComposeVulkanDetection();
+constexpr Composition kFragmentDetection = [] {
+    Composition shader;
+    shader.Add(kFragmentShaderVersion);
+    shader.Add(kFragmentShaderCommon);
+    shader.Add(kRedactionOverlay);
+    shader.Add(kFragmentFetchSource);
+    shader.Add(kFragmentDetectionMain);
+    return shader;
+}();
+constexpr Composition kTransferLutCheck = [] {
+    Composition shader;
+    shader.Add(kFragmentShaderVersion);
+    shader.Add(kTransferLutCheckCommon);
+    shader.Add(kShaderColorFunctions);
+    shader.Add(ToneMapShaders::kHlgRoundTrip);
+    shader.Add(kTransferLutCheckMain);
+    return shader;
+}();
+
+// #version 必须是第一个片段的开头，之前不能有宏或其他文本
+template <size_t N>
+constexpr bool StartsWithVersion(const std::array<Composition, N> &shaders, std::string_view version) {
+    for (const auto &shader : shaders) {
+        if (shader.count == 0 || !std::string_view(shader.parts[0]).starts_with(version)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(StartsWithVersion(kDetectionShaders, "#version 310 es\n"), "Detection shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kProcessingShaders, "#version 310 es\n"), "Processing shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kResampleShaders, "#version 310 es\n"), "Resample shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kRegionProcessingShaders, "#version 310 es\n") &&
+                  StartsWithVersion(std::array{kReduceShader, kRegionDetection, kTileDetection, kFrameStatistics},
+                                    "#version 310 es\n"),
+              "Reduce, region batch, tile detection and statistics shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kRedactionBlurShaders, "#version 310 es\n") &&
+                  StartsWithVersion(std::array{kRedactionMosaic}, "#version 310 es\n"),
+              "Redaction shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kLocalToneMapShaders, "#version 310 es\n"),
+              "Local tone mapping shaders must target ESSL 3.10");
+static_assert(StartsWithVersion(kFragmentProcessingShaders, "#version 300 es\n") &&
+                  StartsWithVersion(kPreviewFragmentShaders, "#version 300 es\n") &&
+                  StartsWithVersion(
+                      std::array{kFullscreenVertex, kPreviewVertex, kFragmentDetection, kTransferLutCheck},
+                      "#version 300 es\n"),
+              "Fragment backend, preview and LUT check shaders must target ESSL 3.00");
+static_assert(StartsWithVersion(kVulkanProcessingShaders, "#version 450\n") &&
+                  StartsWithVersion(std::array{kVulkanDetection}, "#version 450\n"),
+              "Vulkan shaders must target GLSL 4.50");
+
+ShaderSource ToSource(const Composition &shader) { return {shader.parts.data(), shader.count}; }
+
+const char *TargetName(size_t target) {
+    if (target == kLinearImageTarget) {
+        return "linear";
+    }
+    if (target == kBgra8ColorLutTarget) {
+        return "bgra8-lut";
+    }
+    switch (static_cast<OutputPixelFormat>(target)) {
+    case OutputPixelFormat::Rgba16F:
+        return "rgba16f";
+    case OutputPixelFormat::Bgra8GainMap:
+        return "bgra8-gainmap";
+    default:
+        return "bgra8";
+    }
+}
+
+const char *PathName(size_t path) {
+    return path == kSdrPathVariant ? "sdr" : GetToneMapOperatorInfo(static_cast<ToneMapOperator>(path - 1)).name;
+}
+
+} // namespace
+
+ShaderSource DetectionShader(size_t kernel) { return ToSource(kDetectionShaders.at(kernel)); }
+
+ShaderSource ProcessingShader(size_t variant, size_t kernel) {
+    if (kernel >= kKernelConfigCount) {
+        throw std::out_of_range("Unknown kernel config");
+    }
+    return ToSource(kProcessingShaders.at(variant * kKernelConfigCount + kernel));
+}
+
+ShaderSource ReduceShader() { return ToSource(kReduceShader); }
+
+ShaderSource TileDetectionShader() { return ToSource(kTileDetection); }
+ShaderSource FrameStatisticsShader() { return ToSource(kFrameStatistics); }
+
+ShaderSource RedactionBlurShader(bool vertical) { return ToSource(kRedactionBlurShaders[vertical ? 1 : 0]); }
+
+ShaderSource RedactionMosaicShader() { return ToSource(kRedactionMosaic); }
+
+ShaderSource LocalToneMapShader(LocalToneMapStage stage) {
+    return ToSource(kLocalToneMapShaders.at(static_cast<size_t>(stage)));
+}
+
+ShaderSource ResampleShader(size_t variant) { return ToSource(kResampleShaders.at(variant)); }
+
+ShaderSource RegionDetectionShader() { return ToSource(kRegionDetection); }
+
+ShaderSource RegionProcessingShader(ToneMapOperator op) {
+    return ToSource(kRegionProcessingShaders.at(static_cast<size_t>(op)));
+}
+
+ShaderSource FullscreenVertexShader() { return ToSource(kFullscreenVertex); }
+
+ShaderSource FragmentDetectionShader() { return ToSource(kFragmentDetection); }
+
+ShaderSource FragmentProcessingShader(size_t variant) { return ToSource(kFragmentProcessingShaders.at(variant)); }
+
+ShaderSource TransferLutCheckShader() { return ToSource(kTransferLutCheck); }
+
+ShaderSource PreviewVertexShader() { return ToSource(kPreviewVertex); }
+
+ShaderSource PreviewFragmentShader(PreviewStage stage) {
+    return ToSource(kPreviewFragmentShaders.at(static_cast<size_t>(stage)));
+}
+
+ShaderSource VulkanDetectionShader() { return ToSource(kVulkanDetection); }
+
+ShaderSource VulkanProcessingShader(size_t variant) { return ToSource(kVulkanProcessingShaders.at(variant)); }
+
+std::vector<ProgramSource> AllPrograms() {
+    std::vector<ProgramSource> programs;
+    const ShaderSource none{nullptr, 0};
+    for (size_t kernel = 0; kernel < kKernelConfigCount; ++kernel) {
+        programs.push_back({std::string("detect/") + kKernelConfigs[kernel].name, DetectionShader(kernel), none, none});
+    }
+    for (size_t variant = 0; variant < kProcessingVariantCount; ++variant) {
+        const size_t target = variant / kPathVariantCount;
+        const size_t path = variant % kPathVariantCount;
+        for (size_t kernel = 0; kernel < kKernelConfigCount; ++kernel) {
+            programs.push_back({std::string("process/") + TargetName(target) + "/" + PathName(path) + "/" +
+                                    kKernelConfigs[kernel].name,
+                                ProcessingShader(variant, kernel), none, none});
+        }
+    }
+    programs.push_back({"reduce", ReduceShader(), none, none});
+    programs.push_back({"tile-detect", TileDetectionShader(), none, none});
+    programs.push_back({"frame-statistics", FrameStatisticsShader(), none, none});
+    programs.push_back({"redact/blur/horizontal", RedactionBlurShader(false), none, none});
+    programs.push_back({"redact/blur/vertical", RedactionBlurShader(true), none, none});
+    programs.push_back({"redact/mosaic", RedactionMosaicShader(), none, none});
+    programs.push_back({"local-tonemap/grid", LocalToneMapShader(LocalToneMapStage::Grid), none, none});
+    programs.push_back({"local-tonemap/blur", LocalToneMapShader(LocalToneMapStage::Blur), none, none});
+    programs.push_back({"local-tonemap/apply", LocalToneMapShader(LocalToneMapStage::Apply), none, none});
+    for (size_t variant = 0; variant < kResampleVariantCount; ++variant) {
+        const auto filter = static_cast<ScaleFilter>(variant / kResampleStageCount);
+        const size_t stage = variant % kResampleStageCount;
+        const char *stageName = stage == kResampleHorizontalStage      ? "horizontal"
+                                : stage == kResampleBgra8ColorLutStage ? TargetName(kBgra8ColorLutTarget)
+                                                                       : TargetName(stage - 1);
+        programs.push_back({std::string("resample/") + (filter == ScaleFilter::Box ? "box" : "lanczos") + "/" +
+                                stageName,
+                            ResampleShader(variant), none, none});
+    }
+    programs.push_back({"region/detect", RegionDetectionShader(), none, none});
+    for (size_t op = 0; op < kToneMapOperatorCount; ++op) {
+        programs.push_back({std::string("region/process/") + PathName(1 + op),
+                            RegionProcessingShader(static_cast<ToneMapOperator>(op)), none, none});
+    }
+    programs.push_back({"fragment/detect", none, FullscreenVertexShader(), FragmentDetectionShader()});
+    for (size_t variant = 0; variant < kFragmentVariantCount; ++variant) {
+        const size_t path = variant % kPathVariantCount;
+        programs.push_back({std::string("fragment/process/") + PathName(path) +
+                                (variant >= kPathVariantCount ? "/lut" : ""),
+                            none, FullscreenVertexShader(), FragmentProcessingShader(variant)});
+    }
+    programs.push_back({"verify/transfer-lut", none, FullscreenVertexShader(), TransferLutCheckShader()});
+    programs.push_back({"preview/image", none, PreviewVertexShader(), PreviewFragmentShader(PreviewStage::Image)});
+    programs.push_back({"preview/dim", none, PreviewVertexShader(), PreviewFragmentShader(PreviewStage::Dim)});
+    programs.push_back({"preview/border", none, PreviewVertexShader(), PreviewFragmentShader(PreviewStage::Border)});
+    return programs;
+}
+
+std::vector<ProgramSource> VulkanPrograms() {
+    std::vector<ProgramSource> programs;
+    const ShaderSource none{nullptr, 0};
+    programs.push_back({"vulkan/detect", VulkanDetectionShader(), none, none});
+    for (size_t variant = 0; variant < kVulkanProcessingVariantCount; ++variant) {
+        programs.push_back({std::string("vulkan/process/") +
+                                TargetName(variant / kToneMapOperatorCount) + "/" +
+                                PathName(1 + variant % kToneMapOperatorCount),
+                            VulkanProcessingShader(variant), none, none});
+    }
+    return programs;
+}
+
+} // namespace ShaderLibrary
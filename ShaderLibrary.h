@@ -0,0 +1,135 @@
+#pragma once
+
+#include "ImageSink.h"
+#include "KernelConfig.h"
+#include "OutputModule.h"
+#include "ToneMapping.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 所有着色器变体在编译期由 GLSL 片段组合而成：每个（路径、输出格式、色调映射算子、kernel）组合对应一份
+// 独立的源码，功能开关全部体现为宏，运行时不再拼接字符串或按 uniform 分支。
+// 构建时 printscr_shadercheck 会编译并链接 AllPrograms() 中的每一个 program，运行时只按索引取用。
+namespace ShaderLibrary {
+
+// 一份着色器源码：按顺序排列的 NUL 结尾片段，可直接交给 glShaderSource 或 sh::Compile
+struct ShaderSource {
+    const char *const *parts;
+    size_t count;
+};
+
+// 处理 program 变体 = 输出目标 × 路径；路径 0 为 SDR，其后每个色调映射算子一个。
+// 输出目标为各 OutputPixelFormat、缩放输出使用的线性光中间纹理，以及打包前经过色彩管理查找表的 BGRA8
+constexpr size_t kSdrPathVariant = 0;
+constexpr size_t kPathVariantCount = 1 + kToneMapOperatorCount;
+constexpr size_t kLinearImageTarget = kOutputPixelFormatCount;
+constexpr size_t kBgra8ColorLutTarget = kOutputPixelFormatCount + 1;
+constexpr size_t kProcessingTargetCount = kOutputPixelFormatCount + 2;
+constexpr size_t kProcessingVariantCount = kProcessingTargetCount * kPathVariantCount;
+
+constexpr size_t PathVariantFor(bool useHdrPath, ToneMapOperator op) {
+    return useHdrPath ? 1 + static_cast<size_t>(op) : kSdrPathVariant;
+}
+
+// 色彩管理查找表作用在显示编码的信号值上，只有 BGRA8 输出使用；RGBA16F 输出保持线性 sRGB，
+// 带增益图的输出是 Ultra HDR 的 sRGB 基础图像，同样不使用
+constexpr size_t ProcessingTargetFor(OutputPixelFormat format, bool colorLut) {
+    return colorLut && format == OutputPixelFormat::Bgra8 ? kBgra8ColorLutTarget : static_cast<size_t>(format);
+}
+
+constexpr size_t ProcessingVariantFor(size_t target, bool useHdrPath, ToneMapOperator op) {
+    return target * kPathVariantCount + PathVariantFor(useHdrPath, op);
+}
+
+constexpr size_t ProcessingVariantFor(OutputPixelFormat format, bool useHdrPath, ToneMapOperator op) {
+    return ProcessingVariantFor(static_cast<size_t>(format), useHdrPath, op);
+}
+
+// 重采样 program 变体 = 滤波器 × 阶段；阶段 0 为水平 pass，其后 BGRA8 与 RGBA16F 各一个垂直 pass，
+// 最后是经过色彩管理查找表的 BGRA8 垂直 pass。增益图需要色调映射前的颜色，带增益图的输出不支持缩放
+constexpr size_t kResampleHorizontalStage = 0;
+constexpr size_t kResampleOutputFormatCount = 2;
+constexpr size_t kResampleBgra8ColorLutStage = 1 + kResampleOutputFormatCount;
+constexpr size_t kResampleStageCount = 2 + kResampleOutputFormatCount;
+constexpr size_t kScaleFilterCount = 2;
+constexpr size_t kResampleVariantCount = kScaleFilterCount * kResampleStageCount;
+
+constexpr size_t ResampleVariantFor(ScaleFilter filter, size_t stage) {
+    return static_cast<size_t>(filter) * kResampleStageCount + stage;
+}
+
+constexpr size_t ResampleVerticalStage(OutputPixelFormat format, bool colorLut = false) {
+    return colorLut && format == OutputPixelFormat::Bgra8 ? kResampleBgra8ColorLutStage
+                                                          : 1 + static_cast<size_t>(format);
+}
+
+// 片元后端 program 变体 = 是否使用色彩管理查找表 × 路径
+constexpr size_t kFragmentVariantCount = 2 * kPathVariantCount;
+
+constexpr size_t FragmentVariantFor(size_t path, bool colorLut) { return (colorLut ? kPathVariantCount : 0) + path; }
+
+// 计算着色器（GLSL ES 3.10）
+ShaderSource DetectionShader(size_t kernel);
+ShaderSource ProcessingShader(size_t variant, size_t kernel);
+ShaderSource ReduceShader();
+// 整帧检测 tile 索引（16x16 工作组，每个 invocation 一个像素）
+ShaderSource TileDetectionShader();
+// 整帧亮度统计的块内求和面积表（见 FrameStatisticsTiles，每个工作组一个块）
+ShaderSource FrameStatisticsShader();
+ShaderSource ResampleShader(size_t variant);
+// 打码（见 ConversionOptions::redactions）：可分离高斯模糊的两个方向，马赛克。结果写入 patch 纹理，
+// 检测、处理与局部色调映射读取源帧时以 patch 覆盖矩形内的像素
+ShaderSource RedactionBlurShader(bool vertical);
+ShaderSource RedactionMosaicShader();
+// 局部色调映射（见 ConversionOptions::localToneMapping）：建立双边网格，模糊网格，按网格压缩选区
+enum class LocalToneMapStage : size_t { Grid, Blur, Apply };
+constexpr size_t kLocalToneMapStageCount = 3;
+ShaderSource LocalToneMapShader(LocalToneMapStage stage);
+
+// 多区域批量转换（16x16 工作组，每个 invocation 一个像素）：检测只有一个变体；
+// 处理按色调映射算子区分，SDR/HDR 路径与输出格式由每个区域的数据决定
+ShaderSource RegionDetectionShader();
+ShaderSource RegionProcessingShader(ToneMapOperator op);
+
+// 片元后端（GLSL ES 3.00）：共用全屏三角形顶点着色器，片元后端只有 BGRA8 一种输出，变体见 FragmentVariantFor
+ShaderSource FullscreenVertexShader();
+ShaderSource FragmentDetectionShader();
+ShaderSource FragmentProcessingShader(size_t variant);
+
+// 传递函数查找表的 GPU 校验（GLSL ES 3.00），与全屏三角形顶点着色器配合，见 OutputModule::VerifyTransferLut
+ShaderSource TransferLutCheckShader();
+
+// 预览窗口（GLSL ES 3.00）：共用一个顶点着色器，片元着色器按绘制内容区分
+enum class PreviewStage : size_t { Image, Dim, Border };
+constexpr size_t kPreviewStageCount = 3;
+ShaderSource PreviewVertexShader();
+ShaderSource PreviewFragmentShader(PreviewStage stage);
+
+// Vulkan 计算后端（GLSL 4.50，运行时由 shaderc 编译为 SPIR-V）：16x16 工作组，每个 invocation 一个像素。
+// 检测以 subgroupMax 归约出选区峰值；处理在设备上按峰值选择路径，变体 = 输出格式 × 色调映射算子
+constexpr size_t kVulkanProcessingVariantCount = kOutputPixelFormatCount * kToneMapOperatorCount;
+
+constexpr size_t VulkanProcessingVariantFor(OutputPixelFormat format, ToneMapOperator op) {
+    return static_cast<size_t>(format) * kToneMapOperatorCount + static_cast<size_t>(op);
+}
+
+ShaderSource VulkanDetectionShader();
+ShaderSource VulkanProcessingShader(size_t variant);
+
+// 一个可链接的 program：computeShader 非空时为计算 program，否则由顶点与片元着色器组成
+struct ProgramSource {
+    std::string name;
+    ShaderSource computeShader;
+    ShaderSource vertexShader;
+    ShaderSource fragmentShader;
+};
+
+// 运行时可能用到的全部 program，供构建期校验
+std::vector<ProgramSource> AllPrograms();
+
+// Vulkan 后端的全部 program：GLES 驱动无法编译，不在 AllPrograms 中；PRINTSCR_VULKAN 构建时由校验工具用 shaderc 编译
+std::vector<ProgramSource> VulkanPrograms();
+
+} // namespace ShaderLibrary
@@ -0,0 +1,160 @@
+#include "SpeculativeConverter.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+
+// 只比较规范化后的矩形，拖拽方向不同的同一选区视为相同
+bool SameRect(const std::optional<SelectionRect> &a, const SelectionRect &b) {
+    return a && a->Left() == b.Left() && a->Top() == b.Top() && a->Right() == b.Right() && a->Bottom() == b.Bottom();
+}
+
+std::string DescribeRect(const SelectionRect &rect) {
+    return "(" + std::to_string(rect.Left()) + "," + std::to_string(rect.Top()) + ")-(" + std::to_string(rect.Right()) +
+           "," + std::to_string(rect.Bottom()) + ")";
+}
+
+class SpeculativeConverterImpl final : public SpeculativeConverter {
+public:
+    SpeculativeConverterImpl(OutputModule &outputModule, std::shared_ptr<const GpuFrame> gpuFrame,
+                             const DisplayHdrInfo &hdrInfo, const ConversionOptions &options,
+                             OutputPixelFormat format)
+        : m_outputModule(outputModule), m_gpuFrame(std::move(gpuFrame)), m_hdrInfo(hdrInfo), m_options(options),
+          m_format(format) {
+        m_worker = std::thread([this] { WorkerLoop(); });
+    }
+
+    ~SpeculativeConverterImpl() override {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_pending.reset();
+        }
+        m_changed.notify_all();
+        m_worker.join();
+    }
+
+    void Request(const SelectionRect &selection) override {
+        if (!selection.IsValid()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (SameRect(m_pending, selection) || SameRect(m_readyRect, selection) ||
+                (SameRect(m_converting, selection) && m_convertingGeneration == m_generation)) {
+                return;
+            }
+            // 使正在进行的转换失效，替换尚未开始的请求
+            ++m_generation;
+            m_readyRect.reset();
+            m_ready = {};
+            m_pending = selection;
+        }
+        m_changed.notify_all();
+    }
+
+    bool TryTake(const SelectionRect &selection, ImageSink &sink) override {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const bool formatMatches = sink.PreferredFormat() == m_format;
+        if (formatMatches) {
+            // 同一矩形已排队或正在转换：等待它比重新转换更快
+            m_changed.wait(lock, [&] {
+                return !SameRect(m_pending, selection) &&
+                       !(SameRect(m_converting, selection) && m_convertingGeneration == m_generation);
+            });
+        }
+
+        std::optional<ConvertedImage> image;
+        if (formatMatches && SameRect(m_readyRect, selection)) {
+            image = std::move(m_ready);
+        }
+        ++m_generation;
+        m_pending.reset();
+        m_readyRect.reset();
+        m_ready = {};
+        m_changed.wait(lock, [&] { return !m_converting; });
+        lock.unlock();
+
+        if (!image) {
+            LOG("Speculative conversion: no result for " + DescribeRect(selection) + ", converting on demand.");
+            return false;
+        }
+        LOG("Speculative conversion: reusing result for " + DescribeRect(selection) + ".");
+        image->ReplayInto(sink);
+        return true;
+    }
+
+private:
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_changed.wait(lock, [&] { return m_stopping || m_pending; });
+            if (m_stopping) {
+                return;
+            }
+            const SelectionRect selection = *m_pending;
+            m_pending.reset();
+            m_converting = selection;
+            m_convertingGeneration = m_generation;
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            MemorySink sink(m_format);
+            bool succeeded = true;
+            try {
+                m_outputModule.ConvertSelectionToSinks(*m_gpuFrame, selection, m_hdrInfo, m_options,
+                                                       {ScaledOutput{m_options.clipboardScale, &sink}});
+            } catch (const std::exception &ex) {
+                LOG("Speculative conversion failed: " + std::string(ex.what()));
+                succeeded = false;
+            }
+            const double elapsedMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            if (succeeded && m_convertingGeneration == m_generation) {
+                m_readyRect = selection;
+                m_ready = std::move(sink.Image());
+                LOG("Speculative conversion: " + DescribeRect(selection) + " ready in " + std::to_string(elapsedMs) +
+                    " ms.");
+            } else if (succeeded) {
+                LOG("Speculative conversion: discarded stale result for " + DescribeRect(selection) + ".");
+            }
+            m_converting.reset();
+            m_changed.notify_all();
+        }
+    }
+
+    OutputModule &m_outputModule;
+    std::shared_ptr<const GpuFrame> m_gpuFrame;
+    DisplayHdrInfo m_hdrInfo;
+    ConversionOptions m_options;
+    OutputPixelFormat m_format;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::optional<SelectionRect> m_pending;    // 尚未开始的最新请求
+    std::optional<SelectionRect> m_converting; // 后台线程正在转换的矩形
+    uint64_t m_convertingGeneration = 0;       // 与 m_generation 不同表示转换结果已过时
+    uint64_t m_generation = 0;
+    std::optional<SelectionRect> m_readyRect;
+    ConvertedImage m_ready;
+    bool m_stopping = false;
+    std::thread m_worker;
+};
+
+} // namespace
+
+std::unique_ptr<SpeculativeConverter> SpeculativeConverter::Create(OutputModule &outputModule,
+                                                                   std::shared_ptr<const GpuFrame> gpuFrame,
+                                                                   const DisplayHdrInfo &hdrInfo,
+                                                                   const ConversionOptions &options,
+                                                                   OutputPixelFormat format) {
+    return std::make_unique<SpeculativeConverterImpl>(outputModule, std::move(gpuFrame), hdrInfo, options, format);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GpuFrame.h"
+#include "ImageSink.h"
+#include "OutputModule.h"
+#include "SelectionRect.h"
+#include "SystemInfo.h"
+
+#include <memory>
+
+// 预览期间的推测转换：选区稳定（松开鼠标）时在后台线程按剪贴板输出的参数转换当前选区，结果保存在内存中。
+// 用户确认同一矩形时直接把已转换的像素交给 sink，确认延迟只剩一次内存拷贝。
+// 新的请求会取消尚未开始的旧请求；已经开始的转换无法中断，完成后结果被丢弃。
+// 生存期内由后台线程独占 OutputModule（它不是线程安全的），调用方在 TryTake 返回或本对象销毁后才能再使用它
+class SpeculativeConverter {
+public:
+    virtual ~SpeculativeConverter() = default;
+
+    // 选区稳定时调用，与最近一次请求的矩形相同时不做任何事
+    virtual void Request(const SelectionRect &selection) = 0;
+
+    // 有与 selection 相同矩形的结果（含正在转换中的，会等待其完成）且格式与 sink 一致时写入 sink 并返回 true；
+    // 否则丢弃全部推测结果并返回 false。返回时后台线程已空闲
+    virtual bool TryTake(const SelectionRect &selection, ImageSink &sink) = 0;
+
+    // 以 options.clipboardScale 的尺寸、format 格式输出
+    static std::unique_ptr<SpeculativeConverter> Create(OutputModule &outputModule,
+                                                        std::shared_ptr<const GpuFrame> gpuFrame,
+                                                        const DisplayHdrInfo &hdrInfo,
+                                                        const ConversionOptions &options, OutputPixelFormat format);
+};
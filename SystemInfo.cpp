@@ -45,6 +45,8 @@ DisplayHdrInfo SystemInfo::GetPrimaryDisplayHdrInfo() {
             info.minLuminance = desc.MinLuminance;
             info.peakBrightness = desc.MaxLuminance;
             info.maxFullFrameLuminance = desc.MaxFullFrameLuminance;
+            info.hdrEnabled = desc.ColorSpace == DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020;
+            info.bitsPerColor = desc.BitsPerColor;
 
             // Note: SDR White Level is trickier to get.
             // It's usually found in the registry or via some more modern APIs.
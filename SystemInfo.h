@@ -6,6 +6,8 @@ struct DisplayHdrInfo {
     float minLuminance;          // in nits
     float maxLuminance;          // in nits
     float maxFullFrameLuminance; // in nits
+    bool hdrEnabled = false;     // 显示器处于 HDR 模式（PQ / BT.2020 色彩空间）
+    unsigned bitsPerColor = 8;   // 显示器输出的每通道位数
 };
 
 class SystemInfo {
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ToneMapping.h"
+
+#include <array>
+
+// 各色调映射算子的 GLSL 片段（定义 `vec3 ToneMap(vec3 scRgb)`，约定见 ToneMapping.h）。
+// 放在头文件中以便 ShaderLibrary 在编译期把它们拼进着色器变体；运行时注册表也引用同一份文本。
+namespace ToneMapShaders {
+
+inline constexpr const char *kHlgRoundTrip = R"(
+vec3 ToneMap(vec3 scRgb) {
+    vec3 bt2020Linear = SrgbLinearToBt2020Linear(scRgb);
+    // Windows advanced color scRGB capture is absolute-referred:
+    // a linear value of 1.0 corresponds to 80 nits.
+    // HLG OETF 与 BT.1886 EOTF 合并为同一条查找表曲线
+    vec3 interpretedLinear = SampleTransfer(kCurveHlgToDisplayLinear,
+                                            bt2020Linear * (kScRgbReferenceWhiteNits / kReferencePeakNits));
+    vec3 bt709Linear = Bt2020LinearToBt709Linear(interpretedLinear);
+    return SampleTransfer(kCurveBt1886Oetf, bt709Linear);
+}
+)";
+
+// ITU-R BT.2390 EETF：在 PQ 域中把 [0, 显示器峰值] 压到 [0, SDR 白点]，
+// 作用于 max(R, G, B) 并按比例缩放三通道以保持色相
+inline constexpr const char *kBt2390Eetf = R"(
+const float kPqM1 = 0.1593017578125;
+const float kPqM2 = 78.84375;
+const float kPqC1 = 0.8359375;
+const float kPqC2 = 18.8515625;
+const float kPqC3 = 18.6875;
+const float kPqPeakNits = 10000.0;
+
+float PqEncodeNits(float nits) {
+    float y = pow(clamp(nits / kPqPeakNits, 0.0, 1.0), kPqM1);
+    return pow((kPqC1 + kPqC2 * y) / (1.0 + kPqC3 * y), kPqM2);
+}
+
+float PqDecodeNits(float signal) {
+    float e = pow(clamp(signal, 0.0, 1.0), 1.0 / kPqM2);
+    return pow(max(e - kPqC1, 0.0) / (kPqC2 - kPqC3 * e), 1.0 / kPqM1) * kPqPeakNits;
+}
+
+vec3 ToneMap(vec3 scRgb) {
+    float maxChannel = max(max(scRgb.r, scRgb.g), scRgb.b);
+    if (maxChannel <= 0.0) {
+        return vec3(0.0);
+    }
+
+    float sourcePq = PqEncodeNits(max(u_sourcePeak, u_lw) * kScRgbReferenceWhiteNits);
+    float maxLum = PqEncodeNits(u_lw * kScRgbReferenceWhiteNits) / sourcePq;
+    float ks = max(1.5 * maxLum - 0.5, 0.0);
+
+    float e1 = min(PqEncodeNits(maxChannel * kScRgbReferenceWhiteNits) / sourcePq, 1.0);
+    float e2 = e1;
+    if (e1 > ks) {
+        float t = (e1 - ks) / (1.0 - ks);
+        float t2 = t * t;
+        float t3 = t2 * t;
+        e2 = (2.0 * t3 - 3.0 * t2 + 1.0) * ks + (t3 - 2.0 * t2 + t) * (1.0 - ks) + (-2.0 * t3 + 3.0 * t2) * maxLum;
+    }
+
+    float mappedNits = PqDecodeNits(e2 * sourcePq);
+    vec3 mapped = scRgb * (mappedNits / (maxChannel * kScRgbReferenceWhiteNits));
+    return SampleTransfer(kCurveLinearToSrgb, mapped / u_lw);
+}
+)";
+
+// Reinhard extended，作用于亮度，白点取显示器峰值
+inline constexpr const char *kReinhardExtended = R"(
+vec3 ToneMap(vec3 scRgb) {
+    vec3 normalized = scRgb / u_lw;
+    float luminance = dot(normalized, vec3(0.2126, 0.7152, 0.0722));
+    if (luminance <= 0.0) {
+        return vec3(0.0);
+    }
+    float whitePoint = max(u_sourcePeak / u_lw, 1.0);
+    float mapped = luminance * (1.0 + luminance / (whitePoint * whitePoint)) / (1.0 + luminance);
+    return SampleTransfer(kCurveLinearToSrgb, normalized * (mapped / luminance));
+}
+)";
+
+// Narkowicz 的 ACES filmic 拟合曲线，逐通道
+inline constexpr const char *kAcesFit = R"(
+const float kAcesExposure = 0.6;
+
+vec3 ToneMap(vec3 scRgb) {
+    vec3 x = scRgb / u_lw * kAcesExposure;
+    vec3 mapped = (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14);
+    return SampleTransfer(kCurveLinearToSrgb, mapped);
+}
+)";
+
+inline constexpr const char *kHardClip = R"(
+vec3 ToneMap(vec3 scRgb) {
+    return SampleTransfer(kCurveLinearToSrgb, scRgb / u_lw);
+}
+)";
+
+// 按 ToneMapOperator 的值索引
+inline constexpr std::array<const char *, kToneMapOperatorCount> kSources = {
+    kHlgRoundTrip, kBt2390Eetf, kReinhardExtended, kAcesFit, kHardClip,
+};
+
+} // namespace ToneMapShaders
@@ -0,0 +1,41 @@
+#include "ToneMapping.h"
+#include "ToneMapShaders.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const std::array<ToneMapOperatorInfo, kToneMapOperatorCount> kOperators = {{
+    {ToneMapOperator::HlgRoundTrip, "hlg", "HLG round trip", ToneMapShaders::kHlgRoundTrip},
+    {ToneMapOperator::Bt2390Eetf, "bt2390", "BT.2390 EETF", ToneMapShaders::kBt2390Eetf},
+    {ToneMapOperator::ReinhardExtended, "reinhard", "Reinhard extended", ToneMapShaders::kReinhardExtended},
+    {ToneMapOperator::AcesFit, "aces", "ACES fit", ToneMapShaders::kAcesFit},
+    {ToneMapOperator::HardClip, "clip", "Hard clip", ToneMapShaders::kHardClip},
+}};
+
+} // namespace
+
+const std::array<ToneMapOperatorInfo, kToneMapOperatorCount> &GetToneMapOperators() { return kOperators; }
+
+const ToneMapOperatorInfo &GetToneMapOperatorInfo(ToneMapOperator op) {
+    const size_t index = static_cast<size_t>(op);
+    if (index >= kOperators.size()) {
+        throw std::out_of_range("Unknown tone-mapping operator");
+    }
+    return kOperators[index];
+}
+
+std::optional<ToneMapOperator> ParseToneMapOperator(std::string_view name) {
+    std::string lowered(name);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (const auto &info : kOperators) {
+        if (lowered == info.name) {
+            return info.op;
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// HDR→SDR 色调映射算子注册表。
+// 每个算子提供一段定义 `vec3 ToneMap(vec3 scRgb)` 的 GLSL 片段（ToneMapShaders.h），由 ShaderLibrary
+// 在编译期组合进处理着色器，每个算子是独立的 program 变体，运行时不再按像素分支。
+//
+// ToneMap 的输入为 scRGB 线性值（1.0 = 80 nits），输出为已做 gamma 编码的 BT.709 信号。
+// 片段可以使用处理着色器公共部分提供的以下内容：
+//   u_lw          SDR 白点对应的 scRGB 线性值
+//   u_sourcePeak  显示器峰值亮度对应的 scRGB 线性值
+//   SampleTransfer / SrgbLinearToBt2020Linear / Bt2020LinearToBt709Linear 及 kCurve* 常量
+enum class ToneMapOperator : uint32_t {
+    HlgRoundTrip     = 0,
+    Bt2390Eetf       = 1,
+    ReinhardExtended = 2,
+    AcesFit          = 3,
+    HardClip         = 4,
+};
+
+constexpr size_t kToneMapOperatorCount = 5;
+
+struct ToneMapOperatorInfo {
+    ToneMapOperator op;
+    const char *name;        // 命令行使用的短名
+    const char *displayName;
+    const char *glslSource;
+};
+
+const std::array<ToneMapOperatorInfo, kToneMapOperatorCount> &GetToneMapOperators();
+const ToneMapOperatorInfo &GetToneMapOperatorInfo(ToneMapOperator op);
+std::optional<ToneMapOperator> ParseToneMapOperator(std::string_view name);
@@ -0,0 +1,158 @@
+#include "TransferLut.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace TransferLut {
+
+namespace {
+
+const std::array<uint16_t, kSize> &TableFor(Curve curve) {
+    switch (curve) {
+    case Curve::HlgToDisplayLinear:
+        return kHlgToDisplayLinearTable;
+    case Curve::Bt1886Oetf:
+        return kBt1886OetfTable;
+    case Curve::LinearToSrgb:
+    default:
+        return kLinearToSrgbTable;
+    }
+}
+
+// 精确参考实现，刻意不复用头文件中的 constexpr 版本，以便同时校验编译期数学函数
+double ExactHlgOetf(double x) {
+    x = std::clamp(x, 0.0, 1.0);
+    if (x <= 1.0 / 12.0) {
+        return std::sqrt(3.0 * x);
+    }
+    return kHlgA * std::log(12.0 * x - kHlgB) + kHlgC;
+}
+
+double ExactBt1886Oetf(double x) { return std::pow(std::clamp(x, 0.0, 1.0), 1.0 / kBt1886Gamma); }
+
+double ExactEvaluate(Curve curve, double x) {
+    switch (curve) {
+    case Curve::HlgToDisplayLinear:
+        return std::pow(std::clamp(ExactHlgOetf(x), 0.0, 1.0), kBt1886Gamma);
+    case Curve::Bt1886Oetf:
+        return ExactBt1886Oetf(x);
+    case Curve::LinearToSrgb: {
+        x = std::clamp(x, 0.0, 1.0);
+        if (x <= kSrgbLinearThreshold) {
+            return x * kSrgbLowSlope;
+        }
+        return kSrgbHighScale * std::pow(x, 1.0 / 2.4) - kSrgbHighOffset;
+    }
+    }
+    return 0.0;
+}
+
+double ExactChain(Chain chain, double x) {
+    switch (chain) {
+    case Chain::LinearToSrgb:
+        return ExactEvaluate(Curve::LinearToSrgb, x);
+    case Chain::Bt1886Oetf:
+        return ExactEvaluate(Curve::Bt1886Oetf, x);
+    case Chain::HlgRoundTrip:
+        return ExactBt1886Oetf(ExactEvaluate(Curve::HlgToDisplayLinear, x));
+    }
+    return 0.0;
+}
+
+// 与 CpuConversion / 着色器相同：HLG 往返两次查表，误差会累积
+double SampleChain(Chain chain, float x) {
+    switch (chain) {
+    case Chain::LinearToSrgb:
+        return Sample(Curve::LinearToSrgb, x);
+    case Chain::Bt1886Oetf:
+        return Sample(Curve::Bt1886Oetf, x);
+    case Chain::HlgRoundTrip:
+        return Sample(Curve::Bt1886Oetf, Sample(Curve::HlgToDisplayLinear, x));
+    }
+    return 0.0;
+}
+
+int ToCode(double signal) { return static_cast<int>(std::lround(std::clamp(signal, 0.0, 1.0) * 255.0)); }
+
+// approx(chain, pass, index, x) 返回近似的最终信号值
+template <typename Approx> VerifyReport Measure(Approx approx) {
+    VerifyReport report{};
+    report.withinBudget = true;
+    for (size_t i = 0; i < kChainCount; ++i) {
+        const Chain chain = static_cast<Chain>(i);
+        ChainReport &chainReport = report.chains[i];
+        chainReport.chain = chain;
+        for (int pass = 0; pass < kVerifyPasses; ++pass) {
+            for (int s = 0; s <= kVerifySamples; ++s) {
+                const float x = VerifyInput(pass, s);
+                const double exactSignal = ExactChain(chain, x);
+                const double approxSignal = approx(chain, pass, s, x);
+
+                const int codeError = std::abs(ToCode(exactSignal) - ToCode(approxSignal));
+                const double fractionalError = std::abs(exactSignal - approxSignal) * 255.0;
+                chainReport.maxCodeError = (std::max)(chainReport.maxCodeError, codeError);
+                chainReport.maxFractionalError = (std::max)(chainReport.maxFractionalError, fractionalError);
+            }
+        }
+        if (chainReport.maxCodeError > kMaxCodeError) {
+            report.withinBudget = false;
+        }
+    }
+    return report;
+}
+
+} // namespace
+
+std::array<uint16_t, kSize * kCurveCount> BuildTextureData() {
+    std::array<uint16_t, kSize * kCurveCount> data{};
+    for (size_t row = 0; row < kCurveCount; ++row) {
+        const auto &table = TableFor(static_cast<Curve>(row));
+        std::copy(table.begin(), table.end(), data.begin() + row * kSize);
+    }
+    return data;
+}
+
+float Sample(Curve curve, float linearValue) {
+    const auto &table = TableFor(curve);
+    const float t = std::sqrt(std::clamp(linearValue, 0.0f, 1.0f));
+    const float position = t * static_cast<float>(kSize - 1);
+    const size_t index = (std::min)(static_cast<size_t>(position), kSize - 2);
+    const float fraction = position - static_cast<float>(index);
+    const float a = HalfToFloat(table[index]);
+    const float b = HalfToFloat(table[index + 1]);
+    return a + (b - a) * fraction;
+}
+
+VerifyReport Verify() {
+    return Measure([](Chain chain, int, int, float x) { return SampleChain(chain, x); });
+}
+
+VerifyReport VerifyCodes(const std::function<int(Chain chain, int pass, int index)> &codes) {
+    return Measure([&](Chain chain, int pass, int index, float) { return codes(chain, pass, index) / 255.0; });
+}
+
+const char *CurveName(Curve curve) {
+    switch (curve) {
+    case Curve::HlgToDisplayLinear:
+        return "HlgToDisplayLinear";
+    case Curve::Bt1886Oetf:
+        return "Bt1886Oetf";
+    case Curve::LinearToSrgb:
+        return "LinearToSrgb";
+    }
+    return "Unknown";
+}
+
+const char *ChainName(Chain chain) {
+    switch (chain) {
+    case Chain::LinearToSrgb:
+        return "LinearToSrgb";
+    case Chain::Bt1886Oetf:
+        return "Bt1886Oetf";
+    case Chain::HlgRoundTrip:
+        return "HlgToDisplayLinear+Bt1886Oetf";
+    }
+    return "Unknown";
+}
+
+} // namespace TransferLut
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// 传递函数查找表：把处理着色器中逐像素、逐通道的 pow/log/sqrt 换成一次纹理采样。
+// 所有表均在编译期（constexpr）生成，GPU 与 CPU 路径共用同一份数据。
+//
+// 表以 t = sqrt(x) 为索引而不是 x 本身：HLG 的 sqrt 段与 x^(1/2.4) 在 0 附近斜率发散，
+// 线性索引的前几个区间误差会达到数个 8-bit 码值；换成 sqrt 域后曲线足够平滑，
+// 256 个采样点配合线性插值即可把误差控制在 kMaxCodeError 以内（见 Verify 与 OutputModule::VerifyTransferLut）。
+namespace TransferLut {
+
+constexpr size_t kSize = 256;
+
+// 允许的最大 8-bit 输出码值误差
+constexpr int kMaxCodeError = 1;
+
+enum class Curve : uint32_t {
+    HlgToDisplayLinear = 0, // Bt1886Eotf(HlgOetf(x))，HLG 路径的前半段
+    Bt1886Oetf         = 1, // x^(1/2.4)
+    LinearToSrgb       = 2, // sRGB OETF
+};
+
+constexpr size_t kCurveCount = 3;
+
+constexpr double kBt1886Gamma = 2.4;
+constexpr double kHlgA = 0.17883277;
+constexpr double kHlgB = 1.0 - 4.0 * kHlgA;
+constexpr double kHlgC = 0.55991073;
+constexpr double kSrgbLinearThreshold = 0.0031308;
+constexpr double kSrgbLowSlope = 12.92;
+constexpr double kSrgbHighScale = 1.055;
+constexpr double kSrgbHighOffset = 0.055;
+
+// IEEE 754 binary16 编码，就近舍入到偶数，与 packHalf2x16 一致；超出范围（含 Inf/NaN）时钳制到最大有限值。
+// 查找表、CPU 后端的 RGBA16F 输出与色彩管理查找表共用
+constexpr uint16_t FloatToHalf(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    bits &= 0x7FFFFFFFu;
+    if (bits >= 0x477FF000u) {
+        return sign | 0x7BFFu;
+    }
+    if (bits < 0x38800000u) {
+        // 低于最小规格化数（含 0）：以 2^-24 为单位就近舍入到偶数
+        const uint32_t exponent = bits >> 23;
+        if (exponent < 102) {
+            return sign;
+        }
+        const uint32_t mantissa = (bits & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126 - exponent;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        uint32_t result = mantissa >> shift;
+        if (remainder > halfway || (remainder == halfway && (result & 1u) != 0)) {
+            ++result;
+        }
+        return sign | static_cast<uint16_t>(result);
+    }
+    bits += 0xC8000FFFu + ((bits >> 13) & 1u); // 指数减去 112，尾数就近舍入到偶数
+    return sign | static_cast<uint16_t>(bits >> 13);
+}
+
+// binary16 解码，保留 Inf/NaN
+constexpr float HalfToFloat(uint16_t half) {
+    const uint32_t sign = (half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1Fu;
+    const uint32_t mantissa = half & 0x3FFu;
+    if (exponent == 0) {
+        const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign != 0 ? -value : value;
+    }
+    if (exponent == 0x1Fu) {
+        return std::bit_cast<float>(sign | 0x7F800000u | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23) | (mantissa << 13));
+}
+
+namespace detail {
+
+constexpr double kLn2 = 0.693147180559945309417;
+
+constexpr double Clamp01(double value) { return value < 0.0 ? 0.0 : (value > 1.0 ? 1.0 : value); }
+
+constexpr double Sqrt(double value) {
+    if (value <= 0.0) {
+        return 0.0;
+    }
+    double guess = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 64; ++i) {
+        const double next = 0.5 * (guess + value / guess);
+        if (next == guess) {
+            break;
+        }
+        guess = next;
+    }
+    return guess;
+}
+
+// ln(x) = e·ln2 + 2·atanh((m-1)/(m+1))，m ∈ [1, 2)
+constexpr double Log(double value) {
+    int exponent = 0;
+    while (value >= 2.0) {
+        value *= 0.5;
+        ++exponent;
+    }
+    while (value < 1.0) {
+        value *= 2.0;
+        --exponent;
+    }
+    const double y = (value - 1.0) / (value + 1.0);
+    const double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 200; n += 2) {
+        const double add = term / n;
+        if (add < 1e-18) {
+            break;
+        }
+        sum += add;
+        term *= y2;
+    }
+    return exponent * kLn2 + 2.0 * sum;
+}
+
+// e^x = 2^k · e^r，|r| <= ln2/2
+constexpr double Exp(double value) {
+    const int k = static_cast<int>(value / kLn2 + (value >= 0.0 ? 0.5 : -0.5));
+    const double r = value - k * kLn2;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 40; ++n) {
+        term *= r / n;
+        sum += term;
+        if ((term < 0.0 ? -term : term) < 1e-18) {
+            break;
+        }
+    }
+    for (int i = 0; i < k; ++i) {
+        sum *= 2.0;
+    }
+    for (int i = 0; i > k; --i) {
+        sum *= 0.5;
+    }
+    return sum;
+}
+
+constexpr double Pow(double base, double exponent) { return base <= 0.0 ? 0.0 : Exp(exponent * Log(base)); }
+
+} // namespace detail
+
+constexpr double HlgOetf(double linearValue) {
+    linearValue = detail::Clamp01(linearValue);
+    if (linearValue <= (1.0 / 12.0)) {
+        return detail::Sqrt(3.0 * linearValue);
+    }
+    return kHlgA * detail::Log(12.0 * linearValue - kHlgB) + kHlgC;
+}
+
+constexpr double Bt1886Eotf(double signalValue) { return detail::Pow(detail::Clamp01(signalValue), kBt1886Gamma); }
+
+constexpr double Bt1886Oetf(double linearValue) {
+    return detail::Pow(detail::Clamp01(linearValue), 1.0 / kBt1886Gamma);
+}
+
+constexpr double LinearToSrgb(double linearValue) {
+    linearValue = detail::Clamp01(linearValue);
+    if (linearValue <= kSrgbLinearThreshold) {
+        return linearValue * kSrgbLowSlope;
+    }
+    return kSrgbHighScale * detail::Pow(linearValue, 1.0 / 2.4) - kSrgbHighOffset;
+}
+
+constexpr double Evaluate(Curve curve, double linearValue) {
+    switch (curve) {
+    case Curve::HlgToDisplayLinear:
+        return Bt1886Eotf(HlgOetf(linearValue));
+    case Curve::Bt1886Oetf:
+        return Bt1886Oetf(linearValue);
+    case Curve::LinearToSrgb:
+        return LinearToSrgb(linearValue);
+    }
+    return 0.0;
+}
+
+constexpr std::array<uint16_t, kSize> BuildHalfTable(Curve curve) {
+    std::array<uint16_t, kSize> table{};
+    for (size_t i = 0; i < kSize; ++i) {
+        const double t = static_cast<double>(i) / static_cast<double>(kSize - 1);
+        table[i] = FloatToHalf(static_cast<float>(Evaluate(curve, t * t)));
+    }
+    return table;
+}
+
+// 每条曲线单独求值，避免单个常量表达式超出编译器的 constexpr 步数上限
+inline constexpr std::array<uint16_t, kSize> kHlgToDisplayLinearTable = BuildHalfTable(Curve::HlgToDisplayLinear);
+inline constexpr std::array<uint16_t, kSize> kBt1886OetfTable = BuildHalfTable(Curve::Bt1886Oetf);
+inline constexpr std::array<uint16_t, kSize> kLinearToSrgbTable = BuildHalfTable(Curve::LinearToSrgb);
+
+// 按 Curve 顺序拼成 kSize × kCurveCount 的 R16F 纹理数据，每条曲线占一行
+std::array<uint16_t, kSize * kCurveCount> BuildTextureData();
+
+// CPU 路径使用的查表函数，与着色器中的 SampleTransfer 采用相同的索引与插值方式
+float Sample(Curve curve, float linearValue);
+
+// 着色器中从线性值到最终信号值的查表链：SDR 路径与各算子的 sRGB 编码、HLG 往返算子的两次查表
+// （HLG OETF + BT.1886 EOTF，再 BT.1886 OETF，中间的色域矩阵对灰阶为恒等）；单独的 BT.1886 OETF 一并校验
+enum class Chain : uint32_t {
+    LinearToSrgb = 0,
+    Bt1886Oetf = 1,
+    HlgRoundTrip = 2,
+};
+
+constexpr size_t kChainCount = 3;
+
+// 校验的输入序列：两遍各 kVerifySamples + 1 个点，第 2 遍取平方，使暗部（sqrt 域中较稀疏）同样被充分覆盖。
+// GPU 校验按同样的下标生成输入
+constexpr int kVerifySamples = 1 << 18;
+constexpr int kVerifyPasses = 2;
+
+constexpr float VerifyInput(int pass, int index) {
+    const float x = static_cast<float>(index) / static_cast<float>(kVerifySamples);
+    return pass == 1 ? x * x : x;
+}
+
+struct ChainReport {
+    Chain chain;
+    int maxCodeError;          // 最终 8-bit 码值的最大差
+    double maxFractionalError; // 以码值为单位的最大连续误差；只有码值时（GPU 读回）包含量化误差
+};
+
+struct VerifyReport {
+    std::array<ChainReport, kChainCount> chains;
+    bool withinBudget;
+};
+
+// 以 std::pow/std::log 的精确结果为基准，逐条链比较 CPU 查表（Sample 串联）的最终信号值
+VerifyReport Verify();
+
+// 同上，近似结果为 codes(chain, pass, index) 给出的 8-bit 码值，用于校验 GPU 采样后读回的结果
+VerifyReport VerifyCodes(const std::function<int(Chain chain, int pass, int index)> &codes);
+
+const char *CurveName(Curve curve);
+const char *ChainName(Chain chain);
+
+} // namespace TransferLut
@@ -0,0 +1,124 @@
+#include "TuningCache.h"
+#include "Logger.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+constexpr const char *kCacheHeader = "# printscr tuning cache v1";
+
+// 字段内不允许出现分隔符
+std::string Sanitize(std::string text) {
+    for (char &c : text) {
+        if (c == '\t' || c == '\n' || c == '\r') {
+            c = ' ';
+        }
+    }
+    return text;
+}
+
+#ifdef _WIN32
+std::filesystem::path EnvironmentPath(const wchar_t *name) {
+    const wchar_t *value = _wgetenv(name);
+    return value && *value ? std::filesystem::path(value) : std::filesystem::path();
+}
+#else
+std::filesystem::path EnvironmentPath(const char *name) {
+    const char *value = std::getenv(name);
+    return value && *value ? std::filesystem::path(value) : std::filesystem::path();
+}
+#endif
+
+} // namespace
+
+std::filesystem::path TuningCache::DefaultPath() {
+#ifdef _WIN32
+    if (auto overridePath = EnvironmentPath(L"PRINTSCR_TUNING_CACHE"); !overridePath.empty()) {
+        return overridePath;
+    }
+    std::filesystem::path base = EnvironmentPath(L"LOCALAPPDATA");
+#else
+    if (auto overridePath = EnvironmentPath("PRINTSCR_TUNING_CACHE"); !overridePath.empty()) {
+        return overridePath;
+    }
+    std::filesystem::path base = EnvironmentPath("XDG_CACHE_HOME");
+    if (base.empty()) {
+        if (auto home = EnvironmentPath("HOME"); !home.empty()) {
+            base = home / ".cache";
+        }
+    }
+#endif
+    if (base.empty()) {
+        base = std::filesystem::temp_directory_path();
+    }
+    return base / "printscr" / "tuning.tsv";
+}
+
+TuningCache::TuningCache(std::filesystem::path path) : m_path(std::move(path)) { Load(); }
+
+std::optional<std::string> TuningCache::Get(const std::string &section, const std::string &key) const {
+    auto it = m_entries.find({Sanitize(section), Sanitize(key)});
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void TuningCache::Set(const std::string &section, const std::string &key, const std::string &value) {
+    m_entries[{Sanitize(section), Sanitize(key)}] = Sanitize(value);
+    Save();
+}
+
+void TuningCache::Load() {
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) {
+        return;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t first = line.find('\t');
+        const size_t second = first == std::string::npos ? std::string::npos : line.find('\t', first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        m_entries[{line.substr(0, first), line.substr(first + 1, second - first - 1)}] = line.substr(second + 1);
+    }
+}
+
+void TuningCache::Save() const {
+    std::error_code error;
+    std::filesystem::create_directories(m_path.parent_path(), error);
+
+    // 先写临时文件再替换，避免并发的进程读到写了一半的文件
+    std::filesystem::path temporary = m_path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG("TuningCache: cannot write " + temporary.string());
+            return;
+        }
+        file << kCacheHeader << "\n";
+        for (const auto &[key, value] : m_entries) {
+            file << key.first << "\t" << key.second << "\t" << value << "\n";
+        }
+        if (!file) {
+            LOG("TuningCache: failed while writing " + temporary.string());
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, m_path, error);
+    if (error) {
+        LOG("TuningCache: cannot replace " + m_path.string() + ": " + error.message());
+        std::filesystem::remove(temporary, error);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+// 按渲染器保存的调优结果（kernel 排名等）。文件为 UTF-8 文本，每行 "section<TAB>key<TAB>value"，
+// section 通常是 GL_RENDERER 字符串。读写失败只记日志，不影响转换本身。
+class TuningCache {
+public:
+    // PRINTSCR_TUNING_CACHE 环境变量优先；否则 Windows 为 %LOCALAPPDATA%\printscr\tuning.tsv，
+    // 其他平台为 $XDG_CACHE_HOME/printscr/tuning.tsv（默认 ~/.cache）
+    static std::filesystem::path DefaultPath();
+
+    explicit TuningCache(std::filesystem::path path = DefaultPath());
+
+    std::optional<std::string> Get(const std::string &section, const std::string &key) const;
+
+    // 更新并立即写回文件
+    void Set(const std::string &section, const std::string &key, const std::string &value);
+
+    const std::filesystem::path &Path() const { return m_path; }
+
+private:
+    void Load();
+    void Save() const;
+
+    std::filesystem::path m_path;
+    std::map<std::pair<std::string, std::string>, std::string> m_entries;
+};
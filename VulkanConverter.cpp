@@ -0,0 +1,775 @@
+#include "VulkanConverter.h"
+#include "Logger.h"
+#include "ShaderLibrary.h"
+#include "TransferLut.h"
+
+#include <shaderc/shaderc.h>
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 与 ShaderLibrary 中 Vulkan 着色器的 local_size 与 binding 一致
+constexpr uint32_t kWorkgroupSize = 16;
+constexpr uint32_t kSourceBinding = 0;
+constexpr uint32_t kDetectionBinding = 1;
+constexpr uint32_t kOutputBinding = 2;
+constexpr uint32_t kTransferLutBinding = 3;
+
+// 源像素为 R16G16B16A16_FLOAT
+constexpr VkDeviceSize kSourceBytesPerPixel = 8;
+constexpr uint64_t kFenceTimeoutNs = 10'000'000'000ull;
+
+// 与着色器中的 Parameters 块布局一致
+struct PushConstants {
+    int32_t outputSize[2];
+    float lw;
+    float sourcePeak;
+    float threshold;
+};
+
+void Check(VkResult result, const char *what) {
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(std::string(what) + " failed: VkResult " + std::to_string(static_cast<int>(result)));
+    }
+}
+
+double MsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// 缓冲区只增不减；主机可见的缓冲区创建后一直保持映射
+struct Buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void *mapped = nullptr;
+};
+
+std::vector<VkQueueFamilyProperties> GetQueueFamilies(VkPhysicalDevice device) {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, families.data());
+    return families;
+}
+
+// 第一个具备 required 且不具备 excluded 中任何能力的队列族
+std::optional<uint32_t> FindQueueFamily(const std::vector<VkQueueFamilyProperties> &families,
+                                        VkQueueFlags required, VkQueueFlags excluded) {
+    for (uint32_t i = 0; i < families.size(); ++i) {
+        if (families[i].queueCount != 0 && (families[i].queueFlags & required) == required &&
+            (families[i].queueFlags & excluded) == 0) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+class VulkanConverterImpl final : public VulkanConverter {
+public:
+    VulkanConverterImpl() {
+        try {
+            CreateInstance();
+            SelectPhysicalDevice();
+            CreateDevice();
+            CreateCommandObjects();
+            CreateDescriptorObjects();
+            m_compiler = shaderc_compiler_initialize();
+            if (!m_compiler) {
+                throw std::runtime_error("shaderc_compiler_initialize failed");
+            }
+            UploadTransferLut();
+        } catch (...) {
+            Destroy();
+            throw;
+        }
+    }
+
+    ~VulkanConverterImpl() override { Destroy(); }
+
+    VulkanConverterImpl(const VulkanConverterImpl &) = delete;
+    VulkanConverterImpl &operator=(const VulkanConverterImpl &) = delete;
+
+    const std::string &DeviceName() const override { return m_deviceName; }
+
+    bool Convert(const CapturedFrame &frame, const SelectionRect &selection, const Parameters &parameters,
+                 ToneMapOperator op, OutputPixelFormat format, ImageSink &sink, TimingStats *timingStats) override {
+        const uint32_t width = static_cast<uint32_t>(selection.Width());
+        const uint32_t height = static_cast<uint32_t>(selection.Height());
+        const VkDeviceSize sourceBytes = VkDeviceSize{width} * height * kSourceBytesPerPixel;
+        const VkDeviceSize outputBytes = VkDeviceSize{width} * height * BytesPerPixel(format);
+
+        const auto start = std::chrono::steady_clock::now();
+        EnsureBuffer(m_staging, sourceBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+        EnsureBuffer(m_source, sourceBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        EnsureBuffer(m_detection, sizeof(uint32_t),
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+        EnsureBuffer(m_output, outputBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        EnsureBuffer(m_readback, outputBytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        UpdateDescriptorSet();
+
+        // 只上传选区：按行从帧数据拷入暂存缓冲区，着色器中的源坐标因此从 (0, 0) 开始
+        const size_t rowBytes = static_cast<size_t>(width) * kSourceBytesPerPixel;
+        const size_t rowPitch = frame.metadata.rowPitch;
+        const uint8_t *sourceRow = frame.pixelData.data() + static_cast<size_t>(selection.Top()) * rowPitch +
+                                   static_cast<size_t>(selection.Left()) * kSourceBytesPerPixel;
+        auto *stagingRow = static_cast<uint8_t *>(m_staging.mapped);
+        for (uint32_t row = 0; row < height; ++row) {
+            std::memcpy(stagingRow + row * rowBytes, sourceRow + row * rowPitch, rowBytes);
+        }
+        const auto uploaded = std::chrono::steady_clock::now();
+
+        RecordUpload(sourceBytes);
+        RecordCompute(width, height, parameters, ShaderLibrary::VulkanProcessingVariantFor(format, op));
+        RecordReadback(outputBytes);
+        Submit();
+        const auto finished = std::chrono::steady_clock::now();
+
+        // 与着色器相同的判定：峰值以 float 位模式保存
+        uint32_t peakBits = 0;
+        std::memcpy(&peakBits, m_detection.mapped, sizeof(peakBits));
+        float peak = 0.0f;
+        std::memcpy(&peak, &peakBits, sizeof(peak));
+        const bool useHdrPath = peak > parameters.threshold;
+
+        ImageInfo info{};
+        info.width           = width;
+        info.height          = height;
+        info.format          = format;
+        info.hdrPath         = useHdrPath;
+        info.toneMapOperator = op;
+        info.gainMapMaxLog2  = GainMapMaxLog2(parameters.lw, parameters.sourcePeak);
+        sink.Begin(info);
+        sink.WriteRows(0, height, static_cast<const uint8_t *>(m_readback.mapped));
+        sink.End();
+
+        if (timingStats) {
+            timingStats->Add("vulkan-upload", false, MsBetween(start, uploaded));
+            RecordGpuTimings(*timingStats);
+            timingStats->Add("vulkan-submit", false, MsBetween(uploaded, finished));
+        }
+        return useHdrPath;
+    }
+
+private:
+    void CreateInstance() {
+        VkApplicationInfo application{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+        application.pApplicationName = "printscr";
+        application.apiVersion = VK_API_VERSION_1_1;
+
+        VkInstanceCreateInfo createInfo{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+        createInfo.pApplicationInfo = &application;
+        Check(vkCreateInstance(&createInfo, nullptr, &m_instance), "vkCreateInstance");
+    }
+
+    void SelectPhysicalDevice() {
+        uint32_t count = 0;
+        Check(vkEnumeratePhysicalDevices(m_instance, &count, nullptr), "vkEnumeratePhysicalDevices");
+        std::vector<VkPhysicalDevice> devices(count);
+        Check(vkEnumeratePhysicalDevices(m_instance, &count, devices.data()), "vkEnumeratePhysicalDevices");
+
+        const char *filter = std::getenv("PRINTSCR_VULKAN_DEVICE");
+        constexpr VkSubgroupFeatureFlags kRequiredSubgroupOperations =
+            VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+        int bestRank = -1;
+        for (VkPhysicalDevice device : devices) {
+            VkPhysicalDeviceSubgroupProperties subgroup{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+            VkPhysicalDeviceProperties2 properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+            properties.pNext = &subgroup;
+            vkGetPhysicalDeviceProperties2(device, &properties);
+            const std::string name = properties.properties.deviceName;
+
+            const char *rejected = nullptr;
+            if (properties.properties.apiVersion < VK_API_VERSION_1_1) {
+                rejected = "Vulkan 1.1 not supported";
+            } else if ((subgroup.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) == 0 ||
+                       (subgroup.supportedOperations & kRequiredSubgroupOperations) != kRequiredSubgroupOperations) {
+                rejected = "no subgroup arithmetic in compute shaders";
+            } else if (!FindQueueFamily(GetQueueFamilies(device), VK_QUEUE_COMPUTE_BIT, 0)) {
+                rejected = "no compute queue";
+            } else if (filter && name.find(filter) == std::string::npos) {
+                rejected = "does not match PRINTSCR_VULKAN_DEVICE";
+            }
+            if (rejected) {
+                LOG("Vulkan device " + name + " skipped: " + rejected);
+                continue;
+            }
+
+            const VkPhysicalDeviceType type = properties.properties.deviceType;
+            const int rank = type == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU     ? 3
+                             : type == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 2
+                             : type == VK_PHYSICAL_DEVICE_TYPE_CPU            ? 0
+                                                                              : 1;
+            if (rank > bestRank) {
+                bestRank = rank;
+                m_physicalDevice = device;
+                m_deviceName = name;
+                m_subgroupSize = subgroup.subgroupSize;
+                m_timestampPeriod = properties.properties.limits.timestampPeriod;
+            }
+        }
+        if (m_physicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("No Vulkan 1.1 device with subgroup arithmetic in compute shaders");
+        }
+        vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+    }
+
+    void CreateDevice() {
+        const auto families = GetQueueFamilies(m_physicalDevice);
+        m_computeFamily = *FindQueueFamily(families, VK_QUEUE_COMPUTE_BIT, 0);
+        // 只有传输能力的队列族通常对应独立的 DMA 引擎；没有时（如 lavapipe）上传与回读也提交到计算队列
+        m_transferFamily =
+            FindQueueFamily(families, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)
+                .value_or(m_computeFamily);
+        m_timestamps = families[m_computeFamily].timestampValidBits != 0;
+
+        const float priority = 1.0f;
+        std::vector<VkDeviceQueueCreateInfo> queues;
+        for (uint32_t family : {m_computeFamily, m_transferFamily}) {
+            if (!queues.empty() && queues.front().queueFamilyIndex == family) {
+                continue;
+            }
+            VkDeviceQueueCreateInfo queue{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+            queue.queueFamilyIndex = family;
+            queue.queueCount = 1;
+            queue.pQueuePriorities = &priority;
+            queues.push_back(queue);
+        }
+
+        VkDeviceCreateInfo createInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queues.size());
+        createInfo.pQueueCreateInfos = queues.data();
+        Check(vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device), "vkCreateDevice");
+        vkGetDeviceQueue(m_device, m_computeFamily, 0, &m_computeQueue);
+        vkGetDeviceQueue(m_device, m_transferFamily, 0, &m_transferQueue);
+
+        LOG("Vulkan device: " + m_deviceName + ", subgroup size " + std::to_string(m_subgroupSize) +
+            (SeparateTransferQueue() ? ", dedicated transfer queue family " + std::to_string(m_transferFamily)
+                                     : std::string(", transfers on the compute queue")));
+    }
+
+    bool SeparateTransferQueue() const { return m_transferFamily != m_computeFamily; }
+
+    void CreateCommandObjects() {
+        VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = m_computeFamily;
+        Check(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_computePool), "vkCreateCommandPool");
+        poolInfo.queueFamilyIndex = m_transferFamily;
+        Check(vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_transferPool), "vkCreateCommandPool");
+
+        VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandPool = m_computePool;
+        allocateInfo.commandBufferCount = 1;
+        Check(vkAllocateCommandBuffers(m_device, &allocateInfo, &m_computeCommands), "vkAllocateCommandBuffers");
+        allocateInfo.commandPool = m_transferPool;
+        allocateInfo.commandBufferCount = 2;
+        std::array<VkCommandBuffer, 2> transferCommands{};
+        Check(vkAllocateCommandBuffers(m_device, &allocateInfo, transferCommands.data()), "vkAllocateCommandBuffers");
+        m_uploadCommands = transferCommands[0];
+        m_readbackCommands = transferCommands[1];
+
+        VkSemaphoreCreateInfo semaphoreInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        Check(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_uploaded), "vkCreateSemaphore");
+        Check(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_computed), "vkCreateSemaphore");
+        VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        Check(vkCreateFence(m_device, &fenceInfo, nullptr, &m_fence), "vkCreateFence");
+
+        // 检测开始、检测结束、处理结束三个时间戳
+        if (m_timestamps) {
+            VkQueryPoolCreateInfo queryInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+            queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryInfo.queryCount = 3;
+            Check(vkCreateQueryPool(m_device, &queryInfo, nullptr, &m_queryPool), "vkCreateQueryPool");
+        }
+    }
+
+    void CreateDescriptorObjects() {
+        std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+        for (uint32_t binding : {kSourceBinding, kDetectionBinding, kOutputBinding}) {
+            bindings[binding] = {binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+        }
+        bindings[kTransferLutBinding] = {kTransferLutBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT, nullptr};
+        VkDescriptorSetLayoutCreateInfo layoutInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        Check(vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &m_setLayout), "vkCreateDescriptorSetLayout");
+
+        const VkPushConstantRange pushConstants{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants)};
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &m_setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstants;
+        Check(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout),
+              "vkCreatePipelineLayout");
+
+        const std::array<VkDescriptorPoolSize, 2> poolSizes = {{
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
+        }};
+        VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        Check(vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool), "vkCreateDescriptorPool");
+
+        VkDescriptorSetAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        allocateInfo.descriptorPool = m_descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &m_setLayout;
+        Check(vkAllocateDescriptorSets(m_device, &allocateInfo, &m_descriptorSet), "vkAllocateDescriptorSets");
+    }
+
+    uint32_t FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const {
+        for (VkMemoryPropertyFlags flags : {required | preferred, required}) {
+            for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i) {
+                if ((typeBits & (1u << i)) != 0 &&
+                    (m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+                    return i;
+                }
+            }
+        }
+        throw std::runtime_error("No suitable Vulkan memory type");
+    }
+
+    VkDeviceMemory Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags required,
+                            VkMemoryPropertyFlags preferred) {
+        VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, required, preferred);
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        Check(vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory), "vkAllocateMemory");
+        return memory;
+    }
+
+    void EnsureBuffer(Buffer &buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required,
+                      VkMemoryPropertyFlags preferred) {
+        if (buffer.size >= size) {
+            return;
+        }
+        DestroyBuffer(buffer);
+
+        VkBufferCreateInfo createInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        createInfo.size = size;
+        createInfo.usage = usage;
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        Check(vkCreateBuffer(m_device, &createInfo, nullptr, &buffer.buffer), "vkCreateBuffer");
+        VkMemoryRequirements requirements{};
+        vkGetBufferMemoryRequirements(m_device, buffer.buffer, &requirements);
+        buffer.memory = Allocate(requirements, required, preferred);
+        Check(vkBindBufferMemory(m_device, buffer.buffer, buffer.memory, 0), "vkBindBufferMemory");
+        if ((required & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+            Check(vkMapMemory(m_device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped), "vkMapMemory");
+        }
+        buffer.size = size;
+    }
+
+    void DestroyBuffer(Buffer &buffer) {
+        if (buffer.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(m_device, buffer.buffer, nullptr);
+        }
+        if (buffer.memory != VK_NULL_HANDLE) {
+            vkFreeMemory(m_device, buffer.memory, nullptr); // 同时解除映射
+        }
+        buffer = Buffer{};
+    }
+
+    // 传递函数查找表：R16F 2D 纹理，线性过滤，与 GLES 后端的 u_transferLut 相同。初始化时在计算队列上传一次
+    void UploadTransferLut() {
+        const auto data = TransferLut::BuildTextureData();
+        const VkDeviceSize bytes = sizeof(data);
+        EnsureBuffer(m_staging, bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+        std::memcpy(m_staging.mapped, data.data(), bytes);
+
+        const VkExtent3D extent{static_cast<uint32_t>(TransferLut::kSize),
+                                static_cast<uint32_t>(TransferLut::kCurveCount), 1};
+        VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R16_SFLOAT;
+        imageInfo.extent = extent;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        Check(vkCreateImage(m_device, &imageInfo, nullptr, &m_transferLut), "vkCreateImage");
+        VkMemoryRequirements requirements{};
+        vkGetImageMemoryRequirements(m_device, m_transferLut, &requirements);
+        m_transferLutMemory = Allocate(requirements, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        Check(vkBindImageMemory(m_device, m_transferLut, m_transferLutMemory, 0), "vkBindImageMemory");
+
+        const VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+        viewInfo.image = m_transferLut;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R16_SFLOAT;
+        viewInfo.subresourceRange = range;
+        Check(vkCreateImageView(m_device, &viewInfo, nullptr, &m_transferLutView), "vkCreateImageView");
+
+        VkSamplerCreateInfo samplerInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        Check(vkCreateSampler(m_device, &samplerInfo, nullptr, &m_transferLutSampler), "vkCreateSampler");
+
+        BeginCommands(m_computeCommands);
+        ImageBarrier(m_computeCommands, range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                     VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        VkBufferImageCopy copy{};
+        copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        copy.imageExtent = extent;
+        vkCmdCopyBufferToImage(m_computeCommands, m_staging.buffer, m_transferLut,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+        ImageBarrier(m_computeCommands, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        Check(vkEndCommandBuffer(m_computeCommands), "vkEndCommandBuffer");
+
+        VkSubmitInfo submit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &m_computeCommands;
+        Check(vkQueueSubmit(m_computeQueue, 1, &submit, m_fence), "vkQueueSubmit");
+        WaitForFence();
+    }
+
+    void UpdateDescriptorSet() {
+        const std::array<VkDescriptorBufferInfo, 3> buffers = {{
+            {m_source.buffer, 0, VK_WHOLE_SIZE},
+            {m_detection.buffer, 0, VK_WHOLE_SIZE},
+            {m_output.buffer, 0, VK_WHOLE_SIZE},
+        }};
+        const VkDescriptorImageInfo transferLut{m_transferLutSampler, m_transferLutView,
+                                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        std::array<VkWriteDescriptorSet, 4> writes{};
+        for (uint32_t binding = 0; binding < writes.size(); ++binding) {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = m_descriptorSet;
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorCount = 1;
+            if (binding == kTransferLutBinding) {
+                writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[binding].pImageInfo = &transferLut;
+            } else {
+                writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[binding].pBufferInfo = &buffers[binding];
+            }
+        }
+        vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    // 变体按需编译并缓存
+    VkPipeline GetPipeline(VkPipeline &pipeline, ShaderLibrary::ShaderSource source, const char *name) {
+        if (pipeline != VK_NULL_HANDLE) {
+            return pipeline;
+        }
+        std::string text;
+        for (size_t i = 0; i < source.count; ++i) {
+            text += source.parts[i];
+        }
+        shaderc_compile_options_t options = shaderc_compile_options_initialize();
+        shaderc_compile_options_set_target_env(options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+        shaderc_compile_options_set_optimization_level(options, shaderc_optimization_level_performance);
+        shaderc_compilation_result_t result = shaderc_compile_into_spv(
+            m_compiler, text.data(), text.size(), shaderc_compute_shader, name, "main", options);
+        shaderc_compile_options_release(options);
+        if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success) {
+            const std::string error = shaderc_result_get_error_message(result);
+            shaderc_result_release(result);
+            throw std::runtime_error(std::string("Vulkan shader ") + name + " failed to compile: " + error);
+        }
+
+        VkShaderModuleCreateInfo moduleInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+        moduleInfo.codeSize = shaderc_result_get_length(result);
+        moduleInfo.pCode = reinterpret_cast<const uint32_t *>(shaderc_result_get_bytes(result));
+        VkShaderModule module = VK_NULL_HANDLE;
+        const VkResult moduleResult = vkCreateShaderModule(m_device, &moduleInfo, nullptr, &module);
+        shaderc_result_release(result);
+        Check(moduleResult, "vkCreateShaderModule");
+
+        VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        stage.module = module;
+        stage.pName = "main";
+        VkComputePipelineCreateInfo pipelineInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+        pipelineInfo.stage = stage;
+        pipelineInfo.layout = m_pipelineLayout;
+        const VkResult pipelineResult =
+            vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(m_device, module, nullptr);
+        Check(pipelineResult, "vkCreateComputePipelines");
+        return pipeline;
+    }
+
+    static void BeginCommands(VkCommandBuffer commands) {
+        VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        Check(vkBeginCommandBuffer(commands, &beginInfo), "vkBeginCommandBuffer");
+    }
+
+    // 队列族不同时 srcFamily / dstFamily 构成所有权转移：释放方与获取方各记录一次相同的屏障
+    static void BufferBarrier(VkCommandBuffer commands, const Buffer &buffer, VkAccessFlags srcAccess,
+                              VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                              uint32_t srcFamily = VK_QUEUE_FAMILY_IGNORED,
+                              uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED) {
+        VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = buffer.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commands, srcStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void ImageBarrier(VkCommandBuffer commands, const VkImageSubresourceRange &range, VkImageLayout oldLayout,
+                      VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                      VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) const {
+        VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_transferLut;
+        barrier.subresourceRange = range;
+        vkCmdPipelineBarrier(commands, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    // 传输队列：暂存缓冲区 → 设备上的源缓冲区
+    void RecordUpload(VkDeviceSize sourceBytes) {
+        BeginCommands(m_uploadCommands);
+        const VkBufferCopy copy{0, 0, sourceBytes};
+        vkCmdCopyBuffer(m_uploadCommands, m_staging.buffer, m_source.buffer, 1, &copy);
+        if (SeparateTransferQueue()) {
+            BufferBarrier(m_uploadCommands, m_source, VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_transferFamily, m_computeFamily);
+        }
+        Check(vkEndCommandBuffer(m_uploadCommands), "vkEndCommandBuffer");
+    }
+
+    // 计算队列：清零峰值 → 检测 → 处理。同一队列族时上传结果的可见性由 semaphore 保证，不需要额外屏障
+    void RecordCompute(uint32_t width, uint32_t height, const Parameters &parameters, size_t variant) {
+        const VkPipeline detect = GetPipeline(m_detectPipeline, ShaderLibrary::VulkanDetectionShader(), "detect");
+        const VkPipeline process =
+            GetPipeline(m_processPipelines[variant], ShaderLibrary::VulkanProcessingShader(variant), "process");
+
+        VkCommandBuffer commands = m_computeCommands;
+        BeginCommands(commands);
+        if (SeparateTransferQueue()) {
+            BufferBarrier(commands, m_source, 0, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_transferFamily, m_computeFamily);
+        }
+        if (m_timestamps) {
+            vkCmdResetQueryPool(commands, m_queryPool, 0, 3);
+        }
+        vkCmdFillBuffer(commands, m_detection.buffer, 0, sizeof(uint32_t), 0);
+        BufferBarrier(commands, m_detection, VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        const PushConstants pushConstants{{static_cast<int32_t>(width), static_cast<int32_t>(height)},
+                                          parameters.lw, parameters.sourcePeak, parameters.threshold};
+        vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSet, 0,
+                                nullptr);
+        vkCmdPushConstants(commands, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants),
+                           &pushConstants);
+        const uint32_t groupsX = (width + kWorkgroupSize - 1) / kWorkgroupSize;
+        const uint32_t groupsY = (height + kWorkgroupSize - 1) / kWorkgroupSize;
+
+        if (m_timestamps) {
+            vkCmdWriteTimestamp(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+        }
+        vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, detect);
+        vkCmdDispatch(commands, groupsX, groupsY, 1);
+        BufferBarrier(commands, m_detection, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        if (m_timestamps) {
+            vkCmdWriteTimestamp(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_queryPool, 1);
+        }
+        vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_COMPUTE, process);
+        vkCmdDispatch(commands, groupsX, groupsY, 1);
+        if (m_timestamps) {
+            vkCmdWriteTimestamp(commands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_queryPool, 2);
+        }
+
+        // 峰值由 CPU 直接读取映射内存；输出交给传输队列回读
+        BufferBarrier(commands, m_detection, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+        if (SeparateTransferQueue()) {
+            BufferBarrier(commands, m_output, VK_ACCESS_SHADER_WRITE_BIT, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_computeFamily, m_transferFamily);
+        }
+        Check(vkEndCommandBuffer(commands), "vkEndCommandBuffer");
+    }
+
+    // 传输队列：设备上的输出缓冲区 → 主机可见的回读缓冲区
+    void RecordReadback(VkDeviceSize outputBytes) {
+        BeginCommands(m_readbackCommands);
+        if (SeparateTransferQueue()) {
+            BufferBarrier(m_readbackCommands, m_output, 0, VK_ACCESS_TRANSFER_READ_BIT,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, m_computeFamily,
+                          m_transferFamily);
+        }
+        const VkBufferCopy copy{0, 0, outputBytes};
+        vkCmdCopyBuffer(m_readbackCommands, m_output.buffer, m_readback.buffer, 1, &copy);
+        BufferBarrier(m_readbackCommands, m_readback, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+        Check(vkEndCommandBuffer(m_readbackCommands), "vkEndCommandBuffer");
+    }
+
+    // 上传 →(semaphore) 计算 →(semaphore) 回读 →(fence) CPU
+    void Submit() {
+        const VkPipelineStageFlags computeWait = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        const VkPipelineStageFlags readbackWait = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+        VkSubmitInfo upload{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        upload.commandBufferCount = 1;
+        upload.pCommandBuffers = &m_uploadCommands;
+        upload.signalSemaphoreCount = 1;
+        upload.pSignalSemaphores = &m_uploaded;
+        Check(vkQueueSubmit(m_transferQueue, 1, &upload, VK_NULL_HANDLE), "vkQueueSubmit");
+
+        VkSubmitInfo compute{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        compute.waitSemaphoreCount = 1;
+        compute.pWaitSemaphores = &m_uploaded;
+        compute.pWaitDstStageMask = &computeWait;
+        compute.commandBufferCount = 1;
+        compute.pCommandBuffers = &m_computeCommands;
+        compute.signalSemaphoreCount = 1;
+        compute.pSignalSemaphores = &m_computed;
+        Check(vkQueueSubmit(m_computeQueue, 1, &compute, VK_NULL_HANDLE), "vkQueueSubmit");
+
+        VkSubmitInfo readback{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        readback.waitSemaphoreCount = 1;
+        readback.pWaitSemaphores = &m_computed;
+        readback.pWaitDstStageMask = &readbackWait;
+        readback.commandBufferCount = 1;
+        readback.pCommandBuffers = &m_readbackCommands;
+        Check(vkQueueSubmit(m_transferQueue, 1, &readback, m_fence), "vkQueueSubmit");
+        WaitForFence();
+    }
+
+    void WaitForFence() {
+        Check(vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, kFenceTimeoutNs), "vkWaitForFences");
+        Check(vkResetFences(m_device, 1, &m_fence), "vkResetFences");
+    }
+
+    void RecordGpuTimings(TimingStats &timingStats) {
+        if (!m_timestamps) {
+            return;
+        }
+        std::array<uint64_t, 3> ticks{};
+        if (vkGetQueryPoolResults(m_device, m_queryPool, 0, 3, sizeof(ticks), ticks.data(), sizeof(uint64_t),
+                                  VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            return;
+        }
+        const double msPerTick = m_timestampPeriod / 1e6;
+        timingStats.Add("vulkan-detect", true, static_cast<double>(ticks[1] - ticks[0]) * msPerTick);
+        timingStats.Add("vulkan-process", true, static_cast<double>(ticks[2] - ticks[1]) * msPerTick);
+    }
+
+    void Destroy() {
+        if (m_device != VK_NULL_HANDLE) {
+            vkDeviceWaitIdle(m_device);
+            for (VkPipeline pipeline : m_processPipelines) {
+                if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(m_device, pipeline, nullptr);
+            }
+            if (m_detectPipeline != VK_NULL_HANDLE) vkDestroyPipeline(m_device, m_detectPipeline, nullptr);
+            for (Buffer *buffer : {&m_staging, &m_source, &m_detection, &m_output, &m_readback}) {
+                DestroyBuffer(*buffer);
+            }
+            if (m_transferLutSampler != VK_NULL_HANDLE) vkDestroySampler(m_device, m_transferLutSampler, nullptr);
+            if (m_transferLutView != VK_NULL_HANDLE) vkDestroyImageView(m_device, m_transferLutView, nullptr);
+            if (m_transferLut != VK_NULL_HANDLE) vkDestroyImage(m_device, m_transferLut, nullptr);
+            if (m_transferLutMemory != VK_NULL_HANDLE) vkFreeMemory(m_device, m_transferLutMemory, nullptr);
+            if (m_descriptorPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+            if (m_pipelineLayout != VK_NULL_HANDLE) vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+            if (m_setLayout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+            if (m_queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+            if (m_fence != VK_NULL_HANDLE) vkDestroyFence(m_device, m_fence, nullptr);
+            if (m_computed != VK_NULL_HANDLE) vkDestroySemaphore(m_device, m_computed, nullptr);
+            if (m_uploaded != VK_NULL_HANDLE) vkDestroySemaphore(m_device, m_uploaded, nullptr);
+            if (m_transferPool != VK_NULL_HANDLE) vkDestroyCommandPool(m_device, m_transferPool, nullptr);
+            if (m_computePool != VK_NULL_HANDLE) vkDestroyCommandPool(m_device, m_computePool, nullptr);
+            vkDestroyDevice(m_device, nullptr);
+            m_device = VK_NULL_HANDLE;
+        }
+        if (m_instance != VK_NULL_HANDLE) {
+            vkDestroyInstance(m_instance, nullptr);
+            m_instance = VK_NULL_HANDLE;
+        }
+        if (m_compiler) {
+            shaderc_compiler_release(m_compiler);
+            m_compiler = nullptr;
+        }
+    }
+
+    VkInstance m_instance = VK_NULL_HANDLE;
+    VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
+    std::string m_deviceName;
+    uint32_t m_subgroupSize = 0;
+    float m_timestampPeriod = 1.0f;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+    VkDevice m_device = VK_NULL_HANDLE;
+    uint32_t m_computeFamily = 0;
+    uint32_t m_transferFamily = 0;
+    VkQueue m_computeQueue = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE; // 没有专用传输队列族时与 m_computeQueue 相同
+    VkCommandPool m_computePool = VK_NULL_HANDLE;
+    VkCommandPool m_transferPool = VK_NULL_HANDLE;
+    VkCommandBuffer m_computeCommands = VK_NULL_HANDLE;
+    VkCommandBuffer m_uploadCommands = VK_NULL_HANDLE;
+    VkCommandBuffer m_readbackCommands = VK_NULL_HANDLE;
+    VkSemaphore m_uploaded = VK_NULL_HANDLE;
+    VkSemaphore m_computed = VK_NULL_HANDLE;
+    VkFence m_fence = VK_NULL_HANDLE;
+    bool m_timestamps = false;
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+    shaderc_compiler_t m_compiler = nullptr;
+    VkPipeline m_detectPipeline = VK_NULL_HANDLE;
+    std::array<VkPipeline, ShaderLibrary::kVulkanProcessingVariantCount> m_processPipelines{};
+    VkImage m_transferLut = VK_NULL_HANDLE;
+    VkDeviceMemory m_transferLutMemory = VK_NULL_HANDLE;
+    VkImageView m_transferLutView = VK_NULL_HANDLE;
+    VkSampler m_transferLutSampler = VK_NULL_HANDLE;
+    Buffer m_staging;
+    Buffer m_source;
+    Buffer m_detection;
+    Buffer m_output;
+    Buffer m_readback;
+};
+
+} // namespace
+
+std::unique_ptr<VulkanConverter> VulkanConverter::Create() { return std::make_unique<VulkanConverterImpl>(); }
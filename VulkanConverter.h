@@ -0,0 +1,40 @@
+#pragma once
+
+#include "GpuTimer.h"
+#include "ImageSink.h"
+#include "ScreenCapture.h"
+#include "SelectionRect.h"
+#include "ToneMapping.h"
+
+#include <memory>
+#include <string>
+
+// Vulkan 计算后端：检测与处理的色彩函数、色调映射片段与输出打包都来自 ShaderLibrary，与 GLES 计算后端一致。
+// 选区像素从 CapturedFrame 经暂存缓冲区由传输队列上传；检测用 subgroupMax 归约出选区峰值，处理着色器在设备上
+// 按峰值选择路径，结果由传输队列（设备有专用传输队列族时使用它）拷贝到主机可见的回读缓冲区。
+// 上传、计算与回读三次提交之间只用 semaphore 同步，CPU 只在最后等待一次 fence。
+// 需要 Vulkan 1.1 与计算阶段的 subgroup 算术操作，Mesa lavapipe 满足要求，可在无 GPU 的 Linux 主机上运行。
+// 不是线程安全的；只支持 1x 输出，不支持色彩管理查找表
+class VulkanConverter {
+public:
+    // 处理着色器的 push constant
+    struct Parameters {
+        float lw;         // SDR 白点对应的 scRGB 线性值
+        float sourcePeak; // 显示器峰值亮度对应的 scRGB 线性值
+        float threshold;  // 选区峰值超过该值时使用色调映射路径
+    };
+
+    virtual ~VulkanConverter() = default;
+
+    virtual const std::string &DeviceName() const = 0;
+
+    // selection 必须已钳制到帧内。按 format 转换并依次调用 sink 的 Begin / WriteRows / End，返回是否使用 HDR 路径；
+    // timingStats 非空时记录各阶段耗时
+    virtual bool Convert(const CapturedFrame &frame, const SelectionRect &selection, const Parameters &parameters,
+                         ToneMapOperator op, OutputPixelFormat format, ImageSink &sink,
+                         TimingStats *timingStats) = 0;
+
+    // 独立显卡优先，CPU 实现（lavapipe）最后；环境变量 PRINTSCR_VULKAN_DEVICE 按设备名子串筛选。
+    // 没有满足要求的设备时抛出 std::runtime_error
+    static std::unique_ptr<VulkanConverter> Create();
+};
@@ -1,12 +1,24 @@
+#include "EglEnvironment.h"
+#include "FramePrecompute.h"
 #include "GpuFrame.h"
 #include "Logger.h"
 #include "OutputModule.h"
 #include "PreviewModule.h"
 #include "ScreenCapture.h"
+#include "SpeculativeConverter.h"
 #include "SystemInfo.h"
+#include "HeadlessCommands.h"
+#include "RawFrameFile.h"
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 #include <windows.h>
 #include <winrt/base.h>
 
@@ -18,12 +30,17 @@
 static struct {
     wchar_t caller_mutex_name[80];
     wchar_t caller_event_name[80];
+    // 客户端的命令行参数，以 NUL 分隔、连续两个 NUL 结束；持有 caller_mutex 时读写
+    wchar_t caller_arguments[4096];
 } g_shared_context = {0};
 #pragma data_seg()
 
 class PrintScrApp {
 public:
-    PrintScrApp() {
+    PrintScrApp(const ConversionOptions &conversionOptions, bool stageTiming, uint64_t precomputeCapBytes = 0,
+                bool selectionStatistics = false)
+        : m_conversionOptions(conversionOptions), m_precomputeCapBytes(precomputeCapBytes),
+          m_selectionStatistics(selectionStatistics) {
         LOG("Application started.");
         SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
         LOG("High DPI awareness set.");
@@ -31,45 +48,10 @@ public:
         winrt::init_apartment();
         LOG("WinRT apartment initialized.");
 
-        // Init EGL Root
-        m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-        if (m_eglDisplay == EGL_NO_DISPLAY) {
-            throw std::runtime_error("eglGetDisplay failed");
-        }
-        if (!eglInitialize(m_eglDisplay, nullptr, nullptr)) {
-            throw std::runtime_error("eglInitialize failed");
-        }
-
-        const EGLint configAttribs[] = {
-            EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
-            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
-            EGL_RED_SIZE,        8,
-            EGL_GREEN_SIZE,      8,
-            EGL_BLUE_SIZE,       8,
-            EGL_ALPHA_SIZE,      8,
-            EGL_NONE
-        };
-        EGLint configCount = 0;
-        EGLConfig config;
-        if (!eglChooseConfig(m_eglDisplay, configAttribs, &config, 1, &configCount) || configCount == 0) {
-            throw std::runtime_error("eglChooseConfig failed");
-        }
-
-        const EGLint contextAttribs[] = {
-            EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
-            EGL_CONTEXT_MINOR_VERSION_KHR, 1,
-            EGL_NONE
-        };
-        m_rootContext = eglCreateContext(m_eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
-        if (m_rootContext == EGL_NO_CONTEXT) {
-            throw std::runtime_error("eglCreateContext failed");
-        }
-
-        const EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
-        m_dummySurface = eglCreatePbufferSurface(m_eglDisplay, config, surfaceAttribs);
-        if (m_dummySurface == EGL_NO_SURFACE) {
-            throw std::runtime_error("eglCreatePbufferSurface failed");
-        }
+        m_egl = std::make_unique<EglEnvironment>();
+        m_eglDisplay = m_egl->Display();
+        m_dummySurface = m_egl->DummySurface();
+        m_rootContext = m_egl->RootContext();
 
         LOG("Creating ScreenCapturer...");
         m_capturer = ScreenCapturer::Create();
@@ -79,57 +61,106 @@ public:
         
         LOG("Creating OutputModule...");
         m_outputModule = OutputModule::Create(m_eglDisplay, m_dummySurface, m_rootContext);
+
+        m_previewWindow->SetTimingEnabled(stageTiming);
+        m_outputModule->SetTimingEnabled(stageTiming);
     }
 
     ~PrintScrApp() {
         m_previewWindow.reset();
         m_outputModule.reset();
         m_capturer.reset();
-        if (m_eglDisplay != EGL_NO_DISPLAY) {
-            eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-            if (m_dummySurface != EGL_NO_SURFACE) eglDestroySurface(m_eglDisplay, m_dummySurface);
-            if (m_rootContext != EGL_NO_CONTEXT) eglDestroyContext(m_eglDisplay, m_rootContext);
-            eglTerminate(m_eglDisplay);
+        m_egl.reset();
+    }
+
+    // 守护进程启动时预先创建隐藏的预览窗口，热键触发后只需换入新帧。失败时 Show 会再尝试创建
+    void PreparePreview() {
+        if (!m_previewWindow->Prepare()) {
+            LOG("Preview window could not be prepared; it will be created on the first capture.");
         }
     }
 
-    int RunCaptureTarget() {
+    // 缓存中没有 kernel 排名或延迟模型时在守护进程空闲时测量，不占用第一次确认的延迟
+    void PrepareTuning() {
         try {
-            LOG("Starting capture...");
-            m_capturer->StartCapture();
-            std::cout << "Capture started. Waiting for first frame..." << std::endl;
-
-            std::shared_ptr<CapturedFrame> frame = nullptr;
-            for (int i = 0; i < 100; ++i) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                frame = m_capturer->GetLatestFrame();
-                if (frame) {
-                    std::cout << "Frame captured! " << frame->metadata.width << "x" << frame->metadata.height << std::endl;
-                    break;
-                }
-            }
+            m_outputModule->PrepareTuning();
+        } catch (const std::exception &ex) {
+            LOG(std::string("Tuning failed: ") + ex.what());
+        }
+    }
+
+    int RunCaptureTarget() { return RunCaptureTarget(m_conversionOptions); }
 
+    // 守护进程模式下 conversionOptions 由每次调用的参数得出，见 ParseConversionOptions
+    int RunCaptureTarget(const ConversionOptions &conversionOptions) {
+        try {
+            const auto requested = std::chrono::steady_clock::now();
+            std::shared_ptr<CapturedFrame> frame = CaptureFrame();
             if (!frame) {
-                std::cerr << "Timeout waiting for frame." << std::endl;
-                m_capturer->StopCapture();
                 return 1;
             }
-
-            m_capturer->StopCapture();
+            const auto captured = std::chrono::steady_clock::now();
             std::cout << "Capture stopped. Opening preview..." << std::endl;
 
-            auto gpuFrame = GpuFrame::Create(*frame, m_eglDisplay, m_dummySurface, m_rootContext);
+            auto gpuFrame = GpuFrame::Create(frame, m_eglDisplay, m_dummySurface, m_rootContext);
+            const auto uploaded = std::chrono::steady_clock::now();
             std::cout << "GPU frame created." << std::endl;
 
+            // 开启整帧预转换且放得下时，预览期间在后台转换整帧，确认后只需裁剪；
+            // 否则选区每次稳定都在后台转换一次，确认时多半已有结果
+            const DisplayHdrInfo hdrInfo = SystemInfo::GetPrimaryDisplayHdrInfo();
+            // 亮度统计须在后台转换开始前生成：预览按选区查表显示，转换用它代替检测 pass
+            ConversionOptions options = conversionOptions;
+            if (m_selectionStatistics) {
+                options.statistics = ComputeStatistics(gpuFrame, hdrInfo);
+            }
+            m_previewWindow->SetFrameStatistics(options.statistics);
+
+            std::unique_ptr<FramePrecompute> precompute;
+            std::unique_ptr<SpeculativeConverter> speculative;
+            if (CanPrecompute(*gpuFrame, options)) {
+                precompute = FramePrecompute::Create(*m_outputModule, gpuFrame, hdrInfo, options.toneMapOperator);
+            } else {
+                speculative = SpeculativeConverter::Create(*m_outputModule, gpuFrame, hdrInfo, options,
+                                                           OutputPixelFormat::Bgra8);
+                m_previewWindow->SetSelectionSettledCallback(
+                    [&speculative](const SelectionRect &settled) { speculative->Request(settled); });
+            }
+            const auto showCalled = std::chrono::steady_clock::now();
             SelectionRect selection = m_previewWindow->Show(gpuFrame);
+            m_previewWindow->SetSelectionSettledCallback(nullptr);
+            m_previewWindow->SetFrameStatistics(nullptr);
+            if (const auto presented = m_previewWindow->LastFirstPresent()) {
+                auto ms = [](auto duration) {
+                    return std::to_string(std::chrono::duration<double, std::milli>(duration).count());
+                };
+                LOG("Hotkey-to-first-present latency: " + ms(*presented - requested) + " ms (capture " +
+                    ms(captured - requested) + " ms, upload " + ms(uploaded - captured) + " ms, preparation " +
+                    ms(showCalled - uploaded) + " ms, preview " + ms(*presented - showCalled) + " ms)");
+            }
 
             if (selection.IsValid()) {
                 std::cout << "Selection confirmed: (" << selection.Left() << ", " << selection.Top() << ") to ("
                           << selection.Right() << ", " << selection.Bottom() << ")" << std::endl;
                 std::cout << "Size: " << selection.Width() << "x" << selection.Height() << std::endl;
 
-                const DisplayHdrInfo hdrInfo = SystemInfo::GetPrimaryDisplayHdrInfo();
-                m_outputModule->CopySelectionToClipboard(*gpuFrame, selection, hdrInfo);
+                const auto confirmed = std::chrono::steady_clock::now();
+                ClipboardSink sink(options.colorLut ? options.colorLut->IccProfile() : std::vector<uint8_t>{});
+                const char *source = "direct conversion";
+                if (precompute && precompute->TryCrop(selection, sink)) {
+                    source = "precomputed frame";
+                } else if (speculative && speculative->TryTake(selection, sink)) {
+                    source = "speculative result";
+                } else {
+                    precompute.reset();
+                    speculative.reset();
+                    m_outputModule->CopySelectionToClipboard(*gpuFrame, selection, hdrInfo, options);
+                }
+                LOG("Confirm-to-clipboard latency: " +
+                    std::to_string(
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - confirmed)
+                            .count()) +
+                    " ms via " + source);
                 std::cout << "Selection copied to clipboard." << std::endl;
             } else {
                 std::cout << "Selection cancelled." << std::endl;
@@ -146,7 +177,57 @@ public:
         return 0;
     }
 
+    // 截取整屏，对每个色调映射算子测量耗时并给出质量指标
+    int RunToneMapComparison(int iterations) {
+        try {
+            std::shared_ptr<CapturedFrame> frame = CaptureFrame();
+            if (!frame) {
+                return 1;
+            }
+
+            auto gpuFrame = GpuFrame::Create(frame, m_eglDisplay, m_dummySurface, m_rootContext);
+            const SelectionRect fullFrame = {0, 0, static_cast<int>(gpuFrame->Width()),
+                                             static_cast<int>(gpuFrame->Height())};
+            const DisplayHdrInfo hdrInfo = SystemInfo::GetPrimaryDisplayHdrInfo();
+
+            const auto results = m_outputModule->CompareToneMapOperators(*gpuFrame, fullFrame, hdrInfo, iterations);
+            std::cout << "Operator              avg ms   mean luma   clipped %   SDR deviation" << std::endl;
+            for (const auto &result : results) {
+                std::cout << std::left << std::setw(20) << GetToneMapOperatorInfo(result.op).displayName << std::right
+                          << std::fixed << std::setprecision(3) << std::setw(9) << result.averageMs
+                          << std::setw(12) << result.meanLuma << std::setw(12) << result.clippedFraction * 100.0
+                          << std::setw(16) << result.sdrDeviation << std::endl;
+            }
+        } catch (const winrt::hresult_error &ex) {
+            std::cerr << "WinRT Error: " << winrt::to_string(ex.message()) << std::endl;
+            return 1;
+        } catch (const std::exception &ex) {
+            std::cerr << "Error: " << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    int RunRawDump(const std::filesystem::path &path) {
+        try {
+            std::shared_ptr<CapturedFrame> frame = CaptureFrame();
+            if (!frame) {
+                return 1;
+            }
+            WriteRawFrameFile(path, *frame, SystemInfo::GetPrimaryDisplayHdrInfo());
+            std::cout << "Raw frame written to " << path.string() << std::endl;
+        } catch (const winrt::hresult_error &ex) {
+            std::cerr << "WinRT Error: " << winrt::to_string(ex.message()) << std::endl;
+            return 1;
+        } catch (const std::exception &ex) {
+            std::cerr << "Error: " << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
 private:
+    std::unique_ptr<EglEnvironment> m_egl;
     EGLDisplay m_eglDisplay = EGL_NO_DISPLAY;
     EGLSurface m_dummySurface = EGL_NO_SURFACE;
     EGLContext m_rootContext = EGL_NO_CONTEXT;
@@ -154,12 +235,326 @@ private:
     std::unique_ptr<ScreenCapturer> m_capturer;
     std::unique_ptr<PreviewWindow> m_previewWindow;
     std::unique_ptr<OutputModule> m_outputModule;
+    ConversionOptions m_conversionOptions;
+    uint64_t m_precomputeCapBytes = 0; // 0 表示不做整帧预转换
+    bool m_selectionStatistics = false;
+
+    // 生成失败时只记日志，预览不显示统计，转换照常运行检测 pass
+    std::shared_ptr<const FrameStatistics> ComputeStatistics(const std::shared_ptr<GpuFrame> &gpuFrame,
+                                                             const DisplayHdrInfo &hdrInfo) {
+        try {
+            const auto start = std::chrono::steady_clock::now();
+            auto statistics = m_outputModule->ComputeFrameStatistics(gpuFrame, hdrInfo);
+            LOG("Frame statistics built in " +
+                std::to_string(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) +
+                " ms, " + std::to_string(FrameStatistics::EstimateBytes(gpuFrame->Width(), gpuFrame->Height()) >> 20) +
+                " MiB.");
+            return statistics;
+        } catch (const std::exception &ex) {
+            LOG(std::string("Frame statistics unavailable: ") + ex.what());
+            return nullptr;
+        }
+    }
+
+    // 整帧预转换的结果只对应计算后端、不经过色彩管理查找表的 1x BGRA8 输出
+    bool CanPrecompute(const GpuFrame &gpuFrame, const ConversionOptions &options) const {
+        if (m_precomputeCapBytes == 0) {
+            return false;
+        }
+        if (options.colorLut) {
+            LOG("Frame precompute skipped: not available with a color LUT.");
+            return false;
+        }
+        // 预转换的结果没有打码，裁剪会泄露被遮挡的内容
+        if (!options.redactions.empty()) {
+            LOG("Frame precompute skipped: not available with redaction.");
+            return false;
+        }
+        if (options.localToneMapping) {
+            LOG("Frame precompute skipped: not available with local tone mapping.");
+            return false;
+        }
+        const OutputScale &scale = options.clipboardScale;
+        const ConversionBackend backend = options.backend;
+        if (scale.factor < 1.0f || scale.maxDimension != 0 ||
+            (backend != ConversionBackend::Auto && backend != ConversionBackend::Compute)) {
+            LOG("Frame precompute skipped: it only serves 1x output from the compute backend.");
+            return false;
+        }
+        const uint64_t bytes = PrecomputedFrame::EstimateBytes(gpuFrame.Width(), gpuFrame.Height());
+        if (bytes > m_precomputeCapBytes) {
+            LOG("Frame precompute skipped: needs " + std::to_string(bytes >> 20) + " MiB, cap is " +
+                std::to_string(m_precomputeCapBytes >> 20) + " MiB.");
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<CapturedFrame> CaptureFrame() {
+        LOG("Starting capture...");
+        m_capturer->StartCapture();
+        std::cout << "Capture started. Waiting for first frame..." << std::endl;
+
+        std::shared_ptr<CapturedFrame> frame = nullptr;
+        for (int i = 0; i < 100; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            frame = m_capturer->GetLatestFrame();
+            if (frame) {
+                std::cout << "Frame captured! " << frame->metadata.width << "x" << frame->metadata.height << std::endl;
+                break;
+            }
+        }
+
+        m_capturer->StopCapture();
+        if (!frame) {
+            std::cerr << "Timeout waiting for frame." << std::endl;
+        }
+        return frame;
+    }
 };
 
 
+// 命令行参数转为 UTF-8，供跨平台的 HeadlessCommands 使用
+static std::vector<std::string> ToUtf8Arguments(int argc, wchar_t *argv[]) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        const int size = WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string arg(size > 0 ? static_cast<size_t>(size - 1) : 0, '\0');
+        if (size > 1) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, arg.data(), size, nullptr, nullptr);
+        }
+        args.push_back(std::move(arg));
+    }
+    return args;
+}
+
+// 查找 `--name value` 形式的参数，返回 value（仅 ASCII）
+static std::optional<std::string> FindArgument(int argc, wchar_t *argv[], const wchar_t *name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (wcscmp(argv[i], name) == 0) {
+            std::string value;
+            for (const wchar_t *c = argv[i + 1]; *c != 0; ++c) {
+                value.push_back(static_cast<char>(*c));
+            }
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+// 查找 `--name path` 形式的参数，路径保持宽字符
+static std::optional<std::filesystem::path> FindPathArgument(int argc, wchar_t *argv[], const wchar_t *name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (wcscmp(argv[i], name) == 0) {
+            return std::filesystem::path(argv[i + 1]);
+        }
+    }
+    return std::nullopt;
+}
+
+static bool HasFlag(int argc, wchar_t *argv[], const wchar_t *name) {
+    for (int i = 1; i < argc; ++i) {
+        if (wcscmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 等待 handle 置位，期间分发本线程的窗口消息；返回 WAIT_OBJECT_0 或 WAIT_FAILED
+static DWORD WaitPumpingMessages(HANDLE handle) {
+    for (;;) {
+        const DWORD result = MsgWaitForMultipleObjects(1, &handle, FALSE, INFINITE, QS_ALLINPUT);
+        if (result != WAIT_OBJECT_0 + 1) {
+            return result;
+        }
+        MSG msg;
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+}
+
+// 每次截屏的转换选项，在 options（默认值或守护进程的启动参数）的基础上修改，未出现的选项保持原值。
+// 守护进程模式下客户端的参数转发给守护进程再解析一次，因此算子、缩放、后端、打码等可以逐次指定。出错时输出原因
+static bool ParseConversionOptions(int argc, wchar_t *argv[], ConversionOptions &options) {
+    if (auto name = FindArgument(argc, argv, L"--tonemap")) {
+        auto op = ParseToneMapOperator(*name);
+        if (!op) {
+            std::cerr << "Unknown tone-mapping operator: " << *name << std::endl;
+            return false;
+        }
+        options.toneMapOperator = *op;
+    }
+    // 局部色调映射：高光只在其所在区域滚降，其余区域保持 SDR 路径的结果
+    if (HasFlag(argc, argv, L"--local-tonemap")) {
+        options.localToneMapping = true;
+    }
+    // 复制到剪贴板的图像尺寸，如 --scale 0.5 或 --scale 1920px
+    if (auto value = FindArgument(argc, argv, L"--scale")) {
+        auto scale = ParseOutputScale(*value);
+        if (!scale) {
+            std::cerr << "Invalid output scale: " << *value << std::endl;
+            return false;
+        }
+        options.clipboardScale = *scale;
+    }
+    if (auto value = FindArgument(argc, argv, L"--filter")) {
+        auto filter = ParseScaleFilter(*value);
+        if (!filter) {
+            std::cerr << "Unknown scale filter: " << *value << std::endl;
+            return false;
+        }
+        options.scaleFilter = *filter;
+    }
+    if (auto value = FindArgument(argc, argv, L"--backend")) {
+        auto backend = ParseConversionBackend(*value);
+        if (!backend) {
+            std::cerr << "Unknown conversion backend: " << *value << std::endl;
+            return false;
+        }
+        options.backend = *backend;
+    }
+
+    // 打码：--redact x,y,w,h 可重复，坐标为帧内像素；在色调映射之前作用于 FP16 源。
+    // 出现 --redact 时整组替换基础选项中的矩形
+    std::vector<SelectionRect> redactions;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (wcscmp(argv[i], L"--redact") != 0) {
+            continue;
+        }
+        std::string value;
+        for (const wchar_t *c = argv[i + 1]; *c != 0; ++c) {
+            value.push_back(static_cast<char>(*c));
+        }
+        auto rect = ParseSelectionRect(value);
+        if (!rect) {
+            std::cerr << "Invalid redaction rectangle: " << value << std::endl;
+            return false;
+        }
+        redactions.push_back(*rect);
+    }
+    if (redactions.size() > kMaxRedactionRects) {
+        std::cerr << "Too many redaction rectangles, at most " << kMaxRedactionRects << " are supported." << std::endl;
+        return false;
+    }
+    if (!redactions.empty()) {
+        options.redactions = std::move(redactions);
+    }
+    if (auto value = FindArgument(argc, argv, L"--redact-style")) {
+        auto style = ParseRedactionStyle(*value);
+        if (!style) {
+            std::cerr << "Unknown redaction style: " << *value << std::endl;
+            return false;
+        }
+        options.redactionStyle = *style;
+    }
+    if (auto value = FindArgument(argc, argv, L"--redact-size")) {
+        try {
+            options.redactionSize = static_cast<uint32_t>(std::stoul(*value));
+        } catch (const std::exception &) {
+            std::cerr << "Invalid redaction size: " << *value << std::endl;
+            return false;
+        }
+    }
+
+    // 色彩管理查找表：.cube，或由 ICC 配置文件（.icc / .icm）生成；输出同时嵌入该配置文件
+    if (auto path = FindPathArgument(argc, argv, L"--color-lut")) {
+        try {
+            options.colorLut = ColorLut::Load(*path);
+        } catch (const std::exception &ex) {
+            std::cerr << "Cannot load color LUT: " << ex.what() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// 客户端把参数写入共享段；--color-lut 的相对路径按客户端的工作目录转为绝对路径。放不下时返回 false
+static bool ForwardArguments(int argc, wchar_t *argv[]) {
+    std::wstring packed;
+    for (int i = 1; i < argc; ++i) {
+        if (i > 1 && wcscmp(argv[i - 1], L"--color-lut") == 0) {
+            packed += std::filesystem::absolute(argv[i]).wstring();
+        } else {
+            packed += argv[i];
+        }
+        packed.push_back(L'\0');
+    }
+    packed.push_back(L'\0');
+    if (packed.size() > std::size(g_shared_context.caller_arguments)) {
+        return false;
+    }
+    std::copy(packed.begin(), packed.end(), g_shared_context.caller_arguments);
+    return true;
+}
+
+// 守护进程读出最近一次调用转发的参数，第一个元素是 argv[0] 的占位
+static std::vector<std::wstring> ReceiveArguments() {
+    std::vector<std::wstring> arguments{L"printscr"};
+    for (const wchar_t *arg = g_shared_context.caller_arguments; *arg != 0; arg += wcslen(arg) + 1) {
+        arguments.emplace_back(arg);
+    }
+    return arguments;
+}
+
 #include <ole2.h>
 #include <atlbase.h>
 int wmain(int argc, wchar_t *argv[]) {
+    if (argc > 1 && wcscmp(argv[1], L"--verify-transfer-luts") == 0) {
+        return RunTransferLutVerifier();
+    }
+    if (argc > 1 && wcscmp(argv[1], L"--batch") == 0) {
+        return RunBatchCommand(ToUtf8Arguments(argc, argv));
+    }
+    if (argc > 1 && wcscmp(argv[1], L"--autotune") == 0) {
+        return RunAutotuneCommand();
+    }
+    if (argc > 1 && wcscmp(argv[1], L"--bench-precompute") == 0) {
+        return RunPrecomputeBenchmark(ToUtf8Arguments(argc, argv));
+    }
+    if (argc > 1 && wcscmp(argv[1], L"--bench-statistics") == 0) {
+        return RunStatisticsBenchmark(ToUtf8Arguments(argc, argv));
+    }
+    if (argc > 1 && wcscmp(argv[1], L"--bench-lossless") == 0) {
+        return RunLosslessBenchmark(ToUtf8Arguments(argc, argv));
+    }
+
+    ConversionOptions conversionOptions;
+    if (!ParseConversionOptions(argc, argv, conversionOptions)) {
+        return 1;
+    }
+
+    // 逐阶段 GPU 计时，结果写入日志
+    const bool stageTiming = HasFlag(argc, argv, L"--gpu-timing");
+
+    // 整帧预转换，值为内存上限（MiB），默认关闭
+    uint64_t precomputeCapBytes = 0;
+    if (auto value = FindArgument(argc, argv, L"--precompute-frame")) {
+        try {
+            precomputeCapBytes = static_cast<uint64_t>(std::stoull(*value)) << 20;
+        } catch (const std::exception &) {
+            std::cerr << "Invalid precompute memory cap: " << *value << std::endl;
+            return 1;
+        }
+    }
+
+    // 预览时显示选区的亮度统计（平均 / 峰值 nits、超过 SDR 白的比例），整帧求和面积表在截屏后生成一次
+    const bool selectionStatistics = HasFlag(argc, argv, L"--selection-stats");
+
+    if (HasFlag(argc, argv, L"--compare-tonemap")) {
+        PrintScrApp app(conversionOptions, stageTiming);
+        return app.RunToneMapComparison(10);
+    }
+
+    // 截取整屏并保存为 .scrgb 转储，供 --batch 离线转换
+    if (argc > 2 && wcscmp(argv[1], L"--dump-raw") == 0) {
+        PrintScrApp app(conversionOptions, stageTiming);
+        return app.RunRawDump(argv[2]);
+    }
+
     // 守护进程模式
     if (argc > 1 && wcscmp(argv[1], L"--daemon") == 0) {
         if (g_shared_context.caller_event_name[0] != 0 || g_shared_context.caller_mutex_name[0] != 0) {
@@ -189,12 +584,27 @@ int wmain(int argc, wchar_t *argv[]) {
             return 1;
         }
 
-        PrintScrApp app;
+        PrintScrApp app(conversionOptions, stageTiming, precomputeCapBytes, selectionStatistics);
+        app.PreparePreview();
+        app.PrepareTuning();
         for(;;) {
-            if (WaitForSingleObject(hEvent, INFINITE) == WAIT_OBJECT_0) {
+            // 隐藏的预览窗口属于本线程，等待期间须处理它的消息
+            if (WaitPumpingMessages(hEvent) == WAIT_OBJECT_0) {
                 auto wait_mutex_result = WaitForSingleObject(hMutex, INFINITE);
                 if (wait_mutex_result == WAIT_OBJECT_0 || wait_mutex_result == WAIT_ABANDONED_0) {
-                    app.RunCaptureTarget();
+                    // 以启动参数为基础应用本次调用的参数；客户端已校验过，失败只可能是查找表文件此后变化
+                    std::vector<std::wstring> arguments = ReceiveArguments();
+                    std::vector<wchar_t *> forwardedArgv;
+                    for (auto &arg : arguments) {
+                        forwardedArgv.push_back(arg.data());
+                    }
+                    ConversionOptions options = conversionOptions;
+                    const int forwardedArgc = static_cast<int>(forwardedArgv.size());
+                    if (ParseConversionOptions(forwardedArgc, forwardedArgv.data(), options)) {
+                        app.RunCaptureTarget(options);
+                    } else {
+                        std::cerr << "Capture request ignored: invalid options." << std::endl;
+                    }
                     ResetEvent(hEvent);
                     ReleaseMutex(hMutex);
                 } else {
@@ -221,13 +631,19 @@ int wmain(int argc, wchar_t *argv[]) {
             std::cerr << "Failed to open mutex." << std::endl;
             return 1;
         }
+        // 参数在持有互斥量时写入；守护进程处理前若有另一次调用，两次请求合并为一次截屏，使用后者的参数
         WaitForSingleObject(hMutex, INFINITE);
+        if (!ForwardArguments(argc, argv)) {
+            ReleaseMutex(hMutex);
+            std::cerr << "Arguments too long to forward to the daemon." << std::endl;
+            return 1;
+        }
         SetEvent(hEvent);
         ReleaseMutex(hMutex);
         return 0;
     }
 
     // 没有正在运行的守护进程，冷启动执行
-    PrintScrApp app;
+    PrintScrApp app(conversionOptions, stageTiming, precomputeCapBytes, selectionStatistics);
     return app.RunCaptureTarget();
 }